@@ -0,0 +1,266 @@
+/* Benchmark symbol lookup in large global scopes.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* For each scope size, a child process loads that many copies of a
+   filler module with RTLD_GLOBAL, followed by a module defining the
+   target symbol, and measures dlsym (RTLD_DEFAULT) for the target
+   symbol, which is found in the last object of the global scope, and
+   for a symbol of the first filler module.  It also measures the time
+   to start a process which preloads the same modules, which includes
+   building the filter of its global scope.  Run with
+   GLIBC_TUNABLES=glibc.rtld.scope_filter=0 to compare with lookups
+   which visit every object in the scope.  */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define NUM_ITERS 100000
+#define NUM_STARTS 20
+
+static const unsigned int scope_sizes[] = { 16, 64, 128, 300, 1000 };
+
+struct result
+{
+  double time_late;
+  double time_early;
+  double time_startup;
+};
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-dl-lookup: %s failed: %m\n", what);
+  exit (1);
+}
+
+/* Read the module NAME into *DATA.  */
+static size_t
+read_module (const char *name, char **data)
+{
+  int fd = open (name, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    fail (name);
+  *data = malloc (st.st_size);
+  if (*data == NULL || read (fd, *data, st.st_size) != st.st_size)
+    fail ("read");
+  close (fd);
+  return st.st_size;
+}
+
+/* Write a copy of DATA, which is SIZE bytes long, as DIR/N.so, and
+   store its name in NAME.  */
+static void
+write_copy (const char *dir, unsigned int n, const char *data, size_t size,
+	    char *name, size_t name_size)
+{
+  snprintf (name, name_size, "%s/%u.so", dir, n);
+  int fd = open (name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0 || write (fd, data, size) != size || close (fd) != 0)
+    fail ("write");
+}
+
+/* Open a copy of DATA, which is SIZE bytes long, as DIR/N.so.  */
+static void
+open_copy (const char *dir, unsigned int n, const char *data, size_t size)
+{
+  char name[strlen (dir) + 32];
+  write_copy (dir, n, data, size, name, sizeof (name));
+  if (dlopen (name, RTLD_NOW | RTLD_GLOBAL) == NULL)
+    {
+      fprintf (stderr, "bench-dl-lookup: %s\n", dlerror ());
+      exit (1);
+    }
+  unlink (name);
+}
+
+static double
+time_lookup (const char *symbol)
+{
+  timing_t start, stop, elapsed;
+
+  if (dlsym (RTLD_DEFAULT, symbol) == NULL)
+    {
+      fprintf (stderr, "bench-dl-lookup: %s not found\n", symbol);
+      exit (1);
+    }
+
+  TIMING_NOW (start);
+  for (int i = 0; i < NUM_ITERS; ++i)
+    dlsym (RTLD_DEFAULT, symbol);
+  TIMING_NOW (stop);
+
+  TIMING_DIFF (elapsed, start, stop);
+  return (double) elapsed / NUM_ITERS;
+}
+
+/* Return the time to start a process which preloads SIZE copies of
+   FILLER, followed by the target module, and exits.  */
+static double
+time_startup (const char *dir, unsigned int size, const char *filler,
+	      size_t filler_size)
+{
+  size_t name_size = strlen (dir) + 32;
+  char *preload = malloc (size * name_size
+			  + sizeof (OBJPFX "bench-dl-lookup-target.so"));
+  if (preload == NULL)
+    fail ("malloc");
+  char *p = preload;
+  for (unsigned int n = 0; n < size; ++n)
+    {
+      write_copy (dir, n, filler, filler_size, p, name_size);
+      p += strlen (p);
+      *p++ = ':';
+    }
+  strcpy (p, OBJPFX "bench-dl-lookup-target.so");
+
+  char *argv[] =
+    {
+      (char *) RTLD, (char *) "--library-path", (char *) LIBRARY_PATH,
+      (char *) "--preload", preload, (char *) OBJPFX "bench-dl-lookup",
+      (char *) "--exit", NULL
+    };
+  timing_t start, stop, elapsed;
+  TIMING_NOW (start);
+  for (int i = 0; i < NUM_STARTS; ++i)
+    {
+      pid_t pid = fork ();
+      if (pid < 0)
+	fail ("fork");
+      if (pid == 0)
+	{
+	  execv (RTLD, argv);
+	  _exit (127);
+	}
+      int status;
+      if (waitpid (pid, &status, 0) != pid || status != 0)
+	fail ("startup");
+    }
+  TIMING_NOW (stop);
+  TIMING_DIFF (elapsed, start, stop);
+
+  for (unsigned int n = 0; n < size; ++n)
+    {
+      char name[name_size];
+      snprintf (name, name_size, "%s/%u.so", dir, n);
+      unlink (name);
+    }
+  free (preload);
+  return (double) elapsed / NUM_STARTS;
+}
+
+/* Build a scope of SIZE filler modules in a child process, and return
+   the lookup times.  */
+static struct result
+run_scope (const char *dir, unsigned int size, const char *filler,
+	   size_t filler_size)
+{
+  int fds[2];
+  if (pipe (fds) != 0)
+    fail ("pipe");
+  pid_t pid = fork ();
+  if (pid < 0)
+    fail ("fork");
+  if (pid == 0)
+    {
+      for (unsigned int n = 0; n < size; ++n)
+	open_copy (dir, n, filler, filler_size);
+      if (dlopen (OBJPFX "bench-dl-lookup-target.so",
+		  RTLD_NOW | RTLD_GLOBAL) == NULL)
+	{
+	  fprintf (stderr, "bench-dl-lookup: %s\n", dlerror ());
+	  _exit (1);
+	}
+
+      struct result r;
+      r.time_late = time_lookup ("bench_dl_lookup_target");
+      r.time_early = time_lookup ("bench_dl_lookup_fill_00");
+      if (write (fds[1], &r, sizeof (r)) != sizeof (r))
+	_exit (1);
+      _exit (0);
+    }
+
+  close (fds[1]);
+  struct result r;
+  if (read (fds[0], &r, sizeof (r)) != sizeof (r))
+    {
+      fprintf (stderr, "bench-dl-lookup: scope of %u objects failed\n",
+	       size);
+      exit (1);
+    }
+  close (fds[0]);
+  int status;
+  if (waitpid (pid, &status, 0) != pid || status != 0)
+    fail ("child process");
+  return r;
+}
+
+int
+main (int argc, char **argv)
+{
+  /* Started by time_startup.  */
+  if (argc > 1 && strcmp (argv[1], "--exit") == 0)
+    return 0;
+
+  char *filler;
+  size_t filler_size = read_module (OBJPFX "bench-dl-lookup-mod.so",
+				    &filler);
+
+  char dir[] = "/tmp/bench-dl-lookup-XXXXXX";
+  if (mkdtemp (dir) == NULL)
+    fail ("mkdtemp");
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 0, stdout);
+  json_document_begin (&json_ctx);
+  json_attr_string (&json_ctx, "timing_type", TIMING_TYPE);
+  json_attr_object_begin (&json_ctx, "functions");
+  json_attr_object_begin (&json_ctx, "dlsym");
+  json_attr_string (&json_ctx, "bench-variant", "RTLD_DEFAULT");
+  json_array_begin (&json_ctx, "results");
+
+  for (size_t i = 0; i < sizeof (scope_sizes) / sizeof (scope_sizes[0]); ++i)
+    {
+      struct result r = run_scope (dir, scope_sizes[i], filler, filler_size);
+      r.time_startup = time_startup (dir, scope_sizes[i], filler,
+				     filler_size);
+      json_element_object_begin (&json_ctx);
+      json_attr_uint (&json_ctx, "objects", scope_sizes[i]);
+      json_attr_double (&json_ctx, "time_last_object", r.time_late);
+      json_attr_double (&json_ctx, "time_first_object", r.time_early);
+      json_attr_double (&json_ctx, "time_startup", r.time_startup);
+      json_element_object_end (&json_ctx);
+    }
+
+  json_array_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_document_end (&json_ctx);
+
+  rmdir (dir);
+  free (filler);
+  return 0;
+}
@@ -0,0 +1,42 @@
+/* Plugin module for bench-dl-open-many.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Copies of this module are loaded by bench-dl-open-many.  It has a
+   constructor, a TLS variable and a few symbolic relocations, like a
+   small plugin.  */
+
+#include <stdlib.h>
+#include <string.h>
+
+__thread int bench_dl_open_many_var;
+
+static char *buffer;
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  buffer = malloc (16);
+  if (buffer != NULL)
+    memset (buffer, 0, 16);
+}
+
+int *
+bench_dl_open_many_get (void)
+{
+  return &bench_dl_open_many_var;
+}
@@ -0,0 +1,197 @@
+/* Measure loading a set of plugins with dlopen and dlopen_many.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* For each plugin count, copies of a module are loaded in a child
+   process, either with one dlopen call per copy or with a single
+   dlopen_many call, and the total time until all of them are
+   initialized is measured.  */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+/* Number of child processes per measurement.  */
+#define NUM_RUNS 8
+
+static const unsigned int plugin_counts[] = { 16, 64, 256, 1000 };
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-dl-open-many: %s failed: %m\n", what);
+  exit (1);
+}
+
+/* Write COUNT copies of the module to DIR, and return their names.  */
+static char **
+write_copies (const char *dir, unsigned int count)
+{
+  const char *module = OBJPFX "bench-dl-open-many-mod.so";
+  int fd = open (module, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    fail (module);
+  char *data = malloc (st.st_size);
+  if (data == NULL || read (fd, data, st.st_size) != st.st_size)
+    fail ("read");
+  close (fd);
+
+  char **names = malloc (count * sizeof (*names));
+  if (names == NULL)
+    fail ("malloc");
+  for (unsigned int n = 0; n < count; ++n)
+    {
+      if (asprintf (&names[n], "%s/%u.so", dir, n) < 0)
+	fail ("asprintf");
+      fd = open (names[n], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      if (fd < 0 || write (fd, data, st.st_size) != st.st_size
+	  || close (fd) != 0)
+	fail ("write");
+    }
+  free (data);
+  return names;
+}
+
+/* Load the COUNT files in NAMES in a child process, and return the
+   time this took.  */
+static double
+run_once (char **names, unsigned int count, bool many)
+{
+  int fds[2];
+  if (pipe (fds) != 0)
+    fail ("pipe");
+  pid_t pid = fork ();
+  if (pid < 0)
+    fail ("fork");
+  if (pid == 0)
+    {
+      void **handles = malloc (count * sizeof (*handles));
+      if (handles == NULL)
+	_exit (1);
+      timing_t start, stop, elapsed;
+      TIMING_NOW (start);
+      if (many)
+	{
+	  if (dlopen_many ((const char *const *) names, count, RTLD_NOW,
+			   handles) != 0)
+	    {
+	      fprintf (stderr, "bench-dl-open-many: %s\n", dlerror ());
+	      _exit (1);
+	    }
+	}
+      else
+	for (unsigned int n = 0; n < count; ++n)
+	  {
+	    handles[n] = dlopen (names[n], RTLD_NOW);
+	    if (handles[n] == NULL)
+	      {
+		fprintf (stderr, "bench-dl-open-many: %s\n", dlerror ());
+		_exit (1);
+	      }
+	  }
+      TIMING_NOW (stop);
+      TIMING_DIFF (elapsed, start, stop);
+
+      double r = elapsed;
+      if (write (fds[1], &r, sizeof (r)) != sizeof (r))
+	_exit (1);
+      _exit (0);
+    }
+
+  close (fds[1]);
+  double r;
+  if (read (fds[0], &r, sizeof (r)) != sizeof (r))
+    {
+      fprintf (stderr, "bench-dl-open-many: %u plugins failed\n", count);
+      exit (1);
+    }
+  close (fds[0]);
+  int status;
+  if (waitpid (pid, &status, 0) != pid || status != 0)
+    fail ("child process");
+  return r;
+}
+
+/* Return the average time of loading the COUNT files in NAMES.  */
+static double
+run_count (char **names, unsigned int count, bool many)
+{
+  double total = 0;
+  for (unsigned int i = 0; i < NUM_RUNS; ++i)
+    total += run_once (names, count, many);
+  return total / NUM_RUNS;
+}
+
+int
+main (int argc, char **argv)
+{
+  char dir[] = "/tmp/bench-dl-open-many-XXXXXX";
+  if (mkdtemp (dir) == NULL)
+    fail ("mkdtemp");
+
+  unsigned int max_count = 0;
+  for (size_t i = 0; i < sizeof (plugin_counts) / sizeof (plugin_counts[0]);
+       ++i)
+    if (plugin_counts[i] > max_count)
+      max_count = plugin_counts[i];
+  char **names = write_copies (dir, max_count);
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 0, stdout);
+  json_document_begin (&json_ctx);
+  json_attr_string (&json_ctx, "timing_type", TIMING_TYPE);
+  json_attr_object_begin (&json_ctx, "functions");
+  json_attr_object_begin (&json_ctx, "dlopen_many");
+  json_attr_string (&json_ctx, "bench-variant", "startup");
+  json_array_begin (&json_ctx, "results");
+
+  for (size_t i = 0; i < sizeof (plugin_counts) / sizeof (plugin_counts[0]);
+       ++i)
+    {
+      unsigned int count = plugin_counts[i];
+      double t_dlopen = run_count (names, count, false);
+      double t_many = run_count (names, count, true);
+      json_element_object_begin (&json_ctx);
+      json_attr_uint (&json_ctx, "plugins", count);
+      json_attr_double (&json_ctx, "time_dlopen", t_dlopen);
+      json_attr_double (&json_ctx, "time_dlopen_many", t_many);
+      json_element_object_end (&json_ctx);
+    }
+
+  json_array_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_document_end (&json_ctx);
+
+  for (unsigned int n = 0; n < max_count; ++n)
+    {
+      unlink (names[n]);
+      free (names[n]);
+    }
+  free (names);
+  rmdir (dir);
+  return 0;
+}
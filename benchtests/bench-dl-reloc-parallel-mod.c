@@ -0,0 +1,31 @@
+/* Module for benchmarking glibc.rtld.parallel_reloc.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Copies of this module are preloaded.  The table references functions
+   in libc, many of them IFUNCs, which are looked up past every copy
+   at startup.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void *const bench_dl_reloc_parallel_table[] =
+  {
+    strlen, memcpy, memmove, memset, memcmp, strchr, strcmp, strcpy,
+    strncmp, strrchr, stpcpy, malloc, free, calloc, realloc, printf,
+  };
@@ -0,0 +1,180 @@
+/* Benchmark startup with glibc.rtld.parallel_reloc.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Measure the time to start a process which preloads 500 copies of a
+   module with immediate binding, for different numbers of helper
+   threads.  Each copy has relocations against functions in libc,
+   which is searched after all of them.  Run with
+   GLIBC_TUNABLES=glibc.rtld.scope_filter=0 to compare with lookups
+   which visit every object in the scope.  */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define NUM_OBJECTS 500
+#define NUM_STARTS 20
+
+static const int thread_counts[] = { 0, 1, 2, 4, 8 };
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-dl-reloc-parallel: %s failed: %m\n", what);
+  exit (1);
+}
+
+/* Read the module NAME into *DATA.  */
+static size_t
+read_module (const char *name, char **data)
+{
+  int fd = open (name, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    fail (name);
+  *data = malloc (st.st_size);
+  if (*data == NULL || read (fd, *data, st.st_size) != st.st_size)
+    fail ("read");
+  close (fd);
+  return st.st_size;
+}
+
+/* Return the time to start a process which preloads the objects in
+   PRELOAD with glibc.rtld.parallel_reloc=THREADS, and exits.  */
+static double
+time_startup (char *preload, int threads)
+{
+  char tunables[64];
+  snprintf (tunables, sizeof (tunables),
+	    "GLIBC_TUNABLES=glibc.rtld.parallel_reloc=%d", threads);
+  char *env = getenv ("GLIBC_TUNABLES");
+  char *envp[] = { tunables, (char *) "LD_BIND_NOW=1", NULL };
+  /* Keep other tunables, such as glibc.rtld.scope_filter.  */
+  if (env != NULL)
+    {
+      envp[0] = malloc (strlen (tunables) + strlen (env) + 2);
+      if (envp[0] == NULL)
+	fail ("malloc");
+      sprintf (envp[0], "%s:%s", tunables, env);
+    }
+
+  char *argv[] =
+    {
+      (char *) RTLD, (char *) "--library-path", (char *) LIBRARY_PATH,
+      (char *) "--preload", preload,
+      (char *) OBJPFX "bench-dl-reloc-parallel", (char *) "--exit", NULL
+    };
+  timing_t start, stop, elapsed;
+  TIMING_NOW (start);
+  for (int i = 0; i < NUM_STARTS; ++i)
+    {
+      pid_t pid = fork ();
+      if (pid < 0)
+	fail ("fork");
+      if (pid == 0)
+	{
+	  execve (RTLD, argv, envp);
+	  _exit (127);
+	}
+      int status;
+      if (waitpid (pid, &status, 0) != pid || status != 0)
+	fail ("startup");
+    }
+  TIMING_NOW (stop);
+  TIMING_DIFF (elapsed, start, stop);
+
+  if (envp[0] != tunables)
+    free (envp[0]);
+  return (double) elapsed / NUM_STARTS;
+}
+
+int
+main (int argc, char **argv)
+{
+  /* Started by time_startup.  */
+  if (argc > 1 && strcmp (argv[1], "--exit") == 0)
+    return 0;
+
+  char *module;
+  size_t module_size = read_module (OBJPFX "bench-dl-reloc-parallel-mod.so",
+				    &module);
+
+  char dir[] = "/tmp/bench-dl-reloc-parallel-XXXXXX";
+  if (mkdtemp (dir) == NULL)
+    fail ("mkdtemp");
+
+  /* The dynamic linker loads a file only once, so preload copies.  */
+  size_t name_size = strlen (dir) + 32;
+  char *preload = malloc (NUM_OBJECTS * name_size);
+  if (preload == NULL)
+    fail ("malloc");
+  char *p = preload;
+  for (unsigned int n = 0; n < NUM_OBJECTS; ++n)
+    {
+      int len = snprintf (p, name_size, "%s/%u.so", dir, n);
+      int fd = open (p, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      if (fd < 0 || write (fd, module, module_size) != module_size
+	  || close (fd) != 0)
+	fail ("write");
+      p += len;
+      *p++ = ':';
+    }
+  p[-1] = '\0';
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 0, stdout);
+  json_document_begin (&json_ctx);
+  json_attr_string (&json_ctx, "timing_type", TIMING_TYPE);
+  json_attr_object_begin (&json_ctx, "functions");
+  json_attr_object_begin (&json_ctx, "startup");
+  json_attr_string (&json_ctx, "bench-variant", "parallel_reloc");
+  json_array_begin (&json_ctx, "results");
+
+  for (size_t i = 0; i < sizeof (thread_counts) / sizeof (thread_counts[0]);
+       ++i)
+    {
+      json_element_object_begin (&json_ctx);
+      json_attr_uint (&json_ctx, "objects", NUM_OBJECTS);
+      json_attr_uint (&json_ctx, "threads", thread_counts[i]);
+      json_attr_double (&json_ctx, "time_startup",
+			time_startup (preload, thread_counts[i]));
+      json_element_object_end (&json_ctx);
+    }
+
+  json_array_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_document_end (&json_ctx);
+
+  for (unsigned int n = 0; n < NUM_OBJECTS; ++n)
+    {
+      char name[name_size];
+      snprintf (name, name_size, "%s/%u.so", dir, n);
+      unlink (name);
+    }
+  rmdir (dir);
+  free (preload);
+  free (module);
+  return 0;
+}
@@ -0,0 +1,28 @@
+/* Plugin module for bench-dl-sort-maps.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Copies of this module are loaded by bench-dl-sort-maps.  All of them
+   depend on bench-dl-sort-maps-dep.so, which is loaded only once.  */
+
+void bench_dl_sort_maps_register (void);
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  bench_dl_sort_maps_register ();
+}
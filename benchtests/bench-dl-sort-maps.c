@@ -0,0 +1,187 @@
+/* Measure dlopen and dlclose of a plugin while many objects are loaded.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* For each count, a child process loads that many copies of a plugin
+   module, which all share a dependency, and then repeatedly opens and
+   closes one more copy.  The average time of the dlopen and dlclose
+   calls is reported, which includes sorting the objects for their
+   initialization and for running their destructors.  */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+/* Number of dlopen and dlclose calls per measurement.  */
+#define ITERATIONS 200
+
+static const unsigned int loaded_counts[] = { 0, 100, 1000, 2000 };
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-dl-sort-maps: %s failed: %m\n", what);
+  exit (1);
+}
+
+/* Write COUNT copies of the plugin module to DIR, and return their
+   names.  */
+static char **
+write_copies (const char *dir, unsigned int count)
+{
+  const char *module = OBJPFX "bench-dl-sort-maps-mod.so";
+  int fd = open (module, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    fail (module);
+  char *data = malloc (st.st_size);
+  if (data == NULL || read (fd, data, st.st_size) != st.st_size)
+    fail ("read");
+  close (fd);
+
+  char **names = malloc (count * sizeof (*names));
+  if (names == NULL)
+    fail ("malloc");
+  for (unsigned int n = 0; n < count; ++n)
+    {
+      if (asprintf (&names[n], "%s/%u.so", dir, n) < 0)
+	fail ("asprintf");
+      fd = open (names[n], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      if (fd < 0 || write (fd, data, st.st_size) != st.st_size
+	  || close (fd) != 0)
+	fail ("write");
+    }
+  free (data);
+  return names;
+}
+
+/* Load the first COUNT files in NAMES in a child process, and measure
+   opening and closing the next one.  Store the average times in
+   RESULTS.  */
+static void
+run_count (char **names, unsigned int count, double results[2])
+{
+  int fds[2];
+  if (pipe (fds) != 0)
+    fail ("pipe");
+  pid_t pid = fork ();
+  if (pid < 0)
+    fail ("fork");
+  if (pid == 0)
+    {
+      for (unsigned int n = 0; n < count; ++n)
+	if (dlopen (names[n], RTLD_NOW) == NULL)
+	  {
+	    fprintf (stderr, "bench-dl-sort-maps: %s\n", dlerror ());
+	    _exit (1);
+	  }
+
+      double r[2] = { 0, 0 };
+      for (int i = 0; i < ITERATIONS; ++i)
+	{
+	  timing_t start, middle, stop, elapsed;
+	  TIMING_NOW (start);
+	  void *handle = dlopen (names[count], RTLD_NOW);
+	  TIMING_NOW (middle);
+	  if (handle == NULL)
+	    {
+	      fprintf (stderr, "bench-dl-sort-maps: %s\n", dlerror ());
+	      _exit (1);
+	    }
+	  dlclose (handle);
+	  TIMING_NOW (stop);
+	  TIMING_DIFF (elapsed, start, middle);
+	  r[0] += elapsed;
+	  TIMING_DIFF (elapsed, middle, stop);
+	  r[1] += elapsed;
+	}
+      r[0] /= ITERATIONS;
+      r[1] /= ITERATIONS;
+      if (write (fds[1], r, sizeof (r)) != sizeof (r))
+	_exit (1);
+      _exit (0);
+    }
+
+  close (fds[1]);
+  if (read (fds[0], results, 2 * sizeof (double)) != 2 * sizeof (double))
+    {
+      fprintf (stderr, "bench-dl-sort-maps: %u objects failed\n", count);
+      exit (1);
+    }
+  close (fds[0]);
+  int status;
+  if (waitpid (pid, &status, 0) != pid || status != 0)
+    fail ("child process");
+}
+
+int
+main (int argc, char **argv)
+{
+  char dir[] = "/tmp/bench-dl-sort-maps-XXXXXX";
+  if (mkdtemp (dir) == NULL)
+    fail ("mkdtemp");
+
+  unsigned int max_count = 0;
+  for (size_t i = 0; i < sizeof (loaded_counts) / sizeof (loaded_counts[0]);
+       ++i)
+    if (loaded_counts[i] > max_count)
+      max_count = loaded_counts[i];
+  /* One more copy for the plugin which is opened and closed.  */
+  char **names = write_copies (dir, max_count + 1);
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 0, stdout);
+  json_document_begin (&json_ctx);
+  json_attr_string (&json_ctx, "timing_type", TIMING_TYPE);
+  json_attr_object_begin (&json_ctx, "functions");
+  json_attr_object_begin (&json_ctx, "dlopen");
+  json_attr_string (&json_ctx, "bench-variant", "sort-maps");
+  json_array_begin (&json_ctx, "results");
+
+  for (size_t i = 0; i < sizeof (loaded_counts) / sizeof (loaded_counts[0]);
+       ++i)
+    {
+      double results[2];
+      run_count (names, loaded_counts[i], results);
+      json_element_object_begin (&json_ctx);
+      json_attr_uint (&json_ctx, "loaded", loaded_counts[i]);
+      json_attr_double (&json_ctx, "time_dlopen", results[0]);
+      json_attr_double (&json_ctx, "time_dlclose", results[1]);
+      json_element_object_end (&json_ctx);
+    }
+
+  json_array_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_document_end (&json_ctx);
+
+  for (unsigned int n = 0; n <= max_count; ++n)
+    {
+      unlink (names[n]);
+      free (names[n]);
+    }
+  free (names);
+  rmdir (dir);
+  return 0;
+}
@@ -0,0 +1,33 @@
+/* Module with a TLS variable for bench-dl-tls-access.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The module is built with different TLS dialects, and with a TLS
+   block too large for the optional static TLS surplus.  */
+
+#ifndef TLS_SIZE
+# define TLS_SIZE 1
+#endif
+
+__thread int bench_dl_tls_access_var[TLS_SIZE];
+
+/* Each call computes the address of the variable again.  */
+void
+bench_dl_tls_access (void)
+{
+  ++bench_dl_tls_access_var[0];
+}
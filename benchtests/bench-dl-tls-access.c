@@ -0,0 +1,140 @@
+/* Benchmark accesses to TLS variables of dlopen'ed modules.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Measure the cost of an access to a TLS variable of a plugin loaded
+   with dlopen, through __tls_get_addr, and through a TLS descriptor
+   for a module placed in the optional static TLS surplus and for one
+   too large for it.  Every access is made in a function called through
+   a function pointer, so the "call" variant, which only calls an empty
+   function, is the baseline; an initial-exec access in the main program
+   is measured in the same way for comparison.  Run with LD_DEBUG=tls to
+   see the static TLS placement.  */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define NUM_ITERS 1000000
+/* Report the fastest of NUM_RUNS runs of NUM_ITERS accesses, so that
+   interruptions do not distort the comparison.  */
+#define NUM_RUNS 20
+
+static __thread int main_var;
+
+static void __attribute__ ((noinline))
+call_only (void)
+{
+  /* Prevent the call from being optimized away.  */
+  __asm__ volatile ("" ::: "memory");
+}
+
+static void __attribute__ ((noinline))
+access_main (void)
+{
+  ++main_var;
+  __asm__ volatile ("" ::: "memory");
+}
+
+static const struct
+{
+  const char *name;
+  const char *module;
+} variants[] =
+  {
+    { "tls_get_addr", OBJPFX "bench-dl-tls-access-mod.so" },
+#ifdef HAVE_TLSDESC
+    { "tlsdesc-static", OBJPFX "bench-dl-tls-access-desc-mod.so" },
+    { "tlsdesc-dynamic", OBJPFX "bench-dl-tls-access-desc-large-mod.so" },
+#endif
+  };
+
+static double
+time_access (void (*fn) (void))
+{
+  timing_t start, stop, elapsed, best = 0;
+  /* Do not let the compiler inline FN into the loop.  */
+  void (*volatile fnp) (void) = fn;
+
+  /* Allocate the TLS block, if it is dynamic.  */
+  fn ();
+
+  for (int run = 0; run < NUM_RUNS; ++run)
+    {
+      TIMING_NOW (start);
+      for (int i = 0; i < NUM_ITERS; ++i)
+	fnp ();
+      TIMING_NOW (stop);
+
+      TIMING_DIFF (elapsed, start, stop);
+      if (run == 0 || elapsed < best)
+	best = elapsed;
+    }
+  return (double) best / NUM_ITERS;
+}
+
+static void
+print_result (json_ctx_t *json_ctx, const char *name, double time)
+{
+  json_element_object_begin (json_ctx);
+  json_attr_string (json_ctx, "access", name);
+  json_attr_double (json_ctx, "time", time);
+  json_element_object_end (json_ctx);
+}
+
+int
+main (int argc, char **argv)
+{
+  void (*fns[sizeof (variants) / sizeof (variants[0])]) (void);
+  for (size_t i = 0; i < sizeof (variants) / sizeof (variants[0]); ++i)
+    {
+      void *handle = dlopen (variants[i].module, RTLD_NOW);
+      if (handle == NULL)
+	{
+	  fprintf (stderr, "bench-dl-tls-access: %s\n", dlerror ());
+	  return 1;
+	}
+      fns[i] = dlsym (handle, "bench_dl_tls_access");
+      if (fns[i] == NULL)
+	{
+	  fprintf (stderr, "bench-dl-tls-access: %s\n", dlerror ());
+	  return 1;
+	}
+    }
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 0, stdout);
+  json_document_begin (&json_ctx);
+  json_attr_string (&json_ctx, "timing_type", TIMING_TYPE);
+  json_attr_object_begin (&json_ctx, "functions");
+  json_attr_object_begin (&json_ctx, "tls-access");
+  json_attr_string (&json_ctx, "bench-variant", "dlopen");
+  json_array_begin (&json_ctx, "results");
+
+  print_result (&json_ctx, "call", time_access (call_only));
+  print_result (&json_ctx, "initial-exec", time_access (access_main));
+  for (size_t i = 0; i < sizeof (variants) / sizeof (variants[0]); ++i)
+    print_result (&json_ctx, variants[i].name, time_access (fns[i]));
+
+  json_array_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_document_end (&json_ctx);
+  return 0;
+}
@@ -0,0 +1,28 @@
+/* Module with a TLS variable for bench-dl-tls.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Copies of this module are loaded by bench-dl-tls.  The variable is
+   accessed through __tls_get_addr (or a TLS descriptor).  */
+
+__thread int bench_dl_tls_var;
+
+int *
+bench_dl_tls_get (void)
+{
+  return &bench_dl_tls_var;
+}
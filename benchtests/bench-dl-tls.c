@@ -0,0 +1,184 @@
+/* Benchmark the first access to TLS of dlopen'ed modules.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* For each module count, a child process loads that many copies of a
+   module with a TLS variable and accesses the variable of each of
+   them.  It then loads further copies one at a time, and measures the
+   first access to the TLS variable of each new copy, which has to
+   bring the DTV of the thread up to date with the new generation
+   before allocating the TLS block of the module.  */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+/* Number of new copies whose first access is measured.  */
+#define NUM_ITERS 64
+
+static const unsigned int module_counts[] = { 16, 100, 300, 1000 };
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-dl-tls: %s failed: %m\n", what);
+  exit (1);
+}
+
+/* Read the module NAME into *DATA.  */
+static size_t
+read_module (const char *name, char **data)
+{
+  int fd = open (name, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    fail (name);
+  *data = malloc (st.st_size);
+  if (*data == NULL || read (fd, *data, st.st_size) != st.st_size)
+    fail ("read");
+  close (fd);
+  return st.st_size;
+}
+
+typedef int *(*get_function) (void);
+
+/* Open a copy of DATA, which is SIZE bytes long, as DIR/N.so, and
+   return its function for accessing the TLS variable.  */
+static get_function
+open_copy (const char *dir, unsigned int n, const char *data, size_t size)
+{
+  char name[strlen (dir) + 32];
+  snprintf (name, sizeof (name), "%s/%u.so", dir, n);
+  int fd = open (name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0 || write (fd, data, size) != size || close (fd) != 0)
+    fail ("write");
+  void *handle = dlopen (name, RTLD_NOW);
+  if (handle == NULL)
+    {
+      fprintf (stderr, "bench-dl-tls: %s\n", dlerror ());
+      exit (1);
+    }
+  unlink (name);
+  get_function get = dlsym (handle, "bench_dl_tls_get");
+  if (get == NULL)
+    {
+      fprintf (stderr, "bench-dl-tls: %s\n", dlerror ());
+      exit (1);
+    }
+  return get;
+}
+
+/* Load COUNT copies of the module in a child process, and return the
+   average time of the first TLS access to a module loaded after
+   them.  */
+static double
+run_count (const char *dir, unsigned int count, const char *module,
+	   size_t module_size)
+{
+  int fds[2];
+  if (pipe (fds) != 0)
+    fail ("pipe");
+  pid_t pid = fork ();
+  if (pid < 0)
+    fail ("fork");
+  if (pid == 0)
+    {
+      for (unsigned int n = 0; n < count; ++n)
+	{
+	  get_function get = open_copy (dir, n, module, module_size);
+	  *get () = n;
+	}
+
+      double total = 0;
+      for (unsigned int i = 0; i < NUM_ITERS; ++i)
+	{
+	  get_function get = open_copy (dir, count + i, module,
+					module_size);
+	  timing_t start, stop, elapsed;
+	  TIMING_NOW (start);
+	  int *p = get ();
+	  TIMING_NOW (stop);
+	  TIMING_DIFF (elapsed, start, stop);
+	  total += elapsed;
+	  *p = i;
+	}
+
+      double r = total / NUM_ITERS;
+      if (write (fds[1], &r, sizeof (r)) != sizeof (r))
+	_exit (1);
+      _exit (0);
+    }
+
+  close (fds[1]);
+  double r;
+  if (read (fds[0], &r, sizeof (r)) != sizeof (r))
+    {
+      fprintf (stderr, "bench-dl-tls: %u modules failed\n", count);
+      exit (1);
+    }
+  close (fds[0]);
+  int status;
+  if (waitpid (pid, &status, 0) != pid || status != 0)
+    fail ("child process");
+  return r;
+}
+
+int
+main (int argc, char **argv)
+{
+  char *module;
+  size_t module_size = read_module (OBJPFX "bench-dl-tls-mod.so", &module);
+
+  char dir[] = "/tmp/bench-dl-tls-XXXXXX";
+  if (mkdtemp (dir) == NULL)
+    fail ("mkdtemp");
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 0, stdout);
+  json_document_begin (&json_ctx);
+  json_attr_string (&json_ctx, "timing_type", TIMING_TYPE);
+  json_attr_object_begin (&json_ctx, "functions");
+  json_attr_object_begin (&json_ctx, "__tls_get_addr");
+  json_attr_string (&json_ctx, "bench-variant", "first-access");
+  json_array_begin (&json_ctx, "results");
+
+  for (size_t i = 0; i < sizeof (module_counts) / sizeof (module_counts[0]);
+       ++i)
+    {
+      double t = run_count (dir, module_counts[i], module, module_size);
+      json_element_object_begin (&json_ctx);
+      json_attr_uint (&json_ctx, "modules", module_counts[i]);
+      json_attr_double (&json_ctx, "time_first_access", t);
+      json_element_object_end (&json_ctx);
+    }
+
+  json_array_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_attr_object_end (&json_ctx);
+  json_document_end (&json_ctx);
+
+  rmdir (dir);
+  free (module);
+  return 0;
+}
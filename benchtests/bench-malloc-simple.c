@@ -26,9 +26,9 @@
 
 /* Benchmark the malloc/free performance of a varying number of blocks of a
    given size.  This enables performance tracking of the t-cache and fastbins.
-   It tests 3 different scenarios: single-threaded using main arena,
-   multi-threaded using thread-arena, and main arena with SINGLE_THREAD_P
-   false.  */
+   It tests 4 different scenarios: single-threaded using main arena,
+   multi-threaded using thread-arena, main arena with SINGLE_THREAD_P
+   false, and single-threaded using main arena with free_sized.  */
 
 #define NUM_ITERS 200000
 #define NUM_ALLOCS 4
@@ -39,6 +39,7 @@ typedef struct
   size_t iters;
   size_t size;
   int n;
+  int sized;
   timing_t elapsed;
 } malloc_args;
 
@@ -57,8 +58,12 @@ do_benchmark (malloc_args *args, int **arr)
       for (int i = 0; i < n; i++)
 	arr[i] = malloc (size);
 
-      for (int i = 0; i < n; i++)
-	free (arr[i]);
+      if (args->sized)
+	for (int i = 0; i < n; i++)
+	  free_sized (arr[i], size);
+      else
+	for (int i = 0; i < n; i++)
+	  free (arr[i]);
     }
 
   TIMING_NOW (stop);
@@ -66,7 +71,7 @@ do_benchmark (malloc_args *args, int **arr)
   TIMING_DIFF (args->elapsed, start, stop);
 }
 
-static malloc_args tests[3][NUM_ALLOCS];
+static malloc_args tests[4][NUM_ALLOCS];
 static int allocs[NUM_ALLOCS] = { 25, 100, 400, MAX_ALLOCS };
 
 static void *
@@ -87,12 +92,13 @@ bench (unsigned long size)
   size_t iters = NUM_ITERS;
   int **arr = (int**) malloc (MAX_ALLOCS * sizeof (void*));
 
-  for (int t = 0; t < 3; t++)
+  for (int t = 0; t < 4; t++)
     for (int i = 0; i < NUM_ALLOCS; i++)
       {
 	tests[t][i].n = allocs[i];
 	tests[t][i].size = size;
 	tests[t][i].iters = iters / allocs[i];
+	tests[t][i].sized = t == 3;
 
 	/* Do a quick warmup run.  */
 	if (t == 0)
@@ -103,6 +109,10 @@ bench (unsigned long size)
   for (int i = 0; i < NUM_ALLOCS; i++)
     do_benchmark (&tests[0][i], arr);
 
+  /* Repeat it using free_sized.  */
+  for (int i = 0; i < NUM_ALLOCS; i++)
+    do_benchmark (&tests[3][i], arr);
+
   /* Run benchmark in a thread_arena.  */
   pthread_t t;
   pthread_create (&t, NULL, thread_test, (void*)arr);
@@ -142,6 +152,12 @@ bench (unsigned long size)
       json_attr_double (&json_ctx, s, tests[0][i].elapsed / iters2);
     }
 
+  for (int i = 0; i < NUM_ALLOCS; i++)
+    {
+      sprintf (s, "main_arena_st_sized_allocs_%04d_time", allocs[i]);
+      json_attr_double (&json_ctx, s, tests[3][i].elapsed / iters2);
+    }
+
   for (int i = 0; i < NUM_ALLOCS; i++)
     {
       sprintf (s, "main_arena_mt_allocs_%04d_time", allocs[i]);
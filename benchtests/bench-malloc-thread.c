@@ -20,6 +20,7 @@
 #include <math.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -145,10 +146,122 @@ malloc_benchmark_loop (void **ptr_arr)
   return iters;
 }
 
+/* Number of blocks allocated back to back in burst mode, and the
+   largest of them, so that they are served by the thread cache.  */
+#define BURST_LENGTH		128
+#define BURST_MAX_SIZE		1024
+
+/* Allocate a burst of small blocks, then free all of them, as a
+   request handler does.  */
+static size_t
+burst_benchmark_loop (void **ptr_arr)
+{
+  unsigned int block_state = 0;
+  size_t iters = 0;
+
+  while (!timeout)
+    {
+      for (size_t i = 0; i < BURST_LENGTH; i++)
+	{
+	  unsigned int size = get_random_block_size (&block_state);
+	  ptr_arr[i] = malloc (size < BURST_MAX_SIZE ? size : BURST_MAX_SIZE);
+	}
+
+      for (size_t i = 0; i < BURST_LENGTH; i++)
+	free (ptr_arr[i]);
+
+      iters += BURST_LENGTH;
+    }
+
+  return iters;
+}
+
+/* Benchmark modes.  In the default mode each thread frees only the
+   blocks it allocated.  In cross mode the threads are paired, one
+   thread of each pair allocating blocks and passing them through a
+   ring buffer to the other thread, which frees them.  In burst mode
+   each thread allocates a series of small blocks and then frees all
+   of them.  */
+enum bench_mode
+{
+  MODE_LOCAL,
+  MODE_CROSS,
+  MODE_BURST,
+};
+
+static const char *const mode_names[] =
+{
+  [MODE_LOCAL] = "local",
+  [MODE_CROSS] = "cross",
+  [MODE_BURST] = "burst",
+};
+
+static enum bench_mode bench_mode = MODE_LOCAL;
+
+/* Single-producer single-consumer queue of blocks in cross mode.  */
+#define RING_SIZE	256
+
+struct block_ring
+{
+  void *slots[RING_SIZE];
+  size_t head __attribute__ ((aligned (64)));
+  size_t tail __attribute__ ((aligned (64)));
+};
+
+/* Allocate blocks and hand them over to the consumer thread.  */
+static size_t
+producer_loop (struct block_ring *ring)
+{
+  unsigned int block_state = 0;
+  size_t iters = 0;
+
+  while (!timeout)
+    {
+      void *block = malloc (get_random_block_size (&block_state));
+      size_t head = __atomic_load_n (&ring->head, __ATOMIC_RELAXED);
+
+      while (head - __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE)
+	     == RING_SIZE)
+	if (timeout)
+	  {
+	    free (block);
+	    return iters;
+	  }
+
+      ring->slots[head % RING_SIZE] = block;
+      __atomic_store_n (&ring->head, head + 1, __ATOMIC_RELEASE);
+      iters++;
+    }
+
+  return iters;
+}
+
+/* Free the blocks allocated by the producer thread.  */
+static size_t
+consumer_loop (struct block_ring *ring)
+{
+  size_t iters = 0;
+
+  while (!timeout)
+    {
+      size_t tail = __atomic_load_n (&ring->tail, __ATOMIC_RELAXED);
+      if (__atomic_load_n (&ring->head, __ATOMIC_ACQUIRE) == tail)
+	continue;
+
+      free (ring->slots[tail % RING_SIZE]);
+      __atomic_store_n (&ring->tail, tail + 1, __ATOMIC_RELEASE);
+      iters++;
+    }
+
+  return iters;
+}
+
 struct thread_args
 {
   size_t iters;
   void **working_set;
+  struct block_ring *ring;
+  bool producer;
   timing_t elapsed;
 };
 
@@ -161,7 +274,14 @@ benchmark_thread (void *arg)
   timing_t start, stop;
 
   TIMING_NOW (start);
-  iters = malloc_benchmark_loop (thread_set);
+  if (bench_mode == MODE_BURST)
+    iters = burst_benchmark_loop (thread_set);
+  else if (args->ring == NULL)
+    iters = malloc_benchmark_loop (thread_set);
+  else if (args->producer)
+    iters = producer_loop (args->ring);
+  else
+    iters = consumer_loop (args->ring);
   TIMING_NOW (stop);
 
   TIMING_DIFF (args->elapsed, start, stop);
@@ -175,7 +295,39 @@ do_benchmark (size_t num_threads, size_t *iters)
 {
   timing_t elapsed = 0;
 
-  if (num_threads == 1)
+  if (bench_mode == MODE_CROSS)
+    {
+      struct thread_args args[num_threads];
+      struct block_ring rings[num_threads / 2];
+      pthread_t threads[num_threads];
+
+      memset (rings, 0, sizeof (rings));
+
+      *iters = 0;
+
+      for (size_t i = 0; i < num_threads; i++)
+	{
+	  args[i].working_set = NULL;
+	  args[i].ring = &rings[i / 2];
+	  args[i].producer = (i % 2) == 0;
+	  pthread_create(&threads[i], NULL, benchmark_thread, &args[i]);
+	}
+
+      for (size_t i = 0; i < num_threads; i++)
+	{
+	  pthread_join(threads[i], NULL);
+	  TIMING_ACCUM (elapsed, args[i].elapsed);
+	  /* Count each block once, when it is freed.  */
+	  if (!args[i].producer)
+	    *iters += args[i].iters;
+	}
+
+      /* Release the blocks still queued when the benchmark stopped.  */
+      for (size_t i = 0; i < num_threads / 2; i++)
+	for (size_t t = rings[i].tail; t != rings[i].head; t++)
+	  free (rings[i].slots[t % RING_SIZE]);
+    }
+  else if (num_threads == 1)
     {
       timing_t start, stop;
       void *working_set[WORKING_SET_SIZE];
@@ -183,7 +335,10 @@ do_benchmark (size_t num_threads, size_t *iters)
       memset (working_set, 0, sizeof (working_set));
 
       TIMING_NOW (start);
-      *iters = malloc_benchmark_loop (working_set);
+      if (bench_mode == MODE_BURST)
+	*iters = burst_benchmark_loop (working_set);
+      else
+	*iters = malloc_benchmark_loop (working_set);
       TIMING_NOW (stop);
 
       TIMING_DIFF (elapsed, start, stop);
@@ -201,6 +356,7 @@ do_benchmark (size_t num_threads, size_t *iters)
       for (size_t i = 0; i < num_threads; i++)
 	{
 	  args[i].working_set = working_set[i];
+	  args[i].ring = NULL;
 	  pthread_create(&threads[i], NULL, benchmark_thread, &args[i]);
 	}
 
@@ -216,7 +372,7 @@ do_benchmark (size_t num_threads, size_t *iters)
 
 static void usage(const char *name)
 {
-  fprintf (stderr, "%s: <num_threads>\n", name);
+  fprintf (stderr, "%s: <num_threads> [local|cross|burst]\n", name);
   exit (1);
 }
 
@@ -231,7 +387,7 @@ main (int argc, char **argv)
 
   if (argc == 1)
     num_threads = 1;
-  else if (argc == 2)
+  else if (argc == 2 || argc == 3)
     {
       long ret;
 
@@ -242,10 +398,24 @@ main (int argc, char **argv)
 	usage(argv[0]);
 
       num_threads = ret;
+
+      if (argc == 3)
+	{
+	  if (strcmp (argv[2], "cross") == 0)
+	    bench_mode = MODE_CROSS;
+	  else if (strcmp (argv[2], "burst") == 0)
+	    bench_mode = MODE_BURST;
+	  else if (strcmp (argv[2], "local") != 0)
+	    usage(argv[0]);
+	}
     }
   else
     usage(argv[0]);
 
+  /* Cross mode needs an allocating and a freeing thread per pair.  */
+  if (bench_mode == MODE_CROSS && num_threads % 2 != 0)
+    usage(argv[0]);
+
   init_random_values ();
 
   json_init (&json_ctx, 0, stdout);
@@ -281,6 +451,7 @@ main (int argc, char **argv)
   json_attr_double (&json_ctx, "max_rss", usage.ru_maxrss);
 
   json_attr_double (&json_ctx, "threads", num_threads);
+  json_attr_string (&json_ctx, "mode", mode_names[bench_mode]);
   json_attr_double (&json_ctx, "min_size", MIN_ALLOCATION_SIZE);
   json_attr_double (&json_ctx, "max_size", MAX_ALLOCATION_SIZE);
   json_attr_double (&json_ctx, "random_seed", RAND_SEED);
@@ -24,7 +24,9 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <stdbool.h>
 #include <stdatomic.h>
 #include <sys/time.h>
 #include <math.h>
@@ -411,6 +413,138 @@ test_consumer_producer (long iters, int filler)
   return cur;
 }
 
+/* The contended mutex tests run CONTENDED_THREADS threads at most,
+   pinned to CPUs taken in turn from each NUMA node, so that the lock
+   and the data protected by it move between nodes as soon as there
+   are threads on more than one node.  */
+#define CONTENDED_THREADS 8
+
+static int contended_cpus[CONTENDED_THREADS];
+static int contended_nthreads;
+static pthread_barrier_t contended_barrier;
+
+static void
+init_contended_cpus (void)
+{
+  static int cpus[CPU_SETSIZE], nodes[CPU_SETSIZE];
+  static bool used[CPU_SETSIZE];
+  cpu_set_t all, one;
+  int n = 0, max_node = 0;
+
+  if (sched_getaffinity (0, sizeof (all), &all) != 0)
+    return;
+
+  /* Find the node of every CPU by running on it.  */
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET (cpu, &all))
+      {
+	unsigned int c, node;
+	CPU_ZERO (&one);
+	CPU_SET (cpu, &one);
+	if (sched_setaffinity (0, sizeof (one), &one) != 0
+	    || getcpu (&c, &node) != 0)
+	  node = 0;
+	cpus[n] = cpu;
+	nodes[n] = node;
+	if (node > max_node)
+	  max_node = node;
+	++n;
+      }
+  sched_setaffinity (0, sizeof (all), &all);
+
+  while (contended_nthreads < CONTENDED_THREADS && contended_nthreads < n)
+    for (int node = 0; node <= max_node; ++node)
+      for (int i = 0; i < n; ++i)
+	if (!used[i] && nodes[i] == node)
+	  {
+	    used[i] = true;
+	    if (contended_nthreads < CONTENDED_THREADS)
+	      contended_cpus[contended_nthreads++] = cpus[i];
+	    break;
+	  }
+}
+
+typedef struct Contended_Params {
+  long iters;
+  int filler;
+} Contended_Params;
+
+static void *
+test_contended_thread (void *v)
+{
+  Contended_Params *p = (Contended_Params *) v;
+  int filler = p->filler;
+
+  pthread_barrier_wait (&contended_barrier);
+  for (long j = p->iters; j > 0; --j)
+    {
+      pthread_mutex_lock (&m);
+      FILLER_GOES_HERE;
+      pthread_mutex_unlock (&m);
+    }
+
+  return NULL;
+}
+
+static timing_t
+test_mutex_contended_kind (long iters, int filler, int kind)
+{
+  timing_t start, stop, cur;
+  pthread_t threads[CONTENDED_THREADS];
+  pthread_mutexattr_t mattr;
+  pthread_attr_t attr;
+  cpu_set_t set;
+  Contended_Params p;
+
+  pthread_mutexattr_init (&mattr);
+  pthread_mutexattr_settype (&mattr, kind);
+  pthread_mutex_init (&m, &mattr);
+  pthread_mutexattr_destroy (&mattr);
+
+  p.iters = iters / contended_nthreads + 1;
+  p.filler = filler;
+  pthread_barrier_init (&contended_barrier, NULL, contended_nthreads + 1);
+  pthread_attr_init (&attr);
+  for (int i = 0; i < contended_nthreads; ++i)
+    {
+      CPU_ZERO (&set);
+      CPU_SET (contended_cpus[i], &set);
+      pthread_attr_setaffinity_np (&attr, sizeof (set), &set);
+      pthread_create (&threads[i], &attr, test_contended_thread, &p);
+    }
+  pthread_attr_destroy (&attr);
+
+  pthread_barrier_wait (&contended_barrier);
+  TIMING_NOW (start);
+  for (int i = 0; i < contended_nthreads; ++i)
+    pthread_join (threads[i], NULL);
+  TIMING_NOW (stop);
+  TIMING_DIFF (cur, start, stop);
+
+  pthread_barrier_destroy (&contended_barrier);
+  pthread_mutex_destroy (&m);
+  return cur;
+}
+
+static timing_t
+test_mutex_contended (long iters, int filler)
+{
+  return test_mutex_contended_kind (iters, filler, PTHREAD_MUTEX_NORMAL);
+}
+
+static timing_t
+test_mutex_contended_adaptive (long iters, int filler)
+{
+  return test_mutex_contended_kind (iters, filler,
+				    PTHREAD_MUTEX_ADAPTIVE_NP);
+}
+
+static timing_t
+test_mutex_contended_cohort (long iters, int filler)
+{
+  return test_mutex_contended_kind (iters, filler, PTHREAD_MUTEX_COHORT_NP);
+}
+
 /* Number of runs we use for computing mean and standard deviation.
    We actually do two additional runs and discard the outliers.  */
 #define RUN_COUNT 10
@@ -542,6 +676,14 @@ do_bench (void)
   BENCH (condvar);
   BENCH (consumer_producer);
 
+  init_contended_cpus ();
+  if (contended_nthreads > 1)
+    {
+      BENCH (mutex_contended);
+      BENCH (mutex_contended_adaptive);
+      BENCH (mutex_contended_cohort);
+    }
+
   json_attr_object_end (&json_ctx);
 
   return rv;
@@ -0,0 +1,133 @@
+/* Measure the fork-join throughput of pthread_pool_np pools.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Compute Fibonacci numbers recursively, running one of the two
+   recursive calls of each level above CUTOFF as a separate task and
+   waiting for it, on pools with different numbers of workers.  This
+   stresses the deques of the workers, stealing and the waiting of
+   workers for groups of tasks.  The "sequential" variant runs the same
+   recursion without the pool.  The mean is the time per task.  */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define FIB_N 30
+#define CUTOFF 10
+
+static const unsigned int worker_counts[] = { 1, 2, 4, 8 };
+
+static pthread_pool_np_t *pool;
+
+struct fib
+{
+  unsigned int n;
+  unsigned long int result;
+};
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-pthread-pool-forkjoin: %s failed\n", what);
+  exit (1);
+}
+
+static unsigned long int
+fib_sequential (unsigned int n)
+{
+  return n < 2 ? n : fib_sequential (n - 1) + fib_sequential (n - 2);
+}
+
+static void
+fib_task (void *closure)
+{
+  struct fib *f = closure;
+  if (f->n <= CUTOFF)
+    {
+      f->result = fib_sequential (f->n);
+      return;
+    }
+  struct fib a = { f->n - 1, 0 };
+  struct fib b = { f->n - 2, 0 };
+  pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+  if (pthread_pool_submit_np (pool, &group, fib_task, &a) != 0)
+    fail ("pthread_pool_submit_np");
+  fib_task (&b);
+  pthread_pool_wait_np (pool, &group);
+  f->result = a.result + b.result;
+}
+
+/* Return the number of tasks for computing the Fibonacci number of N.  */
+static double
+count_tasks (unsigned int n)
+{
+  return n <= CUTOFF ? 0 : 1 + count_tasks (n - 1) + count_tasks (n - 2);
+}
+
+static void
+report (json_ctx_t *json_ctx, const char *name, timing_t elapsed)
+{
+  double tasks = count_tasks (FIB_N);
+  json_attr_object_begin (json_ctx, name);
+  json_attr_double (json_ctx, "duration", (double) elapsed);
+  json_attr_double (json_ctx, "iterations", tasks);
+  json_attr_double (json_ctx, "mean", (double) elapsed / tasks);
+  json_attr_object_end (json_ctx);
+}
+
+int
+main (int argc, char **argv)
+{
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 2, stdout);
+  json_attr_object_begin (&json_ctx, "pthread_pool_wait_np");
+
+  timing_t start, end, elapsed;
+  TIMING_NOW (start);
+  volatile unsigned long int result = fib_sequential (FIB_N);
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+  report (&json_ctx, "sequential", elapsed);
+
+  for (size_t i = 0; i < sizeof (worker_counts) / sizeof (worker_counts[0]);
+       ++i)
+    {
+      if (pthread_pool_create_np (&pool, worker_counts[i]) != 0)
+	fail ("pthread_pool_create_np");
+      struct fib f = { FIB_N, 0 };
+      pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+      TIMING_NOW (start);
+      if (pthread_pool_submit_np (pool, &group, fib_task, &f) != 0)
+	fail ("pthread_pool_submit_np");
+      pthread_pool_wait_np (pool, &group);
+      TIMING_NOW (end);
+      TIMING_DIFF (elapsed, start, end);
+      if (f.result != result)
+	fail ("fib_task");
+      pthread_pool_destroy_np (pool);
+
+      char name[32];
+      snprintf (name, sizeof (name), "workers-%u", worker_counts[i]);
+      report (&json_ctx, name, elapsed);
+    }
+
+  json_attr_object_end (&json_ctx);
+  return 0;
+}
@@ -0,0 +1,145 @@
+/* Measure the latency of running a task on a pthread_pool_np pool.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The "external" variants submit an empty task from a thread which is
+   not a worker of the pool and wait for it, so they measure the
+   round trip through the injection queue, including the wake-up of a
+   sleeping worker when the task arrives after the workers have stopped
+   spinning ("external-idle").  The "worker" variant does the same from
+   a task, which pushes to and pops from the deque of the worker.  The
+   "thread" variant creates and joins a thread per task, for
+   comparison.  */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define ITERATIONS 20000
+#define IDLE_ITERATIONS 200
+
+static pthread_pool_np_t *pool;
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-pthread-pool-spawn: %s failed\n", what);
+  exit (1);
+}
+
+static void
+empty_task (void *closure)
+{
+}
+
+static void
+spawn_and_wait (unsigned int iterations, unsigned int sleep_us)
+{
+  for (unsigned int i = 0; i < iterations; ++i)
+    {
+      pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+      if (sleep_us != 0)
+	usleep (sleep_us);
+      if (pthread_pool_submit_np (pool, &group, empty_task, NULL) != 0)
+	fail ("pthread_pool_submit_np");
+      pthread_pool_wait_np (pool, &group);
+    }
+}
+
+static void
+worker_task (void *closure)
+{
+  spawn_and_wait (ITERATIONS, 0);
+}
+
+static void *
+empty_thread (void *closure)
+{
+  return NULL;
+}
+
+static void
+report (json_ctx_t *json_ctx, const char *name, timing_t elapsed,
+	unsigned int iterations)
+{
+  json_attr_object_begin (json_ctx, name);
+  json_attr_double (json_ctx, "duration", (double) elapsed);
+  json_attr_double (json_ctx, "iterations", iterations);
+  json_attr_double (json_ctx, "mean", (double) elapsed / iterations);
+  json_attr_object_end (json_ctx);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (pthread_pool_create_np (&pool, 0) != 0)
+    fail ("pthread_pool_create_np");
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 2, stdout);
+  json_attr_object_begin (&json_ctx, "pthread_pool_submit_np");
+
+  timing_t start, end, elapsed;
+
+  TIMING_NOW (start);
+  spawn_and_wait (ITERATIONS, 0);
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+  report (&json_ctx, "external", elapsed, ITERATIONS);
+
+  /* The sleep is included in the time, so subtract it.  */
+  timing_t sleep_time;
+  TIMING_NOW (start);
+  for (unsigned int i = 0; i < IDLE_ITERATIONS; ++i)
+    usleep (1000);
+  TIMING_NOW (end);
+  TIMING_DIFF (sleep_time, start, end);
+  TIMING_NOW (start);
+  spawn_and_wait (IDLE_ITERATIONS, 1000);
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+  report (&json_ctx, "external-idle",
+	  elapsed > sleep_time ? elapsed - sleep_time : 0, IDLE_ITERATIONS);
+
+  pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+  TIMING_NOW (start);
+  if (pthread_pool_submit_np (pool, &group, worker_task, NULL) != 0)
+    fail ("pthread_pool_submit_np");
+  pthread_pool_wait_np (pool, &group);
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+  report (&json_ctx, "worker", elapsed, ITERATIONS);
+
+  TIMING_NOW (start);
+  for (unsigned int i = 0; i < ITERATIONS; ++i)
+    {
+      pthread_t thr;
+      if (pthread_create (&thr, NULL, empty_thread, NULL) != 0)
+	fail ("pthread_create");
+      pthread_join (thr, NULL);
+    }
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+  report (&json_ctx, "thread", elapsed, ITERATIONS);
+
+  json_attr_object_end (&json_ctx);
+  pthread_pool_destroy_np (pool);
+  return 0;
+}
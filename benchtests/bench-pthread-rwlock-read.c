@@ -0,0 +1,129 @@
+/* Measure the read lock throughput of rwlocks.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Each of NTHREADS threads acquires and releases a read lock on a shared
+   rwlock ITERATIONS times, for the default kind and for
+   PTHREAD_RWLOCK_READER_BIASED_NP.  With the default kind, all readers
+   modify the cache line of the rwlock.  The "write-every" variants also
+   take a write lock every WRITE_INTERVAL read locks in each thread, which
+   revokes the bias of the reader-biased kind.  */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define ITERATIONS 1000000
+#define WRITE_INTERVAL 10000
+
+static const unsigned int thread_counts[] = { 1, 2, 4, 8 };
+
+static pthread_rwlock_t lock;
+static pthread_barrier_t barrier;
+static unsigned int write_interval;
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-pthread-rwlock-read: %s failed\n", what);
+  exit (1);
+}
+
+static void *
+reader (void *closure)
+{
+  pthread_barrier_wait (&barrier);
+  for (unsigned int i = 1; i <= ITERATIONS; ++i)
+    {
+      if (write_interval != 0 && i % write_interval == 0)
+	pthread_rwlock_wrlock (&lock);
+      else
+	pthread_rwlock_rdlock (&lock);
+      pthread_rwlock_unlock (&lock);
+    }
+  return NULL;
+}
+
+/* Run the readers and return the time until all of them have
+   finished.  */
+static timing_t
+run (int kind, unsigned int nthreads)
+{
+  pthread_rwlockattr_t attr;
+  pthread_rwlockattr_init (&attr);
+  if (pthread_rwlockattr_setkind_np (&attr, kind) != 0)
+    fail ("pthread_rwlockattr_setkind_np");
+  pthread_rwlock_init (&lock, &attr);
+  pthread_rwlockattr_destroy (&attr);
+  pthread_barrier_init (&barrier, NULL, nthreads + 1);
+
+  pthread_t threads[nthreads];
+  for (unsigned int i = 0; i < nthreads; ++i)
+    if (pthread_create (&threads[i], NULL, reader, NULL) != 0)
+      fail ("pthread_create");
+
+  timing_t start, end, elapsed;
+  TIMING_NOW (start);
+  pthread_barrier_wait (&barrier);
+  for (unsigned int i = 0; i < nthreads; ++i)
+    pthread_join (threads[i], NULL);
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+
+  pthread_barrier_destroy (&barrier);
+  pthread_rwlock_destroy (&lock);
+  return elapsed;
+}
+
+static void
+report (json_ctx_t *json_ctx, const char *kind_name, int kind,
+	unsigned int nthreads, unsigned int interval)
+{
+  char name[64];
+  snprintf (name, sizeof (name), "%s%s-%u", kind_name,
+	    interval != 0 ? "-write-every" : "", nthreads);
+  write_interval = interval;
+  timing_t elapsed = run (kind, nthreads);
+  double iterations = (double) ITERATIONS * nthreads;
+  json_attr_object_begin (json_ctx, name);
+  json_attr_double (json_ctx, "duration", (double) elapsed);
+  json_attr_double (json_ctx, "iterations", iterations);
+  json_attr_double (json_ctx, "mean", (double) elapsed / iterations);
+  json_attr_object_end (json_ctx);
+}
+
+int
+main (int argc, char **argv)
+{
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 2, stdout);
+  json_attr_object_begin (&json_ctx, "pthread_rwlock_rdlock");
+  for (unsigned int interval = 0; interval <= WRITE_INTERVAL;
+       interval += WRITE_INTERVAL)
+    for (size_t i = 0; i < sizeof (thread_counts) / sizeof (thread_counts[0]);
+	 ++i)
+      {
+	report (&json_ctx, "default", PTHREAD_RWLOCK_DEFAULT_NP,
+		thread_counts[i], interval);
+	report (&json_ctx, "reader-biased", PTHREAD_RWLOCK_READER_BIASED_NP,
+		thread_counts[i], interval);
+      }
+  json_attr_object_end (&json_ctx);
+  return 0;
+}
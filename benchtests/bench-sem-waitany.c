@@ -0,0 +1,219 @@
+/* Measure the wake-up latency of sem_clockwaitany_np.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The main thread posts one of NSEMS semaphores in turn, and waits until
+   a consumer thread has noticed the post and acknowledged it.  The
+   consumer either waits on all semaphores with sem_clockwaitany_np, or
+   uses the usual workaround without it: one forwarding thread per
+   semaphore waits on its semaphore and then posts a semaphore on which
+   the consumer waits.  The latency is the time per round trip.  */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench-timing.h"
+#include "json-lib.h"
+
+#define ITERATIONS 20000
+
+static const unsigned int sem_counts[] = { 2, 8, 32 };
+
+#define MAX_SEMS 32
+
+static sem_t sem_storage[MAX_SEMS];
+static sem_t *sems[MAX_SEMS];
+static unsigned int nsems;
+static sem_t ack;
+static sem_t forwarded;
+static atomic_uint last_index;
+static atomic_bool stop;
+
+static void __attribute__ ((noreturn))
+fail (const char *what)
+{
+  fprintf (stderr, "bench-sem-waitany: %s failed: %m\n", what);
+  exit (1);
+}
+
+static void
+xsem_wait (sem_t *sem)
+{
+  while (sem_wait (sem) != 0)
+    if (errno != EINTR)
+      fail ("sem_wait");
+}
+
+static void *
+waitany_consumer (void *closure)
+{
+  while (true)
+    {
+      int r = sem_clockwaitany_np (sems, nsems, CLOCK_MONOTONIC, NULL);
+      if (r < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  fail ("sem_clockwaitany_np");
+	}
+      if (atomic_load_explicit (&stop, memory_order_relaxed))
+	break;
+      atomic_store_explicit (&last_index, r, memory_order_relaxed);
+      sem_post (&ack);
+    }
+  return NULL;
+}
+
+static void *
+forwarder (void *closure)
+{
+  unsigned int i = (uintptr_t) closure;
+  while (true)
+    {
+      xsem_wait (sems[i]);
+      if (atomic_load_explicit (&stop, memory_order_relaxed))
+	break;
+      atomic_store_explicit (&last_index, i, memory_order_relaxed);
+      sem_post (&forwarded);
+    }
+  return NULL;
+}
+
+static void *
+forwarded_consumer (void *closure)
+{
+  while (true)
+    {
+      xsem_wait (&forwarded);
+      if (atomic_load_explicit (&stop, memory_order_relaxed))
+	break;
+      sem_post (&ack);
+    }
+  return NULL;
+}
+
+/* Run the round trips for COUNT semaphores, and return the time they
+   took.  */
+static timing_t
+run (unsigned int count, bool waitany)
+{
+  nsems = count;
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      if (sem_init (&sem_storage[i], 0, 0) != 0)
+	fail ("sem_init");
+      sems[i] = &sem_storage[i];
+    }
+  sem_init (&ack, 0, 0);
+  sem_init (&forwarded, 0, 0);
+  atomic_store (&stop, false);
+
+  pthread_t threads[MAX_SEMS + 1];
+  unsigned int nthreads = 0;
+  if (waitany)
+    {
+      if (pthread_create (&threads[nthreads++], NULL, waitany_consumer,
+			  NULL) != 0)
+	fail ("pthread_create");
+    }
+  else
+    {
+      if (pthread_create (&threads[nthreads++], NULL, forwarded_consumer,
+			  NULL) != 0)
+	fail ("pthread_create");
+      for (unsigned int i = 0; i < count; ++i)
+	if (pthread_create (&threads[nthreads++], NULL, forwarder,
+			    (void *) (uintptr_t) i) != 0)
+	  fail ("pthread_create");
+    }
+
+  timing_t start, end, elapsed;
+  TIMING_NOW (start);
+  for (unsigned int i = 0; i < ITERATIONS; ++i)
+    {
+      sem_post (sems[i % count]);
+      xsem_wait (&ack);
+      if (atomic_load_explicit (&last_index, memory_order_relaxed)
+	  != i % count)
+	{
+	  fprintf (stderr, "bench-sem-waitany: wrong semaphore\n");
+	  exit (1);
+	}
+    }
+  TIMING_NOW (end);
+  TIMING_DIFF (elapsed, start, end);
+
+  atomic_store (&stop, true);
+  for (unsigned int i = 0; i < count; ++i)
+    sem_post (sems[i]);
+  sem_post (&forwarded);
+  for (unsigned int i = 0; i < nthreads; ++i)
+    pthread_join (threads[i], NULL);
+
+  for (unsigned int i = 0; i < count; ++i)
+    sem_destroy (sems[i]);
+  sem_destroy (&ack);
+  sem_destroy (&forwarded);
+  return elapsed;
+}
+
+static void
+report (json_ctx_t *json_ctx, unsigned int count, bool waitany)
+{
+  char name[32];
+  snprintf (name, sizeof (name), "%s-%u",
+	    waitany ? "waitany" : "forwarding", count);
+  timing_t elapsed = run (count, waitany);
+  json_attr_object_begin (json_ctx, name);
+  json_attr_double (json_ctx, "duration", (double) elapsed);
+  json_attr_double (json_ctx, "iterations", ITERATIONS);
+  json_attr_double (json_ctx, "latency", (double) elapsed / ITERATIONS);
+  json_attr_object_end (json_ctx);
+}
+
+int
+main (int argc, char **argv)
+{
+  /* sem_clockwaitany_np needs futex_waitv for more than one
+     semaphore.  */
+  for (unsigned int i = 0; i < 2; ++i)
+    {
+      sem_init (&sem_storage[i], 0, 0);
+      sems[i] = &sem_storage[i];
+    }
+  struct timespec ts = { 0, 0 };
+  bool have_waitany = (sem_clockwaitany_np (sems, 2, CLOCK_MONOTONIC, &ts)
+		       == 0 || errno != ENOSYS);
+
+  json_ctx_t json_ctx;
+  json_init (&json_ctx, 2, stdout);
+  json_attr_object_begin (&json_ctx, "sem_clockwaitany_np");
+  for (size_t i = 0; i < sizeof (sem_counts) / sizeof (sem_counts[0]); ++i)
+    {
+      if (have_waitany)
+	report (&json_ctx, sem_counts[i], true);
+      report (&json_ctx, sem_counts[i], false);
+    }
+  json_attr_object_end (&json_ctx);
+  return 0;
+}
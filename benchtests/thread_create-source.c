@@ -19,6 +19,7 @@
    <https://www.gnu.org/licenses/>.  */
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <support/xthread.h>
 
@@ -30,29 +31,49 @@ thread_create_init (void)
   pgsize = sysconf (_SC_PAGESIZE);
 }
 
+/* Use ARG bytes of the stack, like a thread which does some work.  */
 static void *
 thread_dummy (void *arg)
 {
+  size_t touch = *(size_t *) arg;
+  if (touch > 0)
+    {
+      char buf[touch];
+      memset (buf, 0, touch);
+      /* Keep the compiler from removing the memset.  */
+      __asm__ volatile ("" : : "r" (buf) : "memory");
+    }
   return NULL;
 }
 
+/* Create NTHREADS threads and join them.  With NSIZES greater than 1,
+   the threads cycle through stacks of 1 to NSIZES times STACKSIZE
+   pages.  Each thread uses TOUCH pages of its stack.  */
 static void
-thread_create (int nthreads, size_t stacksize, size_t guardsize)
+thread_create (int nthreads, size_t stacksize, size_t guardsize,
+	       int nsizes, size_t touch)
 {
-  pthread_attr_t attr;
-  xpthread_attr_init (&attr);
+  pthread_attr_t attr[nsizes];
 
   stacksize = stacksize * pgsize;
   guardsize = guardsize * pgsize;
+  touch = touch * pgsize;
 
-  xpthread_attr_setstacksize (&attr, stacksize);
-  xpthread_attr_setguardsize (&attr, guardsize);
+  for (int i = 0; i < nsizes; i++)
+    {
+      xpthread_attr_init (&attr[i]);
+      xpthread_attr_setstacksize (&attr[i], stacksize * (i + 1));
+      xpthread_attr_setguardsize (&attr[i], guardsize);
+    }
 
   pthread_t ts[nthreads];
 
   for (int i = 0; i < nthreads; i++)
-    ts[i] = xpthread_create (&attr, thread_dummy, NULL);
+    ts[i] = xpthread_create (&attr[i % nsizes], thread_dummy, &touch);
 
   for (int i = 0; i < nthreads; i++)
     xpthread_join (ts[i]);
+
+  for (int i = 0; i < nsizes; i++)
+    xpthread_attr_destroy (&attr[i]);
 }
@@ -68,6 +68,19 @@ extern void *dlsym (void *__restrict __handle,
 /* Like `dlopen', but request object to be allocated in a new namespace.  */
 extern void *dlmopen (Lmid_t __nsid, const char *__file, int __mode) __THROWNL;
 
+/* Open the COUNT shared objects named in FILES with MODE, as if by
+   calling `dlopen' for each of them in turn, and store their handles
+   in HANDLES.  All the objects are loaded and relocated before the
+   initializers of any of them run.  With RTLD_GLOBAL, the relocation
+   of each object can bind to the objects named before it, but the
+   objects are only added to the global scope once all initializers
+   have run.  Returns zero on success.  On failure, returns -1 and
+   records an error message to be fetched with `dlerror'; none of the
+   objects remains open in this case.  */
+extern int dlopen_many (const char *const *__files, size_t __count,
+			int __mode, void **__handles)
+     __THROWNL __nonnull ((1, 4));
+
 /* Find the run-time address in the shared object HANDLE refers to
    of the symbol called NAME with VERSION.  */
 extern void *dlvsym (void *__restrict __handle,
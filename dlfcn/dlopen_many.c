@@ -0,0 +1,110 @@
+/* Load several shared objects at run time.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <libintl.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <ldsodefs.h>
+
+struct dlopen_many_args
+{
+  /* The arguments for dlopen_many_doit.  */
+  const char *const *files;
+  size_t count;
+  int mode;
+  void **handles;
+  /* Address of the caller.  */
+  const void *caller;
+};
+
+
+/* Non-shared code has no support for multiple namespaces.  */
+#ifdef SHARED
+# define NS __LM_ID_CALLER
+#else
+# define NS LM_ID_BASE
+#endif
+
+
+static void
+dlopen_many_doit (void *a)
+{
+  struct dlopen_many_args *args = (struct dlopen_many_args *) a;
+
+  if (args->mode & ~(RTLD_BINDING_MASK | RTLD_NOLOAD | RTLD_DEEPBIND
+		     | RTLD_GLOBAL | RTLD_LOCAL | RTLD_NODELETE))
+    _dl_signal_error (0, NULL, NULL, _("invalid mode parameter"));
+
+  /* Unlike dlopen, there is no way to refer to the main program, which
+     would have to be opened in the base namespace.  */
+  for (size_t i = 0; i < args->count; ++i)
+    if (args->files[i] == NULL)
+      _dl_signal_error (EINVAL, NULL, NULL, _("invalid file name"));
+
+  GLRO(dl_open_many) (args->files, args->count, args->mode | __RTLD_DLOPEN,
+		      args->caller, NS, args->handles,
+		      __libc_argc, __libc_argv, __environ);
+}
+
+
+static int
+dlopen_many_implementation (const char *const *files, size_t count, int mode,
+			    void **handles, void *dl_caller)
+{
+  struct dlopen_many_args args;
+  args.files = files;
+  args.count = count;
+  args.mode = mode;
+  args.handles = handles;
+  args.caller = dl_caller;
+
+  return _dlerror_run (dlopen_many_doit, &args) ? -1 : 0;
+}
+
+#ifdef SHARED
+int
+dlopen_many (const char *const *files, size_t count, int mode,
+	     void **handles)
+{
+  if (GLRO (dl_dlfcn_hook) != NULL)
+    return GLRO (dl_dlfcn_hook)->dlopen_many (files, count, mode, handles,
+					      RETURN_ADDRESS (0));
+  else
+    return dlopen_many_implementation (files, count, mode, handles,
+				       RETURN_ADDRESS (0));
+}
+#else /* !SHARED */
+/* Also used with _dlfcn_hook.  */
+int
+__dlopen_many (const char *const *files, size_t count, int mode,
+	       void **handles, void *dl_caller)
+{
+  return dlopen_many_implementation (files, count, mode, handles, dl_caller);
+}
+
+int
+___dlopen_many (const char *const *files, size_t count, int mode,
+		void **handles)
+{
+  return __dlopen_many (files, count, mode, handles, RETURN_ADDRESS (0));
+}
+weak_alias (___dlopen_many, dlopen_many)
+static_link_warning (dlopen_many)
+#endif /* !SHARED */
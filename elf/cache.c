@@ -447,6 +447,55 @@ enum
 			      * sizeof (struct cache_extension_section)))
   };
 
+/* Compute the contents of the cache_extension_tag_hash_index section
+   for the sorted list of entries.  Return the array of slots, and
+   store its size in bytes in *SIZE.  */
+static struct cache_hash_index_slot *
+make_hash_index (uint32_t *size)
+{
+  /* Count the distinct names.  */
+  uint32_t names = 0;
+  for (struct cache_entry *entry = entries, *prev = NULL; entry != NULL;
+       prev = entry, entry = entry->next)
+    if (prev == NULL
+	|| _dl_cache_libcmp (prev->lib->string, entry->lib->string) != 0)
+      ++names;
+  if (names == 0)
+    {
+      *size = 0;
+      return NULL;
+    }
+
+  /* Keep the load factor at or below one half, which also leaves at
+     least one empty slot.  */
+  uint32_t nslots = 2;
+  while (nslots < 2 * names)
+    nslots *= 2;
+  *size = nslots * sizeof (struct cache_hash_index_slot);
+  struct cache_hash_index_slot *slots = xmalloc (*size);
+  for (uint32_t i = 0; i < nslots; ++i)
+    {
+      slots[i].hash = 0;
+      slots[i].entry = cache_hash_index_empty;
+    }
+
+  /* Record the index of the first entry for every name.  */
+  uint32_t idx = 0;
+  for (struct cache_entry *entry = entries, *prev = NULL; entry != NULL;
+       prev = entry, entry = entry->next, ++idx)
+    if (prev == NULL
+	|| _dl_cache_libcmp (prev->lib->string, entry->lib->string) != 0)
+      {
+	uint32_t hash = _dl_cache_hash (entry->lib->string);
+	uint32_t i = hash & (nslots - 1);
+	while (slots[i].entry != cache_hash_index_empty)
+	  i = (i + 1) & (nslots - 1);
+	slots[i].hash = hash;
+	slots[i].entry = idx;
+      }
+  return slots;
+}
+
 /* Write the cache extensions to FD.  The string table is shifted by
    STRING_TABLE_OFFSET.  The extension directory is assumed to be
    located at CACHE_EXTENSION_OFFSET.  assign_glibc_hwcaps_indices
@@ -466,15 +515,22 @@ write_extensions (int fd, uint32_t str_offset,
     if (p->used)
       hwcaps_array[p->section_index] = str_offset + p->name->offset;
 
-  /* This is the offset of the generator string.  */
-  uint32_t generator_offset = hwcaps_offset;
+  /* The hash index follows the hwcaps subdirectories.  */
+  uint32_t hash_index_size;
+  struct cache_hash_index_slot *hash_index
+    = make_hash_index (&hash_index_size);
+
+  /* The section data starts after the directory entries which are
+     actually used.  */
   if (hwcaps_count == 0)
     /* There is no section for the hwcaps subdirectories.  */
-    generator_offset -= sizeof (struct cache_extension_section);
-  else
-    /* The string table indices for the hwcaps subdirectories shift
-       the generator string backwards.  */
-    generator_offset += hwcaps_size;
+    hwcaps_offset -= sizeof (struct cache_extension_section);
+  if (hash_index_size == 0)
+    hwcaps_offset -= sizeof (struct cache_extension_section);
+  uint32_t hash_index_offset = hwcaps_offset + hwcaps_size;
+
+  /* This is the offset of the generator string.  */
+  uint32_t generator_offset = hash_index_offset + hash_index_size;
 
   struct cache_extension *ext = xmalloc (cache_extension_size);
   ext->magic = cache_extension_magic;
@@ -498,6 +554,15 @@ write_extensions (int fd, uint32_t str_offset,
       ext->sections[xid].size = hwcaps_size;
     }
 
+  if (hash_index_size > 0)
+    {
+      ++xid;
+      ext->sections[xid].tag = cache_extension_tag_hash_index;
+      ext->sections[xid].flags = 0;
+      ext->sections[xid].offset = hash_index_offset;
+      ext->sections[xid].size = hash_index_size;
+    }
+
   ++xid;
   ext->count = xid;
   assert (xid <= cache_extension_count);
@@ -506,9 +571,11 @@ write_extensions (int fd, uint32_t str_offset,
 		     + xid * sizeof (struct cache_extension_section));
   if (write (fd, ext, ext_size) != ext_size
       || write (fd, hwcaps_array, hwcaps_size) != hwcaps_size
+      || write (fd, hash_index, hash_index_size) != hash_index_size
       || write (fd, generator, strlen (generator)) != strlen (generator))
     error (EXIT_FAILURE, errno, _("Writing of cache extension data failed"));
 
+  free (hash_index);
   free (hwcaps_array);
   free (ext);
 }
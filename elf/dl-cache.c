@@ -36,6 +36,11 @@ static struct cache_file *cache;
 static struct cache_file_new *cache_new;
 static size_t cachesize;
 
+/* The cache_extension_tag_hash_index section of the cache, or NULL if
+   there is none.  */
+static const struct cache_hash_index_slot *cache_hash_slots;
+static uint32_t cache_hash_nslots;
+
 #ifdef SHARED
 /* This is used to cache the priorities of glibc-hwcaps
    subdirectories.  The elements of _dl_cache_priorities correspond to
@@ -191,15 +196,18 @@ _dl_cache_file_entry (const struct file_entry *libs, size_t entry_size,
   return (const void *) libs + index * entry_size;
 }
 
-/* We use binary search since the table is sorted in the cache file.
-   The first matching entry in the table is returned.  It is important
-   to use the same algorithm as used while generating the cache file.
+/* Find the first entry for NAME in the table, which is sorted in the
+   cache file, using the hash index HASH_SLOTS with HASH_NSLOTS slots
+   if it is not NULL, and binary search otherwise.  The entries for
+   NAME are then searched for the best match.  It is important to use
+   the same algorithm as used while generating the cache file.
    STRING_TABLE_SIZE indicates the maximum offset in STRING_TABLE at
    which data is mapped; it is not exact.  */
 static const char *
 search_cache (const char *string_table, uint32_t string_table_size,
 	      struct file_entry *libs, uint32_t nlibs, uint32_t entry_size,
-	      const char *name)
+	      const struct cache_hash_index_slot *hash_slots,
+	      uint32_t hash_nslots, const char *name)
 {
   /* Used by the HWCAP check in the struct file_entry_new case.  */
   uint64_t platform = _dl_string_platform (GLRO (dl_platform));
@@ -210,144 +218,156 @@ search_cache (const char *string_table, uint32_t string_table_size,
   uint64_t hwcap_exclude = ~((GLRO (dl_hwcap) & hwcap_mask)
 			     | _DL_HWCAP_PLATFORM | _DL_HWCAP_TLS_MASK);
 
-  int left = 0;
-  int right = nlibs - 1;
   const char *best = NULL;
 #ifdef SHARED
   uint32_t best_priority = 0;
 #endif
 
-  while (left <= right)
+  int middle;
+  if (hash_slots != NULL)
     {
-      int middle = (left + right) / 2;
-      uint32_t key = _dl_cache_file_entry (libs, entry_size, middle)->key;
-
-      /* Make sure string table indices are not bogus before using
-	 them.  */
-      if (!_dl_cache_verify_ptr (key, string_table_size))
+      middle = cache_hash_index_lookup (hash_slots, hash_nslots,
+					string_table, string_table_size,
+					libs, nlibs, entry_size, name);
+      if (middle < 0)
 	return NULL;
+    }
+  else
+    {
+      int left = 0;
+      int right = nlibs - 1;
+      while (true)
+	{
+	  if (left > right)
+	    return NULL;
+
+	  middle = (left + right) / 2;
+	  uint32_t key = _dl_cache_file_entry (libs, entry_size, middle)->key;
+
+	  /* Make sure string table indices are not bogus before using
+	     them.  */
+	  if (!_dl_cache_verify_ptr (key, string_table_size))
+	    return NULL;
+
+	  /* Actually compare the entry with the key.  */
+	  int cmpres = _dl_cache_libcmp (name, string_table + key);
+	  if (__glibc_unlikely (cmpres == 0))
+	    break;
+	  if (cmpres < 0)
+	    left = middle + 1;
+	  else
+	    right = middle - 1;
+	}
 
-      /* Actually compare the entry with the key.  */
-      int cmpres = _dl_cache_libcmp (name, string_table + key);
-      if (__glibc_unlikely (cmpres == 0))
+      /* There might be entries with this name before the one we
+	 found.  So we have to find the beginning.  */
+      while (middle > 0)
 	{
-	  /* Found it.  LEFT now marks the last entry for which we
-	     know the name is correct.  */
-	  left = middle;
+	  uint32_t key
+	    = _dl_cache_file_entry (libs, entry_size, middle - 1)->key;
+	  /* Make sure string table indices are not bogus before using
+	     them.  */
+	  if (!_dl_cache_verify_ptr (key, string_table_size)
+	      /* Actually compare the entry.  */
+	      || _dl_cache_libcmp (name, string_table + key) != 0)
+	    break;
+	  --middle;
+	}
+    }
 
-	  /* There might be entries with this name before the one we
-	     found.  So we have to find the beginning.  */
-	  while (middle > 0)
-	    {
-	      key = _dl_cache_file_entry (libs, entry_size, middle - 1)->key;
-	      /* Make sure string table indices are not bogus before
-		 using them.  */
-	      if (!_dl_cache_verify_ptr (key, string_table_size)
-		  /* Actually compare the entry.  */
-		  || _dl_cache_libcmp (name, string_table + key) != 0)
-		break;
-	      --middle;
-	    }
+  /* MIDDLE is now the first entry for NAME.  */
+  int first = middle;
+  do
+    {
+      int flags;
+      const struct file_entry *lib
+	= _dl_cache_file_entry (libs, entry_size, middle);
+
+      /* Only perform the name test if necessary.  */
+      if (middle > first
+	  /* We haven't seen this string so far.  Test whether the
+	     index is ok and whether the name matches.  Otherwise
+	     we are done.  */
+	  && (! _dl_cache_verify_ptr (lib->key, string_table_size)
+	      || (_dl_cache_libcmp (name, string_table + lib->key)
+		  != 0)))
+	break;
+
+      flags = lib->flags;
+      if (_dl_cache_check_flags (flags)
+	  && _dl_cache_verify_ptr (lib->value, string_table_size))
+	{
+	  /* Named/extension hwcaps get slightly different
+	     treatment: We keep searching for a better
+	     match.  */
+	  bool named_hwcap = false;
 
-	  do
+	  if (entry_size >= sizeof (struct file_entry_new))
 	    {
-	      int flags;
-	      const struct file_entry *lib
-		= _dl_cache_file_entry (libs, entry_size, middle);
-
-	      /* Only perform the name test if necessary.  */
-	      if (middle > left
-		  /* We haven't seen this string so far.  Test whether the
-		     index is ok and whether the name matches.  Otherwise
-		     we are done.  */
-		  && (! _dl_cache_verify_ptr (lib->key, string_table_size)
-		      || (_dl_cache_libcmp (name, string_table + lib->key)
-			  != 0)))
-		break;
-
-	      flags = lib->flags;
-	      if (_dl_cache_check_flags (flags)
-		  && _dl_cache_verify_ptr (lib->value, string_table_size))
-		{
-		  /* Named/extension hwcaps get slightly different
-		     treatment: We keep searching for a better
-		     match.  */
-		  bool named_hwcap = false;
-
-		  if (entry_size >= sizeof (struct file_entry_new))
-		    {
-		      /* The entry is large enough to include
-			 HWCAP data.  Check it.  */
-		      struct file_entry_new *libnew
-			= (struct file_entry_new *) lib;
+	      /* The entry is large enough to include
+		 HWCAP data.  Check it.  */
+	      struct file_entry_new *libnew
+		= (struct file_entry_new *) lib;
 
 #ifdef SHARED
-		      named_hwcap = dl_cache_hwcap_extension (libnew);
-		      if (named_hwcap
-			  && !dl_cache_hwcap_isa_level_compatible (libnew))
-			continue;
+	      named_hwcap = dl_cache_hwcap_extension (libnew);
+	      if (named_hwcap
+		  && !dl_cache_hwcap_isa_level_compatible (libnew))
+		continue;
 #endif
 
-		      /* The entries with named/extension hwcaps have
-			 been exhausted (they are listed before all
-			 other entries).  Return the best match
-			 encountered so far if there is one.  */
-		      if (!named_hwcap && best != NULL)
-			break;
-
-		      if ((libnew->hwcap & hwcap_exclude) && !named_hwcap)
-			continue;
-		      if (_DL_PLATFORMS_COUNT
-			  && (libnew->hwcap & _DL_HWCAP_PLATFORM) != 0
-			  && ((libnew->hwcap & _DL_HWCAP_PLATFORM)
-			      != platform))
-			continue;
+	      /* The entries with named/extension hwcaps have
+		 been exhausted (they are listed before all
+		 other entries).  Return the best match
+		 encountered so far if there is one.  */
+	      if (!named_hwcap && best != NULL)
+		break;
+
+	      if ((libnew->hwcap & hwcap_exclude) && !named_hwcap)
+		continue;
+	      if (_DL_PLATFORMS_COUNT
+		  && (libnew->hwcap & _DL_HWCAP_PLATFORM) != 0
+		  && ((libnew->hwcap & _DL_HWCAP_PLATFORM)
+		      != platform))
+		continue;
 
 #ifdef SHARED
-		      /* For named hwcaps, determine the priority and
-			 see if beats what has been found so far.  */
-		      if (named_hwcap)
-			{
-			  uint32_t entry_priority
-			    = glibc_hwcaps_priority (libnew->hwcap);
-			  if (entry_priority == 0)
-			    /* Not usable at all.  Skip.  */
-			    continue;
-			  else if (best == NULL
-				   || entry_priority < best_priority)
-			    /* This entry is of higher priority
-			       than the previous one, or it is the
-			       first entry.  */
-			    best_priority = entry_priority;
-			  else
-			    /* An entry has already been found,
-			       but it is a better match.  */
-			    continue;
-			}
-#endif /* SHARED */
-		    }
-
-		  best = string_table + lib->value;
-
-		  if (!named_hwcap && flags == _DL_CACHE_DEFAULT_ID)
-		    /* With named hwcaps, we need to keep searching to
-		       see if we find a better match.  A better match
-		       is also possible if the flags of the current
-		       entry do not match the expected cache flags.
-		       But if the flags match, no better entry will be
-		       found.  */
-		    break;
+	      /* For named hwcaps, determine the priority and
+		 see if beats what has been found so far.  */
+	      if (named_hwcap)
+		{
+		  uint32_t entry_priority
+		    = glibc_hwcaps_priority (libnew->hwcap);
+		  if (entry_priority == 0)
+		    /* Not usable at all.  Skip.  */
+		    continue;
+		  else if (best == NULL
+			   || entry_priority < best_priority)
+		    /* This entry is of higher priority
+		       than the previous one, or it is the
+		       first entry.  */
+		    best_priority = entry_priority;
+		  else
+		    /* An entry has already been found,
+		       but it is a better match.  */
+		    continue;
 		}
+#endif /* SHARED */
 	    }
-	  while (++middle <= right);
-	  break;
-	}
 
-      if (cmpres < 0)
-	left = middle + 1;
-      else
-	right = middle - 1;
+	  best = string_table + lib->value;
+
+	  if (!named_hwcap && flags == _DL_CACHE_DEFAULT_ID)
+	    /* With named hwcaps, we need to keep searching to
+	       see if we find a better match.  A better match
+	       is also possible if the flags of the current
+	       entry do not match the expected cache flags.
+	       But if the flags match, no better entry will be
+	       found.  */
+	    break;
+	}
     }
+  while (++middle < (int) nlibs);
 
   return best;
 }
@@ -391,6 +411,27 @@ _dl_cache_libcmp (const char *p1, const char *p2)
 }
 
 
+/* Locate the hash index in the cache which has just been loaded.  */
+static void
+cache_hash_index_init (void)
+{
+  cache_hash_slots = NULL;
+  cache_hash_nslots = 0;
+
+  struct cache_extension_all_loaded ext;
+  if (cache == (void *) -1 || cache_new == (void *) -1
+      || !cache_extension_load (cache_new, cache, cachesize, &ext))
+    return;
+
+  const struct cache_extension_loaded *index
+    = &ext.sections[cache_extension_tag_hash_index];
+  if (index->base != NULL)
+    {
+      cache_hash_slots = index->base;
+      cache_hash_nslots = index->size / sizeof (*cache_hash_slots);
+    }
+}
+
 /* Look up NAME in ld.so.cache and return the file name stored there, or null
    if none is found.  The cache is loaded if it was not already.  If loading
    the cache previously failed there will be no more attempts to load it.
@@ -472,6 +513,7 @@ _dl_load_cache_lookup (const char *name)
 	}
 
       assert (cache != NULL);
+      cache_hash_index_init ();
     }
 
   if (cache == (void *) -1)
@@ -484,7 +526,8 @@ _dl_load_cache_lookup (const char *name)
       const char *string_table = (const char *) cache_new;
       best = search_cache (string_table, cachesize,
 			   &cache_new->libs[0].entry, cache_new->nlibs,
-			   sizeof (cache_new->libs[0]), name);
+			   sizeof (cache_new->libs[0]), cache_hash_slots,
+			   cache_hash_nslots, name);
     }
   else
     {
@@ -493,7 +536,7 @@ _dl_load_cache_lookup (const char *name)
 	= (const char *) cache + cachesize - string_table;
       best = search_cache (string_table, string_table_size,
 			   &cache->libs[0], cache->nlibs,
-			   sizeof (cache->libs[0]), name);
+			   sizeof (cache->libs[0]), NULL, 0, name);
     }
 
   /* Print our result if wanted.  */
@@ -527,6 +570,7 @@ _dl_unload_cache (void)
     {
       __munmap (cache, cachesize);
       cache = NULL;
+      cache_hash_slots = NULL;
     }
 #ifdef SHARED
   /* This marks the glibc_hwcaps_priorities array as out-of-date.  */
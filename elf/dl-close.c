@@ -33,6 +33,7 @@
 #include <tls.h>
 #include <stap-probe.h>
 #include <dl-find_object.h>
+#include <dl-scope-filter.h>
 
 #include <dl-unmap-segments.h>
 
@@ -77,6 +78,7 @@ remove_slotinfo (size_t idx, struct dtv_slotinfo_list *listp, size_t disp,
 	  atomic_store_relaxed (&listp->slotinfo[idx - disp].gen,
 				GL(dl_tls_generation) + 1);
 	  atomic_store_relaxed (&listp->slotinfo[idx - disp].map, NULL);
+	  atomic_store_relaxed (&listp->gen, GL(dl_tls_generation) + 1);
 	}
 
       /* If this is not the last currently used entry no need to look
@@ -236,10 +238,37 @@ _dl_close_worker (struct link_map *map, bool force)
 	  }
     }
 
-  /* Sort the entries.  Unless retrying, the maps[0] object (the
-     original argument to dlclose) needs to remain first, so that its
-     destructor runs first.  */
-  _dl_sort_maps (maps, nloaded, /* force_first */ map != NULL, true);
+  /* Sort the entries.  Only the objects which are unloaded need to be
+     sorted: the objects which remain do not depend on them, so they do
+     not affect the order in which the destructors run.  Move the
+     unloaded objects to the front, and put the remaining objects
+     behind them, in the order of the namespace list.  This way, the
+     sorting effort does not grow with the number of objects which stay
+     loaded.  Unless retrying, the maps[0] object (the original argument
+     to dlclose) needs to remain first, so that its destructor runs
+     first.
+
+     _dl_sort_maps only resets l_visited for the maps it is given, and
+     its depth-first traversal follows the dependencies of the unloaded
+     objects to any object with l_visited == 0.  Unloaded objects may
+     depend on remaining ones, so l_visited is set for all remaining
+     objects here, which keeps the traversal (and the result it writes)
+     within the first NUNLOAD elements.  */
+  unsigned int nunload = 0;
+  for (unsigned int i = 0; i < nloaded; ++i)
+    if (!maps[i]->l_map_used)
+      maps[nunload++] = maps[i];
+  unsigned int nkeep = nunload;
+  for (struct link_map *l = ns->_ns_loaded; l != NULL; l = l->l_next)
+    if (l->l_map_used)
+      {
+	l->l_visited = 1;
+	maps[nkeep++] = l;
+      }
+  assert (nkeep == nloaded);
+  if (nunload > 0)
+    _dl_sort_maps (maps, nunload,
+		   /* force_first */ map != NULL && !map->l_map_used, true);
 
   /* Call all termination functions at once.  */
   bool unload_any = false;
@@ -439,6 +468,8 @@ _dl_close_worker (struct link_map *map, bool force)
     {
       /* Some objects are in the global scope list.  Remove them.  */
       struct r_scope_elem *ns_msl = ns->_ns_main_searchlist;
+      /* The indices in the filter change.  */
+      struct dl_scope_filter *filter = _dl_scope_filter_detach (ns_msl);
       unsigned int i;
       unsigned int j = 0;
       unsigned int cnt = ns_msl->r_nlist;
@@ -458,6 +489,7 @@ _dl_close_worker (struct link_map *map, bool force)
 	      j++;
 	    }
       ns_msl->r_nlist = j;
+      _dl_scope_filter_reattach (ns_msl, filter);
     }
 
   if (!RTLD_SINGLE_THREAD_P
@@ -683,6 +715,7 @@ _dl_close_worker (struct link_map *map, bool force)
 	  while (lnp != NULL);
 
 	  /* Remove the searchlists.  */
+	  _dl_scope_filter_free (imap->l_searchlist.r_filter);
 	  free (imap->l_initfini);
 
 	  /* Remove the scope array if we allocated it.  */
@@ -25,6 +25,7 @@
 #include <dl-hwcaps.h>
 #include <dl-main.h>
 #include <dl-procinfo.h>
+#include <dl-resolve-cache.h>
 #include <dl-sysdep.h>
 #include <ldsodefs.h>
 #include "trusted-dirs.h"
@@ -228,6 +229,19 @@ print_version (void)
   _dl_diagnostics_print_labeled_string ("version.version", VERSION);
 }
 
+/* Print the size of the static TLS surplus, and of the part of it that
+   can be used for dlopen'ed objects accessed through TLS descriptors,
+   according to the tunables.  */
+static void
+print_tls (void)
+{
+  _dl_tls_static_surplus_init (0);
+  _dl_diagnostics_print_labeled_value ("tls.static_surplus",
+				       GLRO (dl_tls_static_surplus));
+  _dl_diagnostics_print_labeled_value ("tls.optional_static_tls",
+				       GL (dl_tls_static_optional));
+}
+
 void
 _dl_print_diagnostics (char **environ)
 {
@@ -254,6 +268,8 @@ _dl_print_diagnostics (char **environ)
   print_environ (environ);
   print_paths ();
   print_version ();
+  print_tls ();
+  _dl_resolve_cache_diagnostics ();
 
   _dl_diagnostics_kernel ();
   _dl_diagnostics_cpu ();
@@ -19,6 +19,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <ldsodefs.h>
+#include <dl-timeline.h>
 #include <elf-initfini.h>
 
 
@@ -52,6 +53,8 @@ call_init (struct link_map *l, int argc, char **argv, char **env)
     _dl_debug_printf ("\ncalling init: %s\n\n",
 		      DSO_FILENAME (l->l_name));
 
+  uint64_t timeline_start = _dl_timeline_start ();
+
   /* Now run the local constructors.  There are two forms of them:
      - the one named by DT_INIT
      - the others in the DT_INIT_ARRAY.
@@ -73,6 +76,8 @@ call_init (struct link_map *l, int argc, char **argv, char **env)
       for (j = 0; j < jm; ++j)
 	((dl_init_t) addrs[j]) (argc, argv, env);
     }
+
+  _dl_timeline_end ("init", l->l_name, timeline_start);
 }
 
 
@@ -116,9 +121,11 @@ _dl_init (struct link_map *main_map, int argc, char **argv, char **env)
      loader which has to find the dependencies at runtime instead of
      letting the user do it right.  Stupidity rules!  */
 
+  uint64_t timeline_start = _dl_timeline_start ();
   i = main_map->l_searchlist.r_nlist;
   while (i-- > 0)
     call_init (main_map->l_initfini[i], argc, argv, env);
+  _dl_timeline_end ("init", NULL, timeline_start);
 
 #ifndef HAVE_INLINED_SYSCALLS
   /* Finished starting up.  */
@@ -72,7 +72,9 @@ struct filebuf
 #include <dl-map-segments.h>
 #include <dl-unmap-segments.h>
 #include <dl-machine-reject-phdr.h>
+#include <dl-path-cache.h>
 #include <dl-prop.h>
+#include <dl-timeline.h>
 #include <not-cancel.h>
 
 #include <endian.h>
@@ -538,6 +540,7 @@ fillin_rpath (char *rpath, struct r_search_path_elem **result, const char *sep,
 			   + ncapstr * sizeof (enum r_dir_status));
 	  *((char *) __mempcpy ((char *) dirp->dirname, cp, len)) = '\0';
 	  dirp->dirnamelen = len;
+	  dirp->path_cache = NULL;
 
 	  if (len > max_dirnamelen)
 	    max_dirnamelen = len;
@@ -759,6 +762,7 @@ _dl_init_paths (const char *llp, const char *source,
 
       pelem->dirname = strp;
       pelem->dirnamelen = system_dirs_len[idx];
+      pelem->path_cache = NULL;
       strp += system_dirs_len[idx] + 1;
 
       /* System paths must be absolute.  */
@@ -1836,6 +1840,16 @@ open_path (const char *name, size_t namelen, int mode,
 	  buflen = (char *) __mempcpy (edp, name, namelen) - buf;
 #endif
 
+	  if (_dl_path_cache_excludes (this_dir, cnt, ncapstr, buf,
+				       buflen - namelen, name, loader))
+	    {
+	      /* The directory does not exist, or it does not contain
+		 NAME.  */
+	      here_any |= this_dir->status[cnt] != nonexisting;
+	      __set_errno (ENOENT);
+	      continue;
+	    }
+
 	  /* Print name we try if this is wanted.  */
 	  if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_LIBS))
 	    _dl_debug_printf ("  trying file=%s\n", buf);
@@ -1993,6 +2007,8 @@ _dl_map_object (struct link_map *loader, const char *name,
 		      : "\nfile=%s [%lu];  dynamically loaded by %s [%lu]\n",
 		      name, nsid, DSO_FILENAME (loader->l_name), loader->l_ns);
 
+  uint64_t open_start = _dl_timeline_start ();
+
 #ifdef SHARED
   /* Give the auditing libraries a chance to change the name before we
      try anything.  */
@@ -2230,9 +2246,16 @@ _dl_map_object (struct link_map *loader, const char *name,
 			  N_("cannot open shared object file"));
     }
 
+  _dl_timeline_end ("open", name, open_start);
+
   void *stack_end = __libc_stack_end;
-  return _dl_map_object_from_fd (name, origname, fd, &fb, realname, loader,
-				 type, mode, &stack_end, nsid);
+  uint64_t map_start = _dl_timeline_start ();
+  l = _dl_map_object_from_fd (name, origname, fd, &fb, realname, loader,
+			      type, mode, &stack_end, nsid);
+  /* L is NULL for RTLD_NOLOAD if the object has not been loaded, and
+     REALNAME has been freed then.  */
+  _dl_timeline_end ("map", l != NULL ? l->l_name : name, map_start);
+  return l;
 }
 
 struct add_path_state
@@ -25,6 +25,7 @@
 #include <dl-machine.h>
 #include <dl-new-hash.h>
 #include <dl-protected.h>
+#include <dl-scope-filter.h>
 #include <sysdep-cancel.h>
 #include <libc-lock.h>
 #include <tls.h>
@@ -353,10 +354,37 @@ do_lookup_x (const char *undef_name, unsigned int new_hash,
   __asm volatile ("" : "+r" (n), "+m" (scope->r_list));
   struct link_map **list = scope->r_list;
 
-  do
+  /* Only visit the objects which may define the symbol, unless all
+     of them are listed for debugging.  */
+  struct dl_scope_filter_iter filter;
+  _dl_scope_filter_iter_init (&filter, scope, new_hash);
+  bool debug_symbols = GLRO(dl_debug_mask) & DL_DEBUG_SYMBOLS;
+  if (__glibc_unlikely (debug_symbols))
+    filter.filter = NULL;
+
+  /* Count the objects visited if the filter of the scope is deferred.
+     Helper threads must not build it.  */
+  bool deferred = (__glibc_unlikely (scope == _dl_scope_filter_pending)
+		   && !(flags & DL_LOOKUP_PREFETCH));
+  unsigned int visits = 0;
+
+  for (i = _dl_scope_filter_next (&filter, i, n); i < n;
+       i = _dl_scope_filter_next (&filter, i + 1, n))
     {
       const struct link_map *map = list[i]->l_real;
 
+      if (__glibc_unlikely (deferred)
+	  && ++visits == _dl_scope_filter_pending_visits)
+	{
+	  /* This lookup is slow.  Use the filter for the remaining
+	     objects.  */
+	  _dl_scope_filter_build_pending ();
+	  _dl_scope_filter_iter_init (&filter, scope, new_hash);
+	  if (__glibc_unlikely (debug_symbols))
+	    filter.filter = NULL;
+	  deferred = false;
+	}
+
       /* Here come the extra test needed for `_dl_lookup_symbol_skip'.  */
       if (map == skip)
 	continue;
@@ -501,6 +529,13 @@ do_lookup_x (const char *undef_name, unsigned int new_hash,
 	      return 1;
 
 	    case STB_GNU_UNIQUE:;
+	      if (__glibc_unlikely (flags & DL_LOOKUP_PREFETCH))
+		{
+		  /* The caller discards the result.  */
+		  result->s = sym;
+		  result->m = (struct link_map *) map;
+		  return 1;
+		}
 	      do_lookup_unique (undef_name, new_hash, (struct link_map *) map,
 				result, type_class, sym, strtab, ref,
 				undef_map, flags);
@@ -515,7 +550,6 @@ do_lookup_x (const char *undef_name, unsigned int new_hash,
 skip:
       ;
     }
-  while (++i < n);
 
   /* We have not found anything until now.  */
   return 0;
@@ -797,7 +831,8 @@ _dl_lookup_symbol_x (const char *undef_name, struct link_map *undef_map,
   if (__glibc_unlikely (current_value.s == NULL))
     {
       if ((*ref == NULL || ELFW(ST_BIND) ((*ref)->st_info) != STB_WEAK)
-	  && !(GLRO(dl_debug_mask) & DL_DEBUG_UNUSED))
+	  && !(GLRO(dl_debug_mask) & DL_DEBUG_UNUSED)
+	  && !(flags & DL_LOOKUP_PREFETCH))
 	{
 	  /* We could find no value for a strong reference.  */
 	  const char *reference_name = undef_map ? undef_map->l_name : "";
@@ -37,6 +37,8 @@
 #include <libc-early-init.h>
 #include <gnu/lib-names.h>
 #include <dl-find_object.h>
+#include <dl-scope-filter.h>
+#include <dl-timeline.h>
 
 #include <dl-dst.h>
 #include <dl-prop.h>
@@ -47,14 +49,39 @@
 
 struct dl_open_args
 {
-  const char *file;
+  /* The COUNT objects to open.  The handle of FILES[I] is stored in
+     HANDLES[I] as soon as the object has been mapped, so that it can
+     be closed again if opening fails.  */
+  const char *const *files;
+  void **handles;
+  size_t count;
   int mode;
   /* This is the caller of the dlopen() function.  */
   const void *caller_dlopen;
-  struct link_map *map;
   /* Namespace ID.  */
   Lmid_t nsid;
 
+  /* The objects among HANDLES which have to be relocated and
+     initialized, in the order of FILES.  NEW_COUNT is set by
+     dl_open_worker_begin.  For a single object, NEW_MAPS points to
+     NEW_MAP.  */
+  struct link_map **new_maps;
+  size_t new_count;
+  struct link_map *new_map;
+
+  /* The objects among HANDLES which were open already.  They are
+     stored at the end of the COUNT elements of NEW_MAPS, from the last
+     element backwards.  RTLD_GLOBAL and RTLD_NODELETE are applied to
+     them only after opening cannot fail anymore.  */
+  size_t old_count;
+
+  /* With RTLD_GLOBAL, the objects of the elements of FILES which have
+     been relocated and are not global yet.  They are searched after
+     the global scope by the relocation of the later elements, but are
+     not added to the global scope before the initializers have run.
+     R_LIST is allocated by dl_open_worker_begin.  */
+  struct r_scope_elem pending_global;
+
   /* Original value of _ns_global_scope_pending_adds.  Set by
      dl_open_worker.  Only valid if nsid is a real namespace
      (non-negative).  */
@@ -204,6 +231,9 @@ add_to_global_update (struct link_map *new)
 
   atomic_write_barrier ();
   ns->_ns_main_searchlist->r_nlist = new_nlist;
+
+  /* Cover the new objects by the filter of the global scope.  */
+  _dl_scope_filter_update (ns->_ns_main_searchlist);
 }
 
 /* Search link maps in all namespaces for the DSO that contains the object at
@@ -250,10 +280,12 @@ scope_size (struct link_map *map)
 }
 
 /* Resize the scopes of depended-upon objects, so that the new object
-   can be added later without further allocation of memory.  This
-   function can raise an exceptions due to malloc failure.  */
+   can be added later without further allocation of memory.  RESERVE
+   is the number of objects opened together, whose search lists may
+   all be added to the same scope.  This function can raise an
+   exceptions due to malloc failure.  */
 static void
-resize_scopes (struct link_map *new)
+resize_scopes (struct link_map *new, size_t reserve)
 {
   /* If the file is not loaded now as a dependency, add the search
      list of the newly loaded object to the scope.  */
@@ -270,7 +302,7 @@ resize_scopes (struct link_map *new)
 	    continue;
 
 	  size_t cnt = scope_size (imap);
-	  if (__glibc_unlikely (cnt + 1 >= imap->l_scope_max))
+	  if (__glibc_unlikely (cnt + reserve >= imap->l_scope_max))
 	    {
 	      /* The l_scope array is too small.  Allocate a new one
 		 dynamically.  */
@@ -278,19 +310,20 @@ resize_scopes (struct link_map *new)
 	      struct r_scope_elem **newp;
 
 	      if (imap->l_scope != imap->l_scope_mem
-		  && imap->l_scope_max < array_length (imap->l_scope_mem))
+		  && imap->l_scope_max < array_length (imap->l_scope_mem)
+		  && cnt + reserve < array_length (imap->l_scope_mem))
 		{
 		  /* If the current l_scope memory is not pointing to
 		     the static memory in the structure, but the
 		     static memory in the structure is large enough to
-		     use for cnt + 1 scope entries, then switch to
+		     use for cnt + reserve scope entries, then switch to
 		     using the static memory.  */
 		  new_size = array_length (imap->l_scope_mem);
 		  newp = imap->l_scope_mem;
 		}
 	      else
 		{
-		  new_size = imap->l_scope_max * 2;
+		  new_size = MAX (imap->l_scope_max * 2, cnt + reserve + 1);
 		  newp = (struct r_scope_elem **)
 		    malloc (new_size * sizeof (struct r_scope_elem *));
 		  if (newp == NULL)
@@ -355,50 +388,52 @@ update_scopes (struct link_map *new)
 }
 
 /* Call _dl_add_to_slotinfo with DO_ADD set to false, to allocate
-   space in GL (dl_tls_dtv_slotinfo_list).  This can raise an
-   exception.  The return value is true if any of the new objects use
-   TLS.  */
+   space in GL (dl_tls_dtv_slotinfo_list) for the COUNT objects in
+   MAPS and their dependencies.  This can raise an exception.  The
+   return value is true if any of the new objects use TLS.  */
 static bool
-resize_tls_slotinfo (struct link_map *new)
+resize_tls_slotinfo (struct link_map **maps, size_t count)
 {
   bool any_tls = false;
-  for (unsigned int i = 0; i < new->l_searchlist.r_nlist; ++i)
-    {
-      struct link_map *imap = new->l_searchlist.r_list[i];
-
-      /* Only add TLS memory if this object is loaded now and
-	 therefore is not yet initialized.  */
-      if (! imap->l_init_called && imap->l_tls_blocksize > 0)
-	{
-	  _dl_add_to_slotinfo (imap, false);
-	  any_tls = true;
-	}
-    }
+  for (size_t n = 0; n < count; ++n)
+    for (unsigned int i = 0; i < maps[n]->l_searchlist.r_nlist; ++i)
+      {
+	struct link_map *imap = maps[n]->l_searchlist.r_list[i];
+
+	/* Only add TLS memory if this object is loaded now and
+	   therefore is not yet initialized.  */
+	if (! imap->l_init_called && imap->l_tls_blocksize > 0)
+	  {
+	    _dl_add_to_slotinfo (imap, false);
+	    any_tls = true;
+	  }
+      }
   return any_tls;
 }
 
 /* Second stage of TLS update, after resize_tls_slotinfo.  This
    function does not raise any exception.  It should only be called if
-   resize_tls_slotinfo returned true.  */
+   resize_tls_slotinfo returned true.  All the objects share a single
+   new TLS generation.  */
 static void
-update_tls_slotinfo (struct link_map *new)
+update_tls_slotinfo (struct link_map **maps, size_t count)
 {
-  unsigned int first_static_tls = new->l_searchlist.r_nlist;
-  for (unsigned int i = 0; i < new->l_searchlist.r_nlist; ++i)
-    {
-      struct link_map *imap = new->l_searchlist.r_list[i];
-
-      /* Only add TLS memory if this object is loaded now and
-	 therefore is not yet initialized.  */
-      if (! imap->l_init_called && imap->l_tls_blocksize > 0)
-	{
-	  _dl_add_to_slotinfo (imap, true);
-
-	  if (imap->l_need_tls_init
-	      && first_static_tls == new->l_searchlist.r_nlist)
-	    first_static_tls = i;
-	}
-    }
+  bool any_static_tls = false;
+  for (size_t n = 0; n < count; ++n)
+    for (unsigned int i = 0; i < maps[n]->l_searchlist.r_nlist; ++i)
+      {
+	struct link_map *imap = maps[n]->l_searchlist.r_list[i];
+
+	/* Only add TLS memory if this object is loaded now and
+	   therefore is not yet initialized.  Objects shared by
+	   several of MAPS are added more than once, with the same
+	   generation.  */
+	if (! imap->l_init_called && imap->l_tls_blocksize > 0)
+	  {
+	    _dl_add_to_slotinfo (imap, true);
+	    any_static_tls |= imap->l_need_tls_init;
+	  }
+      }
 
   size_t newgen = GL(dl_tls_generation) + 1;
   if (__glibc_unlikely (newgen == 0))
@@ -410,34 +445,37 @@ TLS generation counter wrapped!  Please report this."));
   /* We need a second pass for static tls data, because
      _dl_update_slotinfo must not be run while calls to
      _dl_add_to_slotinfo are still pending.  */
-  for (unsigned int i = first_static_tls; i < new->l_searchlist.r_nlist; ++i)
-    {
-      struct link_map *imap = new->l_searchlist.r_list[i];
-
-      if (imap->l_need_tls_init
-	  && ! imap->l_init_called
-	  && imap->l_tls_blocksize > 0)
-	{
-	  /* For static TLS we have to allocate the memory here and
-	     now, but we can delay updating the DTV.  */
-	  imap->l_need_tls_init = 0;
+  if (!any_static_tls)
+    return;
+  for (size_t n = 0; n < count; ++n)
+    for (unsigned int i = 0; i < maps[n]->l_searchlist.r_nlist; ++i)
+      {
+	struct link_map *imap = maps[n]->l_searchlist.r_list[i];
+
+	if (imap->l_need_tls_init
+	    && ! imap->l_init_called
+	    && imap->l_tls_blocksize > 0)
+	  {
+	    /* For static TLS we have to allocate the memory here and
+	       now, but we can delay updating the DTV.  */
+	    imap->l_need_tls_init = 0;
 #ifdef SHARED
-	  /* Update the slot information data for the current
-	     generation.  */
-
-	  /* FIXME: This can terminate the process on memory
-	     allocation failure.  It is not possible to raise
-	     exceptions from this context; to fix this bug,
-	     _dl_update_slotinfo would have to be split into two
-	     operations, similar to resize_scopes and update_scopes
-	     above.  This is related to bug 16134.  */
-	  _dl_update_slotinfo (imap->l_tls_modid, newgen);
+	    /* Update the slot information data for the current
+	       generation.  */
+
+	    /* FIXME: This can terminate the process on memory
+	       allocation failure.  It is not possible to raise
+	       exceptions from this context; to fix this bug,
+	       _dl_update_slotinfo would have to be split into two
+	       operations, similar to resize_scopes and update_scopes
+	       above.  This is related to bug 16134.  */
+	    _dl_update_slotinfo (imap->l_tls_modid, newgen);
 #endif
 
-	  dl_init_static_tls (imap);
-	  assert (imap->l_need_tls_init == 0);
-	}
-    }
+	    dl_init_static_tls (imap);
+	    assert (imap->l_need_tls_init == 0);
+	  }
+      }
 }
 
 /* Mark the objects as NODELETE if required.  This is delayed until
@@ -468,16 +506,66 @@ activate_nodelete (struct link_map *new)
       }
 }
 
+/* Return the old objects recorded by dl_open_map_one.  */
+static inline struct link_map **
+dl_open_old_maps (struct dl_open_args *args)
+{
+  return &args->new_maps[args->count - args->old_count];
+}
+
+/* Mark the objects which were open already as NODELETE if the
+   RTLD_NODELETE flag was passed.  Like activate_nodelete, this must
+   only happen once opening cannot fail anymore.  */
+static void
+activate_old_maps (struct dl_open_args *args)
+{
+  if (__glibc_likely ((args->mode & RTLD_NODELETE) == 0))
+    return;
+  struct link_map **old_maps = dl_open_old_maps (args);
+  for (size_t n = 0; n < args->old_count; ++n)
+    {
+      struct link_map *l = old_maps[n];
+      if (__glibc_unlikely (GLRO (dl_debug_mask) & DL_DEBUG_FILES)
+	  && !l->l_nodelete_active)
+	_dl_debug_printf ("marking %s [%lu] as NODELETE\n",
+			  l->l_name, l->l_ns);
+      l->l_nodelete_active = true;
+    }
+}
+
 /* Relocate the object L.  *RELOCATION_IN_PROGRESS controls whether
-   the debugger is notified of the start of relocation processing.  */
+   the debugger is notified of the start of relocation processing.
+   If PENDING_GLOBAL is not empty, it is searched right after the
+   global scope.  */
 static void
 _dl_open_relocate_one_object (struct dl_open_args *args, struct r_debug *r,
-			      struct link_map *l, int reloc_mode,
-			      bool *relocation_in_progress)
+			      struct link_map *l,
+			      struct r_scope_elem *pending_global,
+			      int reloc_mode, bool *relocation_in_progress)
 {
   if (l->l_real->l_relocated)
     return;
 
+  struct r_scope_elem **scope = l->l_scope;
+  if (pending_global != NULL && pending_global->r_nlist > 0)
+    {
+      /* This function is not inlined because of the alloca, so the
+	 array is released once L is relocated.  */
+      size_t n = 0;
+      while (l->l_scope[n] != NULL)
+	++n;
+      scope = alloca ((n + 2) * sizeof (*scope));
+      struct r_scope_elem *global = GL(dl_ns)[l->l_ns]._ns_main_searchlist;
+      size_t j = 0;
+      for (size_t i = 0; i < n; ++i)
+	{
+	  scope[j++] = l->l_scope[i];
+	  if (l->l_scope[i] == global)
+	    scope[j++] = pending_global;
+	}
+      scope[j] = NULL;
+    }
+
   if (!*relocation_in_progress)
     {
       /* Notify the debugger that relocations are about to happen.  */
@@ -495,7 +583,7 @@ _dl_open_relocate_one_object (struct dl_open_args *args, struct r_debug *r,
 	 start the profiling.  */
       struct link_map *old_profile_map = GL(dl_profile_map);
 
-      _dl_relocate_object (l, l->l_scope, reloc_mode | RTLD_LAZY, 1);
+      _dl_relocate_object (l, scope, reloc_mode | RTLD_LAZY, 1);
 
       if (old_profile_map == NULL && GL(dl_profile_map) != NULL)
 	{
@@ -508,7 +596,26 @@ _dl_open_relocate_one_object (struct dl_open_args *args, struct r_debug *r,
     }
   else
 #endif
-    _dl_relocate_object (l, l->l_scope, reloc_mode, 0);
+    _dl_relocate_object (l, scope, reloc_mode, 0);
+}
+
+/* Append the objects loaded for NEW which are not global yet to
+   PENDING_GLOBAL, whose array is large enough.  */
+static void
+add_to_pending_global (struct r_scope_elem *pending_global,
+		       struct link_map *new)
+{
+  for (unsigned int i = 0; i < new->l_searchlist.r_nlist; ++i)
+    {
+      struct link_map *map = new->l_searchlist.r_list[i];
+      if (map->l_global)
+	continue;
+      unsigned int j = 0;
+      while (j < pending_global->r_nlist && pending_global->r_list[j] != map)
+	++j;
+      if (j == pending_global->r_nlist)
+	pending_global->r_list[pending_global->r_nlist++] = map;
+    }
 }
 
 
@@ -516,7 +623,8 @@ _dl_open_relocate_one_object (struct dl_open_args *args, struct r_debug *r,
    exception handling disabled.  */
 struct dl_init_args
 {
-  struct link_map *new;
+  struct link_map **maps;
+  size_t count;
   int argc;
   char **argv;
   char **env;
@@ -526,57 +634,34 @@ static void
 call_dl_init (void *closure)
 {
   struct dl_init_args *args = closure;
-  _dl_init (args->new, args->argc, args->argv, args->env);
+  for (size_t i = 0; i < args->count; ++i)
+    _dl_init (args->maps[i], args->argc, args->argv, args->env);
+}
+
+/* Return the map of the object calling dlopen.  By default we assume
+   this is the main application.  */
+static struct link_map *
+dl_open_caller_map (struct dl_open_args *args)
+{
+  struct link_map *l
+    = _dl_find_dso_for_object ((ElfW(Addr)) args->caller_dlopen);
+  return l != NULL ? l : GL(dl_ns)[LM_ID_BASE]._ns_loaded;
 }
 
+/* Load ARGS->files[I] and its dependencies, using CALL_MAP as the
+   loader.  If the object still needs to be relocated and initialized,
+   append it to ARGS->new_maps.  */
 static void
-dl_open_worker_begin (void *a)
+dl_open_map_one (struct dl_open_args *args, size_t i,
+		 struct link_map *call_map)
 {
-  struct dl_open_args *args = a;
-  const char *file = args->file;
   int mode = args->mode;
-  struct link_map *call_map = NULL;
-
-  /* Determine the caller's map if necessary.  This is needed in case
-     we have a DST, when we don't know the namespace ID we have to put
-     the new object in, or when the file name has no path in which
-     case we need to look along the RUNPATH/RPATH of the caller.  */
-  const char *dst = strchr (file, '$');
-  if (dst != NULL || args->nsid == __LM_ID_CALLER
-      || strchr (file, '/') == NULL)
-    {
-      const void *caller_dlopen = args->caller_dlopen;
-
-      /* We have to find out from which object the caller is calling.
-	 By default we assume this is the main application.  */
-      call_map = GL(dl_ns)[LM_ID_BASE]._ns_loaded;
-
-      struct link_map *l = _dl_find_dso_for_object ((ElfW(Addr)) caller_dlopen);
-
-      if (l)
-	call_map = l;
-
-      if (args->nsid == __LM_ID_CALLER)
-	args->nsid = call_map->l_ns;
-    }
-
-  /* The namespace ID is now known.  Keep track of whether libc.so was
-     already loaded, to determine whether it is necessary to call the
-     early initialization routine (or clear libc_map on error).  */
-  args->libc_already_loaded = GL(dl_ns)[args->nsid].libc_map != NULL;
-
-  /* Retain the old value, so that it can be restored.  */
-  args->original_global_scope_pending_adds
-    = GL (dl_ns)[args->nsid]._ns_global_scope_pending_adds;
-
-  /* One might be tempted to assert that we are RT_CONSISTENT at this point, but that
-     may not be true if this is a recursive call to dlopen.  */
-  _dl_debug_initialize (0, args->nsid);
 
   /* Load the named object.  */
   struct link_map *new;
-  args->map = new = _dl_map_object (call_map, file, lt_loaded, 0,
-				    mode | __RTLD_CALLMAP, args->nsid);
+  args->handles[i] = new = _dl_map_object (call_map, args->files[i],
+					   lt_loaded, 0,
+					   mode | __RTLD_CALLMAP, args->nsid);
 
   /* If the pointer returned is NULL this means the RTLD_NOLOAD flag is
      set and the object is not already loaded.  */
@@ -601,31 +686,27 @@ dl_open_worker_begin (void *a)
 	_dl_debug_printf ("opening file=%s [%lu]; direct_opencount=%u\n\n",
 			  new->l_name, new->l_ns, new->l_direct_opencount);
 
-      /* If the user requested the object to be in the global
-	 namespace but it is not so far, prepare to add it now.  This
-	 can raise an exception to do a malloc failure.  */
-      if ((mode & RTLD_GLOBAL) && new->l_global == 0)
-	add_to_global_resize (new);
-
-      /* Mark the object as not deletable if the RTLD_NODELETE flags
-	 was passed.  */
-      if (__glibc_unlikely (mode & RTLD_NODELETE))
-	{
-	  if (__glibc_unlikely (GLRO (dl_debug_mask) & DL_DEBUG_FILES)
-	      && !new->l_nodelete_active)
-	    _dl_debug_printf ("marking %s [%lu] as NODELETE\n",
-			      new->l_name, new->l_ns);
-	  new->l_nodelete_active = true;
-	}
-
-      /* Finalize the addition to the global scope.  */
-      if ((mode & RTLD_GLOBAL) && new->l_global == 0)
-	add_to_global_update (new);
-
+      /* Earlier elements of ARGS->files may have added objects.  */
       const int r_state __attribute__ ((unused))
         = _dl_debug_update (args->nsid)->r_state;
-      assert (r_state == RT_CONSISTENT);
-
+      assert (args->new_count > 0 || r_state == RT_CONSISTENT);
+
+      /* If the object has been opened by an earlier element of
+	 ARGS->files, it is made global and NODELETE along with
+	 that.  */
+      for (size_t j = 0; j < args->new_count; ++j)
+	if (args->new_maps[j] == new)
+	  return;
+      struct link_map **old_maps = dl_open_old_maps (args);
+      for (size_t j = 0; j < args->old_count; ++j)
+	if (old_maps[j] == new)
+	  return;
+
+      /* RTLD_GLOBAL and RTLD_NODELETE must not take effect before
+	 the later elements of ARGS->files have been opened, because
+	 they cannot be undone if that fails.  */
+      ++args->old_count;
+      dl_open_old_maps (args)[0] = new;
       return;
     }
 
@@ -637,6 +718,7 @@ dl_open_worker_begin (void *a)
   /* Load that object's dependencies.  */
   _dl_map_object_deps (new, NULL, 0, 0,
 		       mode & (__RTLD_DLOPEN | RTLD_DEEPBIND | __RTLD_AUDIT));
+  _dl_scope_filter_update (&new->l_searchlist);
 
   /* So far, so good.  Now check the versions.  */
   for (unsigned int i = 0; i < new->l_searchlist.r_nlist; ++i)
@@ -656,48 +738,104 @@ dl_open_worker_begin (void *a)
 #endif
       }
 
+  args->new_maps[args->new_count++] = new;
+}
+
+static void
+dl_open_worker_begin (void *a)
+{
+  struct dl_open_args *args = a;
+  int mode = args->mode;
+
+  /* Determine the caller's map if necessary.  This is needed in case
+     we have a DST, when we don't know the namespace ID we have to put
+     the new object in, or when the file name has no path in which
+     case we need to look along the RUNPATH/RPATH of the caller.  */
+  bool nsid_from_caller = args->nsid == __LM_ID_CALLER;
+  struct link_map *call_map = NULL;
+  if (nsid_from_caller)
+    {
+      call_map = dl_open_caller_map (args);
+      args->nsid = call_map->l_ns;
+    }
+
+  /* The namespace ID is now known.  Keep track of whether libc.so was
+     already loaded, to determine whether it is necessary to call the
+     early initialization routine (or clear libc_map on error).  */
+  args->libc_already_loaded = GL(dl_ns)[args->nsid].libc_map != NULL;
+
+  /* Retain the old value, so that it can be restored.  */
+  args->original_global_scope_pending_adds
+    = GL (dl_ns)[args->nsid]._ns_global_scope_pending_adds;
+
+  /* One might be tempted to assert that we are RT_CONSISTENT at this point, but that
+     may not be true if this is a recursive call to dlopen.  */
+  _dl_debug_initialize (0, args->nsid);
+
+  /* Map all the objects and their dependencies before relocating any
+     of them.  */
+  args->new_count = 0;
+  args->old_count = 0;
+  for (size_t i = 0; i < args->count; ++i)
+    {
+      const char *file = args->files[i];
+      struct link_map *loader = NULL;
+      if (nsid_from_caller || strchr (file, '$') != NULL
+	  || strchr (file, '/') == NULL)
+	{
+	  if (call_map == NULL)
+	    call_map = dl_open_caller_map (args);
+	  loader = call_map;
+	}
+      dl_open_map_one (args, i, loader);
+    }
+
+  /* If the user requested objects which were open already to be in
+     the global namespace but they are not so far, prepare to add them.
+     This can raise an exception due to a malloc failure.  */
+  struct link_map **old_maps = dl_open_old_maps (args);
+  if (mode & RTLD_GLOBAL)
+    for (size_t n = 0; n < args->old_count; ++n)
+      add_to_global_resize (old_maps[n]);
+
+  struct link_map **new_maps = args->new_maps;
+  size_t new_count = args->new_count;
+  if (new_count == 0)
+    {
+      /* Nothing can fail anymore.  */
+      activate_old_maps (args);
+      if (mode & RTLD_GLOBAL)
+	for (size_t i = 0; i < args->count; ++i)
+	  if (args->handles[i] != NULL)
+	    add_to_global_update (args->handles[i]);
+      return;
+    }
+
 #ifdef SHARED
   /* Auditing checkpoint: we have added all objects.  */
-  _dl_audit_activity_nsid (new->l_ns, LA_ACT_CONSISTENT);
+  _dl_audit_activity_nsid (args->nsid, LA_ACT_CONSISTENT);
 #endif
 
   /* Notify the debugger all new objects are now ready to go.  */
   struct r_debug *r = _dl_debug_update (args->nsid);
   r->r_state = RT_CONSISTENT;
   _dl_debug_state ();
-  LIBC_PROBE (map_complete, 3, args->nsid, r, new);
+  LIBC_PROBE (map_complete, 3, args->nsid, r, new_maps[0]);
 
-  _dl_open_check (new);
+  for (size_t n = 0; n < new_count; ++n)
+    {
+      _dl_open_check (new_maps[n]);
 
-  /* Print scope information.  */
-  if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_SCOPES))
-    _dl_show_scope (new, 0);
+      /* Print scope information.  */
+      if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_SCOPES))
+	_dl_show_scope (new_maps[n], 0);
+    }
 
   /* Only do lazy relocation if `LD_BIND_NOW' is not set.  */
   int reloc_mode = mode & __RTLD_AUDIT;
   if (GLRO(dl_lazy))
     reloc_mode |= mode & RTLD_LAZY;
 
-  /* Objects must be sorted by dependency for the relocation process.
-     This allows IFUNC relocations to work and it also means copy
-     relocation of dependencies are if necessary overwritten.
-     __dl_map_object_deps has already sorted l_initfini for us.  */
-  unsigned int first = UINT_MAX;
-  unsigned int last = 0;
-  unsigned int j = 0;
-  struct link_map *l = new->l_initfini[0];
-  do
-    {
-      if (! l->l_real->l_relocated)
-	{
-	  if (first == UINT_MAX)
-	    first = j;
-	  last = j + 1;
-	}
-      l = new->l_initfini[++j];
-    }
-  while (l != NULL);
-
   bool relocation_in_progress = false;
 
   /* Perform relocation.  This can trigger lazy binding in IFUNC
@@ -716,25 +854,90 @@ dl_open_worker_begin (void *a)
 #ifdef SHARED
   if (GL(dl_ns)[args->nsid].libc_map != NULL)
     _dl_open_relocate_one_object (args, r, GL(dl_ns)[args->nsid].libc_map,
-				  reloc_mode, &relocation_in_progress);
+				  NULL, reloc_mode, &relocation_in_progress);
 #endif
 
-  for (unsigned int i = last; i-- > first; )
-    _dl_open_relocate_one_object (args, r, new->l_initfini[i], reloc_mode,
-				  &relocation_in_progress);
+  /* Objects must be sorted by dependency for the relocation process.
+     This allows IFUNC relocations to work and it also means copy
+     relocation of dependencies are if necessary overwritten.
+     __dl_map_object_deps has already sorted l_initfini for us.
+     Objects shared by several new objects are relocated along with
+     the first of them.
+
+     With RTLD_GLOBAL, the objects of each element of ARGS->files are
+     searched after the global scope by the relocation of the later
+     elements, so that these can bind to them as they could after
+     separate dlopen calls.  The objects are only added to the global
+     scope itself after the initializers have run, so no other thread
+     can bind to them before.  */
+  struct r_scope_elem *pending_global = NULL;
+  if ((mode & RTLD_GLOBAL) && args->count > 1)
+    {
+      size_t total = 0;
+      for (size_t i = 0; i < args->count; ++i)
+	if (args->handles[i] != NULL)
+	  total += ((struct link_map *) args->handles[i])
+		   ->l_searchlist.r_nlist;
+      pending_global = &args->pending_global;
+      pending_global->r_list = malloc (total * sizeof (struct link_map *));
+      if (pending_global->r_list == NULL)
+	add_to_global_resize_failure (new_maps[0]);
+    }
+
+  size_t next_new = 0;
+  for (size_t i = 0; i < args->count; ++i)
+    {
+      struct link_map *new = args->handles[i];
+      if (new == NULL)
+	continue;
+      if (next_new == new_count || new != new_maps[next_new])
+	{
+	  /* The object was open already, or named before.  */
+	  if (pending_global != NULL)
+	    add_to_pending_global (pending_global, new);
+	  continue;
+	}
+      ++next_new;
+
+      unsigned int first = UINT_MAX;
+      unsigned int last = 0;
+      unsigned int j = 0;
+      struct link_map *l = new->l_initfini[0];
+      do
+	{
+	  if (! l->l_real->l_relocated)
+	    {
+	      if (first == UINT_MAX)
+		first = j;
+	      last = j + 1;
+	    }
+	  l = new->l_initfini[++j];
+	}
+      while (l != NULL);
+
+      for (unsigned int k = last; k-- > first; )
+	_dl_open_relocate_one_object (args, r, new->l_initfini[k],
+				      pending_global, reloc_mode,
+				      &relocation_in_progress);
+
+      if (pending_global != NULL)
+	add_to_pending_global (pending_global, new);
+    }
 
   /* This only performs the memory allocations.  The actual update of
      the scopes happens below, after failure is impossible.  */
-  resize_scopes (new);
+  for (size_t n = 0; n < new_count; ++n)
+    resize_scopes (new_maps[n], new_count);
 
   /* Increase the size of the GL (dl_tls_dtv_slotinfo_list) data
      structure.  */
-  bool any_tls = resize_tls_slotinfo (new);
+  bool any_tls = resize_tls_slotinfo (new_maps, new_count);
 
   /* Perform the necessary allocations for adding new global objects
      to the global scope below.  */
   if (mode & RTLD_GLOBAL)
-    add_to_global_resize (new);
+    for (size_t n = 0; n < new_count; ++n)
+      add_to_global_resize (new_maps[n]);
 
   /* Demarcation point: After this, no recoverable errors are allowed.
      All memory allocations for new objects must have happened
@@ -746,16 +949,21 @@ dl_open_worker_begin (void *a)
      update_scopes which ensures that the changes from
      activate_nodelete are visible before new objects show up in the
      local scope.  */
-  activate_nodelete (new);
+  activate_nodelete (new_maps[0]);
+  activate_old_maps (args);
 
   /* Second stage after resize_scopes: Actually perform the scope
      update.  After this, dlsym and lazy binding can bind to new
      objects.  */
-  update_scopes (new);
+  for (size_t n = 0; n < new_count; ++n)
+    update_scopes (new_maps[n]);
 
-  if (!_dl_find_object_update (new))
-    _dl_signal_error (ENOMEM, new->l_libname->name, NULL,
-		      N_ ("cannot allocate address lookup data"));
+  /* The first call covers all objects loaded after NEW_MAPS[0], so
+     the later calls usually have nothing left to do.  */
+  for (size_t n = 0; n < new_count; ++n)
+    if (!_dl_find_object_update (new_maps[n]))
+      _dl_signal_error (ENOMEM, new_maps[n]->l_libname->name, NULL,
+			N_ ("cannot allocate address lookup data"));
 
   /* FIXME: It is unclear whether the order here is correct.
      Shouldn't new objects be made available for binding (and thus
@@ -768,11 +976,11 @@ dl_open_worker_begin (void *a)
   if (any_tls)
     /* FIXME: This calls _dl_update_slotinfo, which aborts the process
        on memory allocation failure.  See bug 16134.  */
-    update_tls_slotinfo (new);
+    update_tls_slotinfo (new_maps, new_count);
 
   /* Notify the debugger all new objects have been relocated.  */
   if (relocation_in_progress)
-    LIBC_PROBE (reloc_complete, 3, args->nsid, r, new);
+    LIBC_PROBE (reloc_complete, 3, args->nsid, r, new_maps[0]);
 
   /* If libc.so was not there before, attempt to call its early
      initialization routine.  Indicate to the initialization routine
@@ -794,6 +1002,9 @@ dl_open_worker (void *a)
   struct dl_open_args *args = a;
 
   args->worker_continue = false;
+  args->pending_global.r_list = NULL;
+  args->pending_global.r_nlist = 0;
+  args->pending_global.r_filter = NULL;
 
   {
     /* Protects global and module specific TLS state.  */
@@ -804,6 +1015,8 @@ dl_open_worker (void *a)
 
     __rtld_lock_unlock_recursive (GL(dl_load_tls_lock));
 
+    free (args->pending_global.r_list);
+
     if (__glibc_unlikely (ex.errstring != NULL))
       /* Reraise the error.  */
       _dl_signal_exception (err, &ex, NULL);
@@ -812,16 +1025,14 @@ dl_open_worker (void *a)
   if (!args->worker_continue)
     return;
 
-  int mode = args->mode;
-  struct link_map *new = args->map;
-
-  /* Run the initializer functions of new objects.  Temporarily
-     disable the exception handler, so that lazy binding failures are
-     fatal.  */
+  /* Run the initializer functions of new objects, in one pass in
+     dependency order.  Temporarily disable the exception handler, so
+     that lazy binding failures are fatal.  */
   {
     struct dl_init_args init_args =
       {
-        .new = new,
+        .maps = args->new_maps,
+        .count = args->new_count,
         .argc = args->argc,
         .argv = args->argv,
         .env = args->env
@@ -829,20 +1040,35 @@ dl_open_worker (void *a)
     _dl_catch_exception (NULL, call_dl_init, &init_args);
   }
 
-  /* Now we can make the new map available in the global scope.  */
-  if (mode & RTLD_GLOBAL)
-    add_to_global_update (new);
+  /* Now we can make the objects available in the global scope, in the
+     order of ARGS->files.  This includes the objects which were open
+     already.  */
+  if (args->mode & RTLD_GLOBAL)
+    for (size_t i = 0; i < args->count; ++i)
+      if (args->handles[i] != NULL)
+	add_to_global_update (args->handles[i]);
 
-  /* Let the user know about the opencount.  */
-  if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_FILES))
-    _dl_debug_printf ("opening file=%s [%lu]; direct_opencount=%u\n\n",
-		      new->l_name, new->l_ns, new->l_direct_opencount);
+  for (size_t n = 0; n < args->new_count; ++n)
+    {
+      struct link_map *new = args->new_maps[n];
+
+      /* Let the user know about the opencount.  */
+      if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_FILES))
+	_dl_debug_printf ("opening file=%s [%lu]; direct_opencount=%u\n\n",
+			  new->l_name, new->l_ns, new->l_direct_opencount);
+    }
 }
 
-void *
-_dl_open (const char *file, int mode, const void *caller_dlopen, Lmid_t nsid,
-	  int argc, char *argv[], char *env[])
+/* Open the objects described by ARGS, which must have at least one
+   element.  Shared by _dl_open and _dl_open_many.  */
+static void
+dl_open (struct dl_open_args *args)
 {
+  const char *file = args->files[0];
+  int mode = args->mode;
+  Lmid_t nsid = args->nsid;
+  uint64_t timeline_start = _dl_timeline_start ();
+
   if ((mode & RTLD_BINDING_MASK) == 0)
     /* One of the flags must be set.  */
     _dl_signal_error (EINVAL, file, NULL, N_("invalid mode for dlopen()"));
@@ -889,20 +1115,14 @@ no more namespaces available for dlmopen()"));
     _dl_signal_error (EINVAL, file, NULL,
 		      N_("invalid target namespace in dlmopen()"));
 
-  struct dl_open_args args;
-  args.file = file;
-  args.mode = mode;
-  args.caller_dlopen = caller_dlopen;
-  args.map = NULL;
-  args.nsid = nsid;
-  /* args.libc_already_loaded is always assigned by dl_open_worker
+  args->nsid = nsid;
+  for (size_t i = 0; i < args->count; ++i)
+    args->handles[i] = NULL;
+  /* args->libc_already_loaded is always assigned by dl_open_worker
      (before any explicit/non-local returns).  */
-  args.argc = argc;
-  args.argv = argv;
-  args.env = env;
 
   struct dl_exception exception;
-  int errcode = _dl_catch_exception (&exception, dl_open_worker, &args);
+  int errcode = _dl_catch_exception (&exception, dl_open_worker, args);
 
 #if defined USE_LDCONFIG && !defined MAP_COPY
   /* We must unmap the cache file.  */
@@ -918,28 +1138,31 @@ no more namespaces available for dlmopen()"));
      old pending adds value is larger than absolutely necessary.
      Since it is just a conservative upper bound, this is harmless.
      The top-level dlopen call will restore the field to zero.  */
-  if (args.nsid >= 0)
-    GL (dl_ns)[args.nsid]._ns_global_scope_pending_adds
-      = args.original_global_scope_pending_adds;
+  if (args->nsid >= 0)
+    GL (dl_ns)[args->nsid]._ns_global_scope_pending_adds
+      = args->original_global_scope_pending_adds;
 
   /* See if an error occurred during loading.  */
   if (__glibc_unlikely (exception.errstring != NULL))
     {
       /* Avoid keeping around a dangling reference to the libc.so link
 	 map in case it has been cached in libc_map.  */
-      if (!args.libc_already_loaded)
-	GL(dl_ns)[args.nsid].libc_map = NULL;
-
-      /* Remove the object from memory.  It may be in an inconsistent
-	 state if relocation failed, for example.  */
-      if (args.map)
-	{
-	  _dl_close_worker (args.map, true);
-
-	  /* All l_nodelete_pending objects should have been deleted
-	     at this point, which is why it is not necessary to reset
-	     the flag here.  */
-	}
+      if (!args->libc_already_loaded)
+	GL(dl_ns)[args->nsid].libc_map = NULL;
+
+      /* Remove the objects from memory, in reverse order.  They may
+	 be in an inconsistent state if relocation failed, for
+	 example.  */
+      for (size_t i = args->count; i-- > 0; )
+	if (args->handles[i] != NULL)
+	  {
+	    _dl_close_worker (args->handles[i], true);
+	    args->handles[i] = NULL;
+	  }
+
+      /* All l_nodelete_pending objects should have been deleted at
+	 this point, which is why it is not necessary to reset the flag
+	 here.  */
 
       /* Release the lock.  */
       __rtld_lock_unlock_recursive (GL(dl_load_lock));
@@ -949,15 +1172,76 @@ no more namespaces available for dlmopen()"));
     }
 
   const int r_state __attribute__ ((unused))
-    = _dl_debug_update (args.nsid)->r_state;
+    = _dl_debug_update (args->nsid)->r_state;
   assert (r_state == RT_CONSISTENT);
 
+  _dl_timeline_end (args->count == 1 ? "dlopen" : "dlopen_many", file,
+		    timeline_start);
+
   /* Release the lock.  */
   __rtld_lock_unlock_recursive (GL(dl_load_lock));
+}
 
-  return args.map;
+void *
+_dl_open (const char *file, int mode, const void *caller_dlopen, Lmid_t nsid,
+	  int argc, char *argv[], char *env[])
+{
+  void *handle;
+  struct dl_open_args args;
+  args.files = &file;
+  args.handles = &handle;
+  args.count = 1;
+  args.mode = mode;
+  args.caller_dlopen = caller_dlopen;
+  args.nsid = nsid;
+  args.new_maps = &args.new_map;
+  args.argc = argc;
+  args.argv = argv;
+  args.env = env;
+
+  dl_open (&args);
+  return handle;
 }
 
+/* Call dl_open with _dl_catch_exception, so that _dl_open_many can
+   free its list of new objects on error.  */
+static void
+call_dl_open (void *closure)
+{
+  dl_open (closure);
+}
+
+void
+_dl_open_many (const char *const files[], size_t count, int mode,
+	       const void *caller_dlopen, Lmid_t nsid, void *handles[],
+	       int argc, char *argv[], char *env[])
+{
+  if (count == 0)
+    return;
+
+  struct dl_open_args args;
+  args.files = files;
+  args.handles = handles;
+  args.count = count;
+  args.mode = mode;
+  args.caller_dlopen = caller_dlopen;
+  args.nsid = nsid;
+  args.argc = argc;
+  args.argv = argv;
+  args.env = env;
+
+  size_t size;
+  if (__builtin_mul_overflow (count, sizeof (struct link_map *), &size)
+      || (args.new_maps = malloc (size)) == NULL)
+    _dl_signal_error (ENOMEM, NULL, NULL,
+		      N_("cannot allocate list of objects to open"));
+
+  struct dl_exception exception;
+  int errcode = _dl_catch_exception (&exception, call_dl_open, &args);
+  free (args.new_maps);
+  if (__glibc_unlikely (exception.errstring != NULL))
+    _dl_signal_exception (errcode, &exception, NULL);
+}
 
 void
 _dl_show_scope (struct link_map *l, int from)
@@ -0,0 +1,194 @@
+/* Cache of the names in library search directories.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* open_path tries to open every needed object in every directory of
+   the search path until it is found, so that loading many objects
+   with a long LD_LIBRARY_PATH issues a large number of failing open
+   calls.  With glibc.rtld.path_cache, the names in a search directory
+   are read once instead, and later searches skip the directory without
+   a system call if it does not contain the object.  Only hashes of the
+   names are kept, so a match may be a false positive, in which case
+   the open call fails as before.
+
+   Files added to a directory after it has been read are not found.  */
+
+#include <dirent.h>
+#include <errno.h>
+#include <dl-new-hash.h>
+#include <dl-path-cache.h>
+#include <dl-tunables.h>
+#include <fcntl.h>
+#include <not-cancel.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Directories with more entries than this are not cached.  */
+#define MAX_ENTRIES (1U << 16)
+
+struct dl_path_cache_dir
+{
+  /* Number of slots minus one.  The number of slots is a power of
+     two.  */
+  uint32_t mask;
+  /* Open-addressing hash table of name hashes.  Zero marks an empty
+     slot.  */
+  uint32_t hashes[];
+};
+
+/* Marks directories which cannot be read, or are too large.  Files in
+   them are opened as without the cache.  */
+#define UNCACHED ((struct dl_path_cache_dir *) -1)
+
+static inline uint32_t
+name_hash (const char *name)
+{
+  uint32_t hash = _dl_new_hash (name);
+  return hash != 0 ? hash : 1;
+}
+
+struct read_state
+{
+  /* Number of names seen.  */
+  uint32_t count;
+  /* The table to fill in, or NULL if names are only counted.  */
+  struct dl_path_cache_dir *dir;
+};
+
+/* Process the names in the directory FD according to STATE.  Return
+   false on error.  */
+static bool
+read_names (int fd, struct read_state *state)
+{
+  char buf[4096] __attribute__ ((aligned (__alignof__ (struct dirent64))));
+  while (true)
+    {
+      ssize_t size = __getdents64 (fd, buf, sizeof (buf));
+      if (size < 0)
+	return false;
+      if (size == 0)
+	return true;
+
+      for (ssize_t offset = 0; offset < size; )
+	{
+	  const struct dirent64 *d = (const struct dirent64 *) (buf + offset);
+	  offset += d->d_reclen;
+	  if (strcmp (d->d_name, ".") == 0 || strcmp (d->d_name, "..") == 0)
+	    continue;
+
+	  if (++state->count > MAX_ENTRIES)
+	    return false;
+	  if (state->dir != NULL)
+	    {
+	      struct dl_path_cache_dir *dir = state->dir;
+	      /* Keep at least one slot empty if the directory has grown
+		 since the names were counted.  */
+	      if (state->count > dir->mask)
+		return false;
+	      uint32_t hash = name_hash (d->d_name);
+	      uint32_t i = hash & dir->mask;
+	      while (dir->hashes[i] != 0 && dir->hashes[i] != hash)
+		i = (i + 1) & dir->mask;
+	      dir->hashes[i] = hash;
+	    }
+	}
+    }
+}
+
+/* Read the names in the directory PATH.  Return NULL if the directory
+   does not exist.  */
+static struct dl_path_cache_dir *
+read_directory (const char *path)
+{
+  int fd = __open64_nocancel (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+    return errno == ENOENT || errno == ENOTDIR ? NULL : UNCACHED;
+
+  struct dl_path_cache_dir *dir = UNCACHED;
+  struct read_state state = { .count = 0, .dir = NULL };
+  if (read_names (fd, &state) && __lseek (fd, 0, SEEK_SET) == 0)
+    {
+      uint32_t nslots = 2;
+      while (nslots < 2 * state.count)
+	nslots *= 2;
+      dir = calloc (1, sizeof (*dir) + nslots * sizeof (uint32_t));
+      if (dir == NULL)
+	dir = UNCACHED;
+      else
+	{
+	  dir->mask = nslots - 1;
+	  state.count = 0;
+	  state.dir = dir;
+	  if (!read_names (fd, &state))
+	    {
+	      free (dir);
+	      dir = UNCACHED;
+	    }
+	}
+    }
+
+  __close_nocancel_nostatus (fd);
+  return dir;
+}
+
+bool
+_dl_path_cache_excludes (struct r_search_path_elem *dir, size_t cnt,
+			 size_t ncapstr, char *path, size_t pathlen,
+			 const char *name, struct link_map *loader)
+{
+  if (TUNABLE_GET (glibc, rtld, path_cache, int32_t, NULL) == 0
+      /* The current directory might change.  */
+      || dir->dirname[0] != '/'
+      /* Do not disturb the program when loading auditing code, as for
+	 the directory status in open_path.  */
+      || (loader != NULL
+	  && GL(dl_ns)[loader->l_ns]._ns_loaded->l_auditing != 0))
+    return false;
+
+  if (dir->path_cache == NULL)
+    {
+      dir->path_cache = calloc (ncapstr, sizeof (*dir->path_cache));
+      if (dir->path_cache == NULL)
+	return false;
+    }
+
+  struct dl_path_cache_dir *names = dir->path_cache[cnt];
+  if (names == NULL)
+    {
+      char saved = path[pathlen];
+      path[pathlen] = '\0';
+      names = read_directory (path);
+      path[pathlen] = saved;
+      if (names == NULL)
+	{
+	  dir->status[cnt] = nonexisting;
+	  return true;
+	}
+      dir->path_cache[cnt] = names;
+      if (names != UNCACHED)
+	dir->status[cnt] = existing;
+    }
+  if (names == UNCACHED)
+    return false;
+
+  uint32_t hash = name_hash (name);
+  for (uint32_t i = hash & names->mask; names->hashes[i] != 0;
+       i = (i + 1) & names->mask)
+    if (names->hashes[i] == hash)
+      return false;
+  return true;
+}
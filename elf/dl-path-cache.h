@@ -0,0 +1,39 @@
+/* Cache of the names in library search directories.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_PATH_CACHE_H
+#define _DL_PATH_CACHE_H
+
+#include <ldsodefs.h>
+#include <stdbool.h>
+
+/* Return true if the directory PATH, which is the directory DIR with
+   the hwcaps subdirectory at index CNT (of NCAPSTR) appended, is known
+   not to contain a file called NAME.  PATH is not null-terminated;
+   its length is PATHLEN, and PATH[PATHLEN] is temporarily overwritten.
+   LOADER is the object on whose behalf the search is performed.
+
+   If glibc.rtld.path_cache is enabled, the names in the directory are
+   read on the first call for it, and DIR->status[CNT] is updated.
+   Otherwise, this always returns false.  */
+bool _dl_path_cache_excludes (struct r_search_path_elem *dir, size_t cnt,
+			      size_t ncapstr, char *path, size_t pathlen,
+			      const char *name, struct link_map *loader)
+  attribute_hidden;
+
+#endif /* _DL_PATH_CACHE_H */
@@ -0,0 +1,246 @@
+/* Symbol lookups for relocation on helper threads.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Most of the time spent relocating large programs goes into symbol
+   lookups, which only read the link maps once the lookup scopes are
+   set up.  With glibc.rtld.parallel_reloc, the lookups for the
+   relocations of all initial objects are performed up front, spread
+   over helper threads, and the results are picked up by resolve_map
+   when the objects are then relocated in the usual order on the main
+   thread.  Applying the relocations stays serial, so that IFUNC
+   resolvers, copy relocations and text relocations are processed
+   exactly as without helper threads.
+
+   Lookups which have side effects are left to the main thread: those
+   binding to unique symbols, which are entered into a table, and
+   those failing for strong references, which report an error.  */
+
+#include <ldsodefs.h>
+#include <atomic.h>
+#include <dl-helper-thread.h>
+#include <dl-machine.h>
+#include <dl-reloc-parallel.h>
+#include <dl-resolve-cache.h>
+#include <dl-scope-filter.h>
+#include <dl-tunables.h>
+#include <sys/mman.h>
+
+/* The largest number of helper threads.  */
+#define MAX_HELPERS 64
+
+struct prefetch_work
+{
+  struct link_map **objects;
+  unsigned int nobjects;
+  /* Index of the next object to process.  */
+  unsigned int next;
+};
+
+/* Call FN for the symbol index and type of the relocations of size
+   ENTSIZE in [START, START + SIZE).  */
+static inline void
+for_each_reloc (ElfW(Addr) start, ElfW(Addr) size, size_t entsize,
+		void (*fn) (struct link_map *, struct dl_reloc_prefetch *,
+			    unsigned long int, unsigned long int),
+		struct link_map *l, struct dl_reloc_prefetch *table)
+{
+  for (ElfW(Addr) p = start; p < start + size; p += entsize)
+    {
+      ElfW(Addr) info = ((const ElfW(Rel) *) p)->r_info;
+      fn (l, table, ELFW(R_SYM) (info), ELFW(R_TYPE) (info));
+    }
+}
+
+/* Call FN for every relocation of L which is processed at startup.  */
+static void
+for_each_startup_reloc (struct link_map *l,
+			void (*fn) (struct link_map *,
+				    struct dl_reloc_prefetch *,
+				    unsigned long int, unsigned long int),
+			struct dl_reloc_prefetch *table)
+{
+  if (l->l_info[DT_REL] != NULL)
+    for_each_reloc (D_PTR (l, l_info[DT_REL]), l->l_info[DT_RELSZ]->d_un.d_val,
+		    sizeof (ElfW(Rel)), fn, l, table);
+  if (l->l_info[DT_RELA] != NULL)
+    for_each_reloc (D_PTR (l, l_info[DT_RELA]),
+		    l->l_info[DT_RELASZ]->d_un.d_val,
+		    sizeof (ElfW(Rela)), fn, l, table);
+  /* PLT relocations are processed later if binding lazily.  */
+  if (l->l_info[DT_JMPREL] != NULL && !GLRO(dl_lazy))
+    for_each_reloc (D_PTR (l, l_info[DT_JMPREL]),
+		    l->l_info[DT_PLTRELSZ]->d_un.d_val,
+		    (l->l_info[DT_PLTREL]->d_un.d_val == DT_RELA
+		     ? sizeof (ElfW(Rela)) : sizeof (ElfW(Rel))),
+		    fn, l, table);
+}
+
+static void
+count_symbol (struct link_map *l, struct dl_reloc_prefetch *table,
+	      unsigned long int symndx, unsigned long int r_type)
+{
+  if (symndx >= table->count)
+    table->count = symndx + 1;
+}
+
+static void
+prefetch_symbol (struct link_map *l, struct dl_reloc_prefetch *table,
+		 unsigned long int symndx, unsigned long int r_type)
+{
+  if (symndx == 0)
+    return;
+  const ElfW(Sym) *sym = ((const ElfW(Sym) *) D_PTR (l, l_info[DT_SYMTAB])
+			  + symndx);
+  if (ELFW(ST_BIND) (sym->st_info) == STB_LOCAL
+      || dl_symbol_visibility_binds_local_p (sym))
+    return;
+
+  /* The first relocation type wins.  If the symbol is also referenced
+     with another class, resolve_map performs that lookup.  */
+  struct dl_reloc_prefetch_entry *e = &table->entries[symndx];
+  if (e->valid)
+    return;
+
+  const struct r_found_version *version = NULL;
+  if (l->l_info[VERSYMIDX (DT_VERSYM)] != NULL)
+    {
+      const ElfW(Half) *versym
+	= (const void *) D_PTR (l, l_info[VERSYMIDX (DT_VERSYM)]);
+      version = &l->l_versions[versym[symndx] & 0x7fff];
+      if (version->hash == 0)
+	version = NULL;
+    }
+
+  int type_class = elf_machine_type_class (r_type);
+  const char *strtab = (const void *) D_PTR (l, l_info[DT_STRTAB]);
+  const ElfW(Sym) *ref = sym;
+  lookup_t result = _dl_lookup_symbol_x (strtab + sym->st_name, l, &ref,
+					 l->l_scope, version, type_class,
+					 DL_LOOKUP_ADD_DEPENDENCY
+					 | DL_LOOKUP_FOR_RELOCATE
+					 | DL_LOOKUP_PREFETCH, NULL);
+  if (ref == NULL ? ELFW(ST_BIND) (sym->st_info) != STB_WEAK
+      : ELFW(ST_BIND) (ref->st_info) == STB_GNU_UNIQUE)
+    return;
+
+  e->map = result;
+  e->sym = ref;
+  e->type_class = type_class;
+  e->valid = true;
+}
+
+static void
+prefetch_object (struct link_map *l)
+{
+  if (l == &GL(dl_rtld_map) || l->l_relocated
+      || l->l_info[DT_SYMTAB] == NULL)
+    return;
+
+  struct dl_reloc_prefetch header = { .count = 0 };
+  for_each_startup_reloc (l, count_symbol, &header);
+  if (header.count == 0)
+    return;
+
+  /* Helper threads cannot use malloc.  */
+  size_t size = ALIGN_UP (sizeof (header)
+			  + header.count
+			  * sizeof (struct dl_reloc_prefetch_entry),
+			  GLRO(dl_pagesize));
+  struct dl_reloc_prefetch *table = __mmap (NULL, size,
+					    PROT_READ | PROT_WRITE,
+					    MAP_PRIVATE | MAP_ANONYMOUS,
+					    -1, 0);
+  if (table == MAP_FAILED)
+    return;
+  table->size = size;
+  table->count = header.count;
+  for_each_startup_reloc (l, prefetch_symbol, table);
+
+  /* Published to the main thread when the helper thread exits.  */
+  l->l_reloc_prefetch = table;
+}
+
+static int
+prefetch_thread (void *closure)
+{
+  struct prefetch_work *work = closure;
+  while (true)
+    {
+      unsigned int i = atomic_fetch_add_relaxed (&work->next, 1);
+      if (i >= work->nobjects)
+	return 0;
+      /* Same order as the relocation loop in dl_main.  */
+      prefetch_object (work->objects[work->nobjects - 1 - i]);
+    }
+}
+
+void
+_dl_reloc_parallel_prefetch (struct link_map *main_map)
+{
+  int32_t nthreads = TUNABLE_GET (glibc, rtld, parallel_reloc, int32_t,
+				  NULL);
+  if (nthreads <= 0
+      /* The statistics counters are not updated atomically, and
+	 LD_DEBUG=bindings and auditors expect lookups in order.  */
+      || GLRO(dl_debug_mask) != 0
+      || GLRO(dl_naudit) > 0
+      /* Lookups found in the resolution cache are cheap already.  */
+      || _dl_resolve_cache_active)
+    return;
+
+  struct prefetch_work work =
+    {
+      .objects = main_map->l_initfini,
+      .nobjects = main_map->l_searchlist.r_nlist,
+    };
+  if (nthreads > MAX_HELPERS)
+    nthreads = MAX_HELPERS;
+  if (nthreads > work.nobjects - 1)
+    nthreads = work.nobjects - 1;
+
+  /* The filter of the global scope cannot be built on the helper
+     threads, and all lookups are about to be performed.  */
+  _dl_scope_filter_build_pending ();
+
+  struct dl_helper_thread helpers[MAX_HELPERS];
+  int started = 0;
+  while (started < nthreads
+	 && _dl_helper_thread_start (&helpers[started], prefetch_thread,
+				     &work))
+    ++started;
+
+  /* The main thread takes its share of the objects.  */
+  prefetch_thread (&work);
+
+  for (int i = 0; i < started; ++i)
+    _dl_helper_thread_join (&helpers[i]);
+}
+
+void
+_dl_reloc_parallel_release (struct link_map *main_map)
+{
+  for (unsigned int i = 0; i < main_map->l_searchlist.r_nlist; ++i)
+    {
+      struct link_map *l = main_map->l_initfini[i];
+      if (l->l_reloc_prefetch != NULL)
+	{
+	  __munmap (l->l_reloc_prefetch, l->l_reloc_prefetch->size);
+	  l->l_reloc_prefetch = NULL;
+	}
+    }
+}
@@ -0,0 +1,74 @@
+/* Symbol lookups for relocation on helper threads.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_RELOC_PARALLEL_H
+#define _DL_RELOC_PARALLEL_H
+
+#include <ldsodefs.h>
+#include <stdbool.h>
+
+/* The result of the lookup for one symbol referenced by the
+   relocations of an object.  */
+struct dl_reloc_prefetch_entry
+{
+  lookup_t map;
+  const ElfW(Sym) *sym;
+  unsigned char type_class;
+  bool valid;
+};
+
+/* The lookup results of an object, indexed by symbol index.  */
+struct dl_reloc_prefetch
+{
+  size_t size;			/* Size of the mapping.  */
+  size_t count;
+  struct dl_reloc_prefetch_entry entries[];
+};
+
+/* Look up the symbols referenced by the relocations of the objects in
+   the search list of MAIN_MAP on glibc.rtld.parallel_reloc helper
+   threads, and store the results in their l_reloc_prefetch tables.
+   Called from dl_main before relocation.  */
+void _dl_reloc_parallel_prefetch (struct link_map *main_map)
+  attribute_hidden;
+
+/* Free the tables once the objects are relocated.  */
+void _dl_reloc_parallel_release (struct link_map *main_map)
+  attribute_hidden;
+
+/* Return true and set *REF and *RESULT if the lookup of *REF with
+   TYPE_CLASS for the relocation of L has been performed ahead of
+   time.  */
+static inline bool
+_dl_reloc_prefetched (struct link_map *l, const ElfW(Sym) **ref,
+		      int type_class, lookup_t *result)
+{
+  const ElfW(Sym) *symtab = (const void *) D_PTR (l, l_info[DT_SYMTAB]);
+  size_t symndx = *ref - symtab;
+  if (symndx >= l->l_reloc_prefetch->count)
+    return false;
+  const struct dl_reloc_prefetch_entry *e
+    = &l->l_reloc_prefetch->entries[symndx];
+  if (!e->valid || e->type_class != type_class)
+    return false;
+  *ref = e->sym;
+  *result = e->map;
+  return true;
+}
+
+#endif /* _DL_RELOC_PARALLEL_H */
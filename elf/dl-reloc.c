@@ -17,6 +17,7 @@
    License along with the GNU C Library; if not, see
    <https://www.gnu.org/licenses/>.  */
 
+#include <atomic.h>
 #include <errno.h>
 #include <libintl.h>
 #include <stdlib.h>
@@ -27,21 +28,40 @@
 #include <sys/types.h>
 #include <_itoa.h>
 #include <libc-pointer-arith.h>
+#include <dl-timeline.h>
 #include "dynamic-link.h"
 
 /* Statistics function.  */
 #ifdef SHARED
+# include <dl-reloc-parallel.h>
+# include <dl-resolve-cache.h>
 # define bump_num_cache_relocations() ++GL(dl_num_cache_relocations)
 #else
 # define bump_num_cache_relocations() ((void) 0)
 #endif
 
 
+/* Set the TLS offset of MAP, which is NO_TLS_OFFSET, to OFFSET, unless
+   a concurrent __tls_get_addr has already switched it to dynamic TLS,
+   which it does without holding GL(dl_load_tls_lock).  */
+static bool
+set_static_tls_offset (struct link_map *map, ptrdiff_t offset)
+{
+  ptrdiff_t expected = NO_TLS_OFFSET;
+  while (!atomic_compare_exchange_weak_relaxed (&map->l_tls_offset,
+						&expected, offset))
+    if (expected != NO_TLS_OFFSET)
+      return false;
+  return true;
+}
+
 /* We are trying to perform a static TLS relocation in MAP, but it was
    dynamically loaded.  This can only work if there is enough surplus in
    the static TLS area already allocated for each running thread.  If this
-   object's TLS segment is too big to fit, we fail with -1.  If it fits,
-   we set MAP->l_tls_offset and return 0.
+   object's TLS segment is too big to fit, we fail with -1.  If a
+   concurrent __tls_get_addr switches MAP to dynamic TLS while we are
+   trying to set its offset, we fail with -2.  If it fits, we set
+   MAP->l_tls_offset and return 0.
    A portion of the surplus static TLS can be optionally used to optimize
    dynamic TLS access (with TLSDESC or powerpc TLS optimizations).
    If OPTIONAL is true then TLS is allocated for such optimization and
@@ -57,6 +77,17 @@ _dl_try_allocate_static_tls (struct link_map *map, bool optional)
       || map->l_tls_align > GLRO (dl_tls_static_align))
     {
     fail:
+      /* The caller falls back to dynamic TLS.  Report this once.  */
+      if (optional && !map->l_tls_optional_failed)
+	{
+	  map->l_tls_optional_failed = 1;
+	  if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_TLS))
+	    _dl_debug_printf ("static TLS: %s: cannot use optional surplus "
+			      "for %zu bytes (%zu bytes left)\n",
+			      DSO_FILENAME (map->l_name),
+			      map->l_tls_blocksize,
+			      GL(dl_tls_static_optional));
+	}
       return -1;
     }
 
@@ -76,12 +107,14 @@ _dl_try_allocate_static_tls (struct link_map *map, bool optional)
   size_t use = freebytes - n * map->l_tls_align - map->l_tls_firstbyte_offset;
   if (optional && use > GL(dl_tls_static_optional))
     goto fail;
-  else if (optional)
-    GL(dl_tls_static_optional) -= use;
 
   size_t offset = GL(dl_tls_static_used) + use;
 
-  map->l_tls_offset = GL(dl_tls_static_used) = offset;
+  if (!set_static_tls_offset (map, offset))
+    goto lost_race;
+  if (optional)
+    GL(dl_tls_static_optional) -= use;
+  GL(dl_tls_static_used) = offset;
 #elif TLS_DTV_AT_TP
   /* dl_tls_static_used includes the TCB at the beginning.  */
   size_t offset = (ALIGN_UP(GL(dl_tls_static_used)
@@ -97,16 +130,25 @@ _dl_try_allocate_static_tls (struct link_map *map, bool optional)
   size_t use = used - GL(dl_tls_static_used);
   if (optional && use > GL(dl_tls_static_optional))
     goto fail;
-  else if (optional)
-    GL(dl_tls_static_optional) -= use;
 
-  map->l_tls_offset = offset;
+  if (!set_static_tls_offset (map, offset))
+    goto lost_race;
+  if (optional)
+    GL(dl_tls_static_optional) -= use;
   map->l_tls_firstbyte_offset = GL(dl_tls_static_used);
   GL(dl_tls_static_used) = used;
 #else
 # error "Either TLS_TCB_AT_TP or TLS_DTV_AT_TP must be defined"
 #endif
 
+  if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_TLS))
+    _dl_debug_printf ("static TLS: %s: %zu bytes at offset 0x%zx%s, "
+		      "%zu bytes of optional surplus left\n",
+		      DSO_FILENAME (map->l_name), map->l_tls_blocksize,
+		      (size_t) map->l_tls_offset,
+		      optional ? " (optional)" : "",
+		      GL(dl_tls_static_optional));
+
   /* If the object is not yet relocated we cannot initialize the
      static TLS region.  Delay it.  */
   if (map->l_real->l_relocated)
@@ -125,6 +167,14 @@ _dl_try_allocate_static_tls (struct link_map *map, bool optional)
     map->l_need_tls_init = 1;
 
   return 0;
+
+ lost_race:
+  /* The surplus was not used up, and the caller falls back to dynamic
+     TLS, which has already been set up for MAP.  */
+  if (__glibc_unlikely (GLRO(dl_debug_mask) & DL_DEBUG_TLS))
+    _dl_debug_printf ("static TLS: %s: switched to dynamic TLS "
+		      "concurrently\n", DSO_FILENAME (map->l_name));
+  return -2;
 }
 
 /* This function intentionally does not return any value but signals error
@@ -187,9 +237,18 @@ resolve_map (lookup_t l, struct r_scope_elem *scope[], const ElfW(Sym) **ref,
       const struct r_found_version *v = NULL;
       if (version != NULL && version->hash != 0)
 	v = version;
-      lookup_t lr = _dl_lookup_symbol_x (
-	  undef_name, l, ref, scope, v, tc,
-	  DL_LOOKUP_ADD_DEPENDENCY | DL_LOOKUP_FOR_RELOCATE, NULL);
+      lookup_t lr;
+#ifdef SHARED
+      if (__glibc_unlikely (l->l_reloc_prefetch != NULL)
+	  && _dl_reloc_prefetched (l, ref, tc, &lr))
+	;
+      else if (__glibc_unlikely (_dl_resolve_cache_active))
+	lr = _dl_resolve_cache_lookup (undef_name, l, ref, scope, v, tc);
+      else
+#endif
+	lr = _dl_lookup_symbol_x (
+	    undef_name, l, ref, scope, v, tc,
+	    DL_LOOKUP_ADD_DEPENDENCY | DL_LOOKUP_FOR_RELOCATE, NULL);
       l->l_lookup_cache.ret = *ref;
       l->l_lookup_cache.value = lr;
     }
@@ -208,6 +267,8 @@ _dl_relocate_object (struct link_map *l, struct r_scope_elem *scope[],
   if (l->l_relocated)
     return;
 
+  uint64_t timeline_start = _dl_timeline_start ();
+
   struct textrels
   {
     caddr_t start;
@@ -347,6 +408,8 @@ _dl_relocate_object (struct link_map *l, struct r_scope_elem *scope[],
      done, do it.  */
   if (l->l_relro_size != 0)
     _dl_protect_relro (l);
+
+  _dl_timeline_end ("relocate", l->l_name, timeline_start);
 }
 
 
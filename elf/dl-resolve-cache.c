@@ -0,0 +1,695 @@
+/* Persistent cache of symbol lookups performed at startup.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The glibc.rtld.resolve_cache tunable names a directory which holds
+   one cache file per program, named after the build ID of the main
+   program in hexadecimal, so that different programs do not replace
+   each other's cache.  The cache file records the result of each
+   symbol lookup performed while the initial objects are relocated, as
+   a hash table mapping (referencing object, symbol index, relocation
+   type class) to (defining object, symbol index).  Objects are identified by their
+   position in the list of loaded objects, so the cache is only used if
+   the build IDs of the loaded objects, their order and the order of
+   their lookup scopes are the same as when it was written.  Otherwise
+   the relocation code falls back to the regular lookup, and the cache
+   file is written again once relocation is complete.
+
+   The cache file is never modified in place.  A new file, or the
+   same table with updated statistics in its header, is written to a
+   temporary file in the same directory and renamed into place, so
+   that other processes either see the old or the new file.  The file
+   is read into memory instead of being mapped, so that the statistics
+   can be updated in the copy which is written out.  The checksum detects damaged files, and the
+   symbol indices in a file read from disk are checked against the
+   size of the symbol tables before they are used.  */
+
+#include <_itoa.h>
+#include <dirent.h>
+#include <dl-diagnostics.h>
+#include <dl-resolve-cache.h>
+#include <dl-tunables.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <not-cancel.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RESOLVE_CACHE_MAGIC "glibc-ld.so-rc1"
+
+/* Marks an unused slot in RESOLVE_CACHE_ENTRY.object, and an unresolved
+   weak reference in RESOLVE_CACHE_ENTRY.provider.  */
+#define RESOLVE_CACHE_NONE UINT32_MAX
+
+struct resolve_cache_header
+{
+  char magic[sizeof (RESOLVE_CACHE_MAGIC)];
+  /* Digest of the build IDs of the objects and of their scopes.  */
+  uint64_t config;
+  /* Digest of the slots following the header.  */
+  uint64_t checksum;
+  uint32_t nobjects;
+  /* Number of slots, a power of two, and of used slots.  */
+  uint32_t nslots;
+  uint32_t nentries;
+  uint32_t pad;
+  /* Number of lookups performed by the last process which used the
+     cache, and how many of them were found in the cache.  These are
+     not covered by the checksum.  */
+  uint64_t last_lookups;
+  uint64_t last_hits;
+};
+
+struct resolve_cache_entry
+{
+  /* Index of the object performing the relocation, or
+     RESOLVE_CACHE_NONE.  */
+  uint32_t object;
+  uint32_t symndx;
+  uint32_t type_class;
+  /* Index of the object providing the definition.  */
+  uint32_t provider;
+  uint32_t provider_symndx;
+};
+
+bool _dl_resolve_cache_active;
+
+/* Path of the cache file for the current program, NUL-terminated.  */
+static char *cache_path;
+
+/* The objects in the base namespace.  The position of each object is
+   stored in its l_idx member while the cache is active.  */
+static struct link_map **cache_maps;
+static uint32_t cache_nobjects;
+static uint64_t cache_config;
+
+/* The number of symbols of each object in CACHE_MAPS, if the cache has
+   been read from the file.  */
+static uint32_t *cache_nsyms;
+
+/* The cache file, followed by its slots.  It is either read from the
+   file, or recorded by the current process.  */
+static struct resolve_cache_header *cache;
+static size_t cache_size;
+static bool cache_recording;
+
+static uint64_t cache_lookups;
+static uint64_t cache_hits;
+
+static inline struct resolve_cache_entry *
+cache_slots (struct resolve_cache_header *header)
+{
+  return (struct resolve_cache_entry *) (header + 1);
+}
+
+static inline size_t
+cache_size_for (uint32_t nslots)
+{
+  return (sizeof (struct resolve_cache_header)
+	  + nslots * sizeof (struct resolve_cache_entry));
+}
+
+/* FNV-1a over the LEN bytes at P.  */
+static uint64_t
+digest_bytes (uint64_t h, const void *p, size_t len)
+{
+  for (const unsigned char *s = p; len > 0; ++s, --len)
+    h = (h ^ *s) * 0x100000001b3ULL;
+  return h;
+}
+
+static inline uint64_t
+digest_word (uint64_t h, uint32_t w)
+{
+  return (h ^ w) * 0x100000001b3ULL;
+}
+
+static uint64_t
+cache_checksum (struct resolve_cache_header *header)
+{
+  const uint32_t *p = (const uint32_t *) cache_slots (header);
+  size_t n = (header->nslots * sizeof (struct resolve_cache_entry)
+	      / sizeof (uint32_t));
+  uint64_t h = 0xcbf29ce484222325ULL;
+  while (n-- > 0)
+    h = digest_word (h, *p++);
+  return h;
+}
+
+static inline uint32_t
+entry_hash (uint32_t object, uint32_t symndx, uint32_t type_class)
+{
+  uint32_t h = (object * 0x9e3779b1U) ^ symndx;
+  h = ((h ^ (h >> 16)) * 0x85ebca6bU) ^ type_class;
+  return h ^ (h >> 13);
+}
+
+/* Return the slot for the key in HEADER, or the unused slot where it
+   would be inserted.  */
+static struct resolve_cache_entry *
+find_slot (struct resolve_cache_header *header, uint32_t object,
+	   uint32_t symndx, uint32_t type_class)
+{
+  struct resolve_cache_entry *slots = cache_slots (header);
+  uint32_t mask = header->nslots - 1;
+  for (uint32_t i = entry_hash (object, symndx, type_class) & mask; ;
+       i = (i + 1) & mask)
+    {
+      struct resolve_cache_entry *e = &slots[i];
+      if (e->object == RESOLVE_CACHE_NONE
+	  || (e->object == object && e->symndx == symndx
+	      && e->type_class == type_class))
+	return e;
+    }
+}
+
+/* Allocate an empty table with NSLOTS slots.  */
+static struct resolve_cache_header *
+cache_allocate (uint32_t nslots)
+{
+  struct resolve_cache_header *header
+    = __mmap (NULL, cache_size_for (nslots), PROT_READ | PROT_WRITE,
+	      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (header == MAP_FAILED)
+    return NULL;
+  memcpy (header->magic, RESOLVE_CACHE_MAGIC, sizeof (header->magic));
+  header->config = cache_config;
+  header->nobjects = cache_nobjects;
+  header->nslots = nslots;
+  memset (cache_slots (header), 0xff,
+	  nslots * sizeof (struct resolve_cache_entry));
+  return header;
+}
+
+/* Add the result of a lookup to the recorded table.  */
+static void
+cache_record (uint32_t object, uint32_t symndx, uint32_t type_class,
+	      uint32_t provider, uint32_t provider_symndx)
+{
+  if (cache->nentries >= cache->nslots / 2)
+    {
+      if (cache->nslots > UINT32_MAX / 4)
+	{
+	  cache_recording = false;
+	  return;
+	}
+      struct resolve_cache_header *grown = cache_allocate (cache->nslots * 2);
+      if (grown == NULL)
+	{
+	  cache_recording = false;
+	  return;
+	}
+      struct resolve_cache_entry *slots = cache_slots (cache);
+      for (uint32_t i = 0; i < cache->nslots; ++i)
+	if (slots[i].object != RESOLVE_CACHE_NONE)
+	  *find_slot (grown, slots[i].object, slots[i].symndx,
+		      slots[i].type_class) = slots[i];
+      grown->nentries = cache->nentries;
+      __munmap (cache, cache_size);
+      cache = grown;
+      cache_size = cache_size_for (grown->nslots);
+    }
+
+  struct resolve_cache_entry *e = find_slot (cache, object, symndx,
+					     type_class);
+  if (e->object == RESOLVE_CACHE_NONE)
+    {
+      e->object = object;
+      e->symndx = symndx;
+      e->type_class = type_class;
+      e->provider = provider;
+      e->provider_symndx = provider_symndx;
+      ++cache->nentries;
+    }
+}
+
+/* Read the cache file FD into anonymous memory and check that it is
+   complete.  Return NULL if it cannot be used.  */
+static struct resolve_cache_header *
+cache_read_fd (int fd, size_t *sizep)
+{
+  struct __stat64_t64 st;
+  if (__fstat64_time64 (fd, &st) < 0
+      || st.st_size < sizeof (struct resolve_cache_header))
+    return NULL;
+  size_t size = st.st_size;
+  struct resolve_cache_header *header
+    = __mmap (NULL, size, PROT_READ | PROT_WRITE,
+	      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (header == MAP_FAILED)
+    return NULL;
+  for (size_t done = 0; done < size; )
+    {
+      ssize_t n = __read_nocancel (fd, (char *) header + done, size - done);
+      if (n <= 0)
+	goto fail;
+      done += n;
+    }
+
+  if (memcmp (header->magic, RESOLVE_CACHE_MAGIC, sizeof (header->magic))
+      != 0
+      || header->nslots == 0
+      || (header->nslots & (header->nslots - 1)) != 0
+      || header->nslots > UINT32_MAX / 2
+      || header->nentries > header->nslots / 2
+      || size != cache_size_for (header->nslots)
+      || header->checksum != cache_checksum (header))
+    goto fail;
+  *sizep = size;
+  return header;
+
+ fail:
+  __munmap (header, size);
+  return NULL;
+}
+
+/* Like cache_read_fd, for the file at PATH.  */
+static struct resolve_cache_header *
+cache_read (const char *path, size_t *sizep)
+{
+  int fd = __open64_nocancel (path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  struct resolve_cache_header *header = cache_read_fd (fd, sizep);
+  __close_nocancel (fd);
+  return header;
+}
+
+/* Store the build ID of L in *ID and *LEN.  */
+static bool
+object_build_id (struct link_map *l, const char **id, size_t *len)
+{
+  for (const ElfW(Phdr) *ph = l->l_phdr; ph < &l->l_phdr[l->l_phnum]; ++ph)
+    if (ph->p_type == PT_NOTE)
+      {
+	size_t align = ph->p_align == 8 ? 8 : 4;
+	const char *p = (const char *) (l->l_addr + ph->p_vaddr);
+	const char *end = p + ph->p_memsz;
+	while (end - p >= sizeof (ElfW(Nhdr)))
+	  {
+	    const ElfW(Nhdr) *note = (const ElfW(Nhdr) *) p;
+	    size_t next = ELF_NOTE_NEXT_OFFSET (note->n_namesz,
+						note->n_descsz, align);
+	    if (next > end - p)
+	      break;
+	    if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4
+		&& memcmp (note + 1, "GNU", 4) == 0)
+	      {
+		*id = p + ELF_NOTE_DESC_OFFSET (note->n_namesz, align);
+		*len = note->n_descsz;
+		return true;
+	      }
+	    p += next;
+	  }
+      }
+  return false;
+}
+
+/* Return the number of entries in the symbol table of L, as implied by
+   its hash table.  */
+static uint32_t
+object_symbol_count (struct link_map *l)
+{
+  if (l->l_info[ELF_MACHINE_GNU_HASH_ADDRIDX] != NULL)
+    {
+      /* The symbols past the bias are in the chains, and the chain of
+	 the highest bucket ends with the last symbol.  */
+      const Elf32_Word *hash32
+	= (const void *) D_PTR (l, l_info[ELF_MACHINE_GNU_HASH_ADDRIDX]);
+      Elf32_Word symbias = hash32[1];
+      Elf32_Word last = 0;
+      for (Elf32_Word i = 0; i < l->l_nbuckets; ++i)
+	if (l->l_gnu_buckets[i] > last)
+	  last = l->l_gnu_buckets[i];
+      if (last < symbias)
+	return symbias;
+      while ((l->l_gnu_chain_zero[last] & 1) == 0)
+	++last;
+      return last + 1;
+    }
+  if (l->l_info[DT_HASH] != NULL)
+    /* The number of chains is the number of symbols.  */
+    return ((const Elf_Symndx *) D_PTR (l, l_info[DT_HASH]))[1];
+  return 0;
+}
+
+/* Set CACHE_PATH to the name of the cache file for the main program in
+   the directory DIR of length LEN.  */
+static bool
+cache_setup_path (const char *dir, size_t len)
+{
+  const char *id;
+  size_t idlen;
+  if (!object_build_id (cache_maps[0], &id, &idlen) || idlen == 0)
+    return false;
+  cache_path = malloc (len + 1 + 2 * idlen + 1);
+  if (cache_path == NULL)
+    return false;
+  char *p = __mempcpy (cache_path, dir, len);
+  *p++ = '/';
+  for (size_t i = 0; i < idlen; ++i)
+    {
+      unsigned char c = id[i];
+      *p++ = _itoa_lower_digits[c >> 4];
+      *p++ = _itoa_lower_digits[c & 15];
+    }
+  *p = '\0';
+  return true;
+}
+
+/* Undo the numbering of the first COUNT objects in CACHE_MAPS, and
+   free it.  */
+static void
+cache_release_objects (uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    cache_maps[i]->l_idx = 0;
+  free (cache_maps);
+  cache_maps = NULL;
+  cache_nobjects = 0;
+}
+
+/* Compute the digest identifying the objects in the base namespace and
+   their scopes, and number the objects.  Return false if an object
+   has no build ID.  */
+static bool
+cache_setup_objects (void)
+{
+  struct r_scope_elem *main_scope
+    = GL(dl_ns)[LM_ID_BASE]._ns_main_searchlist;
+  uint32_t n = GL(dl_ns)[LM_ID_BASE]._ns_nloaded;
+  cache_maps = malloc (n * sizeof (*cache_maps));
+  if (cache_maps == NULL)
+    return false;
+
+  uint32_t i = 0;
+  for (struct link_map *l = GL(dl_ns)[LM_ID_BASE]._ns_loaded;
+       l != NULL && i < n; l = l->l_next)
+    {
+      l->l_idx = i;
+      cache_maps[i++] = l;
+    }
+  if (i != n)
+    {
+      cache_release_objects (i);
+      return false;
+    }
+  cache_nobjects = n;
+
+  uint64_t h = digest_word (0xcbf29ce484222325ULL, n);
+  for (i = 0; i < n; ++i)
+    {
+      struct link_map *l = cache_maps[i];
+      const char *id;
+      size_t len;
+      if (!object_build_id (l, &id, &len))
+	{
+	  cache_release_objects (n);
+	  return false;
+	}
+      h = digest_word (h, len);
+      h = digest_bytes (h, id, len);
+
+      /* Nearly every object uses the global scope, which is hashed
+	 only once below.  The dynamic linker has no scope of its own.  */
+      for (size_t s = 0; l->l_scope != NULL && l->l_scope[s] != NULL; ++s)
+	if (l->l_scope[s] == main_scope)
+	  h = digest_word (h, RESOLVE_CACHE_NONE);
+	else
+	  {
+	    h = digest_word (h, l->l_scope[s]->r_nlist);
+	    for (unsigned int j = 0; j < l->l_scope[s]->r_nlist; ++j)
+	      h = digest_word (h, l->l_scope[s]->r_list[j]->l_idx);
+	  }
+      h = digest_word (h, RESOLVE_CACHE_NONE - 1);
+    }
+  for (unsigned int j = 0; j < main_scope->r_nlist; ++j)
+    h = digest_word (h, main_scope->r_list[j]->l_idx);
+  cache_config = h;
+  return true;
+}
+
+void
+_dl_resolve_cache_init (void)
+{
+  const struct tunable_str_t *path
+    = TUNABLE_GET (glibc, rtld, resolve_cache, struct tunable_str_t *, NULL);
+  if (path->str == NULL || path->len == 0
+      /* Do not let the environment select a file which changes symbol
+	 bindings in privileged programs.  */
+      || __libc_enable_secure
+      /* Auditors and LD_DEBUG=bindings observe every lookup.  */
+      || GLRO(dl_naudit) > 0
+      || (GLRO(dl_debug_mask) & DL_DEBUG_BINDINGS) != 0)
+    return;
+
+  if (!cache_setup_objects ())
+    return;
+  if (!cache_setup_path (path->str, path->len))
+    {
+      cache_release_objects (cache_nobjects);
+      return;
+    }
+
+  cache = cache_read (cache_path, &cache_size);
+  if (cache != NULL
+      && (cache->config != cache_config || cache->nobjects != cache_nobjects))
+    {
+      __munmap (cache, cache_size);
+      cache = NULL;
+    }
+  if (cache == NULL)
+    {
+      cache = cache_allocate (1024);
+      if (cache == NULL)
+	goto fail;
+      cache_size = cache_size_for (cache->nslots);
+      cache_recording = true;
+    }
+  else
+    {
+      cache_nsyms = malloc (cache_nobjects * sizeof (*cache_nsyms));
+      if (cache_nsyms == NULL)
+	{
+	  __munmap (cache, cache_size);
+	  cache = NULL;
+	  goto fail;
+	}
+      for (uint32_t i = 0; i < cache_nobjects; ++i)
+	cache_nsyms[i] = object_symbol_count (cache_maps[i]);
+    }
+
+  _dl_resolve_cache_active = true;
+  return;
+
+ fail:
+  free (cache_path);
+  cache_path = NULL;
+  cache_release_objects (cache_nobjects);
+}
+
+lookup_t
+_dl_resolve_cache_lookup (const char *undef_name, struct link_map *undef_map,
+			  const ElfW(Sym) **ref,
+			  struct r_scope_elem *symbol_scope[],
+			  const struct r_found_version *version,
+			  int type_class)
+{
+  const ElfW(Sym) *symtab = (const void *) D_PTR (undef_map,
+						  l_info[DT_SYMTAB]);
+  uint32_t symndx = *ref - symtab;
+  ++cache_lookups;
+
+  if (!cache_recording)
+    {
+      struct resolve_cache_entry *e = find_slot (cache, undef_map->l_idx,
+						 symndx, type_class);
+      if (e->object == RESOLVE_CACHE_NONE)
+	;
+      else if (e->provider == RESOLVE_CACHE_NONE)
+	{
+	  ++cache_hits;
+	  *ref = NULL;
+	  return NULL;
+	}
+      else if (e->provider < cache_nobjects
+	       && e->provider_symndx < cache_nsyms[e->provider])
+	{
+	  struct link_map *m = cache_maps[e->provider];
+	  const ElfW(Sym) *sym = ((const ElfW(Sym) *) D_PTR (m,
+							     l_info[DT_SYMTAB])
+				  + e->provider_symndx);
+	  const char *strtab = (const void *) D_PTR (m, l_info[DT_STRTAB]);
+	  /* Guard against digest collisions.  */
+	  if (strcmp (strtab + sym->st_name, undef_name) == 0)
+	    {
+	      ++cache_hits;
+	      m->l_used = 1;
+	      *ref = sym;
+	      return m;
+	    }
+	}
+    }
+
+  lookup_t result = _dl_lookup_symbol_x (undef_name, undef_map, ref,
+					 symbol_scope, version, type_class,
+					 DL_LOOKUP_ADD_DEPENDENCY
+					 | DL_LOOKUP_FOR_RELOCATE, NULL);
+
+  /* Unique symbols are entered into a table by the lookup, which must
+     happen in every process.  */
+  if (cache_recording
+      && (*ref == NULL
+	  || ELFW(ST_BIND) ((*ref)->st_info) != STB_GNU_UNIQUE))
+    {
+      if (*ref == NULL)
+	cache_record (undef_map->l_idx, symndx, type_class,
+		      RESOLVE_CACHE_NONE, 0);
+      else
+	cache_record (undef_map->l_idx, symndx, type_class, result->l_idx,
+		      *ref - (const ElfW(Sym) *) D_PTR (result,
+							 l_info[DT_SYMTAB]));
+    }
+  return result;
+}
+
+/* Write CACHE to a file under a name unique to this process, and
+   replace the file at CACHE_PATH only if the new one is complete.  */
+static void
+cache_write (void)
+{
+  size_t len = strlen (cache_path);
+  char tmp[len + 2 + 3 * sizeof (pid_t)];
+  char *p = __mempcpy (tmp, cache_path, len);
+  *p++ = '.';
+  char buf[3 * sizeof (pid_t)];
+  char *end = buf + sizeof (buf);
+  char *digits = _itoa (__getpid (), end, 16, 0);
+  *(char *) __mempcpy (p, digits, end - digits) = '\0';
+
+  int fd = __open64_nocancel (tmp, (O_WRONLY | O_CREAT | O_TRUNC
+				    | O_NOFOLLOW | O_CLOEXEC), 0644);
+  if (fd < 0)
+    return;
+  size_t done = 0;
+  while (done < cache_size)
+    {
+      ssize_t n = __write_nocancel (fd, (char *) cache + done,
+				    cache_size - done);
+      if (n <= 0)
+	break;
+      done += n;
+    }
+  if (__close_nocancel (fd) != 0 || done < cache_size
+      || __renameat (AT_FDCWD, tmp, AT_FDCWD, cache_path) != 0)
+    __unlink (tmp);
+}
+
+void
+_dl_resolve_cache_fini (void)
+{
+  if (!_dl_resolve_cache_active)
+    return;
+  _dl_resolve_cache_active = false;
+
+  /* A table read from the file is written back unchanged, with the
+     statistics of this process, so that a file replaced by another
+     process in the meantime is never modified.  */
+  if (cache_recording)
+    cache->checksum = cache_checksum (cache);
+  cache->last_lookups = cache_lookups;
+  cache->last_hits = cache_hits;
+  cache_write ();
+
+  __munmap (cache, cache_size);
+  cache = NULL;
+}
+
+/* Print the statistics of the cache file NAME in the directory DIRFD,
+   the INDEX-th file listed.  */
+static void
+print_cache_file (int dirfd, const char *name, unsigned int index)
+{
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_string ("name", name);
+
+  size_t size;
+  struct resolve_cache_header *header = NULL;
+  int fd = __openat64_nocancel (dirfd, name, O_RDONLY | O_CLOEXEC);
+  if (fd >= 0)
+    {
+      header = cache_read_fd (fd, &size);
+      __close_nocancel (fd);
+    }
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_value ("valid", header != NULL);
+  if (header == NULL)
+    return;
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_value ("objects", header->nobjects);
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_value ("entries", header->nentries);
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_value ("last_lookups", header->last_lookups);
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_value ("last_hits", header->last_hits);
+  /* Hit rate of the last process in percent.  */
+  _dl_printf ("resolve_cache.file[0x%x].", index);
+  _dl_diagnostics_print_labeled_value
+    ("last_hit_rate",
+     header->last_lookups == 0
+     ? 0 : header->last_hits * 100 / header->last_lookups);
+  __munmap (header, size);
+}
+
+void
+_dl_resolve_cache_diagnostics (void)
+{
+  const struct tunable_str_t *path
+    = TUNABLE_GET (glibc, rtld, resolve_cache, struct tunable_str_t *, NULL);
+  if (path->str == NULL || path->len == 0)
+    return;
+
+  char *name = malloc (path->len + 1);
+  if (name == NULL)
+    return;
+  *(char *) __mempcpy (name, path->str, path->len) = '\0';
+  _dl_diagnostics_print_labeled_string ("resolve_cache.path", name);
+
+  int dirfd = __open64_nocancel (name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirfd < 0)
+    return;
+  /* List the cache files, skipping temporary files, which have a
+     suffix.  */
+  unsigned int index = 0;
+  char buf[4096] __attribute__ ((aligned (__alignof__ (struct dirent64))));
+  ssize_t size;
+  while ((size = __getdents64 (dirfd, buf, sizeof (buf))) > 0)
+    for (ssize_t offset = 0; offset < size; )
+      {
+	const struct dirent64 *d = (const struct dirent64 *) (buf + offset);
+	offset += d->d_reclen;
+	if (d->d_name[0] != '.' && strchr (d->d_name, '.') == NULL)
+	  print_cache_file (dirfd, d->d_name, index++);
+      }
+  __close_nocancel (dirfd);
+}
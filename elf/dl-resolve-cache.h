@@ -0,0 +1,50 @@
+/* Persistent cache of symbol lookups performed at startup.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_RESOLVE_CACHE_H
+#define _DL_RESOLVE_CACHE_H
+
+#include <ldsodefs.h>
+#include <stdbool.h>
+
+/* True while the initial objects are relocated with the cache named by
+   the glibc.rtld.resolve_cache tunable.  */
+extern bool _dl_resolve_cache_active attribute_hidden;
+
+/* Load the cache, or prepare to record it, for the objects in the
+   base namespace.  Called from dl_main before relocation.  */
+void _dl_resolve_cache_init (void) attribute_hidden;
+
+/* Look up UNDEF_NAME for the relocation of UNDEF_MAP against *REF,
+   like _dl_lookup_symbol_x, using the cache if possible.  Called by
+   the relocation code if _dl_resolve_cache_active.  */
+lookup_t _dl_resolve_cache_lookup (const char *undef_name,
+				   struct link_map *undef_map,
+				   const ElfW(Sym) **ref,
+				   struct r_scope_elem *symbol_scope[],
+				   const struct r_found_version *version,
+				   int type_class) attribute_hidden;
+
+/* Write the recorded cache, or the hit statistics of the loaded one,
+   after the initial objects have been relocated.  */
+void _dl_resolve_cache_fini (void) attribute_hidden;
+
+/* Print the contents of the cache file for ld.so --list-diagnostics.  */
+void _dl_resolve_cache_diagnostics (void) attribute_hidden;
+
+#endif /* _DL_RESOLVE_CACHE_H */
@@ -0,0 +1,391 @@
+/* Per-scope symbol hash filters for symbol lookup.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <dl-scope-filter.h>
+#include <dl-tunables.h>
+#include <libc-pointer-arith.h>
+#include <limits.h>
+#include <rtld-malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+struct r_scope_elem *_dl_scope_filter_pending;
+unsigned int _dl_scope_filter_pending_visits;
+
+/* Objects added to a scope with a filter are only covered by a new
+   segment once there are at least this many of them.  */
+#define MIN_SEGMENT_OBJECTS 8
+
+/* If a filter would have more segments than this, it is rebuilt with
+   a single segment.  */
+#define MAX_SEGMENTS 8
+
+/* Average number of entries per bucket.  */
+#define ENTRIES_PER_BUCKET 4
+
+/* Return false if memory allocated now with malloc would come from
+   the minimal malloc in ld.so, which cannot free it.  */
+static bool
+malloc_is_complete (void)
+{
+#ifdef SHARED
+  return __rtld_malloc_is_complete ();
+#else
+  return true;
+#endif
+}
+
+/* Allocate SIZE bytes, with a mapping of their own if malloc is not
+   complete yet, and store the size of the mapping, or zero, in
+   *MAPPED.  */
+static void *
+filter_alloc (size_t size, size_t *mapped)
+{
+  *mapped = 0;
+  if (malloc_is_complete ())
+    return malloc (size);
+  size = ALIGN_UP (size, GLRO(dl_pagesize));
+  void *p = __mmap (NULL, size, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  *mapped = size;
+  return p;
+}
+
+/* Free P, allocated by filter_alloc, which is not used anymore.  */
+static void
+filter_free (void *p, size_t mapped)
+{
+  if (mapped != 0)
+    __munmap (p, mapped);
+  else
+    free (p);
+}
+
+/* Free P, allocated by filter_alloc, once concurrent lookups are
+   done with it.  */
+static void
+filter_free_deferred (void *p, size_t mapped)
+{
+  if (mapped == 0)
+    _dl_scope_free (p);
+  else
+    {
+      if (!RTLD_SINGLE_THREAD_P)
+	THREAD_GSCOPE_WAIT ();
+      __munmap (p, mapped);
+    }
+}
+
+/* Call FN (CLOSURE, HASH) for the hash value of every symbol in the
+   GNU hash table of MAP.  */
+static __always_inline void
+for_each_hash (const struct link_map *map,
+	       void (*fn) (void *, uint32_t), void *closure)
+{
+  for (Elf32_Word bucket = 0; bucket < map->l_nbuckets; ++bucket)
+    {
+      Elf32_Word symidx = map->l_gnu_buckets[bucket];
+      if (symidx == 0)
+	continue;
+      const Elf32_Word *hasharr = &map->l_gnu_chain_zero[symidx];
+      do
+	fn (closure, *hasharr & ~1u);
+      while ((*hasharr++ & 1u) == 0);
+    }
+}
+
+static void
+count_hash (void *closure, uint32_t hash)
+{
+  ++*(size_t *) closure;
+}
+
+struct fill_state
+{
+  uint32_t mask;
+  uint32_t index;
+  uint32_t *offsets;
+  struct dl_scope_filter_entry *entries;
+};
+
+static void
+count_bucket (void *closure, uint32_t hash)
+{
+  struct fill_state *state = closure;
+  ++state->offsets[((hash >> 1) & state->mask) + 1];
+}
+
+static void
+fill_bucket (void *closure, uint32_t hash)
+{
+  struct fill_state *state = closure;
+  struct dl_scope_filter_entry *e
+    = &state->entries[state->offsets[(hash >> 1) & state->mask]++];
+  e->hash = hash;
+  e->index = state->index;
+}
+
+/* Build a segment covering objects START to END - 1 of LIST.  Return
+   NULL on memory allocation failure, or if an object does not have a
+   GNU hash table.  */
+static struct dl_scope_filter_segment *
+build_segment (struct link_map **list, unsigned int start, unsigned int end)
+{
+  size_t count = 0;
+  for (unsigned int i = start; i < end; ++i)
+    {
+      const struct link_map *map = list[i]->l_real;
+      if (map->l_nbuckets == 0)
+	/* Such objects are skipped by do_lookup_x.  */
+	continue;
+      if (map->l_gnu_bitmask == NULL)
+	return NULL;
+      for_each_hash (map, count_hash, &count);
+    }
+  if (count > UINT32_MAX)
+    return NULL;
+
+  uint32_t nbuckets = 1;
+  while (nbuckets < count / ENTRIES_PER_BUCKET)
+    nbuckets *= 2;
+
+  size_t size = (sizeof (struct dl_scope_filter_segment)
+		 + count * sizeof (struct dl_scope_filter_entry)
+		 + (nbuckets + 1) * sizeof (uint32_t));
+  size_t mapped;
+  struct dl_scope_filter_segment *seg = filter_alloc (size, &mapped);
+  if (seg == NULL)
+    return NULL;
+  struct fill_state state =
+    {
+      .mask = nbuckets - 1,
+      .entries = (struct dl_scope_filter_entry *) (seg + 1),
+    };
+  state.offsets = (uint32_t *) (state.entries + count);
+
+  /* Count the entries per bucket in OFFSETS[B + 1], and turn this into
+     the start offset of each bucket.  */
+  memset (state.offsets, 0, (nbuckets + 1) * sizeof (uint32_t));
+  for (unsigned int i = start; i < end; ++i)
+    if (list[i]->l_real->l_nbuckets != 0)
+      for_each_hash (list[i]->l_real, count_bucket, &state);
+  for (uint32_t b = 1; b <= nbuckets; ++b)
+    state.offsets[b] += state.offsets[b - 1];
+
+  /* Fill in the entries in scope order, which advances OFFSETS[B] to
+     the start of bucket B + 1.  Then restore the start offsets.  */
+  for (unsigned int i = start; i < end; ++i)
+    if (list[i]->l_real->l_nbuckets != 0)
+      {
+	state.index = i - start;
+	for_each_hash (list[i]->l_real, fill_bucket, &state);
+      }
+  for (uint32_t b = nbuckets - 1; b > 0; --b)
+    state.offsets[b] = state.offsets[b - 1];
+  state.offsets[0] = 0;
+
+  seg->start = start;
+  seg->end = end;
+  seg->mask = nbuckets - 1;
+  seg->offsets = state.offsets;
+  seg->entries = state.entries;
+  seg->mapped = mapped;
+  seg->rebuild = false;
+  return seg;
+}
+
+/* Return the minimum number of objects of a scope with a filter.  */
+static unsigned int
+min_objects (void)
+{
+  int32_t min = TUNABLE_GET (glibc, rtld, scope_filter, int32_t, NULL);
+  return min <= 0 ? UINT_MAX : min;
+}
+
+void
+_dl_scope_filter_defer (struct r_scope_elem *scope)
+{
+  if (scope != NULL && scope->r_nlist < min_objects ())
+    scope = NULL;
+  _dl_scope_filter_pending = scope;
+  _dl_scope_filter_pending_visits = min_objects ();
+}
+
+void
+_dl_scope_filter_build_pending (void)
+{
+  if (_dl_scope_filter_pending != NULL)
+    _dl_scope_filter_update (_dl_scope_filter_pending);
+}
+
+void
+_dl_scope_filter_update (struct r_scope_elem *scope)
+{
+  /* Whether or not the filter can be built, do not try again on
+     lookups.  */
+  if (scope == _dl_scope_filter_pending)
+    _dl_scope_filter_pending = NULL;
+
+  unsigned int n = scope->r_nlist;
+  if (n < min_objects ())
+    return;
+
+  struct dl_scope_filter *old = scope->r_filter;
+  unsigned int covered = 0;
+  unsigned int nsegments = 0;
+  if (old != NULL)
+    {
+      nsegments = old->nsegments;
+      covered = old->segments[nsegments - 1]->end;
+      if (n <= covered || n - covered < MIN_SEGMENT_OBJECTS)
+	return;
+      if (nsegments == MAX_SEGMENTS)
+	{
+	  /* Start over with a single segment.  */
+	  covered = 0;
+	  nsegments = 0;
+	}
+    }
+
+  size_t mapped;
+  struct dl_scope_filter *filter
+    = filter_alloc (sizeof (*filter)
+		    + (nsegments + 1) * sizeof (struct dl_scope_filter_segment *),
+		    &mapped);
+  if (filter == NULL)
+    return;
+  struct dl_scope_filter_segment *seg
+    = build_segment (scope->r_list, covered, n);
+  if (seg == NULL)
+    {
+      filter_free (filter, mapped);
+      return;
+    }
+  filter->nsegments = nsegments + 1;
+  filter->mapped = mapped;
+  if (nsegments > 0)
+    memcpy (filter->segments, old->segments,
+	    nsegments * sizeof (struct dl_scope_filter_segment *));
+  filter->segments[nsegments] = seg;
+
+  atomic_store_release (&scope->r_filter, filter);
+
+  if (old != NULL)
+    {
+      /* The segments of OLD which are not part of FILTER are freed
+	 along with the header, after concurrent lookups are done.  */
+      for (unsigned int i = nsegments; i < old->nsegments; ++i)
+	filter_free_deferred (old->segments[i], old->segments[i]->mapped);
+      filter_free_deferred (old, old->mapped);
+    }
+}
+
+/* Return the number of objects with l_removed set among objects START
+   to END - 1 of LIST.  */
+static unsigned int
+count_removed (struct link_map **list, unsigned int start, unsigned int end)
+{
+  unsigned int count = 0;
+  for (unsigned int i = start; i < end; ++i)
+    count += list[i]->l_removed;
+  return count;
+}
+
+struct dl_scope_filter *
+_dl_scope_filter_detach (struct r_scope_elem *scope)
+{
+  struct dl_scope_filter *filter = scope->r_filter;
+  if (filter == NULL)
+    return NULL;
+
+  /* Lookups which have loaded the filter use its indices with the
+     current R_LIST, so they must be done before any object is
+     removed.  Lookups which start later search without a filter.  */
+  atomic_store_relaxed (&scope->r_filter, NULL);
+  if (!RTLD_SINGLE_THREAD_P)
+    THREAD_GSCOPE_WAIT ();
+
+  /* Move the segments to the indices their objects will have once the
+     removed objects are gone, which only changes their start and end
+     because the entries are relative to the start.  */
+  unsigned int removed = 0;
+  unsigned int prev_end = 0;
+  for (unsigned int i = 0; i < filter->nsegments; ++i)
+    {
+      struct dl_scope_filter_segment *seg = filter->segments[i];
+      removed += count_removed (scope->r_list, prev_end, seg->start);
+      unsigned int inside = count_removed (scope->r_list,
+					   seg->start, seg->end);
+      prev_end = seg->end;
+      seg->start -= removed;
+      seg->end -= removed + inside;
+      seg->rebuild = inside > 0;
+      removed += inside;
+    }
+  return filter;
+}
+
+void
+_dl_scope_filter_reattach (struct r_scope_elem *scope,
+			   struct dl_scope_filter *filter)
+{
+  if (filter != NULL)
+    {
+      /* No lookup uses FILTER, so it can be changed in place.  */
+      unsigned int nsegments = 0;
+      for (unsigned int i = 0; i < filter->nsegments; ++i)
+	{
+	  struct dl_scope_filter_segment *seg = filter->segments[i];
+	  if (seg->rebuild)
+	    {
+	      struct dl_scope_filter_segment *old = seg;
+	      seg = NULL;
+	      if (old->end - old->start >= MIN_SEGMENT_OBJECTS)
+		seg = build_segment (scope->r_list, old->start, old->end);
+	      filter_free (old, old->mapped);
+	    }
+	  /* Objects which are not covered anymore are visited without
+	     the filter.  */
+	  if (seg != NULL)
+	    filter->segments[nsegments++] = seg;
+	}
+      filter->nsegments = nsegments;
+
+      if (nsegments == 0 || scope->r_nlist < min_objects ())
+	_dl_scope_filter_free (filter);
+      else
+	atomic_store_release (&scope->r_filter, filter);
+    }
+
+  /* Cover the objects at the end of the scope, or build a new filter
+     if there was none.  */
+  _dl_scope_filter_update (scope);
+}
+
+void
+_dl_scope_filter_free (struct dl_scope_filter *filter)
+{
+  if (filter == NULL)
+    return;
+  for (unsigned int i = 0; i < filter->nsegments; ++i)
+    filter_free (filter->segments[i], filter->segments[i]->mapped);
+  filter_free (filter, filter->mapped);
+}
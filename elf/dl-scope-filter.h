@@ -0,0 +1,188 @@
+/* Per-scope symbol hash filters for symbol lookup.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_SCOPE_FILTER_H
+#define _DL_SCOPE_FILTER_H
+
+#include <atomic.h>
+#include <ldsodefs.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A scope filter records, for the GNU hash value of every symbol
+   defined by the objects of a large scope, the indices of the objects
+   in the scope which define a symbol with that hash.  do_lookup_x
+   then only visits these candidate objects, instead of probing the
+   bloom filter of every object in the scope in turn.
+
+   The filter consists of segments, each covering a range of objects
+   in the scope.  Objects added to the global scope by dlopen are
+   covered by a new segment, and objects not covered by any segment
+   are visited as before.  When dlclose removes objects from the global
+   scope, only the segments which covered them are rebuilt.
+
+   The filter of the initial global scope is only built once a lookup
+   during startup visits many of its objects, so that programs whose
+   lookups are fast do not pay for it.  */
+
+struct dl_scope_filter_entry
+{
+  /* GNU hash value, with the lowest bit cleared.  */
+  uint32_t hash;
+  /* Index of the defining object in the scope, relative to the start
+     of the segment, so that the segment remains valid when objects
+     before it are removed from the scope.  */
+  uint32_t index;
+};
+
+struct dl_scope_filter_segment
+{
+  /* Objects START to END - 1 of the scope are covered.  */
+  unsigned int start;
+  unsigned int end;
+  /* Number of buckets minus one.  The number of buckets is a power of
+     two.  */
+  uint32_t mask;
+  /* The entries of bucket B are ENTRIES[OFFSETS[B]] to
+     ENTRIES[OFFSETS[B + 1] - 1], sorted by object index.  */
+  const uint32_t *offsets;
+  const struct dl_scope_filter_entry *entries;
+  /* The size of the mapping if allocated with mmap during startup, or
+     zero if allocated with malloc.  */
+  size_t mapped;
+  /* Set by _dl_scope_filter_detach if objects covered by the segment
+     are removed.  */
+  bool rebuild;
+};
+
+struct dl_scope_filter
+{
+  unsigned int nsegments;
+  /* As in struct dl_scope_filter_segment.  */
+  size_t mapped;
+  /* Sorted by object index, not overlapping.  */
+  struct dl_scope_filter_segment *segments[];
+};
+
+/* Build or extend the filter of SCOPE to cover all of its objects if
+   it is large enough according to the glibc.rtld.scope_filter tunable.
+   Must be called with GL(dl_load_lock) held (or during startup) after
+   objects have been added to the end of the scope.  Memory allocation
+   failure is not an error; the objects which are not covered are then
+   searched without the filter.  */
+void _dl_scope_filter_update (struct r_scope_elem *scope) attribute_hidden;
+
+/* The initial global scope while building its filter is deferred, or
+   NULL, and the number of objects a lookup in it must visit to build
+   the filter.  */
+extern struct r_scope_elem *_dl_scope_filter_pending attribute_hidden;
+extern unsigned int _dl_scope_filter_pending_visits attribute_hidden;
+
+/* Defer building the filter of SCOPE, the initial global scope, until
+   a lookup visits as many objects as the glibc.rtld.scope_filter
+   tunable requires for a filter.  Filters are only built this way on
+   the main thread during startup, so this must be called with a null
+   SCOPE before other threads can perform lookups.  */
+void _dl_scope_filter_defer (struct r_scope_elem *scope) attribute_hidden;
+
+/* Build the deferred filter now, if there is one.  */
+void _dl_scope_filter_build_pending (void) attribute_hidden;
+
+/* Detach the filter from SCOPE before the objects which have
+   l_removed set are removed from it, and return it.  This waits until
+   no lookup uses the filter anymore, so the objects can be removed
+   afterwards.  The result must be passed to _dl_scope_filter_reattach
+   once the objects have been removed.  */
+struct dl_scope_filter *_dl_scope_filter_detach (struct r_scope_elem *scope)
+  attribute_hidden;
+
+/* Attach FILTER, the result of _dl_scope_filter_detach, to SCOPE after
+   objects have been removed from SCOPE.  Only the segments which
+   covered removed objects are rebuilt.  */
+void _dl_scope_filter_reattach (struct r_scope_elem *scope,
+				struct dl_scope_filter *filter)
+  attribute_hidden;
+
+/* Free FILTER, which is no longer used, and its segments.  */
+void _dl_scope_filter_free (struct dl_scope_filter *filter) attribute_hidden;
+
+/* State for iterating over the candidate objects of a lookup.  */
+struct dl_scope_filter_iter
+{
+  const struct dl_scope_filter *filter;
+  uint32_t hash;
+  /* The current segment, and the remaining entries of the bucket of
+     HASH in it.  */
+  unsigned int segment;
+  const struct dl_scope_filter_entry *entry;
+  const struct dl_scope_filter_entry *entry_end;
+};
+
+static __always_inline void
+_dl_scope_filter_iter_init (struct dl_scope_filter_iter *it,
+			    struct r_scope_elem *scope, uint32_t hash)
+{
+  it->filter = atomic_load_acquire (&scope->r_filter);
+  it->hash = hash;
+  it->segment = 0;
+  it->entry = it->entry_end = NULL;
+}
+
+/* Return the index of the first object in the scope at or after index I
+   which may define a symbol with the hash value of IT, or a value not
+   less than N.  */
+static __always_inline size_t
+_dl_scope_filter_next (struct dl_scope_filter_iter *it, size_t i, size_t n)
+{
+  const struct dl_scope_filter *filter = it->filter;
+  if (__glibc_likely (filter == NULL))
+    return i;
+
+  while (i < n)
+    {
+      while (it->segment < filter->nsegments
+	     && filter->segments[it->segment]->end <= i)
+	{
+	  ++it->segment;
+	  it->entry = NULL;
+	}
+      if (it->segment == filter->nsegments)
+	return i;
+      const struct dl_scope_filter_segment *seg
+	= filter->segments[it->segment];
+      if (i < seg->start)
+	return i;
+
+      if (it->entry == NULL)
+	{
+	  uint32_t bucket = (it->hash >> 1) & seg->mask;
+	  it->entry = &seg->entries[seg->offsets[bucket]];
+	  it->entry_end = &seg->entries[seg->offsets[bucket + 1]];
+	}
+      for (; it->entry < it->entry_end; ++it->entry)
+	if (seg->start + it->entry->index >= i
+	    && ((it->entry->hash ^ it->hash) >> 1) == 0)
+	  return seg->start + it->entry->index;
+
+      /* No candidates left in this segment.  */
+      i = seg->end;
+    }
+  return i;
+}
+
+#endif /* _DL_SCOPE_FILTER_H */
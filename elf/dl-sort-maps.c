@@ -172,6 +172,89 @@ dfs_traversal (struct link_map ***rpo, struct link_map *map,
   **rpo = map;
 }
 
+/* Skipping the first object at maps[0] is not valid in general,
+   since traversing along object dependency-links may "find" that
+   first object even when it is not included in the initial order
+   (e.g., a dlopen'ed shared object can have circular dependencies
+   linked back to itself).  In such a case, traversing N-1 objects
+   will create a N-object result, and raise problems.  Instead,
+   force the object back into first place after sorting.  This naive
+   approach may introduce further dependency ordering violations
+   compared to rotating the cycle until the first map is again in
+   the first position, but as there is a cycle, at least one
+   violation is already present.  */
+static void
+force_first_map (struct link_map **maps, unsigned int nmaps,
+		 struct link_map *first_map)
+{
+  if (maps[0] != first_map)
+    {
+      int i;
+      for (i = 0; maps[i] != first_map; ++i)
+	;
+      assert (i < nmaps);
+      memmove (&maps[1], maps, i * sizeof (maps[0]));
+      maps[0] = first_map;
+    }
+}
+
+/* Sort the initializer list MAPS of an object loaded by dlopen, where
+   some of the dependencies have been loaded and initialized before.
+   Such objects cannot depend on the objects loaded now, and do not
+   need to be relocated or initialized again, so only the new objects
+   are sorted, with the same depth-first traversal as the full sort.
+   They are placed before the old objects, which keep their relative
+   order.  This avoids traversing the dependency lists of the old
+   objects, which are their full dependency closures, and so are long
+   when many objects are loaded.
+
+   Return false if the full sort is needed instead: if there are no old
+   objects, as when loading the initial objects, or if an object has
+   been relocated but not initialized yet, as in a dlopen call from an
+   ELF constructor.  */
+static bool
+_dl_sort_maps_incremental (struct link_map **maps, unsigned int nmaps,
+			   bool force_first)
+{
+  unsigned int nnew = 0;
+  for (unsigned int i = 0; i < nmaps; ++i)
+    {
+      struct link_map *l = maps[i];
+      if (!l->l_relocated)
+	{
+	  l->l_visited = 0;
+	  ++nnew;
+	}
+      else if (!l->l_init_called)
+	return false;
+      else
+	/* Not traversed below.  */
+	l->l_visited = 1;
+    }
+  if (nnew == nmaps)
+    return false;
+
+  struct link_map *first_map = maps[0];
+  struct link_map *rpo[nmaps];
+  struct link_map **rpo_head = &rpo[nnew];
+  for (int i = nmaps - 1; i >= 0 && rpo_head != rpo; i--)
+    dfs_traversal (&rpo_head, maps[i], NULL);
+  assert (rpo_head == rpo);
+
+  /* Move the old objects to the end, preserving their order, and put
+     the sorted new objects in front of them.  */
+  unsigned int old_head = nmaps;
+  for (int i = nmaps - 1; i >= 0; i--)
+    if (maps[i]->l_relocated)
+      maps[--old_head] = maps[i];
+  assert (old_head == nnew);
+  memcpy (maps, rpo, sizeof (struct link_map *) * nnew);
+
+  if (force_first)
+    force_first_map (maps, nmaps, first_map);
+  return true;
+}
+
 /* Topologically sort array MAPS according to dependencies of the contained
    objects.  */
 
@@ -179,6 +262,9 @@ static void
 _dl_sort_maps_dfs (struct link_map **maps, unsigned int nmaps,
 		   bool force_first, bool for_fini)
 {
+  if (!for_fini && _dl_sort_maps_incremental (maps, nmaps, force_first))
+    return;
+
   struct link_map *first_map = maps[0];
   for (int i = nmaps - 1; i >= 0; i--)
     maps[i]->l_visited = 0;
@@ -262,26 +348,8 @@ _dl_sort_maps_dfs (struct link_map **maps, unsigned int nmaps,
   else
     memcpy (maps, rpo, sizeof (struct link_map *) * nmaps);
 
-  /* Skipping the first object at maps[0] is not valid in general,
-     since traversing along object dependency-links may "find" that
-     first object even when it is not included in the initial order
-     (e.g., a dlopen'ed shared object can have circular dependencies
-     linked back to itself).  In such a case, traversing N-1 objects
-     will create a N-object result, and raise problems.  Instead,
-     force the object back into first place after sorting.  This naive
-     approach may introduce further dependency ordering violations
-     compared to rotating the cycle until the first map is again in
-     the first position, but as there is a cycle, at least one
-     violation is already present.  */
-  if (force_first && maps[0] != first_map)
-    {
-      int i;
-      for (i = 0; maps[i] != first_map; ++i)
-	;
-      assert (i < nmaps);
-      memmove (&maps[1], maps, i * sizeof (maps[0]));
-      maps[0] = first_map;
-    }
+  if (force_first)
+    force_first_map (maps, nmaps, first_map);
 }
 
 void
@@ -173,7 +173,7 @@ ElfW(Word) _dl_stack_flags = DEFAULT_STACK_PERMS;
 #if PTHREAD_IN_LIBC
 list_t _dl_stack_used;
 list_t _dl_stack_user;
-list_t _dl_stack_cache;
+list_t _dl_stack_cache[DL_STACK_CACHE_BUCKETS];
 size_t _dl_stack_cache_actsize;
 uintptr_t _dl_in_flight_stack;
 int _dl_stack_cache_lock;
@@ -0,0 +1,108 @@
+/* Timeline tracing of dynamic loading (LD_DEBUG=timeline).
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <_itoa.h>
+#include <dl-timeline.h>
+#include <dl-timeline-os.h>
+#include <unistd.h>
+
+/* Object names longer than this are truncated in the trace.  */
+#define MAX_NAME 512
+
+/* Set once the opening bracket of the event array has been written.  */
+static bool timeline_started;
+
+uint64_t
+_dl_timeline_now (void)
+{
+  struct __timespec64 ts;
+  _dl_timeline_clock (&ts);
+  return ts.tv_sec * UINT64_C (1000000000) + ts.tv_nsec;
+}
+
+/* Write NS as microseconds with three decimals to the end of BUF of
+   SIZE bytes, and return the start of the string.  */
+static char *
+format_usec (char *buf, size_t size, uint64_t ns)
+{
+  char *p = &buf[size - 1];
+  *p = '\0';
+  unsigned int frac = ns % 1000;
+  for (int i = 0; i < 3; ++i)
+    {
+      *--p = '0' + frac % 10;
+      frac /= 10;
+    }
+  *--p = '.';
+  return _itoa (ns / 1000, p, 10, 0);
+}
+
+/* Copy NAME to BUF as the contents of a JSON string.  */
+static void
+escape_name (char *buf, const char *name)
+{
+  char *p = buf;
+  char *end = buf + 2 * MAX_NAME;
+  for (; *name != '\0' && p < end; ++name)
+    {
+      unsigned char c = *name;
+      if (c == '"' || c == '\\')
+	{
+	  *p++ = '\\';
+	  *p++ = c;
+	}
+      else if (c < ' ')
+	*p++ = '?';
+      else
+	*p++ = c;
+    }
+  *p = '\0';
+}
+
+void
+_dl_timeline_event (const char *phase, const char *object, uint64_t start)
+{
+  uint64_t now = _dl_timeline_now ();
+
+  if (object == NULL)
+    object = "";
+  else if (object[0] == '\0')
+    /* The main program has no name in its link map.  */
+    object = "main program";
+  char name[2 * MAX_NAME + 2];
+  escape_name (name, object);
+
+  char ts_buf[32];
+  char dur_buf[32];
+  const char *ts = format_usec (ts_buf, sizeof (ts_buf), start);
+  const char *dur = format_usec (dur_buf, sizeof (dur_buf), now - start);
+
+  int pid = __getpid ();
+  int tid = _dl_timeline_tid ();
+
+  if (!timeline_started)
+    {
+      timeline_started = true;
+      _dl_dprintf (GLRO(dl_debug_fd), "[\n");
+    }
+  _dl_dprintf (GLRO(dl_debug_fd),
+	       "{\"name\":\"%s%s%s\",\"cat\":\"%s\",\"ph\":\"X\","
+	       "\"ts\":%s,\"dur\":%s,\"pid\":%d,\"tid\":%d},\n",
+	       phase, name[0] != '\0' ? " " : "", name, phase,
+	       ts, dur, pid, tid);
+}
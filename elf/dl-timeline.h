@@ -0,0 +1,62 @@
+/* Timeline tracing of dynamic loading (LD_DEBUG=timeline).
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_TIMELINE_H
+#define _DL_TIMELINE_H
+
+#include <ldsodefs.h>
+#include <stdint.h>
+
+/* With LD_DEBUG=timeline, the dynamic linker writes a trace of the
+   phases of loading each object (searching for the file, mapping it,
+   relocating it, processing IRELATIVE relocations, and running its
+   ELF constructors) to the debug output.  The trace uses the JSON
+   array format of the Chrome trace event format: one complete ("X")
+   event per phase, with CLOCK_MONOTONIC timestamps in microseconds.
+   The closing bracket of the array is never written, which trace
+   viewers accept, so that dlopen calls after startup can still add
+   events.  */
+
+/* Return the current time in nanoseconds.  */
+uint64_t _dl_timeline_now (void) attribute_hidden;
+
+/* Write an event for PHASE of OBJECT (which may be NULL), which
+   started at time START and ends now.  */
+void _dl_timeline_event (const char *phase, const char *object,
+			 uint64_t start) attribute_hidden;
+
+/* Return the start time of a phase, or 0 if timeline tracing is not
+   enabled.  */
+static inline uint64_t
+_dl_timeline_start (void)
+{
+  if (__glibc_likely ((GLRO(dl_debug_mask) & DL_DEBUG_TIMELINE) == 0))
+    return 0;
+  return _dl_timeline_now ();
+}
+
+/* End the phase which started at START, as returned by
+   _dl_timeline_start.  */
+static inline void
+_dl_timeline_end (const char *phase, const char *object, uint64_t start)
+{
+  if (__glibc_unlikely (start != 0))
+    _dl_timeline_event (phase, object, start);
+}
+
+#endif /* _DL_TIMELINE_H */
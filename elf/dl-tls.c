@@ -478,10 +478,12 @@ extern dtv_t _dl_static_dtv[];
 static dtv_t *
 _dl_resize_dtv (dtv_t *dtv, size_t max_modid)
 {
-  /* Resize the dtv.  */
+  /* Resize the dtv.  Grow it at least geometrically, so that loading
+     many modules one by one does not reallocate the dtv of every
+     thread for each of them.  */
   dtv_t *newp;
-  size_t newsize = max_modid + DTV_SURPLUS;
   size_t oldsize = dtv[-1].counter;
+  size_t newsize = MAX (max_modid + DTV_SURPLUS, 2 * oldsize);
 
   if (dtv == GL(dl_initial_dtv))
     {
@@ -762,7 +764,16 @@ _dl_update_slotinfo (unsigned long int req_modid, size_t new_gen)
      it is used in decisions that can affect concurrent stores.  But this
      should only happen if the OOTA value causes UB that justifies the
      concurrent store of the value.  This is not expected to be an issue
-     in practice.  */
+     in practice.
+
+     Each element of the slotinfo list records the highest generation
+     of its entries, which is stored after the generation of the entry
+     and so is also synchronized up to new_gen.  If it is not above
+     old_gen, all entries of the element are in case (2) or (1), and
+     the element is skipped.  Only the elements with entries updated
+     since old_gen are searched, so the cost of the update depends on
+     the number of changed modules rather than on the number of loaded
+     modules.  */
   struct dtv_slotinfo_list *listp = GL(dl_tls_dtv_slotinfo_list);
 
   if (dtv[0].counter < new_gen)
@@ -771,11 +782,17 @@ _dl_update_slotinfo (unsigned long int req_modid, size_t new_gen)
       size_t max_modid  = atomic_load_relaxed (&GL(dl_tls_max_dtv_idx));
       assert (max_modid >= req_modid);
 
-      /* We have to look through the entire dtv slotinfo list.  */
+      /* We have to look through the dtv slotinfo list, but only at
+	 the elements which have changed.  */
       listp =  GL(dl_tls_dtv_slotinfo_list);
       do
 	{
-	  for (size_t cnt = total == 0 ? 1 : 0; cnt < listp->len; ++cnt)
+	  size_t first = total == 0 ? 1 : 0;
+	  /* Case (2) or (1) for all entries of this element.  */
+	  if (atomic_load_relaxed (&listp->gen) <= dtv[0].counter)
+	    first = listp->len;
+
+	  for (size_t cnt = first; cnt < listp->len; ++cnt)
 	    {
 	      size_t modid = total + cnt;
 
@@ -871,35 +888,34 @@ tls_get_addr_tail (GET_ADDR_ARGS, dtv_t *dtv, struct link_map *the_map)
   /* Make sure that, if a dlopen running in parallel forces the
      variable into static storage, we'll wait until the address in the
      static TLS block is set up, and use that.  If we're undecided
-     yet, make sure we make the decision holding the lock as well.  */
-  if (__glibc_unlikely (the_map->l_tls_offset
-			!= FORCED_DYNAMIC_TLS_OFFSET))
+     yet, make the decision with an atomic update of l_tls_offset,
+     which _dl_try_allocate_static_tls also uses, so that the lock is
+     only needed for static TLS.  */
+  ptrdiff_t offset = atomic_load_relaxed (&the_map->l_tls_offset);
+  while (offset == NO_TLS_OFFSET
+	 && !atomic_compare_exchange_weak_relaxed (&the_map->l_tls_offset,
+						   &offset,
+						   FORCED_DYNAMIC_TLS_OFFSET))
+    ;
+  if (__glibc_unlikely (offset != NO_TLS_OFFSET
+			&& offset != FORCED_DYNAMIC_TLS_OFFSET))
     {
+      /* The offset cannot change anymore, but the dlopen which set it
+	 may still be initializing the static TLS blocks.  */
       __rtld_lock_lock_recursive (GL(dl_load_tls_lock));
-      if (__glibc_likely (the_map->l_tls_offset == NO_TLS_OFFSET))
-	{
-	  the_map->l_tls_offset = FORCED_DYNAMIC_TLS_OFFSET;
-	  __rtld_lock_unlock_recursive (GL(dl_load_tls_lock));
-	}
-      else if (__glibc_likely (the_map->l_tls_offset
-			       != FORCED_DYNAMIC_TLS_OFFSET))
-	{
 #if TLS_TCB_AT_TP
-	  void *p = (char *) THREAD_SELF - the_map->l_tls_offset;
+      void *p = (char *) THREAD_SELF - offset;
 #elif TLS_DTV_AT_TP
-	  void *p = (char *) THREAD_SELF + the_map->l_tls_offset + TLS_PRE_TCB_SIZE;
+      void *p = (char *) THREAD_SELF + offset + TLS_PRE_TCB_SIZE;
 #else
 # error "Either TLS_TCB_AT_TP or TLS_DTV_AT_TP must be defined"
 #endif
-	  __rtld_lock_unlock_recursive (GL(dl_load_tls_lock));
+      __rtld_lock_unlock_recursive (GL(dl_load_tls_lock));
 
-	  dtv[GET_ADDR_MODULE].pointer.to_free = NULL;
-	  dtv[GET_ADDR_MODULE].pointer.val = p;
+      dtv[GET_ADDR_MODULE].pointer.to_free = NULL;
+      dtv[GET_ADDR_MODULE].pointer.val = p;
 
-	  return (char *) p + GET_ADDR_OFFSET;
-	}
-      else
-	__rtld_lock_unlock_recursive (GL(dl_load_tls_lock));
+      return (char *) p + GET_ADDR_OFFSET;
     }
   struct dtv_pointer result = allocate_and_init (the_map);
   dtv[GET_ADDR_MODULE].pointer = result;
@@ -1055,6 +1071,7 @@ cannot create TLS data structures"));
 
       listp->len = TLS_SLOTINFO_SURPLUS;
       listp->next = NULL;
+      listp->gen = 0;
       memset (listp->slotinfo, '\0',
 	      TLS_SLOTINFO_SURPLUS * sizeof (struct dtv_slotinfo));
       /* Synchronize with _dl_update_slotinfo.  */
@@ -1068,6 +1085,7 @@ cannot create TLS data structures"));
       atomic_store_relaxed (&listp->slotinfo[idx].map, l);
       atomic_store_relaxed (&listp->slotinfo[idx].gen,
 			    GL(dl_tls_generation) + 1);
+      atomic_store_relaxed (&listp->gen, GL(dl_tls_generation) + 1);
     }
 }
 
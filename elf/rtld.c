@@ -53,6 +53,10 @@
 #include <dl-find_object.h>
 #include <dl-audit-check.h>
 #include <dl-call_tls_init_tp.h>
+#include <dl-reloc-parallel.h>
+#include <dl-resolve-cache.h>
+#include <dl-scope-filter.h>
+#include <dl-timeline.h>
 
 #include <assert.h>
 
@@ -367,6 +371,7 @@ struct rtld_global_ro _rtld_global_ro attribute_relro =
     ._dl_mcount = _dl_mcount,
     ._dl_lookup_symbol_x = _dl_lookup_symbol_x,
     ._dl_open = _dl_open,
+    ._dl_open_many = _dl_open_many,
     ._dl_close = _dl_close,
     ._dl_catch_error = _dl_catch_error,
     ._dl_error_free = _dl_error_free,
@@ -1365,6 +1370,9 @@ dl_main (const ElfW(Phdr) *phdr,
   /* Process the environment variable which control the behaviour.  */
   process_envvars (&state);
 
+  /* Tracing starts here, once LD_DEBUG has been processed.  */
+  uint64_t timeline_start = _dl_timeline_start ();
+
 #ifndef HAVE_INLINED_SYSCALLS
   /* Set up a flag which tells we are just starting.  */
   _dl_starting_up = 1;
@@ -1962,8 +1970,10 @@ dl_main (const ElfW(Phdr) *phdr,
   {
     RTLD_TIMING_VAR (start);
     rtld_timer_start (&start);
+    uint64_t deps_start = _dl_timeline_start ();
     _dl_map_object_deps (main_map, preloads, npreloads,
 			 state.mode == rtld_mode_trace, 0);
+    _dl_timeline_end ("load", NULL, deps_start);
     rtld_timer_accum (&load_time, start);
   }
 
@@ -2281,6 +2291,18 @@ dl_main (const ElfW(Phdr) *phdr,
   /* If we are profiling we also must do lazy reloaction.  */
   GLRO(dl_lazy) |= consider_profiling;
 
+  /* Speed up the symbol lookups in a large global scope, once they
+     turn out to be slow.  */
+  _dl_scope_filter_defer (GL(dl_ns)[LM_ID_BASE]._ns_main_searchlist);
+
+  /* Reuse the symbol lookups of an earlier run if requested.  */
+  _dl_resolve_cache_init ();
+
+  uint64_t relocate_start = _dl_timeline_start ();
+
+  /* Perform the symbol lookups on helper threads if requested.  */
+  _dl_reloc_parallel_prefetch (main_map);
+
   if (GL(dl_ns)[LM_ID_BASE].libc_map != NULL)
     _dl_relocate_object (GL(dl_ns)[LM_ID_BASE].libc_map,
 			 GL(dl_ns)[LM_ID_BASE].libc_map->l_scope,
@@ -2317,6 +2339,10 @@ dl_main (const ElfW(Phdr) *phdr,
       }
   }
   rtld_timer_stop (&relocate_time, start);
+  _dl_timeline_end ("relocate", NULL, relocate_start);
+
+  _dl_resolve_cache_fini ();
+  _dl_reloc_parallel_release (main_map);
 
   /* Now enable profiling if needed.  Like the previous call,
      this has to go here because the calls it makes should use the
@@ -2374,6 +2400,9 @@ dl_main (const ElfW(Phdr) *phdr,
       rtld_timer_accum (&relocate_time, start);
     }
 
+  /* Lookups by other threads must not build the filter.  */
+  _dl_scope_filter_defer (NULL);
+
   /* Relocation is complete.  Perform early libc initialization.  This
      is the initial libc, even if audit modules have been loaded with
      other libcs.  */
@@ -2401,6 +2430,8 @@ dl_main (const ElfW(Phdr) *phdr,
   _dl_unload_cache ();
 #endif
 
+  _dl_timeline_end ("startup", NULL, timeline_start);
+
   /* Once we return, _dl_sysdep_start will invoke
      the DT_INIT functions and then *USER_ENTRY.  */
 }
@@ -2456,14 +2487,18 @@ process_dl_debug (struct dl_main_state *state, const char *dl_debug)
 	DL_DEBUG_VERSIONS | DL_DEBUG_IMPCALLS },
       { LEN_AND_STR ("scopes"), "display scope information",
 	DL_DEBUG_SCOPES },
+      { LEN_AND_STR ("tls"), "display static TLS allocation",
+	DL_DEBUG_TLS },
       { LEN_AND_STR ("all"), "all previous options combined",
 	DL_DEBUG_LIBS | DL_DEBUG_RELOC | DL_DEBUG_FILES | DL_DEBUG_SYMBOLS
 	| DL_DEBUG_BINDINGS | DL_DEBUG_VERSIONS | DL_DEBUG_IMPCALLS
-	| DL_DEBUG_SCOPES },
+	| DL_DEBUG_SCOPES | DL_DEBUG_TLS },
       { LEN_AND_STR ("statistics"), "display relocation statistics",
 	DL_DEBUG_STATISTICS },
       { LEN_AND_STR ("unused"), "determined unused DSOs",
 	DL_DEBUG_UNUSED },
+      { LEN_AND_STR ("timeline"), "write a trace of loading phases as JSON",
+	DL_DEBUG_TIMELINE },
       { LEN_AND_STR ("help"), "display this help message and exit",
 	DL_DEBUG_HELP },
     };
@@ -36,6 +36,7 @@ static const struct dlfcn_hook _dlfcn_hook =
     .dladdr1 = __dladdr1,
     .dlinfo = __dlinfo,
     .dlmopen = __dlmopen,
+    .dlopen_many = __dlopen_many,
     .libc_dlopen_mode = __libc_dlopen_mode,
     .libc_dlsym = __libc_dlsym,
     .libc_dlvsym = __libc_dlvsym,
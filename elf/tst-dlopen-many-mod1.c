@@ -0,0 +1,14 @@
+extern void record_init (const char *);
+extern int mod3_value (void);
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  record_init ("mod1");
+}
+
+int
+mod1_value (void)
+{
+  return 1 + mod3_value ();
+}
@@ -0,0 +1,15 @@
+extern void record_init (const char *);
+extern int mod4_value (void);
+extern int mod3_value (void);
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  record_init ("mod2");
+}
+
+int
+mod2_value (void)
+{
+  return 2 + mod4_value () + mod3_value ();
+}
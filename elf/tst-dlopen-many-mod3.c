@@ -0,0 +1,14 @@
+extern void record_init (const char *);
+extern int mod4_value (void);
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  record_init ("mod3");
+}
+
+int
+mod3_value (void)
+{
+  return 3 + mod4_value ();
+}
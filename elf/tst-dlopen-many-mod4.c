@@ -0,0 +1,13 @@
+extern void record_init (const char *);
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  record_init ("mod4");
+}
+
+int
+mod4_value (void)
+{
+  return 4;
+}
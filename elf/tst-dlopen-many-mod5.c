@@ -0,0 +1,16 @@
+extern void record_init (const char *);
+extern int mod1_value (void);
+
+static void __attribute__ ((constructor))
+init (void)
+{
+  record_init ("mod5");
+}
+
+/* tst-dlopen-many-mod1.so is not a dependency, so mod1_value has to be
+   found in the global scope.  */
+int
+mod5_value (void)
+{
+  return 5 + mod1_value ();
+}
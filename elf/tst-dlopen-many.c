@@ -0,0 +1,221 @@
+/* Test that dlopen_many runs constructors like individual dlopen calls.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The modules form the dependency graph mod1 -> mod3 -> mod4 and
+   mod2 -> {mod4, mod3}.  mod5 uses mod1 without depending on it, so
+   it can only be opened after mod1 with RTLD_GLOBAL.  Each set of
+   files is opened once with one
+   dlopen call per file and once with dlopen_many, and the order in
+   which the constructors run, the handles, and the unloading of the
+   objects by dlclose are compared.  */
+
+#include <array_length.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/xdlfcn.h>
+
+/* Constructor calls, in order.  Called by the modules.  */
+static char init_order[200];
+
+void
+record_init (const char *name)
+{
+  if (init_order[0] != '\0')
+    strcat (init_order, " ");
+  strcat (init_order, name);
+}
+
+enum { max_files = 4 };
+
+/* Check that none of the modules is loaded.  */
+static void
+check_unloaded (void)
+{
+  for (int i = 1; i <= 5; ++i)
+    {
+      char name[40];
+      snprintf (name, sizeof (name), "tst-dlopen-many-mod%d.so", i);
+      void *handle = dlopen (name, RTLD_NOW | RTLD_NOLOAD);
+      if (handle != NULL)
+	{
+	  support_record_failure ();
+	  printf ("error: %s is still loaded\n", name);
+	  xdlclose (handle);
+	}
+    }
+}
+
+/* Return the value of the modN_value function in HANDLE.  */
+static int
+call_value (void *handle, const char *file)
+{
+  char name[20];
+  TEST_VERIFY_EXIT (sscanf (file, "tst-dlopen-many-mod%1[0-9]", name) == 1);
+  char symbol[20];
+  snprintf (symbol, sizeof (symbol), "mod%s_value", name);
+  int (*fn) (void) = xdlsym (handle, symbol);
+  return fn ();
+}
+
+static void
+check_files (const char *const *files, size_t count, int mode,
+	     const char *expected_order)
+{
+  printf ("info: opening %zu files with mode 0x%x\n", count, mode);
+
+  /* Individual dlopen calls.  */
+  void *handles[max_files];
+  int values[max_files];
+  init_order[0] = '\0';
+  for (size_t i = 0; i < count; ++i)
+    handles[i] = xdlopen (files[i], mode);
+  char order[sizeof (init_order)];
+  strcpy (order, init_order);
+  TEST_COMPARE_STRING (order, expected_order);
+  for (size_t i = 0; i < count; ++i)
+    values[i] = call_value (handles[i], files[i]);
+  for (size_t i = 0; i < count; ++i)
+    xdlclose (handles[i]);
+  check_unloaded ();
+
+  /* The same files with dlopen_many.  */
+  void *many[max_files];
+  init_order[0] = '\0';
+  if (dlopen_many (files, count, mode, many) != 0)
+    FAIL_EXIT1 ("dlopen_many: %s", dlerror ());
+  TEST_COMPARE_STRING (init_order, order);
+  for (size_t i = 0; i < count; ++i)
+    {
+      /* The handle of an object is the same however it is opened.  */
+      void *handle = xdlopen (files[i], mode | RTLD_NOLOAD);
+      TEST_VERIFY (many[i] == handle);
+      xdlclose (handle);
+      TEST_COMPARE (call_value (many[i], files[i]), values[i]);
+      for (size_t j = 0; j < i; ++j)
+	TEST_COMPARE (many[i] == many[j], strcmp (files[i], files[j]) == 0);
+    }
+
+  /* Every handle holds a reference, as with dlopen.  */
+  for (size_t i = 0; i < count; ++i)
+    xdlclose (many[i]);
+  check_unloaded ();
+}
+
+static int
+do_test (void)
+{
+  static const char *const files12[] =
+    { "tst-dlopen-many-mod1.so", "tst-dlopen-many-mod2.so" };
+  static const char *const files21[] =
+    { "tst-dlopen-many-mod2.so", "tst-dlopen-many-mod1.so" };
+  static const char *const files341[] =
+    { "tst-dlopen-many-mod3.so", "tst-dlopen-many-mod4.so",
+      "tst-dlopen-many-mod1.so" };
+  static const char *const files_dup[] =
+    { "tst-dlopen-many-mod1.so", "tst-dlopen-many-mod3.so",
+      "tst-dlopen-many-mod1.so", "tst-dlopen-many-mod2.so" };
+
+  static const int modes[] =
+    { RTLD_NOW, RTLD_LAZY, RTLD_NOW | RTLD_GLOBAL };
+  for (int m = 0; m < array_length (modes); ++m)
+    {
+      check_files (files12, 2, modes[m], "mod4 mod3 mod1 mod2");
+      check_files (files21, 2, modes[m], "mod4 mod3 mod2 mod1");
+      check_files (files341, 3, modes[m], "mod4 mod3 mod1");
+      check_files (files_dup, 4, modes[m], "mod4 mod3 mod1 mod2");
+    }
+
+  /* mod5 binds to mod1 through the global scope, as it would after a
+     separate dlopen of mod1.  */
+  static const char *const files15[] =
+    { "tst-dlopen-many-mod1.so", "tst-dlopen-many-mod5.so" };
+  check_files (files15, 2, RTLD_NOW | RTLD_GLOBAL, "mod4 mod3 mod1 mod5");
+  check_files (files15, 2, RTLD_LAZY | RTLD_GLOBAL, "mod4 mod3 mod1 mod5");
+
+  /* An object which is already open keeps its initialization, and
+     only gets another reference.  */
+  void *mod3 = xdlopen ("tst-dlopen-many-mod3.so", RTLD_NOW);
+  init_order[0] = '\0';
+  void *many[max_files];
+  if (dlopen_many (files12, 2, RTLD_NOW, many) != 0)
+    FAIL_EXIT1 ("dlopen_many: %s", dlerror ());
+  TEST_COMPARE_STRING (init_order, "mod1 mod2");
+  xdlclose (many[1]);
+  xdlclose (many[0]);
+  xdlclose (mod3);
+  check_unloaded ();
+
+  /* If one of the files cannot be opened, none of them remain open,
+     and no constructors run.  */
+  static const char *const files_missing[] =
+    { "tst-dlopen-many-mod1.so", "tst-dlopen-many-mod2.so",
+      "tst-dlopen-many-missing.so" };
+  init_order[0] = '\0';
+  TEST_COMPARE (dlopen_many (files_missing, 3, RTLD_NOW, many), -1);
+  const char *message = dlerror ();
+  TEST_VERIFY (message != NULL
+	       && strstr (message, "tst-dlopen-many-missing.so") != NULL);
+  TEST_COMPARE_STRING (init_order, "");
+  check_unloaded ();
+
+  /* If a later object cannot be relocated, the earlier ones are
+     removed from the global scope again.  */
+  static const char *const files25[] =
+    { "tst-dlopen-many-mod2.so", "tst-dlopen-many-mod5.so" };
+  init_order[0] = '\0';
+  TEST_COMPARE (dlopen_many (files25, 2, RTLD_NOW | RTLD_GLOBAL, many), -1);
+  message = dlerror ();
+  TEST_VERIFY (message != NULL && strstr (message, "mod1_value") != NULL);
+  TEST_COMPARE_STRING (init_order, "");
+  TEST_VERIFY (dlsym (RTLD_DEFAULT, "mod2_value") == NULL);
+  check_unloaded ();
+
+  /* RTLD_GLOBAL and RTLD_NODELETE do not affect an object which was
+     open already if opening fails.  */
+  void *mod3_local = xdlopen ("tst-dlopen-many-mod3.so", RTLD_NOW);
+  static const char *const files3_missing[] =
+    { "tst-dlopen-many-mod3.so", "tst-dlopen-many-missing.so" };
+  TEST_COMPARE (dlopen_many (files3_missing, 2,
+			     RTLD_NOW | RTLD_GLOBAL | RTLD_NODELETE, many),
+		-1);
+  TEST_VERIFY (dlerror () != NULL);
+  TEST_VERIFY (dlsym (RTLD_DEFAULT, "mod3_value") == NULL);
+  xdlclose (mod3_local);
+  check_unloaded ();
+
+  /* Without RTLD_GLOBAL, mod5 cannot use mod1.  */
+  TEST_COMPARE (dlopen_many (files15, 2, RTLD_NOW, many), -1);
+  TEST_VERIFY (dlerror () != NULL);
+  check_unloaded ();
+
+  /* A file name which is null is rejected.  */
+  static const char *const files_null[] =
+    { "tst-dlopen-many-mod1.so", NULL };
+  TEST_COMPARE (dlopen_many (files_null, 2, RTLD_NOW, many), -1);
+  TEST_VERIFY (dlerror () != NULL);
+  check_unloaded ();
+
+  /* Opening no files does nothing.  */
+  TEST_COMPARE (dlopen_many (files12, 0, RTLD_NOW, many), 0);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,162 @@
+/* Test the trace written with LD_DEBUG=timeline.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test program is run again with LD_DEBUG=timeline, and loads a
+   module with a constructor.  Before that, it opens the module with
+   RTLD_NOLOAD, which finds the file but does not map it.  The trace
+   must contain one well-formed event per line, covering every phase of
+   startup and of the dlopen call.  */
+
+#include <array_length.h>
+#include <dlfcn.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/xdlfcn.h>
+
+static int restart;
+#define CMDLINE_OPTIONS \
+  { "restart", no_argument, &restart, 1 },
+
+static int
+handle_restart (void)
+{
+  /* The file is found, but not mapped.  */
+  TEST_VERIFY (dlopen ("tst-ld-debug-timeline-mod.so",
+		       RTLD_NOW | RTLD_NOLOAD) == NULL);
+
+  void *h = xdlopen ("tst-ld-debug-timeline-mod.so", RTLD_NOW);
+  int (*get) (void) = xdlsym (h, "get");
+  TEST_COMPARE (get (), 1);
+  xdlclose (h);
+  return 0;
+}
+
+/* Return true if LINE (without the newline) is a complete event of
+   category CAT whose name starts with PREFIX and contains the string
+   SUBSTRING.  */
+static bool
+match_event (const char *line, const char *cat, const char *prefix,
+	     const char *substring)
+{
+  char *expected_start;
+  if (asprintf (&expected_start, "{\"name\":\"%s", prefix) < 0)
+    FAIL_EXIT1 ("asprintf: %m");
+  char *expected_cat;
+  if (asprintf (&expected_cat, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":",
+		cat) < 0)
+    FAIL_EXIT1 ("asprintf: %m");
+  const char *cat_pos = strstr (line, expected_cat);
+  bool result = (strncmp (line, expected_start, strlen (expected_start)) == 0
+		 && cat_pos != NULL
+		 && (substring == NULL
+		     || (strstr (line, substring) != NULL
+			 && strstr (line, substring) < cat_pos)));
+  free (expected_cat);
+  free (expected_start);
+  return result;
+}
+
+static char *spargv[10];
+
+static int
+do_test (int argc, char *argv[])
+{
+  /* We must have either:
+     - One or four parameters left if called initially:
+       + path to ld.so         optional
+       + "--library-path"      optional
+       + the library path      optional
+       + the application name  */
+
+  if (restart)
+    return handle_restart ();
+
+  int i = 0;
+  for (; i < argc - 1; i++)
+    spargv[i] = argv[i + 1];
+  spargv[i++] = (char *) "--direct";
+  spargv[i++] = (char *) "--restart";
+  spargv[i] = NULL;
+
+  TEST_COMPARE (setenv ("LD_DEBUG", "timeline", 1), 0);
+  struct support_capture_subprocess result
+    = support_capture_subprogram (spargv[0], spargv);
+  support_capture_subprocess_check (&result, "timeline", 0, sc_allow_stderr);
+
+  static const char *const expected[][3] =
+    {
+      { "startup", "startup", NULL },
+      { "load", "load", NULL },
+      { "open", "open ", "libc.so.6" },
+      { "map", "map ", "libc.so.6" },
+      { "relocate", "relocate ", "libc.so.6" },
+      { "relocate", "relocate", NULL },
+      { "init", "init ", "libc.so.6" },
+      { "open", "open ", "tst-ld-debug-timeline-mod.so" },
+      { "map", "map ", "tst-ld-debug-timeline-mod.so" },
+      { "relocate", "relocate ", "tst-ld-debug-timeline-mod.so" },
+      { "init", "init ", "tst-ld-debug-timeline-mod.so" },
+      { "dlopen", "dlopen ", "tst-ld-debug-timeline-mod.so" },
+    };
+  bool found[array_length (expected)] = { false };
+
+  /* The trace is a JSON array which is not terminated.  */
+  char *err = result.err.buffer;
+  TEST_VERIFY_EXIT (strncmp (err, "[\n", 2) == 0);
+  int nevents = 0;
+  for (char *line = err + 2; *line != '\0'; )
+    {
+      char *end = strchr (line, '\n');
+      TEST_VERIFY_EXIT (end != NULL);
+      *end = '\0';
+      if (end - line < 2 || strcmp (end - 2, "},") != 0
+	  || strstr (line, ",\"dur\":") == NULL
+	  || strstr (line, ",\"pid\":") == NULL
+	  || strstr (line, ",\"tid\":") == NULL)
+	{
+	  support_record_failure ();
+	  printf ("error: malformed event: %s\n", line);
+	}
+      for (size_t j = 0; j < array_length (expected); ++j)
+	if (match_event (line, expected[j][0], expected[j][1],
+			 expected[j][2]))
+	  found[j] = true;
+      ++nevents;
+      line = end + 1;
+    }
+  printf ("info: %d events\n", nevents);
+
+  for (size_t j = 0; j < array_length (expected); ++j)
+    if (!found[j])
+      {
+	support_record_failure ();
+	printf ("error: no %s event for %s\n", expected[j][0],
+		expected[j][2] != NULL ? expected[j][2] : "all objects");
+      }
+
+  support_capture_subprocess_free (&result);
+  return 0;
+}
+
+#define TEST_FUNCTION_ARGV do_test
+#include <support/test-driver.c>
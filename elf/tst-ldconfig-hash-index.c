@@ -0,0 +1,192 @@
+/* Test the hash index in ld.so.cache files written by ldconfig.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Run ldconfig on a directory with many libraries, some of them also
+   in a glibc-hwcaps subdirectory, and check that looking up names
+   with the hash index of the resulting cache finds the same entry as
+   a search of the sorted entry array.  */
+
+#include <dl-cache.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/support.h>
+#include <support/temp_file.h>
+#include <support/xunistd.h>
+
+/* Number of libraries in the test directory.  */
+enum { nlibraries = 300 };
+
+/* Return the index of the first entry for NAME, or -1.  This is the
+   result the search in dl-cache.c computes without the hash index.  */
+static int
+search_sorted (const struct cache_file_new *cache, size_t cache_size,
+	       const char *name)
+{
+  for (uint32_t i = 0; i < cache->nlibs; ++i)
+    {
+      TEST_VERIFY_EXIT (cache->libs[i].key < cache_size);
+      if (_dl_cache_libcmp (name, (const char *) cache + cache->libs[i].key)
+	  == 0)
+	return i;
+    }
+  return -1;
+}
+
+static void
+check_name (const struct cache_file_new *cache, size_t cache_size,
+	    const struct cache_extension_loaded *index, const char *name,
+	    bool expected)
+{
+  int sorted = search_sorted (cache, cache_size, name);
+  int hashed = cache_hash_index_lookup (index->base,
+					index->size
+					/ sizeof (struct cache_hash_index_slot),
+					(const char *) cache, cache_size,
+					&cache->libs[0].entry, cache->nlibs,
+					sizeof (cache->libs[0]), name);
+  if (sorted != hashed)
+    {
+      support_record_failure ();
+      printf ("error: %s: hash index lookup returns %d, expected %d\n",
+	      name, hashed, sorted);
+    }
+  if (expected != (sorted >= 0))
+    {
+      support_record_failure ();
+      printf ("error: %s: unexpected lookup result %d\n", name, sorted);
+    }
+}
+
+static int
+do_test (void)
+{
+  char *dir = support_create_temp_directory ("tst-ldconfig-hash-index-");
+  char *libdir = xasprintf ("%s/lib", dir);
+  char *hwcapsdir = xasprintf ("%s/glibc-hwcaps", libdir);
+  char *subdir = xasprintf ("%s/tst-hash-index", hwcapsdir);
+  xmkdir (libdir, 0777);
+  add_temp_file (libdir);
+  xmkdir (hwcapsdir, 0777);
+  add_temp_file (hwcapsdir);
+  xmkdir (subdir, 0777);
+  add_temp_file (subdir);
+
+  /* The library does not have a soname, so ldconfig uses the file
+     names as the keys.  */
+  char *lib = xasprintf ("%s/elf/tst-ldconfig-soname-lib-without-soname.so",
+			 support_objdir_root);
+  for (int i = 0; i < nlibraries; ++i)
+    {
+      char *path = xasprintf ("%s/libtst-hash-index-%d.so.%d",
+			      libdir, i, i % 7);
+      support_copy_file (lib, path);
+      add_temp_file (path);
+      free (path);
+      if (i % 10 == 0)
+	{
+	  path = xasprintf ("%s/libtst-hash-index-%d.so.%d",
+			    subdir, i, i % 7);
+	  support_copy_file (lib, path);
+	  add_temp_file (path);
+	  free (path);
+	}
+    }
+  /* Two names for the same entry according to _dl_cache_libcmp.  */
+  char *path = xasprintf ("%s/libtst-hash-index-zero.so.1", libdir);
+  support_copy_file (lib, path);
+  add_temp_file (path);
+  free (path);
+  path = xasprintf ("%s/libtst-hash-index-zero.so.01", libdir);
+  support_copy_file (lib, path);
+  add_temp_file (path);
+  free (path);
+
+  char *conf = xasprintf ("%s/ld.so.conf", dir);
+  support_write_file_string (conf, "");
+  add_temp_file (conf);
+  char *cache_path = xasprintf ("%s/ld.so.cache", dir);
+  add_temp_file (cache_path);
+
+  char *ldconfig = xasprintf ("%s/elf/ldconfig", support_objdir_root);
+  char *args[] = { ldconfig, (char *) "-X", (char *) "-C", cache_path,
+		   (char *) "-f", conf, libdir, NULL };
+  struct support_capture_subprocess result
+    = support_capture_subprogram (ldconfig, args);
+  support_capture_subprocess_check (&result, "ldconfig", 0,
+				    sc_allow_stdout | sc_allow_stderr);
+  support_capture_subprocess_free (&result);
+
+  int fd = xopen (cache_path, O_RDONLY, 0);
+  struct stat st;
+  xfstat (fd, &st);
+  size_t cache_size = st.st_size;
+  TEST_VERIFY_EXIT (cache_size > sizeof (struct cache_file_new));
+  const struct cache_file_new *cache = xmmap (NULL, cache_size, PROT_READ,
+					      MAP_PRIVATE, fd);
+  xclose (fd);
+  TEST_VERIFY_EXIT (memcmp (cache->magic, CACHEMAGIC_VERSION_NEW,
+			    sizeof CACHEMAGIC_VERSION_NEW - 1) == 0);
+  TEST_VERIFY_EXIT (cache->nlibs >= nlibraries + nlibraries / 10 + 2);
+  TEST_VERIFY_EXIT ((cache_size - sizeof (*cache)) / sizeof (cache->libs[0])
+		    >= cache->nlibs);
+
+  struct cache_extension_all_loaded ext;
+  TEST_VERIFY_EXIT (cache_extension_load (cache, cache, cache_size, &ext));
+  const struct cache_extension_loaded *index
+    = &ext.sections[cache_extension_tag_hash_index];
+  TEST_VERIFY_EXIT (index->base != NULL);
+  printf ("info: %u entries, %zu hash index slots\n", cache->nlibs,
+	  index->size / sizeof (struct cache_hash_index_slot));
+
+  /* Every name in the cache, including those of the system
+     directories.  */
+  for (uint32_t i = 0; i < cache->nlibs; ++i)
+    check_name (cache, cache_size, index,
+		(const char *) cache + cache->libs[i].key, true);
+
+  /* Names which are equal to a cache entry only numerically.  */
+  check_name (cache, cache_size, index, "libtst-hash-index-7.so.00", true);
+  check_name (cache, cache_size, index, "libtst-hash-index-012.so.5", true);
+  check_name (cache, cache_size, index, "libtst-hash-index-zero.so.001",
+	      true);
+
+  /* Names which are not in the cache.  */
+  check_name (cache, cache_size, index, "libtst-hash-index-7.so.1", false);
+  check_name (cache, cache_size, index, "libtst-hash-index-300.so.6",
+	      false);
+  check_name (cache, cache_size, index, "libtst-hash-index-", false);
+  check_name (cache, cache_size, index, "", false);
+
+  xmunmap ((void *) cache, cache_size);
+  free (ldconfig);
+  free (cache_path);
+  free (conf);
+  free (lib);
+  free (subdir);
+  free (hwcapsdir);
+  free (libdir);
+  free (dir);
+  return 0;
+}
+
+#include <support/test-driver.c>
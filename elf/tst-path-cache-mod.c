@@ -0,0 +1,5 @@
+int
+path_cache_value (void)
+{
+  return 42;
+}
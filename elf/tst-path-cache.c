@@ -0,0 +1,161 @@
+/* Test the cache of search directory contents (glibc.rtld.path_cache).
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Run the test program with a temporary directory at the start of the
+   library search path, with and without the cache.  The program loads
+   an object from the directory, and one from a later directory in the
+   search path.  Then it copies the object in the directory under a new
+   name, which is only found without the cache because the directory
+   has been read before.  */
+
+#include <dlfcn.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/support.h>
+#include <support/temp_file.h>
+#include <support/xdlfcn.h>
+#include <unistd.h>
+
+static int restart;
+static int cached;
+#define CMDLINE_OPTIONS \
+  { "restart", no_argument, &restart, 1 }, \
+  { "cached", no_argument, &cached, 1 },
+
+static void
+check_object (const char *name)
+{
+  void *handle = xdlopen (name, RTLD_NOW);
+  int (*fn) (void) = xdlsym (handle, "path_cache_value");
+  TEST_COMPARE (fn (), 42);
+  xdlclose (handle);
+}
+
+static int
+handle_restart (void)
+{
+  const char *dir = getenv ("PATH_CACHE_DIR");
+  TEST_VERIFY_EXIT (dir != NULL);
+
+  /* Found in the temporary directory, which is read with the cache.  */
+  check_object ("libtst-path-cache-a.so");
+  /* Found in the build directory, after the temporary directory.  */
+  check_object ("tst-path-cache-mod.so");
+  /* Found nowhere.  */
+  TEST_VERIFY (dlopen ("libtst-path-cache-missing.so", RTLD_NOW) == NULL);
+
+  char *from = xasprintf ("%s/libtst-path-cache-a.so", dir);
+  char *to = xasprintf ("%s/libtst-path-cache-b.so", dir);
+  support_copy_file (from, to);
+  void *handle = dlopen ("libtst-path-cache-b.so", RTLD_NOW);
+  if (cached)
+    TEST_VERIFY (handle == NULL);
+  else
+    {
+      TEST_VERIFY (handle != NULL);
+      xdlclose (handle);
+    }
+  free (to);
+  free (from);
+  return 0;
+}
+
+static char *spargv[10];
+
+static void
+run_program (const char *what, bool with_cache)
+{
+  if (with_cache)
+    TEST_COMPARE (setenv ("GLIBC_TUNABLES", "glibc.rtld.path_cache=1", 1),
+		  0);
+  else
+    TEST_COMPARE (unsetenv ("GLIBC_TUNABLES"), 0);
+
+  struct support_capture_subprocess result
+    = support_capture_subprogram (spargv[0], spargv);
+  support_capture_subprocess_check (&result, what, 0, sc_allow_none);
+  support_capture_subprocess_free (&result);
+}
+
+static int
+do_test (int argc, char *argv[])
+{
+  /* We must have either:
+     - One or four parameters left if called initially:
+       + path to ld.so         optional
+       + "--library-path"      optional
+       + the library path      optional
+       + the application name  */
+
+  if (restart)
+    return handle_restart ();
+
+  char *dir = support_create_temp_directory ("tst-path-cache-");
+  TEST_COMPARE (setenv ("PATH_CACHE_DIR", dir, 1), 0);
+  char *lib = xasprintf ("%s/elf/tst-path-cache-mod.so", support_objdir_root);
+  char *path_a = xasprintf ("%s/libtst-path-cache-a.so", dir);
+  char *path_b = xasprintf ("%s/libtst-path-cache-b.so", dir);
+  add_temp_file (path_a);
+  add_temp_file (path_b);
+
+  /* Put the temporary directory first in the library search path.  */
+  int i = 0;
+  char *library_path = NULL;
+  for (; i < argc - 1; i++)
+    {
+      spargv[i] = argv[i + 1];
+      if (i > 0 && strcmp (spargv[i - 1], "--library-path") == 0)
+	{
+	  library_path = xasprintf ("%s:%s", dir, spargv[i]);
+	  spargv[i] = library_path;
+	}
+    }
+  if (library_path == NULL)
+    {
+      const char *old = getenv ("LD_LIBRARY_PATH");
+      library_path = (old == NULL ? xstrdup (dir)
+		      : xasprintf ("%s:%s", dir, old));
+      TEST_COMPARE (setenv ("LD_LIBRARY_PATH", library_path, 1), 0);
+    }
+  spargv[i++] = (char *) "--direct";
+  spargv[i++] = (char *) "--restart";
+  int cached_arg = i;
+  spargv[i] = NULL;
+
+  support_copy_file (lib, path_a);
+  run_program ("run without cache", false);
+
+  TEST_COMPARE (unlink (path_b), 0);
+  spargv[cached_arg] = (char *) "--cached";
+  spargv[cached_arg + 1] = NULL;
+  run_program ("run with cache", true);
+
+  free (library_path);
+  free (path_b);
+  free (path_a);
+  free (lib);
+  free (dir);
+  return 0;
+}
+
+#define TEST_FUNCTION_ARGV do_test
+#include <support/test-driver.c>
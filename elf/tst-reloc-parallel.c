@@ -0,0 +1,124 @@
+/* Test for glibc.rtld.parallel_reloc.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test program is linked against a few dozen modules.  Run it
+   with different numbers of helper threads, with lazy and immediate
+   binding, and check that every relocation in the modules has been
+   resolved as without helper threads.  The startup time is measured
+   by benchtests/bench-dl-reloc-parallel.c.  */
+
+#include <array_length.h>
+#include <dlfcn.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/support.h>
+#include <support/xdlfcn.h>
+#include "tst-reloc-parallel.h"
+
+static int restart;
+#define CMDLINE_OPTIONS \
+  { "restart", no_argument, &restart, 1 },
+
+/* The symbols in the tables of the modules, in order.  */
+static const char *const table_names[reloc_parallel_table_size] =
+  {
+    "strlen", "memcpy", "memmove", "memset", "memcmp", "strchr", "strcmp",
+    "strcpy", "strncmp", "strrchr", "stpcpy", "malloc", "free", "calloc",
+    "realloc", "printf", "reloc_parallel_target", NULL,
+  };
+
+static int
+handle_restart (void)
+{
+  void *expected[reloc_parallel_table_size];
+  for (int i = 0; i < reloc_parallel_table_size; ++i)
+    expected[i] = (table_names[i] == NULL ? NULL
+		   : xdlsym (RTLD_DEFAULT, table_names[i]));
+
+  for (int n = 0; n < reloc_parallel_modules; ++n)
+    {
+      char *name = xasprintf ("reloc_parallel_table_%02d", n);
+      void *const *table = xdlsym (RTLD_DEFAULT, name);
+      for (int i = 0; i < reloc_parallel_table_size; ++i)
+	if (table[i] != expected[i])
+	  {
+	    support_record_failure ();
+	    printf ("error: %s[%d] (%s): %p, expected %p\n", name, i,
+		    table_names[i] ?: "undefined", table[i], expected[i]);
+	  }
+      free (name);
+    }
+  TEST_COMPARE (reloc_parallel_target, 42);
+  TEST_VERIFY (reloc_parallel_undefined == NULL);
+  return 0;
+}
+
+static char *spargv[10];
+
+/* Run the test program with glibc.rtld.parallel_reloc=THREADS.  */
+static void
+run_program (int threads)
+{
+  char *tunables = xasprintf ("glibc.rtld.parallel_reloc=%d", threads);
+  TEST_COMPARE (setenv ("GLIBC_TUNABLES", tunables, 1), 0);
+  struct support_capture_subprocess result
+    = support_capture_subprogram (spargv[0], spargv);
+  support_capture_subprocess_check (&result, tunables, 0, sc_allow_none);
+  support_capture_subprocess_free (&result);
+  free (tunables);
+}
+
+static int
+do_test (int argc, char *argv[])
+{
+  /* We must have either:
+     - One or four parameters left if called initially:
+       + path to ld.so         optional
+       + "--library-path"      optional
+       + the library path      optional
+       + the application name  */
+
+  if (restart)
+    return handle_restart ();
+
+  int i = 0;
+  for (; i < argc - 1; i++)
+    spargv[i] = argv[i + 1];
+  spargv[i++] = (char *) "--direct";
+  spargv[i++] = (char *) "--restart";
+  spargv[i] = NULL;
+
+  static const int thread_counts[] = { 0, 1, 2, 4, 8 };
+
+  /* Lazy binding leaves the PLT relocations to the first calls.  */
+  TEST_COMPARE (unsetenv ("LD_BIND_NOW"), 0);
+  run_program (4);
+  TEST_COMPARE (setenv ("LD_BIND_NOW", "1", 1), 0);
+  for (i = 0; i < array_length (thread_counts); ++i)
+    run_program (thread_counts[i]);
+  /* More threads than objects.  */
+  run_program (64);
+
+  return 0;
+}
+
+#define TEST_FUNCTION_ARGV do_test
+#include <support/test-driver.c>
@@ -0,0 +1,29 @@
+/* Declarations for testing glibc.rtld.parallel_reloc.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Defined in the last module.  */
+extern int reloc_parallel_target;
+
+/* Not defined anywhere.  */
+extern void reloc_parallel_undefined (void) __attribute__ ((weak));
+
+/* Number of entries in the table of each module.  */
+enum { reloc_parallel_table_size = 18 };
+
+/* Number of modules.  */
+enum { reloc_parallel_modules = 30 };
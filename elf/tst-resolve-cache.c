@@ -0,0 +1,333 @@
+/* Test the persistent symbol resolution cache (glibc.rtld.resolve_cache).
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Run the test program several times with the same cache directory,
+   and check with ld.so --list-diagnostics that the first run records
+   the lookups in a file named after the build ID of the program, that
+   the next run uses them, that a different set of objects or a damaged
+   file leads to the cache being written again, and that symbol indices
+   out of range are not used.  */
+
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <gnu/lib-names.h>
+#include <link.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/support.h>
+#include <support/temp_file.h>
+#include <support/xunistd.h>
+
+extern int resolve_cache_value;
+extern int resolve_cache_func (void);
+extern void resolve_cache_undefined (void) __attribute__ ((weak));
+
+static int restart;
+#define CMDLINE_OPTIONS \
+  { "restart", no_argument, &restart, 1 },
+
+/* Check the bindings, which may come from the cache.  */
+static int
+handle_restart (void)
+{
+  TEST_COMPARE (resolve_cache_value, 42);
+  TEST_COMPARE (resolve_cache_func (), 43);
+  TEST_VERIFY (resolve_cache_undefined == NULL);
+  TEST_VERIFY (strchr ("abc", 'b') != NULL);
+  return 0;
+}
+
+static char *spargv[10];
+
+static void
+run_program (const char *what)
+{
+  struct support_capture_subprocess result
+    = support_capture_subprogram (spargv[0], spargv);
+  support_capture_subprocess_check (&result, what, 0, sc_allow_none);
+  support_capture_subprocess_free (&result);
+}
+
+/* The layout of the cache file, see elf/dl-resolve-cache.c.  */
+struct cache_header
+{
+  char magic[16];
+  uint64_t config;
+  uint64_t checksum;
+  uint32_t nobjects;
+  uint32_t nslots;
+  uint32_t nentries;
+  uint32_t pad;
+  uint64_t last_lookups;
+  uint64_t last_hits;
+};
+
+struct cache_entry
+{
+  uint32_t object;
+  uint32_t symndx;
+  uint32_t type_class;
+  uint32_t provider;
+  uint32_t provider_symndx;
+};
+
+/* Store the build ID of the main program in hexadecimal in the string
+   pointed to by CLOSURE.  */
+static int
+build_id_callback (struct dl_phdr_info *info, size_t size, void *closure)
+{
+  char **result = closure;
+  for (int i = 0; i < info->dlpi_phnum; ++i)
+    if (info->dlpi_phdr[i].p_type == PT_NOTE)
+      {
+	const char *p = (const char *) (info->dlpi_addr
+					+ info->dlpi_phdr[i].p_vaddr);
+	const char *end = p + info->dlpi_phdr[i].p_memsz;
+	size_t align = info->dlpi_phdr[i].p_align == 8 ? 8 : 4;
+	while (end - p >= sizeof (ElfW(Nhdr)))
+	  {
+	    const ElfW(Nhdr) *note = (const ElfW(Nhdr) *) p;
+	    size_t desc_offset = roundup (sizeof (*note) + note->n_namesz,
+					  align);
+	    size_t next = roundup (desc_offset + note->n_descsz, align);
+	    if (next > end - p)
+	      break;
+	    const unsigned char *desc
+	      = (const unsigned char *) p + desc_offset;
+	    if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4
+		&& memcmp (note + 1, "GNU", 4) == 0)
+	      {
+		char *s = xmalloc (2 * note->n_descsz + 1);
+		for (size_t j = 0; j < note->n_descsz; ++j)
+		  snprintf (s + 2 * j, 3, "%02x", desc[j]);
+		*result = s;
+		return 1;
+	      }
+	    p += next;
+	  }
+      }
+  /* Only look at the main program.  */
+  return 1;
+}
+
+struct diagnostics
+{
+  unsigned long long int valid;
+  unsigned long long int lookups;
+  unsigned long long int hits;
+};
+
+static unsigned long long int
+diagnostics_value (const char *out, const char *label)
+{
+  const char *p = strstr (out, label);
+  if (p == NULL)
+    FAIL_EXIT1 ("%s not found in ld.so --list-diagnostics output", label);
+  return strtoull (p + strlen (label), NULL, 16);
+}
+
+/* The name of the cache file expected in --list-diagnostics.  */
+static char *expected_name;
+
+static struct diagnostics
+read_diagnostics (void)
+{
+  char *argv[] = { (char *) "ld.so", (char *) "--list-diagnostics", NULL };
+  struct support_capture_subprocess result
+    = support_capture_subprogram (support_objdir_elf_ldso, argv);
+  support_capture_subprocess_check (&result, "--list-diagnostics", 0,
+				    sc_allow_stdout);
+  TEST_VERIFY (strstr (result.out.buffer, "\nresolve_cache.path=\"")
+	       != NULL);
+  /* The directory contains at most the file for this program.  */
+  TEST_VERIFY (strstr (result.out.buffer, "\nresolve_cache.file[0x1].")
+	       == NULL);
+  struct diagnostics d = { 0, };
+  if (strstr (result.out.buffer, "\nresolve_cache.file[0x0].name=") == NULL)
+    {
+      support_capture_subprocess_free (&result);
+      return d;
+    }
+  char *name = xasprintf ("\nresolve_cache.file[0x0].name=\"%s\"\n",
+			  expected_name);
+  TEST_VERIFY (strstr (result.out.buffer, name) != NULL);
+  free (name);
+  d.valid = diagnostics_value (result.out.buffer,
+			       "\nresolve_cache.file[0x0].valid=");
+  if (d.valid)
+    {
+      d.lookups = diagnostics_value (result.out.buffer,
+				     "\nresolve_cache.file[0x0].last_lookups=");
+      d.hits = diagnostics_value (result.out.buffer,
+				  "\nresolve_cache.file[0x0].last_hits=");
+      printf ("info: %llu lookups, %llu hits\n", d.lookups, d.hits);
+    }
+  support_capture_subprocess_free (&result);
+  return d;
+}
+
+static int
+do_test (int argc, char *argv[])
+{
+  /* We must have either:
+     - One or four parameters left if called initially:
+       + path to ld.so         optional
+       + "--library-path"      optional
+       + the library path      optional
+       + the application name  */
+
+  if (restart)
+    return handle_restart ();
+
+  int i = 0;
+  for (; i < argc - 1; i++)
+    spargv[i] = argv[i + 1];
+  spargv[i++] = (char *) "--direct";
+  spargv[i++] = (char *) "--restart";
+  spargv[i] = NULL;
+
+  TEST_COMPARE (dl_iterate_phdr (build_id_callback, &expected_name), 1);
+  TEST_VERIFY_EXIT (expected_name != NULL);
+  printf ("info: build ID %s\n", expected_name);
+
+  char *dir = support_create_temp_directory ("tst-resolve-cache-");
+  char *cache = xasprintf ("%s/%s", dir, expected_name);
+  add_temp_file (cache);
+  char *tunables = xasprintf ("glibc.rtld.resolve_cache=%s", dir);
+  TEST_COMPARE (setenv ("GLIBC_TUNABLES", tunables, 1), 0);
+
+  struct diagnostics d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 0);
+
+  /* The first run records the cache.  */
+  run_program ("recording run");
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 1);
+  TEST_VERIFY (d.lookups > 0);
+  TEST_COMPARE (d.hits, 0);
+  unsigned long long int lookups = d.lookups;
+
+  /* The second run uses it.  The statistics are written to a new
+     file which replaces the old one, which is not modified.  */
+  struct stat st_before;
+  xstat (cache, &st_before);
+  run_program ("cached run");
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 1);
+  TEST_COMPARE (d.lookups, lookups);
+  TEST_COMPARE (d.hits, lookups);
+  {
+    struct stat st_after;
+    xstat (cache, &st_after);
+    TEST_VERIFY (st_after.st_ino != st_before.st_ino);
+  }
+
+  /* A different set of objects invalidates the cache.  */
+  TEST_COMPARE (setenv ("LD_PRELOAD", LIBC_SO, 1), 0);
+  run_program ("run with LD_PRELOAD");
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 1);
+  TEST_COMPARE (d.hits, 0);
+  run_program ("cached run with LD_PRELOAD");
+  d = read_diagnostics ();
+  TEST_VERIFY (d.hits > 0);
+  TEST_COMPARE (unsetenv ("LD_PRELOAD"), 0);
+
+  /* A damaged file is ignored and written again.  */
+  {
+    int fd = xopen (cache, O_WRONLY, 0);
+    xlseek (fd, 200, SEEK_SET);
+    xwrite (fd, "damaged", 7);
+    xclose (fd);
+  }
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 0);
+  run_program ("run with damaged cache");
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 1);
+  TEST_COMPARE (d.hits, 0);
+  run_program ("cached run after rewrite");
+  d = read_diagnostics ();
+  TEST_COMPARE (d.hits, lookups);
+
+  /* The temporary file has been renamed.  */
+  {
+    DIR *dirp = opendir (dir);
+    TEST_VERIFY_EXIT (dirp != NULL);
+    int count = 0;
+    struct dirent *e;
+    while ((e = readdir (dirp)) != NULL)
+      if (e->d_name[0] != '.')
+	{
+	  TEST_COMPARE_STRING (e->d_name, expected_name);
+	  ++count;
+	}
+    TEST_COMPARE (count, 1);
+    TEST_COMPARE (closedir (dirp), 0);
+  }
+
+  /* Symbol indices beyond the symbol tables are not used, even in a
+     file with a valid checksum.  */
+  {
+    int fd = xopen (cache, O_RDWR, 0);
+    struct stat64 st;
+    xfstat (fd, &st);
+    char *buf = xmalloc (st.st_size);
+    TEST_COMPARE (read (fd, buf, st.st_size), st.st_size);
+    struct cache_header *header = (struct cache_header *) buf;
+    struct cache_entry *slots = (struct cache_entry *) (header + 1);
+    TEST_COMPARE (st.st_size,
+		  sizeof (*header) + header->nslots * sizeof (*slots));
+    for (uint32_t i = 0; i < header->nslots; ++i)
+      if (slots[i].object != UINT32_MAX && slots[i].provider != UINT32_MAX)
+	slots[i].provider_symndx = 0x7ffffff0;
+    const uint32_t *p = (const uint32_t *) slots;
+    size_t n = header->nslots * sizeof (*slots) / sizeof (*p);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (n-- > 0)
+      h = (h ^ *p++) * 0x100000001b3ULL;
+    header->checksum = h;
+    xlseek (fd, 0, SEEK_SET);
+    xwrite (fd, buf, st.st_size);
+    xclose (fd);
+    free (buf);
+  }
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 1);
+  run_program ("run with symbol indices out of range");
+  d = read_diagnostics ();
+  TEST_COMPARE (d.valid, 1);
+  TEST_COMPARE (d.lookups, lookups);
+  TEST_VERIFY (d.hits < lookups);
+
+  free (tunables);
+  free (cache);
+  free (expected_name);
+  free (dir);
+  return 0;
+}
+
+#define TEST_FUNCTION_ARGV do_test
+#include <support/test-driver.c>
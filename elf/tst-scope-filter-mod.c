@@ -0,0 +1,32 @@
+/* Module for tst-scope-filter.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <dlfcn.h>
+
+/* dlsym records a dependency of the calling object on the object which
+   defines the symbol.  Perform the lookups from this module, so that
+   the dependencies go away when it is closed.  */
+void *
+scope_filter_lookup (void *handle, const char *name)
+{
+  void *result = dlsym (handle, name);
+  /* Prevent a tail call, after which the caller of this function would
+     be the caller of dlsym.  */
+  __asm__ ("" : "+r" (result));
+  return result;
+}
@@ -0,0 +1,135 @@
+/* Test the filter of the global scope across dlopen and dlclose.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.rtld.scope_filter=4, so that the filter
+   is extended by almost every dlopen below.  Check that lookups in the
+   global scope find every definition, in scope order, while modules
+   are added and removed.  */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/support.h>
+#include <support/xdlfcn.h>
+
+enum { nmodules = 200 };
+
+static void *handles[nmodules];
+
+/* Look up NAME in HANDLE, without preventing the defining module from
+   being unloaded.  */
+static void *
+lookup (void *handle, const char *name)
+{
+  void *mod = xdlopen ("tst-scope-filter-mod.so", RTLD_NOW);
+  void *(*fn) (void *, const char *) = xdlsym (mod, "scope_filter_lookup");
+  void *result = fn (handle, name);
+  xdlclose (mod);
+  return result;
+}
+
+static char *
+module_name (int n)
+{
+  return xasprintf ("tst-scope-filter-fill%03d.so", n);
+}
+
+static char *
+value_name (int n)
+{
+  return xasprintf ("scope_filter_value_%03d", n);
+}
+
+/* Check that the first definition of scope_filter_name in the global
+   scope is the one from module EXPECTED.  */
+static void
+check_first (int expected)
+{
+  const char *name = lookup (RTLD_DEFAULT, "scope_filter_name");
+  TEST_VERIFY_EXIT (name != NULL);
+  char *number = xasprintf ("%03d", expected);
+  TEST_COMPARE_STRING (name, number);
+  free (number);
+}
+
+/* Check that the variables of the loaded modules among 0 to END - 1
+   are found in the global scope, and those of the others are not.  */
+static void
+check_values (int end)
+{
+  for (int n = 0; n < end; ++n)
+    {
+      char *value = value_name (n);
+      void *sym = lookup (RTLD_DEFAULT, value);
+      if (handles[n] == NULL)
+	TEST_VERIFY (sym == NULL);
+      else
+	TEST_VERIFY (sym != NULL && sym == lookup (handles[n], value));
+      free (value);
+    }
+}
+
+static void
+open_module (int n)
+{
+  char *name = module_name (n);
+  handles[n] = xdlopen (name, RTLD_NOW | RTLD_GLOBAL);
+  free (name);
+}
+
+static int
+do_test (void)
+{
+  for (int n = 0; n < nmodules; ++n)
+    {
+      open_module (n);
+      check_first (0);
+      check_values (n + 1);
+    }
+
+  /* Remove the first module, and modules in the middle of the scope.  */
+  xdlclose (handles[0]);
+  handles[0] = NULL;
+  check_first (1);
+  check_values (nmodules);
+  for (int n = 50; n < 100; ++n)
+    {
+      xdlclose (handles[n]);
+      handles[n] = NULL;
+      /* Segments after the removed modules move to lower indices.  */
+      if (n % 8 == 0)
+	check_values (nmodules);
+    }
+  check_first (1);
+  check_values (nmodules);
+
+  /* Add them again, at the end of the scope.  */
+  for (int n = 50; n < 100; ++n)
+    open_module (n);
+  open_module (0);
+  check_first (1);
+  check_values (nmodules);
+
+  for (int n = 0; n < nmodules; ++n)
+    xdlclose (handles[n]);
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,114 @@
+/* Test LD_DEBUG=tls output for objects using TLS descriptors.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test program is run again with LD_DEBUG=tls, and loads a module
+   with a small TLS block, which is placed in the optional static TLS
+   surplus, and a module with a TLS block larger than the surplus,
+   which uses dynamic TLS.  */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/xdlfcn.h>
+
+static int restart;
+#define CMDLINE_OPTIONS \
+  { "restart", no_argument, &restart, 1 },
+
+static int
+handle_restart (void)
+{
+  void *h1 = xdlopen ("tst-tls-debug-mod1.so", RTLD_NOW);
+  void *h2 = xdlopen ("tst-tls-debug-mod2.so", RTLD_NOW);
+  int *(*f1) (void) = xdlsym (h1, "f1");
+  int *(*f2) (void) = xdlsym (h2, "f2");
+  TEST_COMPARE (*f1 (), 0);
+  TEST_COMPARE (f2 ()[1023], 0);
+  *f1 () = 1;
+  f2 ()[1023] = 2;
+  TEST_COMPARE (*f1 (), 1);
+  TEST_COMPARE (f2 ()[1023], 2);
+  xdlclose (h2);
+  xdlclose (h1);
+  return 0;
+}
+
+static char *spargv[10];
+
+/* Run the test program and check whether its LD_DEBUG=tls output
+   reports module 1 in the optional static TLS surplus according to
+   MOD1_STATIC.  Module 2 never fits.  */
+static void
+run_program (const char *what, bool mod1_static)
+{
+  struct support_capture_subprocess result
+    = support_capture_subprogram (spargv[0], spargv);
+  support_capture_subprocess_check (&result, what, 0, sc_allow_stderr);
+
+  const char *err = result.err.buffer;
+  bool mod1_placed
+    = strstr (err, "tst-tls-debug-mod1.so: 4 bytes at offset 0x") != NULL;
+  bool mod1_failed
+    = strstr (err, "tst-tls-debug-mod1.so: cannot use optional surplus "
+	      "for 4 bytes") != NULL;
+  bool mod2_failed
+    = strstr (err, "tst-tls-debug-mod2.so: cannot use optional surplus "
+	      "for 4096 bytes") != NULL;
+  if (mod1_placed != mod1_static || mod1_failed == mod1_static
+      || !mod2_failed)
+    {
+      support_record_failure ();
+      printf ("error: %s: unexpected LD_DEBUG output:\n%s", what, err);
+    }
+  support_capture_subprocess_free (&result);
+}
+
+static int
+do_test (int argc, char *argv[])
+{
+  /* We must have either:
+     - One or four parameters left if called initially:
+       + path to ld.so         optional
+       + "--library-path"      optional
+       + the library path      optional
+       + the application name  */
+
+  if (restart)
+    return handle_restart ();
+
+  int i = 0;
+  for (; i < argc - 1; i++)
+    spargv[i] = argv[i + 1];
+  spargv[i++] = (char *) "--direct";
+  spargv[i++] = (char *) "--restart";
+  spargv[i] = NULL;
+
+  TEST_COMPARE (setenv ("LD_DEBUG", "tls", 1), 0);
+  run_program ("default surplus", true);
+  TEST_COMPARE (setenv ("GLIBC_TUNABLES",
+			"glibc.rtld.optional_static_tls=0", 1), 0);
+  run_program ("no optional surplus", false);
+  return 0;
+}
+
+#define TEST_FUNCTION_ARGV do_test
+#include <support/test-driver.c>
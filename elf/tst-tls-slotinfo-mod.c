@@ -0,0 +1,7 @@
+__thread int tls_slotinfo_var = 42;
+
+int *
+tls_slotinfo_get (void)
+{
+  return &tls_slotinfo_var;
+}
@@ -0,0 +1,135 @@
+/* Test DTV updates with many modules and reused module IDs.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Load enough copies of a module with a TLS variable to use several
+   elements of the slotinfo list, then close some of them and load new
+   copies, which reuse their module IDs.  The first access to the
+   variable of a new copy must find a freshly initialized TLS block,
+   both on the main thread, whose DTV still has a block for the closed
+   copy, and on a thread created before any of the copies was
+   loaded.  */
+
+#include <array_length.h>
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <support/check.h>
+#include <support/support.h>
+#include <support/temp_file.h>
+#include <support/xdlfcn.h>
+#include <support/xthread.h>
+
+/* Number of copies loaded at first.  */
+enum { ncopies = 200 };
+
+/* Copies which are closed and replaced.  */
+static const int replaced[] = { 3, 70, 140, 199 };
+
+static char *dir;
+static char *module;
+static void *handles[ncopies];
+static int *(*getters[ncopies]) (void);
+
+static pthread_barrier_t barrier;
+
+static void
+open_copy (int i, int generation)
+{
+  char *path = xasprintf ("%s/tst-tls-slotinfo-%d-%d.so", dir, i,
+			  generation);
+  support_copy_file (module, path);
+  add_temp_file (path);
+  handles[i] = xdlopen (path, RTLD_NOW);
+  getters[i] = xdlsym (handles[i], "tls_slotinfo_get");
+  free (path);
+}
+
+/* Check the variables of all copies, set them to their index plus
+   1000, and check the result again.  If FRESH is not NULL, only
+   copies I with FRESH[I] set are expected to have their initial
+   value.  */
+static void
+check_all (const bool *fresh)
+{
+  for (int i = 0; i < ncopies; ++i)
+    {
+      int *p = getters[i] ();
+      int expected = fresh == NULL || fresh[i] ? 42 : i + 1000;
+      if (*p != expected)
+	{
+	  support_record_failure ();
+	  printf ("error: copy %d: value %d, expected %d\n", i, *p,
+		  expected);
+	}
+      *p = i + 1000;
+    }
+  for (int i = 0; i < ncopies; ++i)
+    TEST_COMPARE (*getters[i] (), i + 1000);
+}
+
+static void *
+thread_func (void *closure)
+{
+  /* Wait until the copies are loaded.  */
+  xpthread_barrier_wait (&barrier);
+  check_all (NULL);
+  /* Let the main thread replace some of them, and wait until it is
+     done.  */
+  xpthread_barrier_wait (&barrier);
+  xpthread_barrier_wait (&barrier);
+  check_all (closure);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  dir = support_create_temp_directory ("tst-tls-slotinfo-");
+  module = xasprintf ("%s/elf/tst-tls-slotinfo-mod.so", support_objdir_root);
+
+  bool fresh[ncopies] = { false, };
+  for (size_t i = 0; i < array_length (replaced); ++i)
+    fresh[replaced[i]] = true;
+
+  xpthread_barrier_init (&barrier, NULL, 2);
+  pthread_t thr = xpthread_create (NULL, thread_func, fresh);
+
+  for (int i = 0; i < ncopies; ++i)
+    open_copy (i, 0);
+  check_all (NULL);
+  xpthread_barrier_wait (&barrier);
+  xpthread_barrier_wait (&barrier);
+
+  for (size_t i = 0; i < array_length (replaced); ++i)
+    xdlclose (handles[replaced[i]]);
+  for (size_t i = 0; i < array_length (replaced); ++i)
+    open_copy (replaced[i], 1);
+  check_all (fresh);
+  xpthread_barrier_wait (&barrier);
+
+  xpthread_join (thr);
+  xpthread_barrier_destroy (&barrier);
+  for (int i = 0; i < ncopies; ++i)
+    xdlclose (handles[i]);
+  free (module);
+  free (dir);
+  return 0;
+}
+
+#include <support/test-driver.c>
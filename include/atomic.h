@@ -602,6 +602,10 @@ void __atomic_link_error (void);
   ({ __atomic_check_size((mem));					      \
   __atomic_compare_exchange_n ((mem), (expected), (desired), 1,		      \
     __ATOMIC_RELEASE, __ATOMIC_RELAXED); })
+# define atomic_compare_exchange_weak_seq_cst(mem, expected, desired) \
+  ({ __atomic_check_size((mem));					      \
+  __atomic_compare_exchange_n ((mem), (expected), (desired), 1,		      \
+    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED); })
 
 # define atomic_exchange_relaxed(mem, desired) \
   ({ __atomic_check_size((mem));					      \
@@ -714,6 +718,11 @@ void __atomic_link_error (void);
      atomic_compare_and_exchange_val_rel ((mem), (desired), *(expected));     \
    *(expected) == __atg103_expected; })
 # endif
+# ifndef atomic_compare_exchange_weak_seq_cst
+#  define atomic_compare_exchange_weak_seq_cst(mem, expected, desired) \
+   ({ atomic_full_barrier ();						      \
+   atomic_compare_exchange_weak_acquire ((mem), (expected), (desired)); })
+# endif
 
 /* XXX Fall back to acquire MO because archs do not define a weaker
    atomic_exchange.  */
@@ -111,6 +111,8 @@ struct dlfcn_hook
 		  void **extra_info, int flags);
   int (*dlinfo) (void *handle, int request, void *arg);
   void *(*dlmopen) (Lmid_t nsid, const char *file, int mode, void *dl_caller);
+  int (*dlopen_many) (const char *const *files, size_t count, int mode,
+		      void **handles, void *dl_caller);
 
   /* Internal interfaces.  */
   void* (*libc_dlopen_mode)  (const char *__name, int __mode);
@@ -126,6 +128,8 @@ struct dlfcn_hook
 extern void *__dlopen (const char *file, int mode, void *caller);
 extern void *__dlmopen (Lmid_t nsid, const char *file, int mode,
 			void *dl_caller);
+extern int __dlopen_many (const char *const *files, size_t count, int mode,
+			  void **handles, void *dl_caller);
 extern int __dlclose (void *handle);
 extern void *__dlsym (void *handle, const char *name, void *dl_caller);
 extern void *__dlvsym (void *handle, const char *name, const char *version,
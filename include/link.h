@@ -69,6 +69,9 @@ struct r_scope_elem
   struct link_map **r_list;
   /* Number of entries in the scope.  */
   unsigned int r_nlist;
+  /* Filter of the symbols defined in large scopes, or NULL.  See
+     elf/dl-scope-filter.h.  */
+  struct dl_scope_filter *r_filter;
 };
 
 
@@ -197,6 +200,9 @@ struct link_map
     unsigned int l_need_tls_init:1; /* Nonzero if GL(dl_init_static_tls)
 				       should be called on this link map
 				       when relocation finishes.  */
+    unsigned int l_tls_optional_failed:1; /* Nonzero if the optional static
+					     TLS surplus was too small for
+					     this object.  */
     unsigned int l_auditing:1;	/* Nonzero if the DSO is used in auditing.  */
     unsigned int l_audit_any_plt:1; /* Nonzero if at least one audit module
 				       is interested in the PLT interception.*/
@@ -292,7 +298,8 @@ struct link_map
     ElfW(Word) l_flags_1;
     ElfW(Word) l_flags;
 
-    /* Temporarily used in `dl_close'.  */
+    /* Temporarily used in `dl_close', and by the resolution cache
+       while the initial objects are relocated.  */
     int l_idx;
 
     struct link_map_machine l_mach;
@@ -305,6 +312,11 @@ struct link_map
       const ElfW(Sym) *ret;
     } l_lookup_cache;
 
+    /* Results of the symbol lookups for the relocations of this object
+       performed ahead of time on helper threads.  Only set while the
+       initial objects are relocated with glibc.rtld.parallel_reloc.  */
+    struct dl_reloc_prefetch *l_reloc_prefetch;
+
     /* Thread-local storage related info.  */
 
     /* Start of the initialization image.  */
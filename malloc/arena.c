@@ -55,6 +55,19 @@ heap_max_size (void)
   return mp_.hp_pagesize == 0 ? HEAP_MAX_SIZE : mp_.hp_pagesize * 4;
 }
 
+/* Return the granularity in which a heap with pages of PAGESIZE is made
+   accessible and released.  With glibc.malloc.heap_thp, heaps backed by
+   regular pages use whole transparent huge pages, so that the kernel
+   can back the usable part of the heap with huge pages.  */
+
+static inline size_t
+heap_extent (size_t pagesize)
+{
+  if (mp_.heap_thp_pagesize != 0 && pagesize == GLRO (dl_pagesize))
+    return mp_.heap_thp_pagesize;
+  return pagesize;
+}
+
 /***************************************************************************/
 
 #define top(ar_ptr) ((ar_ptr)->top)
@@ -133,11 +146,16 @@ static bool __malloc_initialized = false;
 
 #define arena_lock(ptr, size) do {					      \
       if (ptr)								      \
-        __libc_lock_lock (ptr->mutex);					      \
+        arena_mutex_lock (ptr);						      \
       else								      \
         ptr = arena_get2 ((size), NULL);				      \
   } while (0)
 
+/* Acquire the lock of an arena, counting the acquisition for
+   malloc_stats_np.  Defined in malloc.c, after the tcache.  */
+static void arena_mutex_lock (mstate av);
+static bool arena_mutex_trylock (mstate av);
+
 /* find the heap and corresponding arena for a given ptr */
 
 static inline heap_info *
@@ -164,6 +182,20 @@ arena_for_chunk (mchunkptr ptr)
    called, so that other fork handlers can use the malloc
    subsystem.  */
 
+#if USE_TCACHE
+static void percpu_fork_lock (void);
+static void percpu_fork_unlock (bool child);
+static void stats_fork_lock (void);
+static void stats_fork_unlock (bool child);
+#endif
+#if IS_IN (libc)
+static void sample_fork_lock (void);
+static void sample_fork_unlock (bool child);
+static void slab_fork_lock (void);
+static void slab_fork_unlock (bool child);
+static void slab_thread_shutdown (void);
+#endif
+
 void
 __malloc_fork_lock_parent (void)
 {
@@ -173,6 +205,10 @@ __malloc_fork_lock_parent (void)
   /* We do not acquire free_list_lock here because we completely
      reconstruct free_list in __malloc_fork_unlock_child.  */
 
+#if IS_IN (libc)
+  /* The slab locks are never held while acquiring an arena lock.  */
+  slab_fork_lock ();
+#endif
   __libc_lock_lock (list_lock);
 
   for (mstate ar_ptr = &main_arena;; )
@@ -182,6 +218,18 @@ __malloc_fork_lock_parent (void)
       if (ar_ptr == &main_arena)
         break;
     }
+
+#if USE_TCACHE
+  /* The per-CPU cache locks are acquired while holding an arena lock,
+     never the other way round.  */
+  percpu_fork_lock ();
+  stats_fork_lock ();
+#endif
+#if IS_IN (libc)
+  /* realloc acquires the profiler lock while holding an arena lock, and
+     it is never held while acquiring another malloc lock.  */
+  sample_fork_lock ();
+#endif
 }
 
 void
@@ -190,6 +238,14 @@ __malloc_fork_unlock_parent (void)
   if (!__malloc_initialized)
     return;
 
+#if IS_IN (libc)
+  sample_fork_unlock (false);
+#endif
+#if USE_TCACHE
+  stats_fork_unlock (false);
+  percpu_fork_unlock (false);
+#endif
+
   for (mstate ar_ptr = &main_arena;; )
     {
       __libc_lock_unlock (ar_ptr->mutex);
@@ -198,6 +254,9 @@ __malloc_fork_unlock_parent (void)
         break;
     }
   __libc_lock_unlock (list_lock);
+#if IS_IN (libc)
+  slab_fork_unlock (false);
+#endif
 }
 
 void
@@ -208,6 +267,15 @@ __malloc_fork_unlock_child (void)
 
   /* Push all arenas to the free list, except thread_arena, which is
      attached to the current thread.  */
+#if USE_TCACHE
+  stats_fork_unlock (true);
+  percpu_fork_unlock (true);
+#endif
+#if IS_IN (libc)
+  slab_fork_unlock (true);
+  sample_fork_unlock (true);
+#endif
+
   __libc_lock_init (free_list_lock);
   if (thread_arena != NULL)
     thread_arena->attached_threads = 1;
@@ -250,12 +318,26 @@ TUNABLE_CALLBACK_FNDECL (set_arena_test, size_t)
 TUNABLE_CALLBACK_FNDECL (set_tcache_max, size_t)
 TUNABLE_CALLBACK_FNDECL (set_tcache_count, size_t)
 TUNABLE_CALLBACK_FNDECL (set_tcache_unsorted_limit, size_t)
+TUNABLE_CALLBACK_FNDECL (set_tcache_batch, size_t)
+TUNABLE_CALLBACK_FNDECL (set_percpu_count, size_t)
 #endif
 TUNABLE_CALLBACK_FNDECL (set_mxfast, size_t)
 TUNABLE_CALLBACK_FNDECL (set_hugetlb, size_t)
+TUNABLE_CALLBACK_FNDECL (set_remote_free, int32_t)
+TUNABLE_CALLBACK_FNDECL (set_numa, int32_t)
+TUNABLE_CALLBACK_FNDECL (set_decay_ms, size_t)
+TUNABLE_CALLBACK_FNDECL (set_heap_thp, int32_t)
+TUNABLE_CALLBACK_FNDECL (set_sample_interval, size_t)
+TUNABLE_CALLBACK_FNDECL (set_slab, int32_t)
+TUNABLE_CALLBACK_FNDECL (set_stats, int32_t)
 
 #if USE_TCACHE
 static void tcache_key_initialize (void);
+static void percpu_init (void);
+#endif
+#if IS_IN (libc)
+static void sample_enable (void);
+static void slab_init (void);
 #endif
 
 static void
@@ -309,9 +391,32 @@ ptmalloc_init (void)
   TUNABLE_GET (tcache_count, size_t, TUNABLE_CALLBACK (set_tcache_count));
   TUNABLE_GET (tcache_unsorted_limit, size_t,
 	       TUNABLE_CALLBACK (set_tcache_unsorted_limit));
+  TUNABLE_GET (tcache_batch, size_t, TUNABLE_CALLBACK (set_tcache_batch));
+  TUNABLE_GET (percpu, size_t, TUNABLE_CALLBACK (set_percpu_count));
+  if (mp_.percpu_count > 0)
+    percpu_init ();
 # endif
   TUNABLE_GET (mxfast, size_t, TUNABLE_CALLBACK (set_mxfast));
   TUNABLE_GET (hugetlb, size_t, TUNABLE_CALLBACK (set_hugetlb));
+  TUNABLE_GET (remote_free, int32_t, TUNABLE_CALLBACK (set_remote_free));
+  TUNABLE_GET (numa, int32_t, TUNABLE_CALLBACK (set_numa));
+  TUNABLE_GET (decay_ms, size_t, TUNABLE_CALLBACK (set_decay_ms));
+  TUNABLE_GET (heap_thp, int32_t, TUNABLE_CALLBACK (set_heap_thp));
+  TUNABLE_GET (sample_interval, size_t,
+	       TUNABLE_CALLBACK (set_sample_interval));
+  TUNABLE_GET (slab, int32_t, TUNABLE_CALLBACK (set_slab));
+  TUNABLE_GET (stats, int32_t, TUNABLE_CALLBACK (set_stats));
+#if IS_IN (libc)
+  if (mp_.sample_interval != 0)
+    sample_enable ();
+  /* Memory tagging relies on the chunk headers.  */
+  if (mtag_enabled)
+    mp_.slab = 0;
+  if (mp_.slab)
+    slab_init ();
+#else
+  mp_.slab = 0;
+#endif
 
   if (mp_.hp_pagesize > 0)
     {
@@ -372,11 +477,12 @@ dump_heap (heap_info *heap)
 static char *aligned_heap_area;
 
 /* Create a new heap.  size is automatically rounded up to a multiple
-   of the page size. */
+   of the page size.  If NODE is not negative, the memory of the heap
+   is placed on that NUMA node.  */
 
 static heap_info *
 alloc_new_heap  (size_t size, size_t top_pad, size_t pagesize,
-		 int mmap_flags)
+		 int mmap_flags, int node)
 {
   char *p1, *p2;
   unsigned long ul;
@@ -393,6 +499,8 @@ alloc_new_heap  (size_t size, size_t top_pad, size_t pagesize,
   else
     size = max_size;
   size = ALIGN_UP (size, pagesize);
+  size_t extent = heap_extent (pagesize);
+  size_t mprotect_size = ALIGN_UP (size, extent);
 
   /* A memory region aligned to a multiple of max_size is needed.
      No swap space needs to be reserved for the following large
@@ -438,36 +546,48 @@ alloc_new_heap  (size_t size, size_t top_pad, size_t pagesize,
             }
         }
     }
-  if (__mprotect (p2, size, mtag_mmap_flags | PROT_READ | PROT_WRITE) != 0)
+  if (__mprotect (p2, mprotect_size, mtag_mmap_flags | PROT_READ | PROT_WRITE)
+      != 0)
     {
       __munmap (p2, max_size);
       return 0;
     }
 
+  /* Cover the whole reservation, so that the pages made accessible by
+     grow_heap later on are placed on the same node.  This has to
+     happen before the heap header below is written.  */
+  if (node >= 0)
+    malloc_bind_node (p2, max_size, node);
+
   /* Only considere the actual usable range.  */
-  __set_vma_name (p2, size, " glibc: malloc arena");
+  __set_vma_name (p2, mprotect_size, " glibc: malloc arena");
 
-  madvise_thp (p2, size);
+  /* Hint the whole reservation, so that the extents made accessible by
+     grow_heap inherit the advice.  */
+  if (extent != pagesize)
+    __madvise (p2, max_size, MADV_HUGEPAGE);
+  else
+    madvise_thp (p2, size);
 
   h = (heap_info *) p2;
   h->size = size;
-  h->mprotect_size = size;
+  h->mprotect_size = mprotect_size;
   h->pagesize = pagesize;
   LIBC_PROBE (memory_heap_new, 2, h, h->size);
   return h;
 }
 
 static heap_info *
-new_heap (size_t size, size_t top_pad)
+new_heap (size_t size, size_t top_pad, int node)
 {
   if (__glibc_unlikely (mp_.hp_pagesize != 0))
     {
       heap_info *h = alloc_new_heap (size, top_pad, mp_.hp_pagesize,
-				     mp_.hp_flags);
+				     mp_.hp_flags, node);
       if (h != NULL)
 	return h;
     }
-  return alloc_new_heap (size, top_pad, GLRO (dl_pagesize), 0);
+  return alloc_new_heap (size, top_pad, GLRO (dl_pagesize), 0, node);
 }
 
 /* Grow a heap.  size is automatically rounded up to a
@@ -487,12 +607,15 @@ grow_heap (heap_info *h, long diff)
 
   if ((unsigned long) new_size > h->mprotect_size)
     {
+      /* MAX_SIZE is a multiple of the extent, so this stays within the
+	 heap.  */
+      size_t mprotect_size = ALIGN_UP (new_size, heap_extent (pagesize));
       if (__mprotect ((char *) h + h->mprotect_size,
-                      (unsigned long) new_size - h->mprotect_size,
+                      mprotect_size - h->mprotect_size,
                       mtag_mmap_flags | PROT_READ | PROT_WRITE) != 0)
         return -2;
 
-      h->mprotect_size = new_size;
+      h->mprotect_size = mprotect_size;
     }
 
   h->size = new_size;
@@ -511,18 +634,28 @@ shrink_heap (heap_info *h, long diff)
   if (new_size < (long) sizeof (*h))
     return -1;
 
+  /* Memory is only released in whole extents, so that the huge pages
+     backing the rest of the heap are not split.  The tail of the last
+     extent may still be resident from an earlier shrink.  */
+  size_t extent = heap_extent (h->pagesize);
+  long keep = ALIGN_UP (new_size, extent);
+  long end = ALIGN_UP (h->size, extent);
+
   /* Try to re-map the extra heap space freshly to save memory, and make it
      inaccessible.  See malloc-sysdep.h to know when this is true.  */
-  if (__glibc_unlikely (check_may_shrink_heap ()))
+  if (keep < end && __glibc_unlikely (check_may_shrink_heap ()))
     {
-      if ((char *) MMAP ((char *) h + new_size, diff, PROT_NONE,
+      if ((char *) MMAP ((char *) h + keep, end - keep, PROT_NONE,
                          MAP_FIXED) == (char *) MAP_FAILED)
         return -2;
 
-      h->mprotect_size = new_size;
+      /* The fresh mapping does not carry the advice of the old one.  */
+      if (extent != h->pagesize)
+	__madvise ((char *) h + keep, end - keep, MADV_HUGEPAGE);
+      h->mprotect_size = keep;
     }
-  else
-    __madvise ((char *) h + new_size, diff, MADV_DONTNEED);
+  else if (keep < end)
+    __madvise ((char *) h + keep, end - keep, MADV_DONTNEED);
   /*fprintf(stderr, "shrink %p %08lx\n", h, new_size);*/
 
   h->size = new_size;
@@ -628,7 +761,7 @@ detach_arena (mstate replaced_arena)
 }
 
 static mstate
-_int_new_arena (size_t size)
+_int_new_arena (size_t size, int node)
 {
   mstate a;
   heap_info *h;
@@ -636,19 +769,21 @@ _int_new_arena (size_t size)
   unsigned long misalign;
 
   h = new_heap (size + (sizeof (*h) + sizeof (*a) + MALLOC_ALIGNMENT),
-                mp_.top_pad);
+                mp_.top_pad, node);
   if (!h)
     {
       /* Maybe size is too large to fit in a single heap.  So, just try
          to create a minimally-sized arena and let _int_malloc() attempt
          to deal with the large request via mmap_chunk().  */
-      h = new_heap (sizeof (*h) + sizeof (*a) + MALLOC_ALIGNMENT, mp_.top_pad);
+      h = new_heap (sizeof (*h) + sizeof (*a) + MALLOC_ALIGNMENT, mp_.top_pad,
+		    node);
       if (!h)
         return 0;
     }
   a = h->ar_ptr = (mstate) (h + 1);
   malloc_init_state (a);
   a->attached_threads = 1;
+  a->numa_node = node;
   /*a->next = NULL;*/
   a->system_mem = a->max_system_mem = h->size;
 
@@ -691,25 +826,32 @@ _int_new_arena (size_t size)
      but this could result in a deadlock with
      __malloc_fork_lock_parent.  */
 
-  __libc_lock_lock (a->mutex);
+  arena_mutex_lock (a);
 
   return a;
 }
 
 
-/* Remove an arena from free_list.  */
+/* Remove an arena from free_list.  If NODE is not negative, only
+   consider arenas placed on that NUMA node.  */
 static mstate
-get_free_list (void)
+get_free_list (int node)
 {
   mstate replaced_arena = thread_arena;
   mstate result = free_list;
   if (result != NULL)
     {
       __libc_lock_lock (free_list_lock);
-      result = free_list;
+      mstate *previous = &free_list;
+      for (result = free_list; result != NULL; result = result->next_free)
+	{
+	  if (node < 0 || result->numa_node == node)
+	    break;
+	  previous = &result->next_free;
+	}
       if (result != NULL)
 	{
-	  free_list = result->next_free;
+	  *previous = result->next_free;
 
 	  /* The arena will be attached to this thread.  */
 	  assert (result->attached_threads == 0);
@@ -722,7 +864,7 @@ get_free_list (void)
       if (result != NULL)
         {
           LIBC_PROBE (memory_arena_reuse_free_list, 1, result);
-          __libc_lock_lock (result->mutex);
+          arena_mutex_lock (result);
 	  thread_arena = result;
         }
     }
@@ -752,9 +894,10 @@ remove_from_free_list (mstate arena)
 
 /* Lock and return an arena that can be reused for memory allocation.
    Avoid AVOID_ARENA as we have already failed to allocate memory in
-   it and it is currently locked.  */
+   it and it is currently locked.  If NODE is not negative, prefer
+   arenas placed on that NUMA node.  */
 static mstate
-reused_arena (mstate avoid_arena)
+reused_arena (mstate avoid_arena, int node)
 {
   mstate result;
   /* FIXME: Access to next_to_use suffers from data races.  */
@@ -764,10 +907,25 @@ reused_arena (mstate avoid_arena)
 
   /* Iterate over all arenas (including those linked from
      free_list).  */
+  if (node >= 0)
+    {
+      result = next_to_use;
+      do
+	{
+	  if (result->numa_node == node
+	      && arena_mutex_trylock (result))
+	    goto out;
+
+	  /* FIXME: This is a data race, see _int_new_arena.  */
+	  result = result->next;
+	}
+      while (result != next_to_use);
+    }
+
   result = next_to_use;
   do
     {
-      if (!__libc_lock_trylock (result->mutex))
+      if (arena_mutex_trylock (result))
         goto out;
 
       /* FIXME: This is a data race, see _int_new_arena.  */
@@ -782,7 +940,7 @@ reused_arena (mstate avoid_arena)
 
   /* No arena available without contention.  Wait for the next in line.  */
   LIBC_PROBE (memory_arena_reuse_wait, 3, &result->mutex, result, avoid_arena);
-  __libc_lock_lock (result->mutex);
+  arena_mutex_lock (result);
 
 out:
   /* Attach the arena to the current thread.  */
@@ -821,7 +979,11 @@ arena_get2 (size_t size, mstate avoid_arena)
 
   static size_t narenas_limit;
 
-  a = get_free_list ();
+  /* In NUMA mode, look for an arena on the node of the current CPU
+     first, and only create arenas for that node.  */
+  int node = mp_.numa ? malloc_numa_node () : -1;
+
+  a = get_free_list (node);
   if (a == NULL)
     {
       /* Nothing immediately available, so generate a new arena.  */
@@ -854,12 +1016,17 @@ arena_get2 (size_t size, mstate avoid_arena)
         {
           if (catomic_compare_and_exchange_bool_acq (&narenas, n + 1, n))
             goto repeat;
-          a = _int_new_arena (size);
+          a = _int_new_arena (size, node);
 	  if (__glibc_unlikely (a == NULL))
             catomic_decrement (&narenas);
         }
       else
-        a = reused_arena (avoid_arena);
+	{
+	  if (node >= 0)
+	    a = get_free_list (-1);
+	  if (a == NULL)
+	    a = reused_arena (avoid_arena, node);
+	}
     }
   return a;
 }
@@ -876,7 +1043,7 @@ arena_get_retry (mstate ar_ptr, size_t bytes)
     {
       __libc_lock_unlock (ar_ptr->mutex);
       ar_ptr = &main_arena;
-      __libc_lock_lock (ar_ptr->mutex);
+      arena_mutex_lock (ar_ptr);
     }
   else
     {
@@ -895,6 +1062,9 @@ __malloc_arena_thread_freeres (void)
      the thread arena, so do this before we put the arena on the free
      list.  */
   tcache_thread_shutdown ();
+#if IS_IN (libc)
+  slab_thread_shutdown ();
+#endif
 
   mstate a = thread_arena;
   thread_arena = NULL;
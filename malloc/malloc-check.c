@@ -241,6 +241,32 @@ free_check (void *mem)
   __set_errno (err);
 }
 
+/* Check that MEM, about to be passed to free_check, was allocated with
+   a request of BYTES bytes, as free_sized requires.  */
+static void
+free_sized_check (void *mem, size_t bytes)
+{
+  if (!mem)
+    return;
+
+  unsigned char *magic_p;
+  size_t size = 0;
+  __libc_lock_lock (main_arena.mutex);
+  mchunkptr p = mem2chunk_check (mem, &magic_p);
+  if (p)
+    {
+      /* The magic byte follows the requested size.  Restore it for
+	 free_check.  */
+      size = magic_p - (unsigned char *) p - CHUNK_HDR_SZ;
+      *magic_p ^= 0xFF;
+    }
+  __libc_lock_unlock (main_arena.mutex);
+  if (!p)
+    malloc_printerr ("free_sized(): invalid pointer");
+  if (size != bytes)
+    malloc_printerr ("free_sized(): invalid size");
+}
+
 static void *
 realloc_check (void *oldmem, size_t bytes)
 {
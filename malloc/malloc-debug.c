@@ -190,12 +190,12 @@ __debug_malloc (size_t bytes)
 strong_alias (__debug_malloc, malloc)
 
 static void
-__debug_free (void *mem)
+_debug_mid_free (void *mem, const void *address)
 {
   void (*hook) (void *, const void *) = atomic_forced_read (__free_hook);
   if (__builtin_expect (hook != NULL, 0))
     {
-      (*hook)(mem, RETURN_ADDRESS (0));
+      (*hook)(mem, address);
       return;
     }
 
@@ -209,10 +209,43 @@ __debug_free (void *mem)
   else
     __libc_free (mem);
   if (__is_malloc_debug_enabled (MALLOC_MTRACE_HOOK))
-    free_mtrace (mem, RETURN_ADDRESS (0));
+    free_mtrace (mem, address);
+}
+
+static void
+__debug_free (void *mem)
+{
+  _debug_mid_free (mem, RETURN_ADDRESS (0));
 }
 strong_alias (__debug_free, free)
 
+/* The sized variants are checked only for MALLOC_CHECK_, which records
+   the size of each request.  */
+static void
+_debug_mid_free_sized (void *mem, size_t bytes, const void *address)
+{
+  if (__is_malloc_debug_enabled (MALLOC_CHECK_HOOK)
+      && !__is_malloc_debug_enabled (MALLOC_MCHECK_HOOK)
+      && atomic_forced_read (__free_hook) == NULL
+      && !DUMPED_MAIN_ARENA_CHUNK (mem2chunk (mem)))
+    free_sized_check (mem, bytes);
+  _debug_mid_free (mem, address);
+}
+
+static void
+__debug_free_sized (void *mem, size_t bytes)
+{
+  _debug_mid_free_sized (mem, bytes, RETURN_ADDRESS (0));
+}
+strong_alias (__debug_free_sized, free_sized)
+
+static void
+__debug_free_aligned_sized (void *mem, size_t alignment, size_t bytes)
+{
+  _debug_mid_free_sized (mem, bytes, RETURN_ADDRESS (0));
+}
+strong_alias (__debug_free_aligned_sized, free_aligned_sized)
+
 static void *
 __debug_realloc (void *oldmem, size_t bytes)
 {
@@ -403,6 +436,16 @@ __debug_calloc (size_t nmemb, size_t size)
 }
 strong_alias (__debug_calloc, calloc)
 
+#define LIBC_SYMBOL(sym) libc_ ## sym
+#define SYMHANDLE(sym) sym ## _handle
+
+#define LOAD_SYM(sym) ({ \
+  static void *SYMHANDLE (sym);						      \
+  if (SYMHANDLE (sym) == NULL)						      \
+    SYMHANDLE (sym) = dlsym (RTLD_NEXT, #sym);				      \
+  SYMHANDLE (sym);							      \
+})
+
 size_t
 malloc_usable_size (void *mem)
 {
@@ -418,19 +461,16 @@ malloc_usable_size (void *mem)
   if (DUMPED_MAIN_ARENA_CHUNK (p))
     return chunksize (p) - SIZE_SZ;
 
+  /* The chunk may come from the slab allocator of libc, which has no
+     chunk header.  */
+  size_t (*LIBC_SYMBOL (malloc_usable_size)) (void *)
+    = LOAD_SYM (malloc_usable_size);
+  if (LIBC_SYMBOL (malloc_usable_size) != NULL)
+    return LIBC_SYMBOL (malloc_usable_size) (mem);
+
   return musable (mem);
 }
 
-#define LIBC_SYMBOL(sym) libc_ ## sym
-#define SYMHANDLE(sym) sym ## _handle
-
-#define LOAD_SYM(sym) ({ \
-  static void *SYMHANDLE (sym);						      \
-  if (SYMHANDLE (sym) == NULL)						      \
-    SYMHANDLE (sym) = dlsym (RTLD_NEXT, #sym);				      \
-  SYMHANDLE (sym);							      \
-})
-
 int
 malloc_info (int options, FILE *fp)
 {
@@ -650,6 +690,9 @@ compat_symbol (libc_malloc_debug, malloc_set_state, malloc_set_state,
 compat_symbol (libc_malloc_debug, aligned_alloc, aligned_alloc, GLIBC_2_16);
 compat_symbol (libc_malloc_debug, calloc, calloc, GLIBC_2_0);
 compat_symbol (libc_malloc_debug, free, free, GLIBC_2_0);
+compat_symbol (libc_malloc_debug, free_aligned_sized, free_aligned_sized,
+	       GLIBC_2_40);
+compat_symbol (libc_malloc_debug, free_sized, free_sized, GLIBC_2_40);
 compat_symbol (libc_malloc_debug, mallinfo2, mallinfo2, GLIBC_2_33);
 compat_symbol (libc_malloc_debug, mallinfo, mallinfo, GLIBC_2_0);
 compat_symbol (libc_malloc_debug, malloc_info, malloc_info, GLIBC_2_10);
@@ -605,6 +605,20 @@ libc_hidden_proto (__libc_malloc)
 void     __libc_free(void*);
 libc_hidden_proto (__libc_free)
 
+/*
+  free_sized(void* p, size_t n);
+  free_aligned_sized(void* p, size_t alignment, size_t n);
+  Like free, for memory that was allocated with a request of n bytes
+  by malloc, calloc or realloc, or by aligned_alloc with the given
+  alignment.  Passing any other size has undefined effects.  The size
+  selects the tcache bin of small chunks directly.  The chunk header
+  is still read on every call, and the program aborts if the chunk is
+  smaller than n.  Chunks whose size belongs to another bin are freed
+  as by free.
+*/
+void     __libc_free_sized(void*, size_t);
+void     __libc_free_aligned_sized(void*, size_t, size_t);
+
 /*
   calloc(size_t n_elements, size_t element_size);
   Returns a pointer to n_elements * element_size bytes, with all locations
@@ -1087,16 +1101,20 @@ typedef struct malloc_chunk* mchunkptr;
 
 static void*  _int_malloc(mstate, size_t);
 static void     _int_free(mstate, mchunkptr, int);
+static void _int_free_chunk (mstate, mchunkptr, INTERNAL_SIZE_T, int);
 static void _int_free_merge_chunk (mstate, mchunkptr, INTERNAL_SIZE_T);
 static INTERNAL_SIZE_T _int_free_create_chunk (mstate,
 					       mchunkptr, INTERNAL_SIZE_T,
 					       mchunkptr, INTERNAL_SIZE_T);
 static void _int_free_maybe_consolidate (mstate, INTERNAL_SIZE_T);
+static void _int_free_remote (mstate, mchunkptr);
+static void _int_free_remote_drain (mstate);
 static void*  _int_realloc(mstate, mchunkptr, INTERNAL_SIZE_T,
 			   INTERNAL_SIZE_T);
 static void*  _int_memalign(mstate, size_t, size_t);
 #if IS_IN (libc)
 static void*  _mid_memalign(size_t, size_t, void *);
+static void*  _mid_realloc(void *, size_t);
 #endif
 
 static void malloc_printerr(const char *str) __attribute__ ((noreturn));
@@ -1824,6 +1842,11 @@ struct malloc_state
   /* Fastbins */
   mfastbinptr fastbinsY[NFASTBINS];
 
+  /* Chunks freed by threads not attached to this arena.  Pushed
+     without holding MUTEX (see _int_free_remote) and merged by the
+     next thread which acquires it.  Only used if mp_.remote_free.  */
+  mchunkptr remote_free;
+
   /* Base of the topmost chunk -- not otherwise kept in a bin */
   mchunkptr top;
 
@@ -1848,6 +1871,16 @@ struct malloc_state
      free_list_lock in arena.c.  */
   INTERNAL_SIZE_T attached_threads;
 
+  /* NUMA node on which the memory of this arena is placed, or -1.  Set
+     when the arena is created if mp_.numa.  */
+  int numa_node;
+
+  /* State of decay-based purging, see arena_decay.  Only used if
+     mp_.decay_ms.  */
+  unsigned int decay_ticks;
+  uint32_t decay_epoch;
+  uint32_t decay_time;
+
   /* Memory allocated from the system in this arena.  */
   INTERNAL_SIZE_T system_mem;
   INTERNAL_SIZE_T max_system_mem;
@@ -1862,8 +1895,31 @@ struct malloc_par
   INTERNAL_SIZE_T arena_test;
   INTERNAL_SIZE_T arena_max;
 
+  /* Non-zero if arenas are selected and placed by NUMA node.  */
+  int numa;
+
+  /* Age in milliseconds after which the pages of free chunks are
+     returned to the system, or zero to disable decay-based purging.  */
+  size_t decay_ms;
+
+  /* Non-zero if chunks freed by a thread not attached to their arena
+     are queued on the arena's remote_free list instead of taking the
+     arena lock.  */
+  int remote_free;
+
   /* Transparent Large Page support.  */
   INTERNAL_SIZE_T thp_pagesize;
+  /* A value different than 0 means to grow and shrink non-main heaps in
+     extents of heap_thp_pagesize, hinted with MADV_HUGEPAGE.  */
+  INTERNAL_SIZE_T heap_thp_pagesize;
+  /* Average number of bytes allocated between two samples of the heap
+     profiler, or zero to disable sampling.  */
+  size_t sample_interval;
+
+  /* Non-zero if small requests are served by the slab allocator.  */
+  int slab;
+  /* Non-zero if the threads keep the counters of malloc_stats_np.  */
+  int stats;
   /* A value different than 0 means to align mmap allocation to hp_pagesize
      add hp_flags on flags.  */
   INTERNAL_SIZE_T hp_pagesize;
@@ -1894,6 +1950,12 @@ struct malloc_par
   /* Maximum number of chunks to remove from the unsorted list, which
      aren't used to prefill the cache.  */
   size_t tcache_unsorted_limit;
+  /* Number of chunks to move between a bucket and the arena under a
+     single lock acquisition, or zero to move chunks one at a time.  */
+  size_t tcache_batch;
+  /* Maximum number of chunks in each bucket of a per-CPU cache, or
+     zero if the per-CPU caches are disabled.  */
+  size_t percpu_count;
 #endif
 };
 
@@ -1907,7 +1969,8 @@ static struct malloc_state main_arena =
 {
   .mutex = _LIBC_LOCK_INITIALIZER,
   .next = &main_arena,
-  .attached_threads = 1
+  .attached_threads = 1,
+  .numa_node = -1
 };
 
 /* There is only one instance of the malloc parameters.  */
@@ -1969,6 +2032,46 @@ static int      systrim (size_t, mstate);
 static void     malloc_consolidate (mstate);
 
 
+/* Decay-based purging.  Every free chunk which spans at least one whole
+   page records the decay epoch of its arena when it is put on the
+   unsorted list, whether it was freed, merged by malloc_consolidate or
+   split off a larger chunk by _int_malloc, in the word following its
+   malloc_chunk fields.  Once per mp_.decay_ms milliseconds, checked
+   every DECAY_TICKS frees, the arena advances its epoch.  A chunk
+   stamped with epoch E was put on the list at some point during period
+   E, so it has been free for a whole period only once period E + 1 has
+   ended, that is, when the epoch advances to E + 2.  arena_decay then
+   returns its pages to the kernel; a chunk is thus purged after between
+   one and two periods.  Purged chunks are marked with DECAY_CLEAN so
+   that they are skipped by later passes, until they are merged with a
+   newly freed chunk.  */
+
+#define DECAY_TICKS 64
+#define DECAY_CLEAN UINT32_MAX
+
+static __always_inline uint32_t *
+decay_stamp (mchunkptr p)
+{
+  return (uint32_t *) ((char *) p + sizeof (struct malloc_chunk));
+}
+
+/* Return true if a free chunk of SIZE bytes is large enough to hold a
+   decay stamp and at least one whole page after it.  */
+static __always_inline bool
+decay_eligible (INTERNAL_SIZE_T size)
+{
+  return size > GLRO (dl_pagesize) + sizeof (struct malloc_chunk)
+		+ sizeof (uint32_t);
+}
+
+/* Stamp the free chunk P of SIZE bytes of AV with the current epoch.  */
+static __always_inline void
+decay_mark (mstate av, mchunkptr p, INTERNAL_SIZE_T size)
+{
+  if (mp_.decay_ms > 0 && decay_eligible (size))
+    *decay_stamp (p) = av->decay_epoch;
+}
+
 /* -------------- Early definitions for debugging hooks ---------------- */
 
 /* This function is called from the arena shutdown hook, to free the
@@ -2424,6 +2527,9 @@ sysmalloc_mmap (INTERNAL_SIZE_T nb, size_t pagesize, int extra_flags, mstate av)
   if (mm == MAP_FAILED)
     return mm;
 
+  if (av != NULL && av->numa_node >= 0)
+    malloc_bind_node (mm, size, av->numa_node);
+
 #ifdef MAP_HUGETLB
   if (!(extra_flags & MAP_HUGETLB))
     madvise_thp (mm, size);
@@ -2620,7 +2726,8 @@ sysmalloc (INTERNAL_SIZE_T nb, mstate av)
           set_head (old_top, (((char *) old_heap + old_heap->size) - (char *) old_top)
                     | PREV_INUSE);
         }
-      else if ((heap = new_heap (nb + (MINSIZE + sizeof (*heap)), mp_.top_pad)))
+      else if ((heap = new_heap (nb + (MINSIZE + sizeof (*heap)), mp_.top_pad,
+				 av->numa_node)))
         {
           /* Use a newly allocated heap.  */
           heap->ar_ptr = av;
@@ -3110,6 +3217,25 @@ typedef struct tcache_entry
   uintptr_t key;
 } tcache_entry;
 
+/* Statistics of one thread, reported by malloc_stats_np.  The counters
+   are only written by their thread, with relaxed atomic stores, so that
+   they can be read from other threads without stopping them.  They are
+   only allocated, after the tcache, if glibc.malloc.stats is set.  */
+struct tcache_stats
+{
+  size_t arena_locks;
+  size_t arena_lock_waits;
+  struct
+  {
+    size_t hits;
+    size_t misses;
+    size_t frees;
+  } bins[TCACHE_MAX_BINS];
+  /* List of the live threads, protected by stats_lock.  */
+  struct tcache_stats *next;
+  struct tcache_stats *prev;
+};
+
 /* There is one of these for each thread, which contains the
    per-thread cache (hence "tcache_perthread_struct").  Keeping
    overall size low is mildly important.  Note that COUNTS and ENTRIES
@@ -3119,11 +3245,99 @@ typedef struct tcache_perthread_struct
 {
   uint16_t counts[TCACHE_MAX_BINS];
   tcache_entry *entries[TCACHE_MAX_BINS];
+  struct tcache_stats *stats;
 } tcache_perthread_struct;
 
 static __thread bool tcache_shutting_down = false;
 static __thread tcache_perthread_struct *tcache = NULL;
 
+#define tcache_stats_inc(field)					\
+  do								\
+    {								\
+      struct tcache_stats *__s = tcache->stats;			\
+      if (__glibc_unlikely (__s != NULL))			\
+	atomic_store_relaxed (&__s->field, __s->field + 1);	\
+    }								\
+  while (0)
+
+/* Protects stats_list and stats_retired.  */
+__libc_lock_define_initialized (static, stats_lock);
+static struct tcache_stats *stats_list;
+/* Sum of the counters of the threads which have exited.  */
+static struct tcache_stats stats_retired;
+
+/* Add the counters of SRC to DST.  */
+static void
+stats_add (struct tcache_stats *dst, struct tcache_stats *src)
+{
+  dst->arena_locks += atomic_load_relaxed (&src->arena_locks);
+  dst->arena_lock_waits += atomic_load_relaxed (&src->arena_lock_waits);
+  for (size_t i = 0; i < TCACHE_MAX_BINS; ++i)
+    {
+      dst->bins[i].hits += atomic_load_relaxed (&src->bins[i].hits);
+      dst->bins[i].misses += atomic_load_relaxed (&src->bins[i].misses);
+      dst->bins[i].frees += atomic_load_relaxed (&src->bins[i].frees);
+    }
+}
+
+static void
+stats_register (struct tcache_stats *s)
+{
+  __libc_lock_lock (stats_lock);
+  s->prev = NULL;
+  s->next = stats_list;
+  if (stats_list != NULL)
+    stats_list->prev = s;
+  stats_list = s;
+  __libc_lock_unlock (stats_lock);
+}
+
+/* Called at thread exit, before S is freed.  */
+static void
+stats_unregister (struct tcache_stats *s)
+{
+  __libc_lock_lock (stats_lock);
+  stats_add (&stats_retired, s);
+  if (s->prev != NULL)
+    s->prev->next = s->next;
+  else
+    stats_list = s->next;
+  if (s->next != NULL)
+    s->next->prev = s->prev;
+  __libc_lock_unlock (stats_lock);
+}
+
+/* Acquire the lock of AV, counting whether the thread had to wait.
+   All acquisitions of arena locks go through this function, except
+   those of the fork handlers.  */
+static __always_inline void
+arena_mutex_lock (mstate av)
+{
+  if (tcache != NULL && __glibc_unlikely (tcache->stats != NULL))
+    {
+      if (__libc_lock_trylock (av->mutex) != 0)
+	{
+	  tcache_stats_inc (arena_lock_waits);
+	  __libc_lock_lock (av->mutex);
+	}
+      tcache_stats_inc (arena_locks);
+    }
+  else
+    __libc_lock_lock (av->mutex);
+}
+
+/* Try to acquire the lock of AV without waiting, and return true if it
+   was acquired.  */
+static __always_inline bool
+arena_mutex_trylock (mstate av)
+{
+  if (__libc_lock_trylock (av->mutex) != 0)
+    return false;
+  if (tcache != NULL && __glibc_unlikely (tcache->stats != NULL))
+    tcache_stats_inc (arena_locks);
+  return true;
+}
+
 /* Process-wide key to try and catch a double-free in the same thread.  */
 static uintptr_t tcache_key;
 
@@ -3167,6 +3381,32 @@ tcache_put (mchunkptr chunk, size_t tc_idx)
   ++(tcache->counts[tc_idx]);
 }
 
+/* Called when the key of E, a chunk about to be put in bin TC_IDX,
+   matches tcache_key.  This test succeeds on double free.  However, we
+   don't 100% trust it (it also matches random payload data at a 1 in
+   2^<size_t> chance), so verify it's not an unlikely coincidence before
+   aborting.  */
+static __attribute_noinline__ void
+tcache_double_free_verify (tcache_entry *e, size_t tc_idx)
+{
+  tcache_entry *tmp;
+  size_t cnt = 0;
+  LIBC_PROBE (memory_tcache_double_free, 2, e, tc_idx);
+  for (tmp = tcache->entries[tc_idx];
+       tmp;
+       tmp = REVEAL_PTR (tmp->next), ++cnt)
+    {
+      if (cnt >= mp_.tcache_count)
+	malloc_printerr ("free(): too many chunks detected in tcache");
+      if (__glibc_unlikely (!aligned_OK (tmp)))
+	malloc_printerr ("free(): unaligned chunk detected in tcache 2");
+      if (tmp == e)
+	malloc_printerr ("free(): double free detected in tcache 2");
+      /* If we get here, it was a coincidence.  We've wasted a
+	 few cycles, but don't abort.  */
+    }
+}
+
 /* Caller must ensure that we know tc_idx is valid and there's
    available chunks to remove.  Removes chunk from the middle of the
    list.  */
@@ -3206,6 +3446,273 @@ tcache_next (tcache_entry *e)
   return (tcache_entry *) REVEAL_PTR (e->next);
 }
 
+/* Called with the lock of AV held, after an allocation of BYTES found
+   bin TC_IDX empty and was served from AV.  Take further chunks of the
+   same size from AV while the lock is held, so that the next
+   allocations of this size do not need to acquire it again.  */
+static void
+tcache_refill (mstate av, size_t tc_idx, size_t bytes)
+{
+  size_t target = MIN (mp_.tcache_batch, mp_.tcache_count);
+
+  while (tcache->counts[tc_idx] < target)
+    {
+      void *mem = _int_malloc (av, bytes);
+      if (mem == NULL)
+	break;
+
+      mchunkptr p = mem2chunk (mem);
+      if (chunk_is_mmapped (p) || csize2tidx (chunksize (p)) != tc_idx)
+	{
+	  /* A chunk which does not fit the bin, for example one with a
+	     remainder too small to split off.  Give it back and stop.  */
+	  _int_free_chunk (av, p, chunksize (p), 1);
+	  break;
+	}
+      tcache_put (p, tc_idx);
+    }
+}
+
+/* Return the older half of the full bin TC_IDX to the arenas.  The
+   entries are freed in runs which belong to the same arena, so that
+   the arena lock is acquired once per run rather than once per
+   chunk.  */
+static void
+tcache_flush (size_t tc_idx)
+{
+  size_t keep = tcache->counts[tc_idx] / 2;
+  tcache_entry *e = tcache->entries[tc_idx];
+  tcache_entry *last = NULL;
+
+  /* The most recently freed entries are at the head of the list and
+     are the most likely to still be in the CPU cache.  Keep those.  */
+  for (size_t i = 0; i < keep; ++i)
+    {
+      last = e;
+      e = REVEAL_PTR (e->next);
+    }
+  if (last == NULL)
+    tcache->entries[tc_idx] = NULL;
+  else
+    last->next = PROTECT_PTR (&last->next, NULL);
+  tcache->counts[tc_idx] = keep;
+
+  bool need_lock = !SINGLE_THREAD_P;
+  mstate locked = NULL;
+  while (e != NULL)
+    {
+      if (__glibc_unlikely (!aligned_OK (e)))
+	malloc_printerr ("tcache_flush(): unaligned tcache chunk detected");
+      tcache_entry *next = REVEAL_PTR (e->next);
+      mchunkptr p = mem2chunk (e);
+      mstate av = arena_for_chunk (p);
+
+      e->key = 0;
+      if (need_lock && av != locked)
+	{
+	  if (locked != NULL)
+	    __libc_lock_unlock (locked->mutex);
+	  arena_mutex_lock (av);
+	  locked = av;
+	}
+      _int_free_chunk (av, p, chunksize (p), 1);
+      e = next;
+    }
+  if (locked != NULL)
+    __libc_lock_unlock (locked->mutex);
+}
+
+/* Per-CPU caches.  They sit between the tcaches and the arenas and
+   hold chunks of the tcache sizes, selected by the CPU the thread is
+   running on.  With many more threads than CPUs, small tcaches backed
+   by per-CPU caches keep fewer chunks idle than large tcaches, while
+   the lock of a per-CPU cache is rarely contended because it is only
+   taken by threads running on that CPU.  */
+
+typedef struct percpu_cache
+{
+  __libc_lock_define (, lock);
+  uint16_t counts[TCACHE_MAX_BINS];
+  tcache_entry *entries[TCACHE_MAX_BINS];
+} __attribute__ ((aligned (64))) percpu_cache;
+
+/* Array of NCPUS caches, or NULL if disabled.  */
+static percpu_cache *percpu_caches;
+static int percpu_ncpus;
+
+/* Called from ptmalloc_init if glibc.malloc.percpu is set.  */
+static void
+percpu_init (void)
+{
+  int ncpus = __get_nprocs_conf ();
+
+  if (malloc_cpu_id () < 0 || ncpus <= 0)
+    {
+      mp_.percpu_count = 0;
+      return;
+    }
+
+  /* The mapping is zero-filled, which initializes the locks.  */
+  size_t size = ALIGN_UP (ncpus * sizeof (percpu_cache),
+			  GLRO (dl_pagesize));
+  void *p = MMAP (NULL, size, PROT_READ | PROT_WRITE, 0);
+  if (p == MAP_FAILED)
+    {
+      mp_.percpu_count = 0;
+      return;
+    }
+  __set_vma_name (p, size, " glibc: malloc per-cpu");
+
+  percpu_ncpus = ncpus;
+  percpu_caches = p;
+}
+
+/* Return the cache of the CPU the thread is running on, or NULL.  The
+   thread may migrate at any time, so the result is only a hint for
+   which lock to take.  */
+static __always_inline percpu_cache *
+percpu_current (void)
+{
+  if (percpu_caches == NULL)
+    return NULL;
+
+  int cpu = malloc_cpu_id ();
+  if (__glibc_unlikely (cpu < 0 || cpu >= percpu_ncpus))
+    return NULL;
+  return &percpu_caches[cpu];
+}
+
+/* Remove a chunk from bin TC_IDX of the current CPU's cache.  */
+static void *
+percpu_get (size_t tc_idx)
+{
+  percpu_cache *pc = percpu_current ();
+  void *victim = NULL;
+
+  if (pc == NULL || atomic_load_relaxed (&pc->entries[tc_idx]) == NULL)
+    return NULL;
+
+  __libc_lock_lock (pc->lock);
+  tcache_entry *e = pc->entries[tc_idx];
+  if (e != NULL)
+    {
+      if (__glibc_unlikely (!aligned_OK (e)))
+	malloc_printerr ("malloc(): unaligned per-cpu chunk detected");
+      pc->entries[tc_idx] = REVEAL_PTR (e->next);
+      --(pc->counts[tc_idx]);
+      e->key = 0;
+      victim = e;
+    }
+  __libc_lock_unlock (pc->lock);
+
+  return victim;
+}
+
+/* Add chunk P to bin TC_IDX of the current CPU's cache.  Return false
+   if the bin is full.  */
+static bool
+percpu_put (mchunkptr p, size_t tc_idx)
+{
+  percpu_cache *pc = percpu_current ();
+  tcache_entry *e = (tcache_entry *) chunk2mem (p);
+  bool done = false;
+
+  if (pc == NULL)
+    return false;
+
+  __libc_lock_lock (pc->lock);
+  if (pc->counts[tc_idx] < mp_.percpu_count)
+    {
+      if (__glibc_unlikely (pc->entries[tc_idx] == e))
+	malloc_printerr ("double free or corruption (per-cpu)");
+      e->next = PROTECT_PTR (&e->next, pc->entries[tc_idx]);
+      pc->entries[tc_idx] = e;
+      ++(pc->counts[tc_idx]);
+      done = true;
+    }
+  __libc_lock_unlock (pc->lock);
+
+  return done;
+}
+
+/* Return the contents of all per-CPU caches to the arenas.  */
+static void
+percpu_release (void)
+{
+  for (int cpu = 0; cpu < percpu_ncpus; ++cpu)
+    {
+      percpu_cache *pc = &percpu_caches[cpu];
+      for (size_t i = 0; i < TCACHE_MAX_BINS; ++i)
+	{
+	  if (atomic_load_relaxed (&pc->entries[i]) == NULL)
+	    continue;
+
+	  __libc_lock_lock (pc->lock);
+	  tcache_entry *e = pc->entries[i];
+	  pc->entries[i] = NULL;
+	  pc->counts[i] = 0;
+	  __libc_lock_unlock (pc->lock);
+
+	  while (e != NULL)
+	    {
+	      if (__glibc_unlikely (!aligned_OK (e)))
+		malloc_printerr ("malloc_trim(): "
+				 "unaligned per-cpu chunk detected");
+	      tcache_entry *next = REVEAL_PTR (e->next);
+	      mchunkptr p = mem2chunk (e);
+	      _int_free_chunk (arena_for_chunk (p), p, chunksize (p), 0);
+	      e = next;
+	    }
+	}
+    }
+}
+
+/* Fork handling, see __malloc_fork_lock_parent.  */
+static void
+percpu_fork_lock (void)
+{
+  for (int cpu = 0; cpu < percpu_ncpus; ++cpu)
+    __libc_lock_lock (percpu_caches[cpu].lock);
+}
+
+static void
+percpu_fork_unlock (bool child)
+{
+  for (int cpu = 0; cpu < percpu_ncpus; ++cpu)
+    if (child)
+      __libc_lock_init (percpu_caches[cpu].lock);
+    else
+      __libc_lock_unlock (percpu_caches[cpu].lock);
+}
+
+static void
+stats_fork_lock (void)
+{
+  __libc_lock_lock (stats_lock);
+}
+
+static void
+stats_fork_unlock (bool child)
+{
+  if (!child)
+    {
+      __libc_lock_unlock (stats_lock);
+      return;
+    }
+
+  /* Only the current thread survives in the child.  */
+  __libc_lock_init (stats_lock);
+  for (struct tcache_stats *s = stats_list; s != NULL; s = s->next)
+    if (tcache == NULL || s != tcache->stats)
+      stats_add (&stats_retired, s);
+  stats_list = NULL;
+  if (tcache != NULL && tcache->stats != NULL)
+    {
+      tcache->stats->prev = tcache->stats->next = NULL;
+      stats_list = tcache->stats;
+    }
+}
+
 static void
 tcache_thread_shutdown (void)
 {
@@ -3220,6 +3727,9 @@ tcache_thread_shutdown (void)
   /* Disable the tcache and prevent it from being reinitialized.  */
   tcache = NULL;
 
+  if (tcache_tmp->stats != NULL)
+    stats_unregister (tcache_tmp->stats);
+
   /* Free all of the entries and the tcache itself back to the arena
      heap for coalescing.  */
   for (i = 0; i < TCACHE_MAX_BINS; ++i)
@@ -3243,7 +3753,8 @@ tcache_init(void)
 {
   mstate ar_ptr;
   void *victim = 0;
-  const size_t bytes = sizeof (tcache_perthread_struct);
+  const size_t bytes = (sizeof (tcache_perthread_struct)
+			+ (mp_.stats ? sizeof (struct tcache_stats) : 0));
 
   if (tcache_shutting_down)
     return;
@@ -3268,7 +3779,12 @@ tcache_init(void)
   if (victim)
     {
       tcache = (tcache_perthread_struct *) victim;
-      memset (tcache, 0, sizeof (tcache_perthread_struct));
+      memset (tcache, 0, bytes);
+      if (mp_.stats)
+	{
+	  tcache->stats = (struct tcache_stats *) (tcache + 1);
+	  stats_register (tcache->stats);
+	}
     }
 
 }
@@ -3280,6 +3796,18 @@ tcache_init(void)
 #else  /* !USE_TCACHE */
 # define MAYBE_INIT_TCACHE()
 
+static __always_inline void
+arena_mutex_lock (mstate av)
+{
+  __libc_lock_lock (av->mutex);
+}
+
+static __always_inline bool
+arena_mutex_trylock (mstate av)
+{
+  return __libc_lock_trylock (av->mutex) == 0;
+}
+
 static void
 tcache_thread_shutdown (void)
 {
@@ -3289,6 +3817,9 @@ tcache_thread_shutdown (void)
 #endif /* !USE_TCACHE  */
 
 #if IS_IN (libc)
+#include "sample.c"
+#include "slab.c"
+
 void *
 __libc_malloc (size_t bytes)
 {
@@ -3298,8 +3829,18 @@ __libc_malloc (size_t bytes)
   _Static_assert (PTRDIFF_MAX <= SIZE_MAX / 2,
                   "PTRDIFF_MAX is not more than half of SIZE_MAX");
 
+  if (sample_due (bytes))
+    return sample_malloc (bytes, RETURN_ADDRESS (0));
+
   if (!__malloc_initialized)
     ptmalloc_init ();
+
+  if (mp_.slab && bytes <= SLAB_MAX_SIZE)
+    {
+      victim = slab_malloc (bytes);
+      if (victim != NULL)
+	return victim;
+    }
 #if USE_TCACHE
   /* int_free also calls request2size, be careful to not pad twice.  */
   size_t tbytes = checked_request2size (bytes);
@@ -3314,13 +3855,24 @@ __libc_malloc (size_t bytes)
 
   DIAG_PUSH_NEEDS_COMMENT;
   if (tc_idx < mp_.tcache_bins
-      && tcache != NULL
-      && tcache->counts[tc_idx] > 0)
+      && tcache != NULL)
     {
-      victim = tcache_get (tc_idx);
-      return tag_new_usable (victim);
+      if (tcache->counts[tc_idx] > 0)
+	{
+	  tcache_stats_inc (bins[tc_idx].hits);
+	  victim = tcache_get (tc_idx);
+	  return tag_new_usable (victim);
+	}
+      tcache_stats_inc (bins[tc_idx].misses);
     }
   DIAG_POP_NEEDS_COMMENT;
+
+  if (mp_.percpu_count > 0 && tc_idx < mp_.tcache_bins)
+    {
+      victim = percpu_get (tc_idx);
+      if (victim != NULL)
+	return tag_new_usable (victim);
+    }
 #endif
 
   if (SINGLE_THREAD_P)
@@ -3343,6 +3895,13 @@ __libc_malloc (size_t bytes)
       victim = _int_malloc (ar_ptr, bytes);
     }
 
+#if USE_TCACHE
+  /* The bin was empty.  Fill it while we hold the arena lock.  */
+  if (victim != NULL && ar_ptr != NULL && mp_.tcache_batch > 0
+      && tc_idx < mp_.tcache_bins && tcache != NULL)
+    tcache_refill (ar_ptr, tc_idx, bytes);
+#endif
+
   if (ar_ptr != NULL)
     __libc_lock_unlock (ar_ptr->mutex);
 
@@ -3363,6 +3922,14 @@ __libc_free (void *mem)
   if (mem == 0)                              /* free(0) has no effect */
     return;
 
+  sample_free (mem);
+
+  if (slab_contains (mem))
+    {
+      slab_free (mem);
+      return;
+    }
+
   /* Quickly check that the freed pointer matches the tag for the memory.
      This gives a useful double-free detection.  */
   if (__glibc_unlikely (mtag_enabled))
@@ -3402,12 +3969,69 @@ __libc_free (void *mem)
 }
 libc_hidden_def (__libc_free)
 
+/* Free MEM, which the caller guarantees was allocated with a request
+   of BYTES bytes.  If the request maps to a tcache bin with room, and
+   the chunk belongs to the same bin, the chunk is cached without the
+   checks of _int_free.  A chunk smaller than the request means a wrong
+   size argument and is diagnosed.  */
+static __always_inline void
+free_sized_common (void *mem, size_t bytes)
+{
+#if USE_TCACHE
+  size_t nb = checked_request2size (bytes);
+  size_t tc_idx = csize2tidx (nb);
+  mchunkptr p = mem2chunk (mem);
+
+  /* The header still has to be read to rule out chunks that sysmalloc
+     served with mmap because the arena could not grow.  */
+  if (mem != NULL && tcache != NULL && nb != 0 && !mtag_enabled
+      && !slab_contains (mem)
+      && !misaligned_chunk (p)
+      && !chunk_is_mmapped (p))
+    {
+      size_t size = chunksize (p);
+      if (__glibc_unlikely (size < nb))
+	malloc_printerr ("free_sized(): invalid size");
+      /* The chunk may legitimately be larger than requested, by less
+	 than MINSIZE if the remainder was too small to split off, or
+	 more after memalign, so its bin can differ from the one for
+	 BYTES.  Let free handle it then.  */
+      if (tc_idx < mp_.tcache_bins
+	  && __glibc_likely (csize2tidx (size) == tc_idx)
+	  && tcache->counts[tc_idx] < mp_.tcache_count)
+	{
+	  tcache_entry *e = (tcache_entry *) mem;
+	  if (__glibc_unlikely (e->key == tcache_key))
+	    tcache_double_free_verify (e, tc_idx);
+	  sample_free (mem);
+	  tcache_put (p, tc_idx);
+	  tcache_stats_inc (bins[tc_idx].frees);
+	  return;
+	}
+    }
+#endif
+
+  __libc_free (mem);
+}
+
+void
+__libc_free_sized (void *mem, size_t bytes)
+{
+  free_sized_common (mem, bytes);
+}
+
+void
+__libc_free_aligned_sized (void *mem, size_t alignment, size_t bytes)
+{
+  /* _int_memalign gives back the space before and after the aligned
+     chunk, so the chunk usually belongs to the bin for BYTES and takes
+     the fast path of free_sized.  */
+  free_sized_common (mem, bytes);
+}
+
 void *
 __libc_realloc (void *oldmem, size_t bytes)
 {
-  mstate ar_ptr;
-  INTERNAL_SIZE_T nb;         /* padded request size */
-
   void *newp;             /* chunk to return */
 
   if (!__malloc_initialized)
@@ -3424,6 +4048,50 @@ __libc_realloc (void *oldmem, size_t bytes)
   if (oldmem == 0)
     return __libc_malloc (bytes);
 
+  /* The heap profiler accounts for the growth of the block.  */
+  size_t oldusable = 0;
+  if (sample_enabled)
+    oldusable = (slab_contains (oldmem) ? slab_usable_size (oldmem)
+		 : musable (oldmem));
+
+  newp = _mid_realloc (oldmem, bytes);
+
+  if (newp != NULL && sample_enabled)
+    {
+      size_t grown = bytes;
+      if (newp == oldmem)
+	grown = bytes > oldusable ? bytes - oldusable : 0;
+      sample_realloc (newp, grown, bytes, RETURN_ADDRESS (0));
+    }
+  return newp;
+}
+libc_hidden_def (__libc_realloc)
+
+/* Reallocate OLDMEM, which is not NULL, to BYTES bytes.  The old block
+   is removed from the heap profile when it is released.  */
+static void *
+_mid_realloc (void *oldmem, size_t bytes)
+{
+  mstate ar_ptr;
+  INTERNAL_SIZE_T nb;         /* padded request size */
+
+  void *newp;             /* chunk to return */
+
+  if (slab_contains (oldmem))
+    {
+      size_t usable = slab_usable_size (oldmem);
+      if (bytes <= usable && bytes > usable / 2)
+	return oldmem;
+      newp = malloc_unsampled (bytes);
+      if (newp != NULL)
+	{
+	  memcpy (newp, oldmem, MIN (bytes, usable));
+	  sample_free (oldmem);
+	  slab_free (oldmem);
+	}
+      return newp;
+    }
+
   /* Perform a quick check to ensure that the pointer's tag matches the
      memory's tag.  */
   if (__glibc_unlikely (mtag_enabled))
@@ -3481,6 +4149,11 @@ __libc_realloc (void *oldmem, size_t bytes)
       if (newp)
 	{
 	  void *newmem = chunk2mem_tag (newp);
+	  /* The kernel has released the old mapping if it moved, so
+	     another thread may have sampled a new block at the same
+	     address in the meantime, and lose its record.  */
+	  if (newmem != oldmem)
+	    sample_free (oldmem);
 	  /* Give the new block a different tag.  This helps to ensure
 	     that stale handles to the previous mapping are not
 	     reused.  There's a performance hit for both us and the
@@ -3494,11 +4167,12 @@ __libc_realloc (void *oldmem, size_t bytes)
         return oldmem;                         /* do nothing */
 
       /* Must alloc, copy, free. */
-      newmem = __libc_malloc (bytes);
+      newmem = malloc_unsampled (bytes);
       if (newmem == 0)
         return 0;              /* propagate failure */
 
       memcpy (newmem, oldmem, oldsize - CHUNK_HDR_SZ);
+      sample_free (oldmem);
       munmap_chunk (oldp);
       return newmem;
     }
@@ -3508,13 +4182,19 @@ __libc_realloc (void *oldmem, size_t bytes)
       newp = _int_realloc (ar_ptr, oldp, oldsize, nb);
       assert (!newp || chunk_is_mmapped (mem2chunk (newp)) ||
 	      ar_ptr == arena_for_chunk (mem2chunk (newp)));
+      if (newp != NULL && newp != oldmem)
+	sample_free (oldmem);
 
       return newp;
     }
 
-  __libc_lock_lock (ar_ptr->mutex);
+  arena_mutex_lock (ar_ptr);
 
   newp = _int_realloc (ar_ptr, oldp, oldsize, nb);
+  /* If the block moved, the old chunk is in the arena, where no other
+     thread can reuse it before we unlock.  */
+  if (newp != NULL && newp != oldmem)
+    sample_free (oldmem);
 
   __libc_lock_unlock (ar_ptr->mutex);
   assert (!newp || chunk_is_mmapped (mem2chunk (newp)) ||
@@ -3524,19 +4204,19 @@ __libc_realloc (void *oldmem, size_t bytes)
     {
       /* Try harder to allocate memory in other arenas.  */
       LIBC_PROBE (memory_realloc_retry, 2, bytes, oldmem);
-      newp = __libc_malloc (bytes);
+      newp = malloc_unsampled (bytes);
       if (newp != NULL)
         {
 	  size_t sz = memsize (oldp);
 	  memcpy (newp, oldmem, sz);
 	  (void) tag_region (chunk2mem (oldp), sz);
+	  sample_free (oldmem);
           _int_free (ar_ptr, oldp, 0);
         }
     }
 
   return newp;
 }
-libc_hidden_def (__libc_realloc)
 
 void *
 __libc_memalign (size_t alignment, size_t bytes)
@@ -3577,9 +4257,12 @@ _mid_memalign (size_t alignment, size_t bytes, void *address)
   mstate ar_ptr;
   void *p;
 
+  if (sample_due (bytes))
+    return sample_memalign (alignment, bytes, address);
+
   /* If we need less alignment than we give anyway, just relay to malloc.  */
   if (alignment <= MALLOC_ALIGNMENT)
-    return __libc_malloc (bytes);
+    return malloc_unsampled (bytes);
 
   /* Otherwise, ensure that it is at least a minimum chunk size */
   if (alignment < MINSIZE)
@@ -3714,6 +4397,9 @@ __libc_calloc (size_t n, size_t elem_size)
 
   sz = bytes;
 
+  if (sample_due (sz))
+    return sample_calloc (n, elem_size, RETURN_ADDRESS (0));
+
   if (!__malloc_initialized)
     ptmalloc_init ();
 
@@ -3892,6 +4578,11 @@ _int_malloc (mstate av, size_t bytes)
       return p;
     }
 
+  /* Merge chunks which other threads freed into this arena while we
+     did not hold the lock, so that they can satisfy this request.  */
+  if (__glibc_unlikely (atomic_load_relaxed (&av->remote_free) != NULL))
+    _int_free_remote_drain (av);
+
   /*
      If the size qualifies as a fastbin, first check corresponding bin.
      This code is safe to execute even if av is not yet initialized, so we
@@ -4116,6 +4807,7 @@ _int_malloc (mstate av, size_t bytes)
                         (av != &main_arena ? NON_MAIN_ARENA : 0));
               set_head (remainder, remainder_size | PREV_INUSE);
               set_foot (remainder, remainder_size);
+              decay_mark (av, remainder, remainder_size);
 
               check_malloced_chunk (av, victim, nb);
               void *p = chunk2mem (victim);
@@ -4308,6 +5000,7 @@ _int_malloc (mstate av, size_t bytes)
                             (av != &main_arena ? NON_MAIN_ARENA : 0));
                   set_head (remainder, remainder_size | PREV_INUSE);
                   set_foot (remainder, remainder_size);
+                  decay_mark (av, remainder, remainder_size);
                 }
               check_malloced_chunk (av, victim, nb);
               void *p = chunk2mem (victim);
@@ -4416,6 +5109,7 @@ _int_malloc (mstate av, size_t bytes)
                             (av != &main_arena ? NON_MAIN_ARENA : 0));
                   set_head (remainder, remainder_size | PREV_INUSE);
                   set_foot (remainder, remainder_size);
+                  decay_mark (av, remainder, remainder_size);
                 }
               check_malloced_chunk (av, victim, nb);
               void *p = chunk2mem (victim);
@@ -4494,7 +5188,6 @@ static void
 _int_free (mstate av, mchunkptr p, int have_lock)
 {
   INTERNAL_SIZE_T size;        /* its size */
-  mfastbinptr *fb;             /* associated fastbin */
 
   size = chunksize (p);
 
@@ -4519,40 +5212,43 @@ _int_free (mstate av, mchunkptr p, int have_lock)
       {
 	/* Check to see if it's already in the tcache.  */
 	tcache_entry *e = (tcache_entry *) chunk2mem (p);
-
-	/* This test succeeds on double free.  However, we don't 100%
-	   trust it (it also matches random payload data at a 1 in
-	   2^<size_t> chance), so verify it's not an unlikely
-	   coincidence before aborting.  */
 	if (__glibc_unlikely (e->key == tcache_key))
+	  tcache_double_free_verify (e, tc_idx);
+
+	if (tcache->counts[tc_idx] < mp_.tcache_count)
 	  {
-	    tcache_entry *tmp;
-	    size_t cnt = 0;
-	    LIBC_PROBE (memory_tcache_double_free, 2, e, tc_idx);
-	    for (tmp = tcache->entries[tc_idx];
-		 tmp;
-		 tmp = REVEAL_PTR (tmp->next), ++cnt)
-	      {
-		if (cnt >= mp_.tcache_count)
-		  malloc_printerr ("free(): too many chunks detected in tcache");
-		if (__glibc_unlikely (!aligned_OK (tmp)))
-		  malloc_printerr ("free(): unaligned chunk detected in tcache 2");
-		if (tmp == e)
-		  malloc_printerr ("free(): double free detected in tcache 2");
-		/* If we get here, it was a coincidence.  We've wasted a
-		   few cycles, but don't abort.  */
-	      }
+	    tcache_put (p, tc_idx);
+	    tcache_stats_inc (bins[tc_idx].frees);
+	    return;
 	  }
 
-	if (tcache->counts[tc_idx] < mp_.tcache_count)
+	if (mp_.percpu_count > 0 && percpu_put (p, tc_idx))
+	  return;
+
+	/* The bin is full.  Rather than sending this and every further
+	   chunk of this size to the arena one at a time, return the
+	   older half of the bin in one go and cache P instead.  */
+	if (mp_.tcache_batch > 0 && !have_lock && mp_.tcache_count > 0)
 	  {
+	    tcache_flush (tc_idx);
 	    tcache_put (p, tc_idx);
+	    tcache_stats_inc (bins[tc_idx].frees);
 	    return;
 	  }
       }
   }
 #endif
 
+  _int_free_chunk (av, p, size, have_lock);
+}
+
+/* Free chunk P of SIZE bytes, which belongs to arena AV, bypassing the
+   tcache.  If HAVE_LOCK, the caller holds the lock of AV.  */
+static void
+_int_free_chunk (mstate av, mchunkptr p, INTERNAL_SIZE_T size, int have_lock)
+{
+  mfastbinptr *fb;             /* associated fastbin */
+
   /*
     If eligible, place chunk on a fastbin so it can be found
     and used quickly in malloc.
@@ -4580,7 +5276,7 @@ _int_free (mstate av, mchunkptr p, int have_lock)
 	   getting the lock.  */
 	if (!have_lock)
 	  {
-	    __libc_lock_lock (av->mutex);
+	    arena_mutex_lock (av);
 	    fail = (chunksize_nomask (chunk_at_offset (p, size)) <= CHUNK_HDR_SZ
 		    || chunksize (chunk_at_offset (p, size)) >= av->system_mem);
 	    __libc_lock_unlock (av->mutex);
@@ -4640,8 +5336,16 @@ _int_free (mstate av, mchunkptr p, int have_lock)
     if (SINGLE_THREAD_P)
       have_lock = true;
 
+    /* If the chunk belongs to an arena other than ours, hand it to
+       the owner instead of contending for its lock.  */
+    if (!have_lock && mp_.remote_free && av != thread_arena)
+      {
+	_int_free_remote (av, p);
+	return;
+      }
+
     if (!have_lock)
-      __libc_lock_lock (av->mutex);
+      arena_mutex_lock (av);
 
     _int_free_merge_chunk (av, p, size);
 
@@ -4657,6 +5361,68 @@ _int_free (mstate av, mchunkptr p, int have_lock)
   }
 }
 
+static uint32_t
+decay_now (void)
+{
+  struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+  __clock_gettime (CLOCK_MONOTONIC_COARSE, &ts);
+#else
+  __clock_gettime (CLOCK_MONOTONIC, &ts);
+#endif
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Purge the chunks of AV which have been free for at least one whole
+   decay period.  AV must be locked.  */
+static void
+arena_decay (mstate av)
+{
+  const size_t ps = GLRO (dl_pagesize);
+  const size_t psm1 = ps - 1;
+  int psindex = bin_index (ps);
+  uint32_t epoch = ++av->decay_epoch;
+
+  for (int i = 1; i < NBINS; ++i)
+    if (i == 1 || i >= psindex)
+      {
+	mbinptr bin = bin_at (av, i);
+
+	for (mchunkptr p = last (bin); p != bin; p = p->bk)
+	  {
+	    INTERNAL_SIZE_T size = chunksize (p);
+	    if (!decay_eligible (size))
+	      continue;
+
+	    uint32_t *stamp = decay_stamp (p);
+	    /* See above for why this is two epochs.  */
+	    if (*stamp == DECAY_CLEAN || epoch - *stamp < 2)
+	      continue;
+
+	    char *paligned_mem = PTR_ALIGN_UP ((char *) (stamp + 1), ps);
+	    size -= paligned_mem - (char *) p;
+	    if (size > psm1)
+	      __madvise (paligned_mem, size & ~psm1, MADV_DONTNEED);
+	    *stamp = DECAY_CLEAN;
+	  }
+      }
+}
+
+/* Called with AV locked after each chunk is freed into it.  */
+static void
+arena_decay_tick (mstate av)
+{
+  if (++av->decay_ticks < DECAY_TICKS)
+    return;
+  av->decay_ticks = 0;
+
+  uint32_t now = decay_now ();
+  if (now - av->decay_time < mp_.decay_ms)
+    return;
+  av->decay_time = now;
+  arena_decay (av);
+}
+
 /* Try to merge chunk P of SIZE bytes with its neighbors.  Put the
    resulting chunk on the appropriate bin list.  P must not be on a
    bin list yet, and it can be in use.  */
@@ -4746,6 +5512,8 @@ _int_free_create_chunk (mstate av, mchunkptr p, INTERNAL_SIZE_T size,
       set_head(p, size | PREV_INUSE);
       set_foot(p, size);
 
+      decay_mark (av, p, size);
+
       check_free_chunk(av, p);
     }
 
@@ -4795,6 +5563,53 @@ _int_free_maybe_consolidate (mstate av, INTERNAL_SIZE_T size)
 	  heap_trim (heap, mp_.top_pad);
 	}
     }
+
+  if (mp_.decay_ms > 0)
+    arena_decay_tick (av);
+}
+
+/* Push chunk P onto the remote free list of arena AV.  This does not
+   require the arena lock: the list is a lock-free stack with any
+   number of producers and a single consumer, the thread holding the
+   arena lock, which removes all entries at once in
+   _int_free_remote_drain.  The chunk stays marked as in use until it
+   is merged.  */
+static void
+_int_free_remote (mstate av, mchunkptr p)
+{
+  mchunkptr old = atomic_load_relaxed (&av->remote_free), old2;
+
+  do
+    {
+      /* Check that the top of the list is not the record we are going
+	 to add (i.e., double free).  */
+      if (__glibc_unlikely (old == p))
+	malloc_printerr ("double free or corruption (remote)");
+      old2 = old;
+      p->fd = PROTECT_PTR (&p->fd, old);
+    }
+  while ((old = catomic_compare_and_exchange_val_rel (&av->remote_free,
+						      p, old2))
+	 != old2);
+}
+
+/* Merge all chunks on the remote free list of arena AV into its bins.
+   The caller must hold the arena lock.  */
+static void
+_int_free_remote_drain (mstate av)
+{
+  mchunkptr p = atomic_exchange_acquire (&av->remote_free, NULL);
+
+  while (p != NULL)
+    {
+      if (__glibc_unlikely (misaligned_chunk (p)))
+	malloc_printerr ("_int_free_remote_drain(): "
+			 "unaligned remote chunk detected");
+      check_inuse_chunk (av, p);
+      mchunkptr nextp = REVEAL_PTR (p->fd);
+      _int_free_merge_chunk (av, p, chunksize (p));
+      p = nextp;
+    }
 }
 
 /*
@@ -4825,6 +5640,11 @@ static void malloc_consolidate(mstate av)
 
   atomic_store_relaxed (&av->have_fastchunks, false);
 
+  /* Chunks on the remote free list are not yet in any bin, so merge
+     them first to give them the same chance of consolidation.  */
+  if (atomic_load_relaxed (&av->remote_free) != NULL)
+    _int_free_remote_drain (av);
+
   unsorted_bin = unsorted_chunks(av);
 
   /*
@@ -4890,6 +5710,7 @@ static void malloc_consolidate(mstate av)
 	  p->bk = unsorted_bin;
 	  p->fd = first_unsorted;
 	  set_foot(p, size);
+	  decay_mark (av, p, size);
 	}
 
 	else {
@@ -5211,10 +6032,17 @@ __malloc_trim (size_t s)
   if (!__malloc_initialized)
     ptmalloc_init ();
 
+#if USE_TCACHE
+  /* Chunks in the per-CPU caches are in use as far as the arenas are
+     concerned, and would prevent them from being trimmed.  */
+  if (mp_.percpu_count > 0)
+    percpu_release ();
+#endif
+
   mstate ar_ptr = &main_arena;
   do
     {
-      __libc_lock_lock (ar_ptr->mutex);
+      arena_mutex_lock (ar_ptr);
       result |= mtrim (ar_ptr, s);
       __libc_lock_unlock (ar_ptr->mutex);
 
@@ -5249,6 +6077,8 @@ __malloc_usable_size (void *m)
 {
   if (m == NULL)
     return 0;
+  if (slab_contains (m))
+    return slab_usable_size (m);
   return musable (m);
 }
 #endif
@@ -5334,7 +6164,7 @@ __libc_mallinfo2 (void)
   ar_ptr = &main_arena;
   do
     {
-      __libc_lock_lock (ar_ptr->mutex);
+      arena_mutex_lock (ar_ptr);
       int_mallinfo (ar_ptr, &m);
       __libc_lock_unlock (ar_ptr->mutex);
 
@@ -5388,7 +6218,7 @@ __malloc_stats (void)
       struct mallinfo2 mi;
 
       memset (&mi, 0, sizeof (mi));
-      __libc_lock_lock (ar_ptr->mutex);
+      arena_mutex_lock (ar_ptr);
       int_mallinfo (ar_ptr, &mi);
       fprintf (stderr, "Arena %d:\n", i);
       fprintf (stderr, "system bytes     = %10u\n", (unsigned int) mi.arena);
@@ -5521,6 +6351,30 @@ do_set_tcache_unsorted_limit (size_t value)
   mp_.tcache_unsorted_limit = value;
   return 1;
 }
+
+static __always_inline int
+do_set_tcache_batch (size_t value)
+{
+  if (value <= MAX_TCACHE_COUNT)
+    {
+      LIBC_PROBE (memory_tunable_tcache_batch, 2, value, mp_.tcache_batch);
+      mp_.tcache_batch = value;
+      return 1;
+    }
+  return 0;
+}
+
+static __always_inline int
+do_set_percpu_count (size_t value)
+{
+  if (value <= MAX_TCACHE_COUNT)
+    {
+      LIBC_PROBE (memory_tunable_percpu_count, 2, value, mp_.percpu_count);
+      mp_.percpu_count = value;
+      return 1;
+    }
+  return 0;
+}
 #endif
 
 static __always_inline int
@@ -5535,6 +6389,74 @@ do_set_mxfast (size_t value)
   return 0;
 }
 
+static __always_inline int
+do_set_remote_free (int32_t value)
+{
+  mp_.remote_free = value;
+  return 1;
+}
+
+static __always_inline int
+do_set_numa (int32_t value)
+{
+  mp_.numa = value;
+  return 1;
+}
+
+static __always_inline int
+do_set_decay_ms (size_t value)
+{
+  LIBC_PROBE (memory_tunable_decay_ms, 2, value, mp_.decay_ms);
+  mp_.decay_ms = value;
+  return 1;
+}
+
+static __always_inline int
+do_set_heap_thp (int32_t value)
+{
+  mp_.heap_thp_pagesize = 0;
+  if (value != 0)
+    {
+      enum malloc_thp_mode_t thp_mode = __malloc_thp_mode ();
+      /* Heaps are aligned to their maximum size, so the extents are only
+	 aligned to the huge page size if it divides the maximum.  */
+      if (thp_mode == malloc_thp_mode_madvise
+	  || thp_mode == malloc_thp_mode_always)
+	{
+	  size_t thp_pagesize = __malloc_default_thp_pagesize ();
+	  if (powerof2 (thp_pagesize) && thp_pagesize > GLRO (dl_pagesize)
+	      && thp_pagesize <= HEAP_MAX_SIZE)
+	    mp_.heap_thp_pagesize = thp_pagesize;
+	}
+    }
+  return 1;
+}
+
+static __always_inline int
+do_set_sample_interval (size_t value)
+{
+  LIBC_PROBE (memory_tunable_sample_interval, 2, value,
+	      mp_.sample_interval);
+  mp_.sample_interval = value;
+  return 1;
+}
+
+static __always_inline int
+do_set_slab (int32_t value)
+{
+  LIBC_PROBE (memory_tunable_slab, 2, value, mp_.slab);
+  mp_.slab = value;
+  return 1;
+}
+
+static __always_inline int
+do_set_stats (int32_t value)
+{
+  LIBC_PROBE (memory_tunable_stats, 2, value, mp_.stats);
+  mp_.stats = value;
+  return 1;
+}
+
 static __always_inline int
 do_set_hugetlb (size_t value)
 {
@@ -5562,7 +6484,7 @@ __libc_mallopt (int param_number, int value)
 
   if (!__malloc_initialized)
     ptmalloc_init ();
-  __libc_lock_lock (av->mutex);
+  arena_mutex_lock (av);
 
   LIBC_PROBE (memory_mallopt, 2, param_number, value);
 
@@ -5825,6 +6747,7 @@ __malloc_info (int options, FILE *fp)
   size_t total_max_system = 0;
   size_t total_aspace = 0;
   size_t total_aspace_mprotect = 0;
+  size_t total_aspace_thp = 0;
 
 
 
@@ -5852,7 +6775,7 @@ __malloc_info (int options, FILE *fp)
       } sizes[NFASTBINS + NBINS - 1];
 #define nsizes (sizeof (sizes) / sizeof (sizes[0]))
 
-      __libc_lock_lock (ar_ptr->mutex);
+      arena_mutex_lock (ar_ptr);
 
       /* Account for top chunk.  The top-most available chunk is
 	 treated specially and is never in any bin. See "initial_top"
@@ -5924,6 +6847,7 @@ __malloc_info (int options, FILE *fp)
       size_t heap_size = 0;
       size_t heap_mprotect_size = 0;
       size_t heap_count = 0;
+      size_t heap_thp_size = 0;
       if (ar_ptr != &main_arena)
 	{
 	  /* Iterate over the arena heaps from back to front.  */
@@ -5932,6 +6856,10 @@ __malloc_info (int options, FILE *fp)
 	    {
 	      heap_size += heap->size;
 	      heap_mprotect_size += heap->mprotect_size;
+	      /* This reads the memory map of the process once per heap,
+		 so only do it if the heaps are set up for huge pages.  */
+	      if (mp_.heap_thp_pagesize != 0)
+		heap_thp_size += __malloc_thp_usage (heap, heap_max_size ());
 	      heap = heap->prev;
 	      ++heap_count;
 	    }
@@ -5976,8 +6904,12 @@ __malloc_info (int options, FILE *fp)
 		   "<aspace type=\"mprotect\" size=\"%zu\"/>\n"
 		   "<aspace type=\"subheaps\" size=\"%zu\"/>\n",
 		   heap_size, heap_mprotect_size, heap_count);
+	  if (mp_.heap_thp_pagesize != 0)
+	    fprintf (fp, "<aspace type=\"thp\" size=\"%zu\"/>\n",
+		     heap_thp_size);
 	  total_aspace += heap_size;
 	  total_aspace_mprotect += heap_mprotect_size;
+	  total_aspace_thp += heap_thp_size;
 	}
       else
 	{
@@ -6001,20 +6933,76 @@ __malloc_info (int options, FILE *fp)
 	   "<system type=\"current\" size=\"%zu\"/>\n"
 	   "<system type=\"max\" size=\"%zu\"/>\n"
 	   "<aspace type=\"total\" size=\"%zu\"/>\n"
-	   "<aspace type=\"mprotect\" size=\"%zu\"/>\n"
-	   "</malloc>\n",
+	   "<aspace type=\"mprotect\" size=\"%zu\"/>\n",
 	   total_nfastblocks, total_fastavail, total_nblocks, total_avail,
 	   mp_.n_mmaps, mp_.mmapped_mem,
 	   total_system, total_max_system,
 	   total_aspace, total_aspace_mprotect);
+  if (mp_.heap_thp_pagesize != 0)
+    fprintf (fp, "<aspace type=\"thp\" size=\"%zu\"/>\n", total_aspace_thp);
+#if IS_IN (libc)
+  if (mp_.slab)
+    {
+      size_t slab_nfree = 0, slab_free_bytes = 0, slab_run_bytes = 0;
+      slab_info (&slab_nfree, &slab_free_bytes, &slab_run_bytes);
+      fprintf (fp,
+	       "<total type=\"slab\" count=\"%zu\" size=\"%zu\"/>\n"
+	       "<aspace type=\"slab\" size=\"%zu\"/>\n",
+	       slab_nfree, slab_free_bytes, slab_run_bytes);
+    }
+#endif
+  fputs ("</malloc>\n", fp);
 
   return 0;
 }
 #if IS_IN (libc)
 weak_alias (__malloc_info, malloc_info)
 
+/* Unlike mallinfo2 and malloc_info, this does not walk the arenas, so
+   it can be called often.  The counters of the threads are read while
+   they run, under stats_lock, which only threads starting or exiting
+   contend for.  */
+int
+__malloc_stats_np (struct malloc_stats_np *stats, size_t size)
+{
+  struct malloc_stats_np result = { 0, };
+
+  _Static_assert (MALLOC_STATS_NP_BINS == TCACHE_MAX_BINS,
+		  "MALLOC_STATS_NP_BINS matches TCACHE_MAX_BINS");
+  struct tcache_stats sum = { 0, };
+  __libc_lock_lock (stats_lock);
+  stats_add (&sum, &stats_retired);
+  for (struct tcache_stats *s = stats_list; s != NULL; s = s->next)
+    {
+      stats_add (&sum, s);
+      ++result.threads;
+    }
+  __libc_lock_unlock (stats_lock);
+
+  result.arena_locks = sum.arena_locks;
+  result.arena_lock_waits = sum.arena_lock_waits;
+  result.nbins = mp_.tcache_bins;
+  for (size_t i = 0; i < MALLOC_STATS_NP_BINS; ++i)
+    {
+      result.bins[i].size = tidx2usize (i);
+      result.bins[i].hits = sum.bins[i].hits;
+      result.bins[i].misses = sum.bins[i].misses;
+      result.bins[i].frees = sum.bins[i].frees;
+    }
+
+  result.mmap_chunks = atomic_load_relaxed (&mp_.n_mmaps);
+  result.mmap_chunks_max = atomic_load_relaxed (&mp_.max_n_mmaps);
+  result.mmap_bytes = atomic_load_relaxed (&mp_.mmapped_mem);
+
+  memcpy (stats, &result, MIN (size, sizeof (result)));
+  return 0;
+}
+weak_alias (__malloc_stats_np, malloc_stats_np)
+
 strong_alias (__libc_calloc, __calloc) weak_alias (__libc_calloc, calloc)
 strong_alias (__libc_free, __free) strong_alias (__libc_free, free)
+strong_alias (__libc_free_sized, free_sized)
+strong_alias (__libc_free_aligned_sized, free_aligned_sized)
 strong_alias (__libc_malloc, __malloc) strong_alias (__libc_malloc, malloc)
 strong_alias (__libc_memalign, __memalign)
 weak_alias (__libc_memalign, memalign)
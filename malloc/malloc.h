@@ -157,5 +157,40 @@ extern void malloc_stats (void) __THROW;
 /* Output information about state of allocator to stream FP.  */
 extern int malloc_info (int __options, FILE *__fp) __THROW;
 
+/* Write the allocations sampled by the heap profiler to stream FP.
+   Return 0 on success, or -1 with errno set on failure.  */
+extern int malloc_heap_profile (int __options, FILE *__fp) __THROW;
+
+/* Number of size classes reported by malloc_stats_np.  */
+#define MALLOC_STATS_NP_BINS 64
+
+/* Counters of one size class of the per-thread caches.  */
+struct malloc_bin_stats_np
+{
+  size_t size;     /* largest request size of the class */
+  size_t hits;     /* malloc calls served from a per-thread cache */
+  size_t misses;   /* malloc calls which found the cache empty */
+  size_t frees;    /* chunks kept in a per-thread cache by free */
+};
+
+struct malloc_stats_np
+{
+  size_t threads;          /* threads with a per-thread cache */
+  size_t arena_locks;      /* arena lock acquisitions */
+  size_t arena_lock_waits; /* acquisitions which found the lock held */
+  size_t mmap_chunks;      /* number of mmapped chunks */
+  size_t mmap_chunks_max;  /* maximum number of mmapped chunks */
+  size_t mmap_bytes;       /* space in mmapped chunks */
+  size_t nbins;            /* number of size classes in use */
+  struct malloc_bin_stats_np bins[MALLOC_STATS_NP_BINS];
+};
+
+/* Store statistics of the allocator in the first __size bytes of
+   *__stats, without stopping the other threads.  The per-thread
+   counters are only kept if the glibc.malloc.stats tunable is set.
+   Return 0.  */
+extern int malloc_stats_np (struct malloc_stats_np *__stats, size_t __size)
+     __THROW;
+
 __END_DECLS
 #endif /* malloc.h */
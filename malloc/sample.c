@@ -0,0 +1,522 @@
+/* Sampling heap profiler.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* When glibc.malloc.sample_interval is set, malloc records the stack of
+   one allocation in every sample_interval bytes on average.  The
+   distance to the next sample is drawn from an exponential
+   distribution, so that every allocated byte has the same chance of
+   being sampled, and is tracked by a per-thread countdown which
+   __libc_malloc decrements before anything else, including the tcache
+   fast path.  calloc and the memalign family decrement it in the same
+   way.  The countdown is only touched if sample_enabled is set, so that
+   programs which do not sample only test a flag which does not change
+   after initialization.  realloc decrements it by the growth of a block resized in
+   place, or by the whole size of a block it moves, once the new block
+   has been allocated.
+
+   Live sampled allocations are kept in a hash table under sample_lock.
+   free cannot afford to take the lock, so the table is summarized by a
+   counting filter indexed by the same hash, which free reads without
+   the lock: a zero counter proves that the pointer was not sampled.
+   The pointer passed to free was returned by malloc, which updated the
+   filter before returning, so the lock-free read cannot miss it.
+   realloc removes the old block of a moved allocation only once the
+   new block exists, but before the old block can be reused by another
+   thread.  sample_lock is acquired while holding an arena lock, never
+   the other way round.
+
+   The stack is recorded with backtrace, which loads libgcc_s with
+   dlopen on first use.  That must not happen from within malloc, which
+   may be called by the dynamic loader itself, so a constructor loads the
+   unwinder with __libc_unwind_link_get if sampling is enabled, as
+   pthread_cancel does before unwinding, and only the caller of malloc
+   is recorded until then or if libgcc_s cannot be loaded.
+
+   malloc_heap_profile writes the table out in the heap profile format
+   used by gperftools, which pprof reads.  */
+
+#include <array_length.h>
+#include <execinfo.h>
+#include <unwind-link.h>
+
+#ifndef SHARED
+/* Do not link the unwinder into every static program.  Only the caller
+   of malloc is recorded unless the program uses backtrace.  */
+weak_extern (__backtrace)
+#else
+/* True once sample_init has loaded the unwinder.  */
+static bool sample_unwinder_loaded;
+#endif
+
+/* True if glibc.malloc.sample_interval is set.  Only written by
+   ptmalloc_init.  */
+static bool sample_enabled;
+
+/* Frames recorded per sampled allocation.  */
+#define SAMPLE_MAX_FRAMES 32
+/* Frames of the profiler and of malloc at the top of each backtrace,
+   which are skipped.  */
+#define SAMPLE_SKIP_FRAMES 4
+
+/* Number of counters in the filter read by free.  Power of two.  */
+#define SAMPLE_FILTER_SIZE 16384
+/* Initial number of slots in the table.  Power of two.  */
+#define SAMPLE_INITIAL_SLOTS 1024
+
+struct sample_record
+{
+  /* Pointer returned by malloc, or 0 for an empty slot.  */
+  uintptr_t key;
+  /* Size requested from malloc.  */
+  size_t size;
+  int depth;
+  void *frames[SAMPLE_MAX_FRAMES];
+};
+
+struct sample_table
+{
+  size_t mask;
+  size_t count;
+  struct sample_record slots[];
+};
+
+/* Protects sample_table and the updates of sample_filter.  */
+__libc_lock_define_initialized (static, sample_lock);
+static struct sample_table *sample_table;
+/* Counters of the live samples by hash.  NULL until the first sample,
+   and never unmapped afterwards.  A saturated counter is never
+   decremented.  */
+static uint16_t *sample_filter;
+
+/* Bytes that the current thread can allocate before the next sample.
+   The initial value makes the first allocation of each thread set up
+   the countdown.  */
+static __thread size_t sample_bytes_left;
+static __thread uint64_t sample_rng;
+
+static void
+sample_enable (void)
+{
+  sample_enabled = true;
+}
+
+/* Count BYTES allocated by the calling thread, and return true if the
+   countdown has expired and the allocation has to go through one of
+   the sample_* functions below.  */
+static __always_inline bool
+sample_due (size_t bytes)
+{
+  if (__glibc_likely (!sample_enabled))
+    return false;
+  if (__glibc_unlikely (bytes > sample_bytes_left))
+    return true;
+  sample_bytes_left -= bytes;
+  return false;
+}
+
+static inline size_t
+sample_hash (uintptr_t key)
+{
+  size_t h = (key / MALLOC_ALIGNMENT) * (size_t) 0x9e3779b97f4a7c15ULL;
+  return h ^ (h >> 16);
+}
+
+/* Return -log(U) for U uniformly distributed in (0, 1].  This avoids
+   a dependency on libm, and is precise enough for sampling.  */
+static double
+sample_neg_log (uint64_t u53)
+{
+  /* U = M * 2^(E - 53) with M in [1, 2).  */
+  int e = 63 - __builtin_clzll (u53);
+  double m = (double) u53 / (double) (1ULL << e);
+  /* log(M) = 2 atanh (S) with S = (M - 1) / (M + 1) in [0, 1/3).  */
+  double s = (m - 1) / (m + 1);
+  double s2 = s * s;
+  double log_m = 2 * s * (1 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 / 7)));
+  return (53 - e) * 0x1.62e42fefa39efp-1 - log_m;
+}
+
+/* Return the number of bytes until the next sample.  */
+static size_t
+sample_next_interval (void)
+{
+  if (mp_.sample_interval == 0)
+    return SIZE_MAX;
+
+  if (sample_rng == 0)
+    sample_rng = (((uint64_t) random_bits () << 32) | random_bits ())
+		 ^ (uintptr_t) &sample_rng;
+  if (sample_rng == 0)
+    sample_rng = 1;
+
+  /* xorshift64*.  */
+  sample_rng ^= sample_rng >> 12;
+  sample_rng ^= sample_rng << 25;
+  sample_rng ^= sample_rng >> 27;
+  uint64_t u53 = ((sample_rng * 2685821657736338717ULL) >> 11) + 1;
+
+  double next = sample_neg_log (u53) * mp_.sample_interval;
+  if (next < 1)
+    return 1;
+  if (next >= (double) (SIZE_MAX / 2))
+    return SIZE_MAX / 2;
+  return next;
+}
+
+/* Allocate a table with SLOTS slots.  */
+static struct sample_table *
+sample_table_alloc (size_t slots)
+{
+  size_t size = ALIGN_UP (sizeof (struct sample_table)
+			  + slots * sizeof (struct sample_record),
+			  GLRO (dl_pagesize));
+  struct sample_table *t = (struct sample_table *)
+    MMAP (NULL, size, PROT_READ | PROT_WRITE, 0);
+  if (t == MAP_FAILED)
+    return NULL;
+  t->mask = slots - 1;
+  t->count = 0;
+  return t;
+}
+
+static void
+sample_table_free (struct sample_table *t)
+{
+  __munmap (t, ALIGN_UP (sizeof (struct sample_table)
+			 + (t->mask + 1) * sizeof (struct sample_record),
+			 GLRO (dl_pagesize)));
+}
+
+/* Return the slot of KEY in T, or the empty slot where it belongs.  */
+static struct sample_record *
+sample_table_find (struct sample_table *t, uintptr_t key)
+{
+  for (size_t i = sample_hash (key) & t->mask;; i = (i + 1) & t->mask)
+    if (t->slots[i].key == key || t->slots[i].key == 0)
+      return &t->slots[i];
+}
+
+/* Make room for one more record.  Called with sample_lock held.  */
+static bool
+sample_table_reserve (void)
+{
+  struct sample_table *t = sample_table;
+  if (t != NULL && (t->count + 1) * 2 <= t->mask + 1)
+    return true;
+
+  struct sample_table *n
+    = sample_table_alloc (t == NULL ? SAMPLE_INITIAL_SLOTS
+			  : (t->mask + 1) * 2);
+  if (n == NULL)
+    return false;
+  if (t != NULL)
+    {
+      for (size_t i = 0; i <= t->mask; ++i)
+	if (t->slots[i].key != 0)
+	  *sample_table_find (n, t->slots[i].key) = t->slots[i];
+      n->count = t->count;
+      sample_table_free (t);
+    }
+  sample_table = n;
+  return true;
+}
+
+/* Record MEM, allocated with a request of BYTES bytes by a call to
+   malloc which returns to CALLER.  */
+static void
+sample_record (void *mem, size_t bytes, void *caller)
+{
+  void *frames[SAMPLE_MAX_FRAMES + SAMPLE_SKIP_FRAMES];
+  int depth = 0;
+#ifdef SHARED
+  if (atomic_load_relaxed (&sample_unwinder_loaded))
+#else
+  if (__backtrace != NULL)
+#endif
+    depth = __backtrace (frames, array_length (frames));
+  /* The trace starts at the caller of malloc.  */
+  int skip = 0;
+  while (skip < depth && skip < SAMPLE_SKIP_FRAMES && frames[skip] != caller)
+    ++skip;
+  if (skip == depth || frames[skip] != caller)
+    {
+      frames[0] = caller;
+      depth = 1;
+      skip = 0;
+    }
+  depth = MIN (depth - skip, SAMPLE_MAX_FRAMES);
+
+  __libc_lock_lock (sample_lock);
+  if (sample_filter == NULL)
+    {
+      void *filter = MMAP (NULL, SAMPLE_FILTER_SIZE * sizeof (uint16_t),
+			   PROT_READ | PROT_WRITE, 0);
+      if (filter != MAP_FAILED)
+	atomic_store_release (&sample_filter, filter);
+    }
+  if (sample_filter != NULL && sample_table_reserve ())
+    {
+      uintptr_t key = (uintptr_t) mem;
+      struct sample_record *r = sample_table_find (sample_table, key);
+      /* A record for the same pointer is left over if it was released
+	 without going through free, which is undefined.  */
+      if (r->key == 0)
+	{
+	  ++sample_table->count;
+	  uint16_t *c = &sample_filter[sample_hash (key)
+				       & (SAMPLE_FILTER_SIZE - 1)];
+	  if (*c != UINT16_MAX)
+	    atomic_store_relaxed (c, *c + 1);
+	}
+      r->key = key;
+      r->size = bytes;
+      r->depth = depth;
+      memcpy (r->frames, frames + skip, depth * sizeof (void *));
+    }
+  __libc_lock_unlock (sample_lock);
+}
+
+/* Remove MEM from the table, if it is there.  */
+static void __attribute_noinline__
+sample_remove (void *mem)
+{
+  uintptr_t key = (uintptr_t) mem;
+
+  __libc_lock_lock (sample_lock);
+  struct sample_table *t = sample_table;
+  struct sample_record *r;
+  if (t != NULL && (r = sample_table_find (t, key))->key == key)
+    {
+      uint16_t *c = &sample_filter[sample_hash (key)
+				   & (SAMPLE_FILTER_SIZE - 1)];
+      if (*c != UINT16_MAX)
+	atomic_store_relaxed (c, *c - 1);
+      --t->count;
+
+      /* Shift the following records of the cluster back, so that
+	 lookups can stop at the first empty slot.  */
+      size_t i = r - t->slots;
+      size_t j = i;
+      while (1)
+	{
+	  j = (j + 1) & t->mask;
+	  if (t->slots[j].key == 0)
+	    break;
+	  size_t home = sample_hash (t->slots[j].key) & t->mask;
+	  /* Move J to I unless its home lies cyclically in (I, J].  */
+	  if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+	    continue;
+	  t->slots[i] = t->slots[j];
+	  i = j;
+	}
+      t->slots[i].key = 0;
+    }
+  __libc_lock_unlock (sample_lock);
+}
+
+/* Called by every function which releases MEM.  */
+static __always_inline void
+sample_free (void *mem)
+{
+  uint16_t *filter = atomic_load_acquire (&sample_filter);
+  if (__glibc_unlikely (filter != NULL)
+      && atomic_load_relaxed (&filter[sample_hash ((uintptr_t) mem)
+				      & (SAMPLE_FILTER_SIZE - 1)]) != 0)
+    sample_remove (mem);
+}
+
+/* Called when the countdown of the thread expires.  Suspend sampling,
+   so that neither the allocation itself nor those done while taking the
+   backtrace are sampled.  Return false if the countdown of a new thread
+   is only being set up, in which case nothing is recorded.  */
+static bool
+sample_begin (void)
+{
+  bool first = sample_rng == 0;
+  sample_bytes_left = SIZE_MAX;
+  return !first;
+}
+
+/* Record MEM, allocated with a request of BYTES bytes by a function
+   which returns to CALLER, if RECORD, and restart the countdown.  */
+static void
+sample_end (void *mem, size_t bytes, void *caller, bool record)
+{
+  if (mem != NULL && record && mp_.sample_interval != 0)
+    sample_record (mem, bytes, caller);
+  sample_bytes_left = sample_next_interval ();
+}
+
+/* Called by __libc_malloc, which returns to CALLER, when the countdown
+   of the thread expires.  */
+static void * __attribute_noinline__
+sample_malloc (size_t bytes, void *caller)
+{
+  bool record = sample_begin ();
+  void *mem = __libc_malloc (bytes);
+  sample_end (mem, bytes, caller, record);
+  return mem;
+}
+
+/* Likewise for __libc_calloc.  */
+static void * __attribute_noinline__
+sample_calloc (size_t n, size_t elem_size, void *caller)
+{
+  bool record = sample_begin ();
+  void *mem = __libc_calloc (n, elem_size);
+  sample_end (mem, n * elem_size, caller, record);
+  return mem;
+}
+
+/* Likewise for _mid_memalign.  */
+static void * __attribute_noinline__
+sample_memalign (size_t alignment, size_t bytes, void *caller)
+{
+  bool record = sample_begin ();
+  void *mem = _mid_memalign (alignment, bytes, caller);
+  sample_end (mem, bytes, caller, record);
+  return mem;
+}
+
+/* Account for BYTES bytes added to MEM by realloc, which returns to
+   CALLER, after the fact.  SIZE is the new size of MEM.  */
+static __always_inline void
+sample_realloc (void *mem, size_t bytes, size_t size, void *caller)
+{
+  if (__glibc_unlikely (bytes > sample_bytes_left))
+    sample_end (mem, size, caller, sample_begin ());
+  else
+    sample_bytes_left -= bytes;
+}
+
+/* Allocate BYTES bytes with malloc for a function which accounts for
+   them in the countdown itself.  */
+static void *
+malloc_unsampled (size_t bytes)
+{
+  if (!sample_enabled)
+    return __libc_malloc (bytes);
+  size_t left = sample_bytes_left;
+  sample_bytes_left = SIZE_MAX;
+  void *mem = __libc_malloc (bytes);
+  sample_bytes_left = left;
+  return mem;
+}
+
+#ifdef SHARED
+static void __attribute__ ((constructor))
+sample_init (void)
+{
+  if (!__malloc_initialized)
+    ptmalloc_init ();
+  if (sample_enabled && __libc_unwind_link_get () != NULL)
+    atomic_store_relaxed (&sample_unwinder_loaded, true);
+}
+#endif
+
+static void
+sample_fork_lock (void)
+{
+  __libc_lock_lock (sample_lock);
+}
+
+static void
+sample_fork_unlock (bool child)
+{
+  if (child)
+    __libc_lock_init (sample_lock);
+  else
+    __libc_lock_unlock (sample_lock);
+}
+
+int
+__malloc_heap_profile (int options, FILE *fp)
+{
+  if (options != 0)
+    {
+      __set_errno (EINVAL);
+      return -1;
+    }
+
+  /* Copy the records, so that the lock is not held while writing,
+     which may allocate and free memory.  */
+  struct sample_table *copy = NULL;
+  __libc_lock_lock (sample_lock);
+  if (sample_table != NULL && sample_table->count > 0)
+    {
+      copy = sample_table_alloc (sample_table->mask + 1);
+      if (copy == NULL)
+	{
+	  __libc_lock_unlock (sample_lock);
+	  __set_errno (ENOMEM);
+	  return -1;
+	}
+      memcpy (copy, sample_table,
+	      sizeof (struct sample_table)
+	      + (sample_table->mask + 1) * sizeof (struct sample_record));
+    }
+  __libc_lock_unlock (sample_lock);
+
+  size_t count = 0;
+  size_t total = 0;
+  if (copy != NULL)
+    for (size_t i = 0; i <= copy->mask; ++i)
+      if (copy->slots[i].key != 0)
+	{
+	  ++count;
+	  total += copy->slots[i].size;
+	}
+
+  /* pprof scales each sample by the sampling interval.  */
+  fprintf (fp, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+	   count, total, count, total, (size_t) mp_.sample_interval);
+  if (copy != NULL)
+    {
+      for (size_t i = 0; i <= copy->mask; ++i)
+	{
+	  struct sample_record *r = &copy->slots[i];
+	  if (r->key == 0)
+	    continue;
+	  fprintf (fp, "1: %zu [1: %zu] @", r->size, r->size);
+	  for (int f = 0; f < r->depth; ++f)
+	    fprintf (fp, " %p", r->frames[f]);
+	  fputc ('\n', fp);
+	}
+      sample_table_free (copy);
+    }
+
+  /* pprof uses the mappings to symbolize the addresses.  */
+  fputs ("\nMAPPED_LIBRARIES:\n", fp);
+  int fd = __open64_nocancel ("/proc/self/maps", O_RDONLY);
+  if (fd != -1)
+    {
+      char buf[1024];
+      ssize_t n;
+      while ((n = __read_nocancel (fd, buf, sizeof (buf))) > 0)
+	fwrite (buf, 1, n, fp);
+      __close_nocancel (fd);
+    }
+
+  if (ferror (fp))
+    {
+      __set_errno (EIO);
+      return -1;
+    }
+  return 0;
+}
+weak_alias (__malloc_heap_profile, malloc_heap_profile)
@@ -0,0 +1,554 @@
+/* Slab allocator for small requests.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* When glibc.malloc.slab is set, malloc serves requests of up to
+   SLAB_MAX_SIZE bytes from slots without a chunk header.  The slots of
+   one size are carved from runs of SLAB_RUN_SIZE bytes, which are
+   allocated from a region reserved at startup.  A pointer belongs to
+   the slab allocator if it lies in the region; its run is found by
+   rounding it down to the run size.
+
+   The metadata of each run, its class and a bitmap of its free slots,
+   is kept in a separate array indexed by run number, so that the runs
+   contain nothing but slots.  Runs which become empty are returned to
+   the system with MADV_DONTNEED and can be reused for any size.
+
+   Each size class has a lock and a list of the runs with free slots.
+   The lock of a class may be held while acquiring slab_region_lock,
+   never the other way round.
+
+   The locks are not taken for every allocation: like the tcache, each
+   thread caches up to SLAB_CACHE_MAX free slots per class in a list
+   threaded through the slots, which remain marked as allocated in their
+   runs.  A thread whose list is empty takes the lock of the class once
+   to fill it with SLAB_CACHE_BATCH slots, and a thread whose list is
+   full returns that many to their runs at once.  The slots of a thread
+   are returned when it exits.  */
+
+/* Size of a run.  A fixed size keeps the bitmaps small on systems with
+   large pages; empty runs are only returned to the system if they
+   cover whole pages.  */
+#define SLAB_RUN_SIZE 4096
+/* Size classes are multiples of SLAB_ALIGNMENT up to SLAB_MAX_SIZE.  */
+#define SLAB_ALIGNMENT MALLOC_ALIGNMENT
+#define SLAB_MAX_SIZE 256
+#define SLAB_CLASSES (SLAB_MAX_SIZE / SLAB_ALIGNMENT)
+#define SLAB_MAP_WORDS (SLAB_RUN_SIZE / SLAB_ALIGNMENT / 64)
+/* Size of the region reserved for the runs.  */
+#if __WORDSIZE == 64
+# define SLAB_REGION_SIZE (1UL << 30)
+#else
+# define SLAB_REGION_SIZE (64UL << 20)
+#endif
+#define SLAB_RUNS (SLAB_REGION_SIZE / SLAB_RUN_SIZE)
+/* Number of runs made accessible at a time.  */
+#define SLAB_GROW_RUNS 64
+/* Maximum number of free slots of each class cached by a thread, and
+   the number of slots moved between the cache and the runs at once.  */
+#define SLAB_CACHE_MAX 32
+#define SLAB_CACHE_BATCH (SLAB_CACHE_MAX / 2)
+
+struct slab_run
+{
+  /* Bit I is set if slot I is free.  */
+  uint64_t free_map[SLAB_MAP_WORDS];
+  /* Links of the list of the class, or of the list of unused runs.
+     Run numbers plus one, zero terminates.  */
+  uint32_t prev;
+  uint32_t next;
+  uint16_t nfree;
+  /* Size class, or zero if the run is unused.  */
+  uint8_t cls;
+};
+
+struct slab_class
+{
+  __libc_lock_define (, lock);
+  /* Runs with at least one free slot, plus one.  */
+  uint32_t partial;
+  /* Number of runs of this class.  */
+  size_t nruns;
+};
+
+/* A free slot in the cache of a thread.  */
+struct slab_entry
+{
+  /* Protected as in the tcache.  */
+  struct slab_entry *next;
+  /* slab_key while the slot is cached, to detect double frees.  */
+  uintptr_t key;
+};
+
+struct slab_cache
+{
+  struct slab_entry *entries[SLAB_CLASSES + 1];
+  uint16_t counts[SLAB_CLASSES + 1];
+};
+
+static __thread bool slab_shutting_down;
+static __thread struct slab_cache *slab_cache;
+
+/* Set once by ptmalloc_init.  */
+static uintptr_t slab_key;
+static char *slab_base;
+static struct slab_run *slab_runs;
+static size_t slab_size;
+
+static struct slab_class slab_classes[SLAB_CLASSES + 1];
+
+/* Protects the following.  */
+__libc_lock_define_initialized (static, slab_region_lock);
+/* Runs below this index have been made accessible.  */
+static size_t slab_mapped;
+/* Runs below this index have been used.  */
+static size_t slab_top;
+/* Unused runs below slab_top, plus one.  */
+static uint32_t slab_unused;
+
+static inline bool
+slab_contains (void *mem)
+{
+  return (uintptr_t) mem - (uintptr_t) slab_base < slab_size;
+}
+
+static inline size_t
+slab_class_size (size_t cls)
+{
+  return cls * SLAB_ALIGNMENT;
+}
+
+static inline size_t
+slab_class_slots (size_t cls)
+{
+  return SLAB_RUN_SIZE / slab_class_size (cls);
+}
+
+static inline char *
+slab_run_start (size_t run)
+{
+  return slab_base + run * SLAB_RUN_SIZE;
+}
+
+static void
+slab_init (void)
+{
+  size_t meta_size = ALIGN_UP (SLAB_RUNS * sizeof (struct slab_run),
+			       GLRO (dl_pagesize));
+  char *p = (char *) MMAP (NULL, SLAB_REGION_SIZE + meta_size, PROT_NONE,
+			   MAP_NORESERVE);
+  if (p == MAP_FAILED)
+    {
+      mp_.slab = 0;
+      return;
+    }
+  __set_vma_name (p, SLAB_REGION_SIZE + meta_size, " glibc: malloc slab");
+  for (size_t i = 1; i <= SLAB_CLASSES; ++i)
+    __libc_lock_init (slab_classes[i].lock);
+  slab_key = random_bits ();
+#if __WORDSIZE == 64
+  slab_key = (slab_key << 32) | random_bits ();
+#endif
+  slab_runs = (struct slab_run *) p;
+  slab_base = p + meta_size;
+  slab_size = SLAB_REGION_SIZE;
+}
+
+/* Return a run for class CLS with all its slots free, or -1 if the
+   region is exhausted.  Called with the lock of CLS held.  */
+static ssize_t
+slab_new_run (size_t cls)
+{
+  ssize_t run = -1;
+
+  __libc_lock_lock (slab_region_lock);
+  if (slab_unused != 0)
+    {
+      run = slab_unused - 1;
+      slab_unused = slab_runs[run].next;
+    }
+  else if (slab_top < SLAB_RUNS)
+    {
+      if (slab_top == slab_mapped)
+	{
+	  size_t pagesize = GLRO (dl_pagesize);
+	  size_t grow = MIN (ALIGN_UP (SLAB_GROW_RUNS * SLAB_RUN_SIZE,
+				       pagesize) / SLAB_RUN_SIZE,
+			     SLAB_RUNS - slab_mapped);
+	  uintptr_t meta_start = (uintptr_t) &slab_runs[slab_mapped];
+	  uintptr_t meta_end = (uintptr_t) &slab_runs[slab_mapped + grow];
+	  meta_start = ALIGN_DOWN (meta_start, pagesize);
+	  meta_end = ALIGN_UP (meta_end, pagesize);
+	  if (__mprotect (slab_run_start (slab_mapped),
+			  grow * SLAB_RUN_SIZE, PROT_READ | PROT_WRITE) == 0
+	      && __mprotect ((void *) meta_start, meta_end - meta_start,
+			     PROT_READ | PROT_WRITE) == 0)
+	    slab_mapped += grow;
+	}
+      if (slab_top < slab_mapped)
+	{
+	  run = slab_top;
+	  atomic_store_relaxed (&slab_top, slab_top + 1);
+	}
+    }
+  __libc_lock_unlock (slab_region_lock);
+
+  if (run >= 0)
+    {
+      struct slab_run *r = &slab_runs[run];
+      size_t slots = slab_class_slots (cls);
+      memset (r->free_map, 0, sizeof (r->free_map));
+      for (size_t i = 0; i < slots / 64; ++i)
+	r->free_map[i] = UINT64_MAX;
+      if (slots % 64 != 0)
+	r->free_map[slots / 64] = (1ULL << (slots % 64)) - 1;
+      r->nfree = slots;
+      r->cls = cls;
+      ++slab_classes[cls].nruns;
+    }
+  return run;
+}
+
+/* Return RUN, which has no allocated slots, to the system.  Called with
+   the lock of its class held, after it was removed from the list.  */
+static void
+slab_release_run (size_t run)
+{
+  struct slab_run *r = &slab_runs[run];
+  --slab_classes[r->cls].nruns;
+  r->cls = 0;
+  if (GLRO (dl_pagesize) <= SLAB_RUN_SIZE)
+    __madvise (slab_run_start (run), SLAB_RUN_SIZE, MADV_DONTNEED);
+
+  __libc_lock_lock (slab_region_lock);
+  r->next = slab_unused;
+  slab_unused = run + 1;
+  __libc_lock_unlock (slab_region_lock);
+}
+
+static void
+slab_list_remove (struct slab_class *c, size_t run)
+{
+  struct slab_run *r = &slab_runs[run];
+  if (r->prev != 0)
+    slab_runs[r->prev - 1].next = r->next;
+  else
+    c->partial = r->next;
+  if (r->next != 0)
+    slab_runs[r->next - 1].prev = r->prev;
+}
+
+static void
+slab_list_push (struct slab_class *c, size_t run)
+{
+  struct slab_run *r = &slab_runs[run];
+  r->prev = 0;
+  r->next = c->partial;
+  if (c->partial != 0)
+    slab_runs[c->partial - 1].prev = run + 1;
+  c->partial = run + 1;
+}
+
+static inline size_t
+slab_class_of (size_t bytes)
+{
+  return (MAX (bytes, 1) + SLAB_ALIGNMENT - 1) / SLAB_ALIGNMENT;
+}
+
+/* Take a free slot of class CLS out of its runs.  Return NULL if the
+   region is exhausted.  Called with the lock of CLS held.  */
+static void *
+slab_take_locked (size_t cls)
+{
+  struct slab_class *c = &slab_classes[cls];
+  ssize_t run = (ssize_t) c->partial - 1;
+  if (run < 0)
+    {
+      run = slab_new_run (cls);
+      if (run < 0)
+	return NULL;
+      slab_list_push (c, run);
+    }
+  struct slab_run *r = &slab_runs[run];
+  size_t w = 0;
+  while (r->free_map[w] == 0)
+    ++w;
+  size_t bit = __builtin_ctzll (r->free_map[w]);
+  r->free_map[w] &= ~(1ULL << bit);
+  if (--r->nfree == 0)
+    slab_list_remove (c, run);
+  return slab_run_start (run) + (w * 64 + bit) * slab_class_size (cls);
+}
+
+/* Return the class of MEM, a slot handed out by slab_malloc, and store
+   its run and slot number in *RUN and *SLOT.  */
+static size_t
+slab_locate (void *mem, size_t *run, size_t *slot)
+{
+  size_t offset = (char *) mem - slab_base;
+  *run = offset / SLAB_RUN_SIZE;
+  if (__glibc_unlikely (*run >= atomic_load_relaxed (&slab_top)))
+    malloc_printerr ("free(): invalid pointer");
+  size_t cls = slab_runs[*run].cls;
+  if (__glibc_unlikely (cls == 0))
+    malloc_printerr ("free(): invalid pointer");
+  size_t size = slab_class_size (cls);
+  *slot = (offset % SLAB_RUN_SIZE) / size;
+  if (__glibc_unlikely (offset % SLAB_RUN_SIZE != *slot * size
+			|| *slot >= slab_class_slots (cls)))
+    malloc_printerr ("free(): invalid pointer");
+  return cls;
+}
+
+/* Mark SLOT of RUN, of class CLS, as free.  Called with the lock of CLS
+   held.  */
+static void
+slab_put_locked (size_t cls, size_t run, size_t slot)
+{
+  struct slab_class *c = &slab_classes[cls];
+  struct slab_run *r = &slab_runs[run];
+  /* Check the class again, in case of a concurrent double free.  */
+  if (__glibc_unlikely (r->cls != cls
+			|| (r->free_map[slot / 64] & (1ULL << (slot % 64)))))
+    malloc_printerr ("free(): double free detected in slab");
+  r->free_map[slot / 64] |= 1ULL << (slot % 64);
+  if (r->nfree++ == 0)
+    slab_list_push (c, run);
+  else if (r->nfree == slab_class_slots (cls)
+	   && (r->prev != 0 || r->next != 0))
+    {
+      /* Keep one empty run per class, so that a single allocation and
+	 free do not map and unmap a run each time.  */
+      slab_list_remove (c, run);
+      slab_release_run (run);
+    }
+}
+
+/* Take a slot of class CLS for the caller and, if SC is not NULL, up to
+   SLAB_CACHE_BATCH more for SC, under a single acquisition of the lock
+   of CLS.  Return NULL if the region is exhausted.  */
+static void *
+slab_refill (struct slab_cache *sc, size_t cls)
+{
+  void *batch[SLAB_CACHE_BATCH];
+  size_t n = 0;
+
+  __libc_lock_lock (slab_classes[cls].lock);
+  void *mem = slab_take_locked (cls);
+  if (mem != NULL && sc != NULL)
+    while (n < SLAB_CACHE_BATCH
+	   && (batch[n] = slab_take_locked (cls)) != NULL)
+      ++n;
+  __libc_lock_unlock (slab_classes[cls].lock);
+
+  /* Push in reverse, so that the slots are handed out in address
+     order.  */
+  while (n > 0)
+    {
+      struct slab_entry *e = batch[--n];
+      e->next = PROTECT_PTR (&e->next, sc->entries[cls]);
+      e->key = slab_key;
+      sc->entries[cls] = e;
+      ++sc->counts[cls];
+    }
+  return mem;
+}
+
+/* Return COUNT slots of class CLS from SC to their runs.  */
+static void
+slab_drain (struct slab_cache *sc, size_t cls, size_t count)
+{
+  __libc_lock_lock (slab_classes[cls].lock);
+  for (; count > 0 && sc->entries[cls] != NULL; --count)
+    {
+      struct slab_entry *e = sc->entries[cls];
+      if (__glibc_unlikely (!aligned_OK (e)))
+	malloc_printerr ("free(): unaligned slot detected in slab cache");
+      sc->entries[cls] = REVEAL_PTR (e->next);
+      --sc->counts[cls];
+      e->key = 0;
+      size_t run, slot;
+      slab_locate (e, &run, &slot);
+      slab_put_locked (cls, run, slot);
+    }
+  __libc_lock_unlock (slab_classes[cls].lock);
+}
+
+/* Set up the cache of the calling thread.  The cache is itself a slot,
+   taken without a cache.  */
+static struct slab_cache *
+slab_cache_init (void)
+{
+  if (slab_shutting_down)
+    return NULL;
+  struct slab_cache *sc
+    = slab_refill (NULL, slab_class_of (sizeof (struct slab_cache)));
+  if (sc != NULL)
+    {
+      memset (sc, 0, sizeof (*sc));
+      slab_cache = sc;
+    }
+  return sc;
+}
+
+/* Allocate a slot for a request of BYTES bytes, at most SLAB_MAX_SIZE.
+   Return NULL if the region is exhausted.  */
+static void *
+slab_malloc (size_t bytes)
+{
+  size_t cls = slab_class_of (bytes);
+  struct slab_cache *sc = slab_cache;
+  if (__glibc_unlikely (sc == NULL))
+    sc = slab_cache_init ();
+
+  void *mem;
+  struct slab_entry *e;
+  if (sc != NULL && (e = sc->entries[cls]) != NULL)
+    {
+      if (__glibc_unlikely (!aligned_OK (e)))
+	malloc_printerr ("malloc(): unaligned slot detected in slab cache");
+      sc->entries[cls] = REVEAL_PTR (e->next);
+      --sc->counts[cls];
+      e->key = 0;
+      mem = e;
+    }
+  else
+    mem = slab_refill (sc, cls);
+
+  if (mem != NULL)
+    alloc_perturb (mem, bytes);
+  return mem;
+}
+
+/* Abort if E, which carries the key of cached slots, is in the cache
+   SC for class CLS.  */
+static void __attribute_noinline__
+slab_double_free_verify (struct slab_cache *sc, size_t cls,
+			 struct slab_entry *e)
+{
+  size_t cnt = 0;
+  for (struct slab_entry *tmp = sc->entries[cls]; tmp != NULL;
+       tmp = REVEAL_PTR (tmp->next), ++cnt)
+    {
+      if (cnt >= SLAB_CACHE_MAX)
+	malloc_printerr ("free(): too many slots detected in slab cache");
+      if (__glibc_unlikely (!aligned_OK (tmp)))
+	malloc_printerr ("free(): unaligned slot detected in slab cache");
+      if (tmp == e)
+	malloc_printerr ("free(): double free detected in slab cache");
+    }
+}
+
+static void
+slab_free (void *mem)
+{
+  size_t run, slot;
+  size_t cls = slab_locate (mem, &run, &slot);
+  struct slab_cache *sc = slab_cache;
+  struct slab_entry *e = mem;
+
+  if (sc != NULL && __glibc_unlikely (e->key == slab_key))
+    slab_double_free_verify (sc, cls, e);
+
+  free_perturb (mem, slab_class_size (cls));
+
+  if (__glibc_unlikely (sc == NULL))
+    {
+      __libc_lock_lock (slab_classes[cls].lock);
+      slab_put_locked (cls, run, slot);
+      __libc_lock_unlock (slab_classes[cls].lock);
+      return;
+    }
+
+  if (sc->counts[cls] >= SLAB_CACHE_MAX)
+    slab_drain (sc, cls, SLAB_CACHE_BATCH);
+  e->next = PROTECT_PTR (&e->next, sc->entries[cls]);
+  e->key = slab_key;
+  sc->entries[cls] = e;
+  ++sc->counts[cls];
+}
+
+/* Return the slots cached by the calling thread, and its cache, which
+   is not set up again afterwards.  */
+static void
+slab_thread_shutdown (void)
+{
+  struct slab_cache *sc = slab_cache;
+  slab_shutting_down = true;
+  if (sc == NULL)
+    return;
+  slab_cache = NULL;
+  for (size_t cls = 1; cls <= SLAB_CLASSES; ++cls)
+    if (sc->counts[cls] > 0)
+      slab_drain (sc, cls, sc->counts[cls]);
+  slab_free (sc);
+}
+
+static size_t
+slab_usable_size (void *mem)
+{
+  size_t run = ((char *) mem - slab_base) / SLAB_RUN_SIZE;
+  return slab_class_size (slab_runs[run].cls);
+}
+
+/* Add the free slots to *NFREE and *FREE_BYTES and the size of the runs
+   to *RUN_BYTES.  */
+static void
+slab_info (size_t *nfree, size_t *free_bytes, size_t *run_bytes)
+{
+  for (size_t cls = 1; cls <= SLAB_CLASSES; ++cls)
+    {
+      struct slab_class *c = &slab_classes[cls];
+      __libc_lock_lock (c->lock);
+      for (uint32_t run = c->partial; run != 0; run = slab_runs[run - 1].next)
+	{
+	  *nfree += slab_runs[run - 1].nfree;
+	  *free_bytes += slab_runs[run - 1].nfree * slab_class_size (cls);
+	}
+      *run_bytes += c->nruns * SLAB_RUN_SIZE;
+      __libc_lock_unlock (c->lock);
+    }
+}
+
+static void
+slab_fork_lock (void)
+{
+  if (!mp_.slab)
+    return;
+  for (size_t cls = 1; cls <= SLAB_CLASSES; ++cls)
+    __libc_lock_lock (slab_classes[cls].lock);
+  __libc_lock_lock (slab_region_lock);
+}
+
+static void
+slab_fork_unlock (bool child)
+{
+  if (!mp_.slab)
+    return;
+  if (child)
+    {
+      __libc_lock_init (slab_region_lock);
+      for (size_t cls = 1; cls <= SLAB_CLASSES; ++cls)
+	__libc_lock_init (slab_classes[cls].lock);
+    }
+  else
+    {
+      __libc_lock_unlock (slab_region_lock);
+      for (size_t cls = 1; cls <= SLAB_CLASSES; ++cls)
+	__libc_lock_unlock (slab_classes[cls].lock);
+    }
+}
@@ -0,0 +1,179 @@
+/* Test free_sized and free_aligned_sized.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Free memory from every allocation function with the sized variants,
+   including sizes served by the tcache, by the arena and by mmap, and
+   check that reusing the memory does not corrupt the heap.  */
+
+#include <array_length.h>
+#include <malloc.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/xthread.h>
+
+static const size_t sizes[] =
+  {
+    0, 1, 8, 24, 25, 100, 1000, 1032, 4096, 64 * 1024, 1024 * 1024
+  };
+
+static const size_t alignments[] = { 16, 64, 256, 4096 };
+
+enum { rounds = 8 };
+enum { blocks = 16 };
+
+/* Allocate BLOCKS blocks of SIZE bytes with the allocation function
+   selected by KIND, fill them, and free them with free_sized.  */
+static void
+check_size (size_t size, int kind)
+{
+  void *p[blocks];
+
+  for (int i = 0; i < blocks; ++i)
+    {
+      switch (kind)
+	{
+	case 0:
+	  p[i] = malloc (size);
+	  break;
+	case 1:
+	  p[i] = calloc (1, size);
+	  break;
+	case 2:
+	  /* Shrink a larger block, which leaves the chunk larger than
+	     the request if the remainder is too small to split.  */
+	  p[i] = malloc (size + 8);
+	  TEST_VERIFY_EXIT (p[i] != NULL);
+	  p[i] = realloc (p[i], size);
+	  break;
+	}
+      if (size == 0 && p[i] == NULL)
+	continue;
+      TEST_VERIFY_EXIT (p[i] != NULL);
+      memset (p[i], 0xa5, size);
+    }
+  for (int i = 0; i < blocks; ++i)
+    free_sized (p[i], size);
+}
+
+static void
+check_aligned (size_t alignment, size_t size)
+{
+  void *p[blocks];
+
+  for (int i = 0; i < blocks; ++i)
+    {
+      p[i] = aligned_alloc (alignment, size);
+      TEST_VERIFY_EXIT (p[i] != NULL);
+      TEST_COMPARE ((uintptr_t) p[i] % alignment, 0);
+      memset (p[i], 0x5a, size);
+    }
+  for (int i = 0; i < blocks; ++i)
+    free_aligned_sized (p[i], alignment, size);
+}
+
+/* A size argument that is too small must not put the chunk into the
+   tcache bin for that size, which would let a later malloc of that size
+   overflow it.  */
+static void
+check_wrong_size (void)
+{
+  void *p = malloc (1000);
+  TEST_VERIFY_EXIT (p != NULL);
+  free_sized (p, 24);
+  void *q[blocks];
+  for (int i = 0; i < blocks; ++i)
+    {
+      q[i] = malloc (24);
+      TEST_VERIFY_EXIT (q[i] != NULL);
+      TEST_VERIFY (q[i] != p);
+    }
+  for (int i = 0; i < blocks; ++i)
+    free (q[i]);
+}
+
+static void
+free_too_large (void *closure)
+{
+  void *p = malloc (24);
+  TEST_VERIFY_EXIT (p != NULL);
+  free_sized (p, 1000);
+}
+
+static void *
+run_checks (void *closure)
+{
+  for (int r = 0; r < rounds; ++r)
+    {
+      for (size_t i = 0; i < array_length (sizes); ++i)
+	for (int kind = 0; kind < 3; ++kind)
+	  check_size (sizes[i], kind);
+
+      for (size_t i = 0; i < array_length (alignments); ++i)
+	for (size_t j = 0; j < array_length (sizes); ++j)
+	  if (sizes[j] != 0)
+	    check_aligned (alignments[i], sizes[j]);
+
+      /* Memory freed with free_sized must be reused like memory freed
+	 with free.  */
+      for (size_t i = 0; i < array_length (sizes); ++i)
+	{
+	  void *p = malloc (sizes[i]);
+	  TEST_VERIFY_EXIT (p != NULL);
+	  memset (p, 0xcc, sizes[i]);
+	  TEST_VERIFY (malloc_usable_size (p) >= sizes[i]);
+	  free (p);
+	}
+    }
+
+  free_sized (NULL, 0);
+  free_sized (NULL, 100);
+  free_aligned_sized (NULL, 64, 100);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  /* Before the tcache bins fill up, so that the chunk is not
+     split.  */
+  check_wrong_size ();
+
+  /* Main arena.  */
+  run_checks (NULL);
+
+  /* Secondary arena.  */
+  xpthread_join (xpthread_create (NULL, run_checks, NULL));
+
+  /* A size argument larger than the chunk is diagnosed.  */
+  struct support_capture_subprocess result
+    = support_capture_subprocess (free_too_large, NULL);
+  TEST_VERIFY (WIFSIGNALED (result.status)
+	       && WTERMSIG (result.status) == SIGABRT);
+  TEST_VERIFY (strstr (result.err.buffer, "free_sized(): invalid size")
+	       != NULL);
+  support_capture_subprocess_free (&result);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,121 @@
+/* Test decay-based purging of free chunks.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.decay_ms=10.  Free large blocks in
+   the middle of the heap, keep calling free for a while, and check that
+   the pages of the large blocks are no longer resident.  This includes
+   the remainder of a large block which is split by a later malloc.  */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <support/check.h>
+
+/* Smaller than the mmap threshold.  */
+enum { big_size = 64 * 1024 };
+enum { big_count = 8 };
+/* Larger than the tcache and fastbin limits, so that each free of these
+   reaches the arena.  */
+enum { small_size = 2000 };
+enum { small_count = 1024 };
+enum { rounds = 16 };
+
+static void *small[small_count];
+
+/* Count the resident pages in the whole pages of [P, P + SIZE).  The
+   first words of a free chunk are kept, so skip them.  */
+static size_t
+resident_pages (void *p, size_t size)
+{
+  long int ps = sysconf (_SC_PAGESIZE);
+  uintptr_t start = ((uintptr_t) p + 64 + ps - 1) & -ps;
+  uintptr_t end = ((uintptr_t) p + size) & -ps;
+  unsigned char vec[big_size / 4096 + 1];
+  size_t count = 0;
+
+  TEST_VERIFY_EXIT ((end - start) / ps <= sizeof (vec));
+  if (mincore ((void *) start, end - start, vec) != 0)
+    FAIL_EXIT1 ("mincore: %m");
+  for (size_t i = 0; i < (end - start) / ps; ++i)
+    count += vec[i] & 1;
+  return count;
+}
+
+static int
+do_test (void)
+{
+  void *big[big_count];
+  void *guard[big_count];
+
+  for (int i = 0; i < small_count; ++i)
+    small[i] = malloc (small_size);
+
+  /* Separate the large blocks, so that they neither merge with each
+     other nor with the top chunk when freed.  */
+  for (int i = 0; i < big_count; ++i)
+    {
+      big[i] = malloc (big_size);
+      guard[i] = malloc (small_size);
+      TEST_VERIFY_EXIT (big[i] != NULL && guard[i] != NULL);
+      /* All bits set, so that a remainder which is not stamped when
+	 it is split off looks like an already purged chunk.  */
+      memset (big[i], 0xff, big_size);
+    }
+  TEST_VERIFY (resident_pages (big[0], big_size) > 0);
+
+  for (int i = 0; i < big_count; ++i)
+    free (big[i]);
+
+  /* Split one of the large blocks.  The allocation is taken from the
+     start of the block.  */
+  void *piece = malloc (small_size);
+  TEST_VERIFY_EXIT (piece != NULL);
+  int split = -1;
+  for (int i = 0; i < big_count; ++i)
+    if (big[i] == piece)
+      split = i;
+  TEST_VERIFY_EXIT (split >= 0);
+
+  /* Free the small blocks in batches, so that the arena checks the age
+     of its free chunks several times.  */
+  int next = 0;
+  for (int r = 0; r < rounds && next < small_count; ++r)
+    {
+      usleep (20 * 1000);
+      for (int i = 0; i < small_count / rounds; ++i)
+	free (small[next++]);
+    }
+
+  for (int i = 0; i < big_count; ++i)
+    if (i == split)
+      TEST_COMPARE (resident_pages ((char *) piece + small_size,
+				    big_size - small_size), 0);
+    else
+      TEST_COMPARE (resident_pages (big[i], big_size), 0);
+
+  free (piece);
+
+  for (int i = 0; i < big_count; ++i)
+    free (guard[i]);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
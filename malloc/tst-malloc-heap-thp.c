@@ -0,0 +1,139 @@
+/* Test huge page aligned heaps for non-main arenas.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.heap_thp=1.  Grow and shrink the
+   heap of a secondary arena, and check that malloc_info reports it as
+   accessible in whole transparent huge pages, along with the amount
+   backed by huge pages.  */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/xmemstream.h>
+#include <support/xstdio.h>
+#include <support/xthread.h>
+
+/* Smaller than the mmap threshold.  */
+enum { block_size = 64 * 1024 };
+enum { block_count = 96 };
+
+static size_t thp_pagesize;
+
+static void
+read_thp_config (void)
+{
+  FILE *fp = fopen ("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (fp == NULL)
+    FAIL_UNSUPPORTED ("transparent huge pages not supported");
+  char mode[64] = "";
+  if (fgets (mode, sizeof (mode), fp) == NULL)
+    mode[0] = '\0';
+  xfclose (fp);
+  if (strstr (mode, "[never]") != NULL || strchr (mode, '[') == NULL)
+    FAIL_UNSUPPORTED ("transparent huge pages disabled: %s", mode);
+
+  fp = xfopen ("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+  if (fscanf (fp, "%zu", &thp_pagesize) != 1)
+    FAIL_EXIT1 ("cannot read hpage_pmd_size");
+  xfclose (fp);
+  if (thp_pagesize > 64 * 1024 * 1024)
+    FAIL_UNSUPPORTED ("huge page size %zu too large for heaps",
+		      thp_pagesize);
+}
+
+/* Check the malloc_info output of the secondary arena, the second heap
+   element.  */
+static void
+check_malloc_info (const char *when)
+{
+  struct xmemstream out;
+  xopen_memstream (&out);
+  TEST_COMPARE (malloc_info (0, out.out), 0);
+  xfclose_memstream (&out);
+
+  const char *heap = strstr (out.buffer, "<heap nr=\"1\">");
+  TEST_VERIFY_EXIT (heap != NULL);
+
+  size_t mprotect_size, thp_size;
+  const char *p = strstr (heap, "<aspace type=\"mprotect\" size=\"");
+  TEST_VERIFY_EXIT (p != NULL);
+  TEST_COMPARE (sscanf (p, "<aspace type=\"mprotect\" size=\"%zu\"",
+			&mprotect_size), 1);
+  p = strstr (heap, "<aspace type=\"thp\" size=\"");
+  TEST_VERIFY_EXIT (p != NULL);
+  TEST_COMPARE (sscanf (p, "<aspace type=\"thp\" size=\"%zu\"", &thp_size),
+		1);
+  printf ("info: %s: accessible %zu, huge page backed %zu\n",
+	  when, mprotect_size, thp_size);
+
+  TEST_COMPARE (mprotect_size % thp_pagesize, 0);
+  TEST_VERIFY (thp_size <= mprotect_size);
+  TEST_COMPARE (thp_size % thp_pagesize, 0);
+
+  /* The totals are reported too.  */
+  p = strstr (heap, "</heap>\n<total");
+  TEST_VERIFY_EXIT (p != NULL);
+  TEST_VERIFY (strstr (p, "<aspace type=\"thp\"") != NULL);
+
+  free (out.buffer);
+}
+
+static void *
+thread_func (void *closure)
+{
+  void *blocks[block_count];
+
+  for (int i = 0; i < block_count; ++i)
+    {
+      blocks[i] = malloc (block_size);
+      TEST_VERIFY_EXIT (blocks[i] != NULL);
+      memset (blocks[i], 0xa5, block_size);
+    }
+  check_malloc_info ("after allocation");
+
+  /* Release the upper part of the heap.  */
+  for (int i = block_count / 4; i < block_count; ++i)
+    free (blocks[i]);
+  malloc_trim (0);
+  check_malloc_info ("after trim");
+
+  /* Grow the heap again.  */
+  for (int i = block_count / 4; i < block_count; ++i)
+    {
+      blocks[i] = malloc (block_size);
+      TEST_VERIFY_EXIT (blocks[i] != NULL);
+      memset (blocks[i], 0x5a, block_size);
+    }
+  check_malloc_info ("after reallocation");
+
+  for (int i = 0; i < block_count; ++i)
+    free (blocks[i]);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  read_thp_config ();
+  xpthread_join (xpthread_create (NULL, thread_func, NULL));
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,111 @@
+/* Test NUMA placement of arenas with glibc.malloc.numa=1.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* For each CPU the test may run on, start a thread pinned to that CPU,
+   allocate memory from the thread's arena and check with move_pages
+   that the memory was placed on the node of the CPU.  */
+
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <support/check.h>
+#include <support/xthread.h>
+
+/* Larger than the tcache limit and smaller than the mmap threshold, so
+   that the memory comes from the heap of the thread's arena.  */
+enum { block_size = 64 * 1024 };
+
+/* Upper bound on the number of CPUs tested.  */
+enum { max_cpus = 64 };
+
+static int tested;
+
+/* Return the node on which the page containing P is placed, or a
+   negative errno value.  */
+static int
+page_node (void *p)
+{
+  long int pagesize = sysconf (_SC_PAGESIZE);
+  void *page = (void *) ((uintptr_t) p & -pagesize);
+  int status = -1;
+  if (syscall (SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) != 0)
+    return -errno;
+  return status;
+}
+
+static void *
+thread_func (void *closure)
+{
+  int cpu = (uintptr_t) closure;
+  cpu_set_t set;
+  CPU_ZERO (&set);
+  CPU_SET (cpu, &set);
+  if (sched_setaffinity (0, sizeof (set), &set) != 0)
+    FAIL_EXIT1 ("sched_setaffinity (%d): %m", cpu);
+
+  unsigned int cur_cpu, node;
+  TEST_COMPARE (getcpu (&cur_cpu, &node), 0);
+  TEST_COMPARE (cur_cpu, cpu);
+
+  char *p = malloc (block_size);
+  TEST_VERIFY_EXIT (p != NULL);
+  memset (p, 0xa5, block_size);
+
+  int result = page_node (p + block_size / 2);
+  if (result == -ENOSYS || result == -EPERM)
+    printf ("warning: move_pages not available: %s\n", strerror (-result));
+  else
+    {
+      printf ("info: CPU %d node %u: block placed on node %d\n",
+	      cpu, node, result);
+      TEST_COMPARE (result, node);
+      ++tested;
+    }
+
+  free (p);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  cpu_set_t set;
+  if (sched_getaffinity (0, sizeof (set), &set) != 0)
+    FAIL_EXIT1 ("sched_getaffinity: %m");
+
+  /* Threads run one after the other, so that each creates its arena
+     or picks up the free arena of the previous thread on its node.  */
+  for (int cpu = 0, n = 0; cpu < CPU_SETSIZE && n < max_cpus; ++cpu)
+    if (CPU_ISSET (cpu, &set))
+      {
+	xpthread_join (xpthread_create (NULL, thread_func,
+					(void *) (uintptr_t) cpu));
+	++n;
+      }
+
+  if (tested == 0)
+    FAIL_UNSUPPORTED ("move_pages is not supported");
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,107 @@
+/* Test the per-CPU malloc caches.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.percpu set and a single-entry
+   tcache, so that most small chunks pass through the per-CPU caches.
+   If rseq is not available the caches are disabled and the test only
+   exercises the regular paths.  */
+
+#include <malloc.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <support/check.h>
+#include <support/xthread.h>
+#include <support/xunistd.h>
+
+enum { block_count = 100 };
+enum { rounds = 500 };
+enum { thread_count = 8 };
+
+static void
+run_rounds (unsigned int seed)
+{
+  unsigned char *blocks[block_count];
+  size_t sizes[block_count];
+
+  for (int r = 0; r < rounds; ++r)
+    {
+      for (int i = 0; i < block_count; ++i)
+	{
+	  seed = seed * 1103515245 + 12345;
+	  sizes[i] = 16 * ((seed >> 8) % 32 + 1);
+	  blocks[i] = malloc (sizes[i]);
+	  TEST_VERIFY_EXIT (blocks[i] != NULL);
+	  memset (blocks[i], (uint8_t) i, sizes[i]);
+	}
+
+      for (int i = 0; i < block_count; ++i)
+	{
+	  for (size_t j = 0; j < sizes[i]; ++j)
+	    if (blocks[i][j] != (uint8_t) i)
+	      FAIL_EXIT1 ("block %d of round %d overwritten", i, r);
+	  free (blocks[i]);
+	}
+
+      /* Give other threads a chance to run on this CPU.  */
+      if (r % 64 == 0)
+	sched_yield ();
+    }
+}
+
+static void *
+thread_func (void *closure)
+{
+  run_rounds ((uintptr_t) closure);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  pthread_t threads[thread_count];
+  for (int i = 0; i < thread_count; ++i)
+    threads[i] = xpthread_create (NULL, thread_func,
+				  (void *) (uintptr_t) (i + 1));
+  run_rounds (0);
+  for (int i = 0; i < thread_count; ++i)
+    xpthread_join (threads[i]);
+
+  /* Drain the per-CPU caches back to the arenas.  */
+  malloc_trim (0);
+  run_rounds (thread_count + 1);
+
+  /* The per-CPU cache locks must be usable in a child process.  */
+  threads[0] = xpthread_create (NULL, thread_func, (void *) 42);
+  pid_t pid = xfork ();
+  if (pid == 0)
+    {
+      run_rounds (43);
+      _exit (0);
+    }
+  int status;
+  xwaitpid (pid, &status, 0);
+  TEST_VERIFY (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+  xpthread_join (threads[0]);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,104 @@
+/* Test freeing chunks from threads not attached to their arena.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.remote_free=1, which queues chunks
+   freed by a thread other than the arena owner.  Check that queued
+   chunks are eventually merged into their arena and that concurrent
+   remote frees and allocations do not corrupt the heap.  */
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/xthread.h>
+
+/* Larger than the tcache and fastbin limits, smaller than the mmap
+   threshold, so that free reaches the arena.  */
+enum { block_size = 4096 };
+enum { block_count = 64 };
+enum { rounds = 200 };
+
+static void *
+allocate_blocks (void *closure)
+{
+  void **blocks = closure;
+  for (int i = 0; i < block_count; ++i)
+    {
+      blocks[i] = malloc (block_size);
+      TEST_VERIFY_EXIT (blocks[i] != NULL);
+      memset (blocks[i], 0xa5, block_size);
+    }
+  return NULL;
+}
+
+static void *blocks_a[block_count];
+static void *blocks_b[block_count];
+static pthread_barrier_t barrier;
+
+/* Allocate into MINE, then free the blocks the other thread has just
+   allocated into THEIRS, while the other thread does the same.  */
+static void
+exchange_blocks (void **mine, void **theirs)
+{
+  for (int r = 0; r < rounds; ++r)
+    {
+      allocate_blocks (mine);
+      xpthread_barrier_wait (&barrier);
+      for (int i = 0; i < block_count; ++i)
+	free (theirs[i]);
+      xpthread_barrier_wait (&barrier);
+    }
+}
+
+static void *
+exchange_thread (void *closure)
+{
+  exchange_blocks (blocks_b, blocks_a);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  void *blocks[block_count];
+
+  /* Allocate from a secondary arena and free from the main thread.  */
+  xpthread_join (xpthread_create (NULL, allocate_blocks, blocks));
+
+  struct mallinfo2 before = mallinfo2 ();
+  for (int i = 0; i < block_count; ++i)
+    free (blocks[i]);
+
+  /* malloc_trim consolidates every arena, which merges queued chunks.  */
+  malloc_trim (0);
+  struct mallinfo2 after = mallinfo2 ();
+  printf ("info: in use before free: %zu, after trim: %zu\n",
+	  before.uordblks, after.uordblks);
+  TEST_VERIFY (after.uordblks + block_count * block_size <= before.uordblks);
+
+  /* Concurrent remote frees in both directions.  */
+  xpthread_barrier_init (&barrier, NULL, 2);
+  pthread_t thr = xpthread_create (NULL, exchange_thread, NULL);
+  exchange_blocks (blocks_a, blocks_b);
+  xpthread_join (thr);
+  xpthread_barrier_destroy (&barrier);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
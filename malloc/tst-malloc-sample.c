@@ -0,0 +1,275 @@
+/* Test the sampling heap profiler.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.sample_interval=4096.  Allocate
+   blocks from several threads with every allocation function, and check
+   that malloc_heap_profile reports samples with stack traces while the
+   blocks are in use, and drops them once the blocks are freed.  Check
+   that realloc keeps the sample of a block it does not move.  */
+
+#include <errno.h>
+#include <libc-diag.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/xmemstream.h>
+#include <support/xstdio.h>
+#include <support/xthread.h>
+#include <support/xunistd.h>
+#include <sys/wait.h>
+
+enum { block_size = 256 };
+/* Allocates 1 MiB, for about 256 samples per thread.  */
+enum { block_count = 4096 };
+/* Size of the block used to check realloc, which no other sample
+   has.  */
+enum { marked_size = 3001 };
+
+/* Allocation functions used by allocate_blocks.  */
+enum
+{
+  kind_malloc,
+  kind_calloc,
+  kind_aligned_alloc,
+  kind_posix_memalign,
+  kind_count,
+  /* Cycle through all of the above.  */
+  kind_mixed = kind_count
+};
+
+struct profile
+{
+  size_t count;
+  size_t bytes;
+  size_t interval;
+  /* Samples with a non-empty stack trace.  */
+  size_t traced;
+  /* Samples of marked_size bytes.  */
+  size_t marked;
+};
+
+static struct profile
+read_profile (void)
+{
+  struct xmemstream out;
+  xopen_memstream (&out);
+  TEST_COMPARE (malloc_heap_profile (0, out.out), 0);
+  xfclose_memstream (&out);
+
+  struct profile prof = { 0, };
+  size_t count2, bytes2;
+  TEST_COMPARE (sscanf (out.buffer,
+			"heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+			&prof.count, &prof.bytes, &count2, &bytes2,
+			&prof.interval), 5);
+  TEST_COMPARE (prof.count, count2);
+  TEST_COMPARE (prof.bytes, bytes2);
+
+  const char *end = strstr (out.buffer, "\nMAPPED_LIBRARIES:\n");
+  TEST_VERIFY_EXIT (end != NULL);
+  /* The memory mappings are copied from /proc/self/maps.  */
+  TEST_VERIFY (strstr (end, "[stack]") != NULL);
+
+  size_t lines = 0;
+  for (const char *p = strstr (out.buffer, "\n1: "); p != NULL && p < end;
+       p = strstr (p + 1, "\n1: "))
+    {
+      size_t size, size2;
+      int n;
+      TEST_COMPARE (sscanf (p, "\n1: %zu [1: %zu] @%n", &size, &size2, &n),
+		    2);
+      TEST_COMPARE (size, size2);
+      ++lines;
+      if (size == marked_size)
+	++prof.marked;
+      if (p[n] == ' ')
+	++prof.traced;
+    }
+  TEST_COMPARE (lines, prof.count);
+
+  free (out.buffer);
+  return prof;
+}
+
+static void **
+allocate_blocks (int kind)
+{
+  void **blocks = malloc (block_count * sizeof (void *));
+  TEST_VERIFY_EXIT (blocks != NULL);
+  for (int i = 0; i < block_count; ++i)
+    {
+      switch (kind == kind_mixed ? i % kind_count : kind)
+	{
+	case kind_malloc:
+	  blocks[i] = malloc (block_size);
+	  break;
+	case kind_calloc:
+	  blocks[i] = calloc (block_size / 4, 4);
+	  break;
+	case kind_aligned_alloc:
+	  blocks[i] = aligned_alloc (64, block_size);
+	  break;
+	case kind_posix_memalign:
+	  TEST_COMPARE (posix_memalign (&blocks[i], 64, block_size), 0);
+	  break;
+	}
+      TEST_VERIFY_EXIT (blocks[i] != NULL);
+      memset (blocks[i], 0xa5, block_size);
+    }
+  return blocks;
+}
+
+static void
+free_blocks (void **blocks)
+{
+  /* Exercise every function which releases memory.  */
+  for (int i = 0; i < block_count; ++i)
+    switch (i % 3)
+      {
+      case 0:
+	free (blocks[i]);
+	break;
+      case 1:
+	free_sized (blocks[i], block_size);
+	break;
+      case 2:
+	free (realloc (blocks[i], 2 * block_size));
+	break;
+      }
+  free (blocks);
+}
+
+static void *
+thread_func (void *closure)
+{
+  free_blocks (allocate_blocks (kind_mixed));
+  return closure;
+}
+
+/* Check that every allocation function is sampled.  */
+static void
+check_kinds (void)
+{
+  for (int kind = 0; kind < kind_count; ++kind)
+    {
+      struct profile before = read_profile ();
+      void **blocks = allocate_blocks (kind);
+      struct profile during = read_profile ();
+      printf ("info: kind %d: samples before: %zu, during: %zu\n",
+	      kind, before.count, during.count);
+      TEST_VERIFY (during.count >= before.count + 64);
+      free_blocks (blocks);
+    }
+}
+
+/* Check that realloc only drops the sample of a block once it has
+   moved it.  */
+static void
+check_realloc (void)
+{
+  void *p = NULL;
+  for (int i = 0; i < 100 && p == NULL; ++i)
+    {
+      p = malloc (marked_size);
+      TEST_VERIFY_EXIT (p != NULL);
+      if (read_profile ().marked == 0)
+	{
+	  free (p);
+	  p = NULL;
+	}
+    }
+  TEST_VERIFY_EXIT (p != NULL);
+  TEST_COMPARE (read_profile ().marked, 1);
+
+  /* A failed realloc leaves the block alone.  */
+  errno = 0;
+  TEST_VERIFY (realloc (p, PTRDIFF_MAX) == NULL);
+  TEST_COMPARE (errno, ENOMEM);
+  TEST_COMPARE (read_profile ().marked, 1);
+
+  /* So does growth into the padding of the block.  Compare the
+     addresses as integers, because P is not used after realloc.  */
+  /* P is still valid after the failed realloc, which GCC does not
+     know.  */
+  DIAG_PUSH_NEEDS_COMMENT;
+#if __GNUC_PREREQ (12, 0)
+  DIAG_IGNORE_NEEDS_COMMENT (12, "-Wuse-after-free");
+#endif
+  uintptr_t old = (uintptr_t) p;
+  p = realloc (p, marked_size + 1);
+  DIAG_POP_NEEDS_COMMENT;
+  TEST_VERIFY_EXIT ((uintptr_t) p == old);
+  TEST_COMPARE (read_profile ().marked, 1);
+
+  p = realloc (p, 16 * marked_size);
+  TEST_VERIFY_EXIT (p != NULL);
+  if ((uintptr_t) p != old)
+    TEST_COMPARE (read_profile ().marked, 0);
+  free (p);
+  TEST_COMPARE (read_profile ().marked, 0);
+}
+
+static int
+do_test (void)
+{
+  errno = 0;
+  TEST_COMPARE (malloc_heap_profile (1, stdout), -1);
+  TEST_COMPARE (errno, EINVAL);
+
+  struct profile before = read_profile ();
+  TEST_COMPARE (before.interval, 4096);
+
+  check_kinds ();
+  check_realloc ();
+
+  void **blocks = allocate_blocks (kind_mixed);
+  struct profile during = read_profile ();
+  printf ("info: samples before: %zu, during: %zu (%zu bytes)\n",
+	  before.count, during.count, during.bytes);
+  TEST_VERIFY (during.count >= before.count + 64);
+  TEST_VERIFY (during.traced >= during.count - before.count);
+
+  /* Samples taken concurrently, and in a child process.  */
+  pthread_t thr[4];
+  for (int i = 0; i < 4; ++i)
+    thr[i] = xpthread_create (NULL, thread_func, NULL);
+  pid_t pid = xfork ();
+  if (pid == 0)
+    {
+      free_blocks (allocate_blocks (kind_mixed));
+      read_profile ();
+      _exit (support_record_failure_is_failed () ? 1 : 0);
+    }
+  for (int i = 0; i < 4; ++i)
+    xpthread_join (thr[i]);
+  int status;
+  xwaitpid (pid, &status, 0);
+  TEST_COMPARE (status, 0);
+
+  free_blocks (blocks);
+  struct profile after = read_profile ();
+  printf ("info: samples after: %zu\n", after.count);
+  TEST_VERIFY (after.count < before.count + 64);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,206 @@
+/* Test the slab allocator for small requests.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.slab=1.  Check that small blocks
+   are packed without headers, that blocks of every size can be
+   reallocated and freed from any thread, that malloc_info accounts
+   for the runs, which are released once they are empty, and that a
+   double free of a slot in the cache of the thread is detected.  */
+
+#include <libc-diag.h>
+#include <malloc.h>
+#include <malloc-size.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/capture_subprocess.h>
+#include <support/check.h>
+#include <support/xmemstream.h>
+#include <support/xstdio.h>
+#include <support/xthread.h>
+
+enum { max_size = 256 };
+enum { block_count = 4096 };
+enum { thread_count = 4 };
+
+/* Return the size of the slab runs reported by malloc_info.  */
+static size_t
+slab_runs_size (void)
+{
+  struct xmemstream out;
+  xopen_memstream (&out);
+  TEST_COMPARE (malloc_info (0, out.out), 0);
+  xfclose_memstream (&out);
+
+  const char *p = strstr (out.buffer, "<aspace type=\"slab\" size=\"");
+  TEST_VERIFY_EXIT (p != NULL);
+  size_t size;
+  TEST_COMPARE (sscanf (p, "<aspace type=\"slab\" size=\"%zu\"", &size), 1);
+  TEST_VERIFY (strstr (out.buffer, "<total type=\"slab\" count=\"") != NULL);
+  free (out.buffer);
+  return size;
+}
+
+static void
+fill (unsigned char *p, size_t size, size_t seed)
+{
+  for (size_t i = 0; i < size; ++i)
+    p[i] = seed + i;
+}
+
+static void
+check (const unsigned char *p, size_t size, size_t seed)
+{
+  for (size_t i = 0; i < size; ++i)
+    if (p[i] != (unsigned char) (seed + i))
+      FAIL_EXIT1 ("block %p of %zu bytes corrupted at %zu", p, size, i);
+}
+
+static void *blocks[thread_count][block_count];
+
+/* Allocate blocks of every size into BLOCKS[N].  */
+static void *
+allocate_thread (void *closure)
+{
+  uintptr_t n = (uintptr_t) closure;
+  for (size_t i = 0; i < block_count; ++i)
+    {
+      size_t size = i % (max_size + 1);
+      blocks[n][i] = malloc (size);
+      TEST_VERIFY_EXIT (blocks[n][i] != NULL);
+      TEST_COMPARE ((uintptr_t) blocks[n][i] % MALLOC_ALIGNMENT, 0);
+      fill (blocks[n][i], size, i);
+    }
+  return NULL;
+}
+
+/* Check and free the blocks allocated by another thread.  */
+static void *
+free_thread (void *closure)
+{
+  uintptr_t n = (uintptr_t) closure;
+  for (size_t i = 0; i < block_count; ++i)
+    {
+      check (blocks[n][i], i % (max_size + 1), i);
+      free (blocks[n][i]);
+    }
+  return NULL;
+}
+
+static void
+double_free (void *closure)
+{
+  void *p = malloc (32);
+  TEST_VERIFY_EXIT (p != NULL);
+  free (p);
+  DIAG_PUSH_NEEDS_COMMENT;
+#if __GNUC_PREREQ (12, 0)
+  /* This is the double free the test checks for.  */
+  DIAG_IGNORE_NEEDS_COMMENT (12, "-Wuse-after-free");
+#endif
+  free (p);
+  DIAG_POP_NEEDS_COMMENT;
+}
+
+static int
+do_test (void)
+{
+  size_t before = slab_runs_size ();
+
+  /* Small blocks are rounded up to the alignment only.  */
+  for (size_t size = 0; size <= max_size; ++size)
+    {
+      unsigned char *p = malloc (size);
+      TEST_VERIFY_EXIT (p != NULL);
+      size_t usable = malloc_usable_size (p);
+      TEST_VERIFY (usable >= size);
+      TEST_VERIFY (usable < size + MALLOC_ALIGNMENT
+		   || (size == 0 && usable == MALLOC_ALIGNMENT));
+      fill (p, usable, size);
+      free (p);
+    }
+
+  /* Blocks of the same size are adjacent, without headers.  */
+  char *a = malloc (16);
+  char *b = malloc (16);
+  TEST_VERIFY_EXIT (a != NULL && b != NULL);
+  TEST_COMPARE (b > a ? b - a : a - b, 16);
+  free (a);
+  free (b);
+
+  /* realloc within a class, to a smaller class, and out of the slab
+     allocator.  */
+  unsigned char *p = malloc (200);
+  TEST_VERIFY_EXIT (p != NULL);
+  fill (p, 200, 7);
+  p = realloc (p, 190);
+  TEST_VERIFY_EXIT (p != NULL);
+  check (p, 190, 7);
+  p = realloc (p, 20);
+  TEST_VERIFY_EXIT (p != NULL);
+  check (p, 20, 7);
+  TEST_VERIFY (malloc_usable_size (p) <= 32);
+  p = realloc (p, 100000);
+  TEST_VERIFY_EXIT (p != NULL);
+  check (p, 20, 7);
+  p = realloc (p, 10);
+  TEST_VERIFY_EXIT (p != NULL);
+  check (p, 10, 7);
+  free (p);
+
+  /* free_sized and freeing from another thread.  */
+  p = malloc (48);
+  TEST_VERIFY_EXIT (p != NULL);
+  free_sized (p, 48);
+
+  for (uintptr_t i = 0; i < thread_count; ++i)
+    xpthread_join (xpthread_create (NULL, allocate_thread, (void *) i));
+  size_t during = slab_runs_size ();
+  printf ("info: slab runs: %zu bytes before, %zu during\n", before, during);
+  /* About 128 bytes per block, plus a partial run per size.  */
+  TEST_VERIFY (during > before);
+  TEST_VERIFY (during <= before + thread_count * block_count * 160
+			 + (max_size / MALLOC_ALIGNMENT) * 2 * 4096);
+
+  pthread_t threads[thread_count];
+  for (uintptr_t i = 0; i < thread_count; ++i)
+    threads[i] = xpthread_create (NULL, free_thread,
+				  (void *) ((i + 1) % thread_count));
+  for (int i = 0; i < thread_count; ++i)
+    xpthread_join (threads[i]);
+
+  /* Empty runs are released, except one per size, and the runs of the
+     slots cached by this thread, at most one per size.  */
+  size_t after = slab_runs_size ();
+  printf ("info: slab runs after free: %zu bytes\n", after);
+  TEST_VERIFY (after <= before + (max_size / MALLOC_ALIGNMENT) * 2 * 4096);
+
+  struct support_capture_subprocess result
+    = support_capture_subprocess (double_free, NULL);
+  TEST_VERIFY (WIFSIGNALED (result.status)
+	       && WTERMSIG (result.status) == SIGABRT);
+  TEST_VERIFY (strstr (result.err.buffer, "double free detected in slab")
+	       != NULL);
+  support_capture_subprocess_free (&result);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,159 @@
+/* Test malloc_stats_np.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Check that the counters follow the allocations of the current
+   thread, keep the counts of exited threads, and can be read while
+   other threads allocate.  */
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/xthread.h>
+
+enum { block_size = 100 };
+enum { block_count = 1000 };
+enum { thread_count = 4 };
+
+static size_t
+bin_of (size_t size, const struct malloc_stats_np *stats)
+{
+  for (size_t i = 0; i < stats->nbins; ++i)
+    if (stats->bins[i].size >= size)
+      return i;
+  FAIL_EXIT1 ("no size class for %zu bytes", size);
+}
+
+static void
+allocate_and_free (void)
+{
+  void *blocks[block_count];
+  for (int i = 0; i < block_count; ++i)
+    {
+      blocks[i] = malloc (block_size);
+      TEST_VERIFY_EXIT (blocks[i] != NULL);
+    }
+  for (int i = 0; i < block_count; ++i)
+    free (blocks[i]);
+  /* These are served from the per-thread cache.  */
+  for (int i = 0; i < block_count; ++i)
+    {
+      void *volatile p = malloc (block_size);
+      free (p);
+    }
+}
+
+static void *
+allocate_thread (void *closure)
+{
+  allocate_and_free ();
+  return NULL;
+}
+
+static volatile bool stop;
+
+static void *
+read_thread (void *closure)
+{
+  size_t reads = 0;
+  struct malloc_stats_np before, after;
+  TEST_COMPARE (malloc_stats_np (&before, sizeof (before)), 0);
+  while (!stop)
+    {
+      TEST_COMPARE (malloc_stats_np (&after, sizeof (after)), 0);
+      /* Counters never go backwards, even across thread exits.  */
+      TEST_VERIFY (after.arena_locks >= before.arena_locks);
+      for (size_t i = 0; i < MALLOC_STATS_NP_BINS; ++i)
+	{
+	  TEST_VERIFY (after.bins[i].hits >= before.bins[i].hits);
+	  TEST_VERIFY (after.bins[i].frees >= before.bins[i].frees);
+	}
+      before = after;
+      ++reads;
+    }
+  printf ("info: %zu concurrent reads\n", reads);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  struct malloc_stats_np before, after;
+
+  /* Set up the per-thread cache.  */
+  void *volatile p = malloc (1);
+  free (p);
+  TEST_COMPARE (malloc_stats_np (&before, sizeof (before)), 0);
+  TEST_VERIFY (before.threads >= 1);
+  TEST_VERIFY (before.nbins > 0 && before.nbins <= MALLOC_STATS_NP_BINS);
+  for (size_t i = 1; i < MALLOC_STATS_NP_BINS; ++i)
+    TEST_VERIFY (before.bins[i].size > before.bins[i - 1].size);
+  size_t bin = bin_of (block_size, &before);
+
+  allocate_and_free ();
+  TEST_COMPARE (malloc_stats_np (&after, sizeof (after)), 0);
+  printf ("info: bin %zu: hits %zu, misses %zu, frees %zu\n", bin,
+	  after.bins[bin].hits - before.bins[bin].hits,
+	  after.bins[bin].misses - before.bins[bin].misses,
+	  after.bins[bin].frees - before.bins[bin].frees);
+  TEST_VERIFY (after.bins[bin].hits >= before.bins[bin].hits + block_count);
+  TEST_VERIFY (after.bins[bin].misses > before.bins[bin].misses);
+  TEST_VERIFY (after.bins[bin].frees >= before.bins[bin].frees
+	       + block_count);
+
+  /* Chunks allocated with mmap.  */
+  void *large = malloc (64 * 1024 * 1024);
+  TEST_VERIFY_EXIT (large != NULL);
+  TEST_COMPARE (malloc_stats_np (&after, sizeof (after)), 0);
+  TEST_COMPARE (after.mmap_chunks, before.mmap_chunks + 1);
+  TEST_VERIFY (after.mmap_chunks_max >= after.mmap_chunks);
+  TEST_VERIFY (after.mmap_bytes >= before.mmap_bytes + 64 * 1024 * 1024);
+  free (large);
+  TEST_COMPARE (malloc_stats_np (&after, sizeof (after)), 0);
+  TEST_COMPARE (after.mmap_chunks, before.mmap_chunks);
+
+  /* Only the first SIZE bytes are written.  */
+  struct malloc_stats_np partial;
+  memset (&partial, 0xff, sizeof (partial));
+  TEST_COMPARE (malloc_stats_np (&partial, sizeof (size_t)), 0);
+  TEST_VERIFY (partial.threads >= 1);
+  TEST_COMPARE (partial.arena_locks, (size_t) -1);
+
+  /* Threads which exit keep their counts.  */
+  TEST_COMPARE (malloc_stats_np (&before, sizeof (before)), 0);
+  pthread_t reader = xpthread_create (NULL, read_thread, NULL);
+  pthread_t threads[thread_count];
+  for (int i = 0; i < thread_count; ++i)
+    threads[i] = xpthread_create (NULL, allocate_thread, NULL);
+  for (int i = 0; i < thread_count; ++i)
+    xpthread_join (threads[i]);
+  stop = true;
+  xpthread_join (reader);
+  TEST_COMPARE (malloc_stats_np (&after, sizeof (after)), 0);
+  TEST_COMPARE (after.threads, before.threads);
+  /* Secondary threads lock their arena.  */
+  TEST_VERIFY (after.arena_locks > before.arena_locks);
+  TEST_VERIFY (after.bins[bin].hits
+	       >= before.bins[bin].hits + thread_count * block_count);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
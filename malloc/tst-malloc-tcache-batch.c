@@ -0,0 +1,87 @@
+/* Test batched transfers between the tcache and the arenas.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The test is run with glibc.malloc.tcache_batch set, so that bins are
+   refilled from and flushed to the arenas several chunks at a time.
+   Allocate and free bursts of blocks, which overflow and drain the
+   bins repeatedly, and check that no block is handed out twice.  */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <support/check.h>
+#include <support/xthread.h>
+
+enum { burst_length = 200 };
+enum { rounds = 500 };
+enum { thread_count = 4 };
+
+static void
+run_bursts (unsigned int seed)
+{
+  unsigned char *blocks[burst_length];
+  size_t sizes[burst_length];
+
+  for (int r = 0; r < rounds; ++r)
+    {
+      for (int i = 0; i < burst_length; ++i)
+	{
+	  /* Mostly a handful of size classes, so that the bins fill up,
+	     with some larger blocks which are served by the arena.  */
+	  seed = seed * 1103515245 + 12345;
+	  sizes[i] = (seed >> 16) % 8 == 0 ? 2048 : 16 * ((seed >> 8) % 4 + 1);
+	  blocks[i] = malloc (sizes[i]);
+	  TEST_VERIFY_EXIT (blocks[i] != NULL);
+	  memset (blocks[i], (uint8_t) i, sizes[i]);
+	}
+
+      for (int i = 0; i < burst_length; ++i)
+	{
+	  for (size_t j = 0; j < sizes[i]; ++j)
+	    if (blocks[i][j] != (uint8_t) i)
+	      FAIL_EXIT1 ("block %d of round %d overwritten", i, r);
+	  free (blocks[i]);
+	}
+    }
+}
+
+static void *
+thread_func (void *closure)
+{
+  run_bursts ((uintptr_t) closure);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  /* Without threads the arena lock is not taken at all.  */
+  run_bursts (0);
+
+  pthread_t threads[thread_count];
+  for (int i = 0; i < thread_count; ++i)
+    threads[i] = xpthread_create (NULL, thread_func,
+				  (void *) (uintptr_t) (i + 1));
+  run_bursts (thread_count + 1);
+  for (int i = 0; i < thread_count; ++i)
+    xpthread_join (threads[i]);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -66,29 +66,34 @@ get_cached_stack (size_t *sizep, void **memp)
   lll_lock (GL (dl_stack_cache_lock), LLL_PRIVATE);
 
   /* Search the cache for a matching entry.  We search for the
-     smallest stack which has at least the required size.  Note that
-     in normal situations the size of all allocated stacks is the
-     same.  As the very least there are only a few different sizes.
-     Therefore this loop will exit early most of the time with an
-     exact match.  */
-  list_for_each (entry, &GL (dl_stack_cache))
-    {
-      struct pthread *curr;
-
-      curr = list_entry (entry, struct pthread, list);
-      if (__nptl_stack_in_use (curr) && curr->stackblock_size >= size)
-	{
-	  if (curr->stackblock_size == size)
-	    {
+     smallest stack which has at least the required size, starting
+     with the bucket for the size.  Note that in normal situations the
+     size of all allocated stacks is the same.  As the very least there
+     are only a few different sizes.  Therefore this loop will exit
+     early most of the time with an exact match.  Stacks in the buckets
+     after the next two are more than four times as large as needed, so
+     they are not used anyway (see below).  */
+  size_t bucket = __nptl_stack_cache_bucket (size);
+  for (size_t i = bucket;
+       result == NULL && i < DL_STACK_CACHE_BUCKETS && i <= bucket + 2; ++i)
+    list_for_each (entry, &GL (dl_stack_cache)[i])
+      {
+	struct pthread *curr;
+
+	curr = list_entry (entry, struct pthread, list);
+	if (__nptl_stack_in_use (curr) && curr->stackblock_size >= size)
+	  {
+	    if (curr->stackblock_size == size)
+	      {
+		result = curr;
+		break;
+	      }
+
+	    if (result == NULL
+		|| result->stackblock_size > curr->stackblock_size)
 	      result = curr;
-	      break;
-	    }
-
-	  if (result == NULL
-	      || result->stackblock_size > curr->stackblock_size)
-	    result = curr;
-	}
-    }
+	  }
+      }
 
   if (__builtin_expect (result == NULL, 0)
       /* Make sure the size difference is not too excessive.  In that
@@ -110,8 +115,11 @@ get_cached_stack (size_t *sizep, void **memp)
   /* And add to the list of stacks in use.  */
   __nptl_stack_list_add (&result->list, &GL (dl_stack_used));
 
-  /* And decrease the cache size.  */
+  /* And decrease the cache size.  The memory the previous thread used
+     is reused as it is.  */
   GL (dl_stack_cache_actsize) -= result->stackblock_size;
+  __nptl_stack_cache_resident -= result->stackblock_unadvised_size;
+  result->stackblock_unadvised_size = 0;
 
   /* Release the lock early.  */
   lll_unlock (GL (dl_stack_cache_lock), LLL_PRIVATE);
@@ -131,6 +139,7 @@ get_cached_stack (size_t *sizep, void **memp)
   result->exiting = false;
   __libc_lock_init (result->exit_lock);
   memset (&result->tls_state, 0, sizeof result->tls_state);
+  memset (result->rwlock_bias, 0, sizeof result->rwlock_bias);
 
   /* Clear the DTV.  */
   dtv_t *dtv = GET_DTV (TLS_TPADJ (result));
@@ -180,30 +189,47 @@ setup_stack_prot (char *mem, size_t size, char *guard, size_t guardsize,
   return 0;
 }
 
-/* Mark the memory of the stack as usable to the kernel.  It frees everything
-   except for the space used for the TCB itself.  */
+/* Mark the memory of the stack of the exiting thread PD as usable to the
+   kernel.  It frees everything except for the space used for the TCB
+   itself.  Unless glibc.pthread.stack_cache_resident_size is zero, the
+   memory is only recorded here, and returned to the kernel later if the
+   stack is not reused in the meantime (see nptl-stack.c).  */
 static __always_inline void
-advise_stack_range (void *mem, size_t size, uintptr_t pd, size_t guardsize)
+advise_stack_range (struct pthread *pd)
 {
+  void *mem = pd->stackblock;
+  size_t size = pd->stackblock_size;
   uintptr_t sp = (uintptr_t) CURRENT_STACK_FRAME;
   size_t pagesize_m1 = __getpagesize () - 1;
+  void *freeblock;
+  size_t freesize;
 #if _STACK_GROWS_DOWN
-  size_t freesize = (sp - (uintptr_t) mem) & ~pagesize_m1;
+  freesize = (sp - (uintptr_t) mem) & ~pagesize_m1;
   assert (freesize < size);
-  if (freesize > PTHREAD_STACK_MIN)
-    __madvise (mem, freesize - PTHREAD_STACK_MIN, MADV_DONTNEED);
+  if (freesize <= PTHREAD_STACK_MIN)
+    return;
+  freeblock = mem;
+  freesize -= PTHREAD_STACK_MIN;
 #else
   /* Page aligned start of memory to free (higher than or equal
      to current sp plus the minimum stack size).  */
-  uintptr_t freeblock = (sp + PTHREAD_STACK_MIN + pagesize_m1) & ~pagesize_m1;
-  uintptr_t free_end = (pd - guardsize) & ~pagesize_m1;
-  if (free_end > freeblock)
+  uintptr_t free_start = (sp + PTHREAD_STACK_MIN + pagesize_m1)
+			 & ~pagesize_m1;
+  uintptr_t free_end = ((uintptr_t) pd - pd->guardsize) & ~pagesize_m1;
+  if (free_end <= free_start)
+    return;
+  freeblock = (void *) free_start;
+  freesize = free_end - free_start;
+  assert (freesize < size);
+#endif
+
+  if (__nptl_stack_cache_resident_maxsize == 0)
+    __madvise (freeblock, freesize, MADV_DONTNEED);
+  else
     {
-      size_t freesize = free_end - freeblock;
-      assert (freesize < size);
-      __madvise ((void*) freeblock, freesize, MADV_DONTNEED);
+      pd->stackblock_unadvised = freeblock;
+      pd->stackblock_unadvised_size = freesize;
     }
-#endif
 }
 
 /* Returns a usable stack for a new thread either by allocating a
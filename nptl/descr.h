@@ -126,6 +126,22 @@ struct priority_protection_data
 };
 
 
+/* Number of PTHREAD_RWLOCK_READER_BIASED_NP rwlocks on which a thread
+   can hold read locks without registering in the rwlock.  */
+#define PTHREAD_RWLOCK_BIAS_SLOTS 4
+
+/* A read lock held without registering in the rwlock.  See
+   pthread_rwlock_bias.h.  */
+struct pthread_rwlock_bias_slot
+{
+  pthread_rwlock_t *lock;
+  unsigned int count;
+  /* Nonzero if a writer revoking the bias waits for LOCK to be
+     released.  */
+  unsigned int wake;
+};
+
+
 /* Thread descriptor data structure.  */
 struct pthread
 {
@@ -377,6 +393,11 @@ struct pthread
   size_t guardsize;
   /* This is what the user specified and what we will report.  */
   size_t reported_guardsize;
+  /* Part of the stackblock area which the thread no longer used when it
+     exited, and which has not been returned to the kernel yet.  Only
+     set while the stack is in the cache.  See nptl-stack.c.  */
+  void *stackblock_unadvised;
+  size_t stackblock_unadvised_size;
 
   /* Thread Priority Protection data.  */
   struct priority_protection_data *tpp;
@@ -401,19 +422,28 @@ struct pthread
   bool exiting;
   int exit_lock; /* A low-level lock (for use with __libc_lock_init etc).  */
 
+  /* Read locks on reader-biased rwlocks.  Only the thread itself changes
+     them, but writers revoking the bias read them.  */
+  struct pthread_rwlock_bias_slot rwlock_bias[PTHREAD_RWLOCK_BIAS_SLOTS];
+
   /* Used on strsignal.  */
   struct tls_internal_t tls_state;
 
   /* rseq area registered with the kernel.  Use a custom definition
      here to isolate from kernel struct rseq changes.  The
-     implementation of sched_getcpu needs acccess to the cpu_id field;
-     the other fields are unused and not included here.  */
+     implementation of sched_getcpu needs acccess to the cpu_id field,
+     and cohort mutexes to the node_id field, which the kernel only
+     updates since Linux 6.3 (see rseq_node_id_supported).  */
   union
   {
     struct
     {
       uint32_t cpu_id_start;
       uint32_t cpu_id;
+      uint64_t rseq_cs;
+      uint32_t flags;
+      uint32_t node_id;
+      uint32_t mm_cid;
     };
     char pad[32];		/* Original rseq area size.  */
   } rseq_area __attribute__ ((aligned (32)));
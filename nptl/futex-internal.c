@@ -141,6 +141,50 @@ __futex_abstimed_wait_cancelable64 (unsigned int* futex_word,
 }
 libc_hidden_def (__futex_abstimed_wait_cancelable64)
 
+int
+__futex_waitv_cancelable64 (struct futex_waitv_item *items,
+			    unsigned int nitems, clockid_t clockid,
+			    const struct __timespec64 *abstime)
+{
+  /* See __futex_abstimed_wait_common.  */
+  if (__glibc_unlikely ((abstime != NULL) && (abstime->tv_sec < 0)))
+    return ETIMEDOUT;
+
+  if (! lll_futex_supported_clockid (clockid))
+    return EINVAL;
+
+#ifdef __NR_futex_waitv
+  /* The system call only exists with a 64-bit timeout, and it always
+     takes an absolute one.  */
+  int err = INTERNAL_SYSCALL_CANCEL (futex_waitv, items, nitems, 0, abstime,
+				     clockid);
+#else
+  int err = -ENOSYS;
+#endif
+
+  /* On success, the index of the woken futex word is returned.  */
+  if (err >= 0)
+    return 0;
+
+  switch (err)
+    {
+    case -EAGAIN:
+    case -EINTR:
+    case -ETIMEDOUT:
+    case -ENOSYS:
+      return -err;
+
+    case -EINVAL: /* Due to wrong alignment, flags, or a number of futex
+		     words out of range.  Must have been caused by a glibc
+		     or application bug.  */
+    case -EFAULT: /* Must have been caused by a glibc or application bug.  */
+    /* No other errors are documented at this time.  */
+    default:
+      futex_fatal_error ();
+    }
+}
+libc_hidden_def (__futex_waitv_cancelable64)
+
 int
 __futex_lock_pi64 (int *futex_word, clockid_t clockid,
 		   const struct __timespec64 *abstime, int private)
@@ -41,7 +41,8 @@ MUTEX_TYPES = {
     PTHREAD_MUTEX_NORMAL: ('Type', 'Normal'),
     PTHREAD_MUTEX_RECURSIVE: ('Type', 'Recursive'),
     PTHREAD_MUTEX_ERRORCHECK: ('Type', 'Error check'),
-    PTHREAD_MUTEX_ADAPTIVE_NP: ('Type', 'Adaptive')
+    PTHREAD_MUTEX_ADAPTIVE_NP: ('Type', 'Adaptive'),
+    PTHREAD_MUTEX_COHORT_NP: ('Type', 'Cohort')
 }
 
 class MutexPrinter(object):
@@ -500,6 +501,8 @@ class RWLockPrinter(object):
             self.values.append(('Prefers', 'Readers'))
         elif self.flags == PTHREAD_RWLOCK_PREFER_WRITER_NP:
             self.values.append(('Prefers', 'Writers'))
+        elif self.flags == PTHREAD_RWLOCK_READER_BIASED_NP:
+            self.values.append(('Prefers', 'Reader-biased'))
         else:
             self.values.append(('Prefers', 'Writers no recursive readers'))
 
@@ -566,6 +569,8 @@ class RWLockAttributesPrinter(object):
             self.values.append(('Prefers', 'Readers'))
         elif rwlock_type == PTHREAD_RWLOCK_PREFER_WRITER_NP:
             self.values.append(('Prefers', 'Writers'))
+        elif rwlock_type == PTHREAD_RWLOCK_READER_BIASED_NP:
+            self.values.append(('Prefers', 'Reader-biased'))
         else:
             self.values.append(('Prefers', 'Writers no recursive readers'))
 
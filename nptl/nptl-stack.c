@@ -19,10 +19,33 @@
 #include <nptl-stack.h>
 #include <ldsodefs.h>
 #include <pthreadP.h>
+#include <sys/mman.h>
 
 size_t __nptl_stack_cache_maxsize = 40 * 1024 * 1024;
+size_t __nptl_stack_cache_resident_maxsize = 8 * 1024 * 1024;
+size_t __nptl_stack_cache_resident;
 int32_t __nptl_stack_hugetlb = 1;
 
+/* Thread-per-request servers create and destroy threads at high rates,
+   so the time spent with the stack cache lock held matters.  The cache
+   is split into buckets by size class, so that get_cached_stack usually
+   finds an exact match at the head of a bucket.  Stacks which are
+   removed from the cache are only unlinked under the lock; unmapping
+   them happens afterwards.
+
+   When a thread exits, it does not return the part of its stack it no
+   longer uses to the kernel, but records it in stackblock_unadvised and
+   stackblock_unadvised_size.  If a new thread reuses the stack soon,
+   this avoids both the madvise call and the page faults to map the
+   memory again.  Once more than __nptl_stack_cache_resident_maxsize
+   bytes are recorded for the cached stacks, the thread which adds a
+   stack to the cache returns the memory of the least recently cached
+   ones with MADV_DONTNEED, again without holding the lock.  */
+
+/* Maximum number of stacks whose memory is returned to the kernel by one
+   call to __nptl_deallocate_stack.  */
+#define ADVISE_BATCH 8
+
 void
 __nptl_stack_list_del (list_t *elem)
 {
@@ -53,63 +76,156 @@ __nptl_stack_list_add (list_t *elem, list_t *list)
 }
 libc_hidden_def (__nptl_stack_list_add)
 
-void
-__nptl_free_stacks (size_t limit)
+/* Move stacks from the cache to the list RELEASED until the cache size
+   is below LIMIT.  Larger stacks are removed first, and within a bucket
+   the least recently cached ones.  Must be called with the cache lock
+   held.  */
+static void
+unlink_stacks (size_t limit, list_t *released)
 {
-  /* We reduce the size of the cache.  Remove the last entries until
-     the size is below the limit.  */
-  list_t *entry;
-  list_t *prev;
-
-  /* Search from the end of the list.  */
-  list_for_each_prev_safe (entry, prev, &GL (dl_stack_cache))
+  for (size_t i = DL_STACK_CACHE_BUCKETS; i-- > 0; )
     {
-      struct pthread *curr;
+      list_t *entry;
+      list_t *prev;
 
-      curr = list_entry (entry, struct pthread, list);
-      if (__nptl_stack_in_use (curr))
+      /* Search from the end of the list.  */
+      list_for_each_prev_safe (entry, prev, &GL (dl_stack_cache)[i])
 	{
-	  /* Unlink the block.  */
-	  __nptl_stack_list_del (entry);
+	  struct pthread *curr;
 
-	  /* Account for the freed memory.  */
-	  GL (dl_stack_cache_actsize) -= curr->stackblock_size;
+	  curr = list_entry (entry, struct pthread, list);
+	  if (__nptl_stack_in_use (curr))
+	    {
+	      /* Unlink the block.  */
+	      __nptl_stack_list_del (entry);
+	      list_add (entry, released);
 
-	  /* Free the memory associated with the ELF TLS.  */
-	  _dl_deallocate_tls (TLS_TPADJ (curr), false);
+	      /* Account for the freed memory.  */
+	      GL (dl_stack_cache_actsize) -= curr->stackblock_size;
+	      __nptl_stack_cache_resident -= curr->stackblock_unadvised_size;
 
-	  /* Remove this block.  This should never fail.  If it does
-	     something is really wrong.  */
-	  if (__munmap (curr->stackblock, curr->stackblock_size) != 0)
-	    abort ();
-
-	  /* Maybe we have freed enough.  */
-	  if (GL (dl_stack_cache_actsize) <= limit)
-	    break;
+	      /* Maybe we have freed enough.  */
+	      if (GL (dl_stack_cache_actsize) <= limit)
+		return;
+	    }
 	}
     }
 }
 
-/* Add a stack frame which is not used anymore to the stack.  Must be
-   called with the cache lock held.  */
+/* Free the stacks on the list RELEASED.  */
+static void
+release_stacks (list_t *released)
+{
+  list_t *entry;
+  list_t *prev;
+
+  list_for_each_prev_safe (entry, prev, released)
+    {
+      struct pthread *curr = list_entry (entry, struct pthread, list);
+
+      /* Free the memory associated with the ELF TLS.  */
+      _dl_deallocate_tls (TLS_TPADJ (curr), false);
+
+      /* Remove this block.  This should never fail.  If it does
+	 something is really wrong.  */
+      if (__munmap (curr->stackblock, curr->stackblock_size) != 0)
+	abort ();
+    }
+}
+
+void
+__nptl_free_stacks (size_t limit)
+{
+  /* We reduce the size of the cache.  Remove the last entries until
+     the size is below the limit.  */
+  list_t released;
+  INIT_LIST_HEAD (&released);
+  unlink_stacks (limit, &released);
+  release_stacks (&released);
+}
+
+/* Add a stack frame which is not used anymore to the stack.  If the
+   cache grows too large, move stacks to RELEASED, which the caller has
+   to free after releasing the lock.  Must be called with the cache lock
+   held.  */
 static inline void
 __attribute ((always_inline))
-queue_stack (struct pthread *stack)
+queue_stack (struct pthread *stack, list_t *released)
 {
   /* We unconditionally add the stack to the list.  The memory may
      still be in use but it will not be reused until the kernel marks
      the stack as not used anymore.  */
-  __nptl_stack_list_add (&stack->list, &GL (dl_stack_cache));
+  __nptl_stack_list_add (&stack->list,
+			 &GL (dl_stack_cache)[__nptl_stack_cache_bucket
+					      (stack->stackblock_size)]);
 
   GL (dl_stack_cache_actsize) += stack->stackblock_size;
+  __nptl_stack_cache_resident += stack->stackblock_unadvised_size;
   if (__glibc_unlikely (GL (dl_stack_cache_actsize)
 			> __nptl_stack_cache_maxsize))
-    __nptl_free_stacks (__nptl_stack_cache_maxsize);
+    unlink_stacks (__nptl_stack_cache_maxsize, released);
+}
+
+/* Store up to ADVISE_BATCH of the least recently cached stacks with
+   unadvised memory in BATCH, until __nptl_stack_cache_resident is no
+   longer above its limit, and return their number.  The stacks stay in
+   the cache, but are marked with STACK_ADVISING_TID.  Must be called
+   with the cache lock held.  */
+static size_t
+select_stacks_to_advise (struct pthread **batch)
+{
+  size_t n = 0;
+
+  for (size_t i = DL_STACK_CACHE_BUCKETS; i-- > 0; )
+    {
+      list_t *entry;
+
+      list_for_each_prev (entry, &GL (dl_stack_cache)[i])
+	{
+	  if (n == ADVISE_BATCH
+	      || (__nptl_stack_cache_resident
+		  <= __nptl_stack_cache_resident_maxsize))
+	    return n;
+
+	  struct pthread *curr = list_entry (entry, struct pthread, list);
+	  if (curr->stackblock_unadvised_size != 0
+	      && __nptl_stack_in_use (curr))
+	    {
+	      curr->tid = STACK_ADVISING_TID;
+	      __nptl_stack_cache_resident -= curr->stackblock_unadvised_size;
+	      batch[n++] = curr;
+	    }
+	}
+    }
+  return n;
+}
+
+/* Return the unadvised memory of the N stacks in BATCH to the kernel,
+   and make the stacks available again.  */
+static void
+advise_stacks (struct pthread **batch, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+    __madvise (batch[i]->stackblock_unadvised,
+	       batch[i]->stackblock_unadvised_size, MADV_DONTNEED);
+
+  lll_lock (GL (dl_stack_cache_lock), LLL_PRIVATE);
+  for (size_t i = 0; i < n; ++i)
+    {
+      batch[i]->stackblock_unadvised_size = 0;
+      batch[i]->tid = 0;
+    }
+  lll_unlock (GL (dl_stack_cache_lock), LLL_PRIVATE);
 }
 
 void
 __nptl_deallocate_stack (struct pthread *pd)
 {
+  list_t released;
+  INIT_LIST_HEAD (&released);
+  struct pthread *batch[ADVISE_BATCH];
+  size_t nadvise = 0;
+
   lll_lock (GL (dl_stack_cache_lock), LLL_PRIVATE);
 
   /* Remove the thread from the list of threads with user defined
@@ -121,12 +237,25 @@ __nptl_deallocate_stack (struct pthread *pd)
      the kernel.  If no thread has been created yet this field is
      still zero.  */
   if (__glibc_likely (! pd->user_stack))
-    (void) queue_stack (pd);
+    {
+      queue_stack (pd, &released);
+      if (__glibc_unlikely (__nptl_stack_cache_resident
+			    > __nptl_stack_cache_resident_maxsize))
+	nadvise = select_stacks_to_advise (batch);
+    }
   else
     /* Free the memory associated with the ELF TLS.  */
     _dl_deallocate_tls (TLS_TPADJ (pd), false);
 
   lll_unlock (GL (dl_stack_cache_lock), LLL_PRIVATE);
+
+  /* The system calls for the removed stacks do not need the lock.  If
+     the process forks in the meantime, the child does not see the
+     stacks in RELEASED, and never reuses the ones in BATCH, which only
+     wastes memory.  */
+  release_stacks (&released);
+  if (nadvise > 0)
+    advise_stacks (batch, nadvise);
 }
 libc_hidden_def (__nptl_deallocate_stack)
 
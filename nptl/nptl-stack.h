@@ -27,6 +27,15 @@
 /* Maximum size of the cache, in bytes.  40 MiB by default.  */
 extern size_t __nptl_stack_cache_maxsize attribute_hidden;
 
+/* Maximum size of the memory that exited threads used in cached stacks
+   which has not been returned to the kernel, in bytes.  8 MiB by
+   default.  */
+extern size_t __nptl_stack_cache_resident_maxsize attribute_hidden;
+
+/* Size of that memory (sum over stackblock_unadvised_size of the cached
+   stacks).  Protected by the stack cache lock.  */
+extern size_t __nptl_stack_cache_resident attribute_hidden;
+
 /* Should allow stacks to use hugetlb. (1) is default.  */
 extern int32_t __nptl_stack_hugetlb;
 
@@ -37,12 +46,33 @@ __nptl_stack_in_use (struct pthread *pd)
   return pd->tid <= 0;
 }
 
+/* Value of the tid field of a cached stack whose memory is being
+   returned to the kernel without holding the stack cache lock, so that
+   the stack is neither reused nor freed in the meantime.  No thread with
+   a stack allocated by glibc can have this TID.  */
+#define STACK_ADVISING_TID 1
+
+/* Return the index of the stack cache bucket for stacks of SIZE bytes.
+   Bucket I holds stacks of at least 2^(I+14) and less than 2^(I+15)
+   bytes, except that the first bucket also holds smaller stacks, and the
+   last bucket also holds larger ones.  */
+static inline size_t
+__nptl_stack_cache_bucket (size_t size)
+{
+  int log2 = 63 - __builtin_clzll ((unsigned long long int) size | 1);
+  if (log2 <= 14)
+    return 0;
+  if (log2 - 14 >= DL_STACK_CACHE_BUCKETS)
+    return DL_STACK_CACHE_BUCKETS - 1;
+  return log2 - 14;
+}
+
 /* Remove the stack ELEM from its list.  */
 void __nptl_stack_list_del (list_t *elem);
 libc_hidden_proto (__nptl_stack_list_del)
 
 /* Add ELEM to a stack list.  LIST can be either &GL (dl_stack_used)
-   or &GL (dl_stack_cache).  */
+   or one of the buckets in GL (dl_stack_cache).  */
 void __nptl_stack_list_add (list_t *elem, list_t *list);
 libc_hidden_proto (__nptl_stack_list_add)
 
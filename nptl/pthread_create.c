@@ -550,8 +550,7 @@ start_thread (void *arg)
 #endif
 
   if (!pd->user_stack)
-    advise_stack_range (pd->stackblock, pd->stackblock_size, (uintptr_t) pd,
-			pd->guardsize);
+    advise_stack_range (pd);
 
   if (__glibc_unlikely (pd->cancelhandling & SETXID_BITMASK))
     {
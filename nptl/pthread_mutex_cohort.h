@@ -0,0 +1,154 @@
+/* NUMA-aware lock handoff for PTHREAD_MUTEX_COHORT_NP mutexes.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _PTHREAD_MUTEX_COHORT_H
+#define _PTHREAD_MUTEX_COHORT_H 1
+
+#include <atomic.h>
+#include <pthreadP.h>
+#include <rseq-internal.h>
+#include <sched.h>
+
+/* A cohort mutex uses the same lock word and futex protocol as a
+   normal mutex.  In addition, threads which spin waiting for the lock
+   announce their NUMA node (their cohort) in the __count field, which
+   is otherwise unused for non-recursive mutexes.  When the lock is
+   released while a thread of the releasing cohort is spinning, the
+   lock is reserved for that cohort: spinning threads of other cohorts
+   do not try to acquire the free lock until they have exhausted their
+   spin count.  After glibc.pthread.mutex_cohort_passes consecutive
+   reservations for one cohort, the lock is reserved for the next
+   cohort with spinning threads instead, so that the cache lines
+   protected by the mutex move between nodes only once per batch of
+   critical sections.
+
+   Reservations are only a hint.  Threads blocked on the futex, trylock,
+   and threads which have spun for too long acquire the lock as for a
+   normal mutex, so the mutual exclusion and wakeup guarantees do not
+   depend on the cohort state.
+
+   Layout of the __count field:
+     bits 0-7    cohort for which the free lock is reserved, plus one,
+                 or 0 if it is not reserved
+     bits 8-15   consecutive reservations for that cohort
+     bits 16-31  one bit per cohort with spinning threads
+
+   Nodes with the same number modulo COHORT_MAX share a cohort.  */
+
+#define COHORT_MAX 16
+#define COHORT_NODE_MASK 0xffu
+#define COHORT_PASSES_SHIFT 8
+#define COHORT_PASSES_MASK 0xff00u
+#define COHORT_SPINNERS_SHIFT 16
+
+/* Return the cohort of the calling thread, plus one.  This is called
+   on every contended acquisition and release, so the node is read from
+   the rseq area if possible, instead of calling getcpu.  */
+static inline unsigned int
+cohort_self (void)
+{
+  unsigned int node;
+  if (__glibc_likely (__mutex_aconf.cohort_rseq_node)
+      && __glibc_likely ((int) RSEQ_GETMEM_ONCE (cpu_id) >= 0))
+    node = RSEQ_GETMEM_ONCE (node_id);
+  else
+    {
+      unsigned int cpu;
+      if (__getcpu (&cpu, &node) != 0)
+	return 1;
+    }
+  return node % COHORT_MAX + 1;
+}
+
+static inline unsigned int
+cohort_spinner_bit (unsigned int cohort)
+{
+  return 1u << (COHORT_SPINNERS_SHIFT + cohort - 1);
+}
+
+/* Return true if a thread of COHORT may try to acquire the free lock of
+   MUTEX.  A COHORT of 0 only acquires locks without a reservation.  */
+static inline bool
+cohort_may_acquire (pthread_mutex_t *mutex, unsigned int cohort)
+{
+  unsigned int reserved
+    = atomic_load_relaxed (&mutex->__data.__count) & COHORT_NODE_MASK;
+  return reserved == 0 || reserved == cohort;
+}
+
+/* Announce that a thread of COHORT spins waiting for MUTEX.  */
+static inline void
+cohort_announce (pthread_mutex_t *mutex, unsigned int cohort)
+{
+  unsigned int bit = cohort_spinner_bit (cohort);
+  if (__mutex_aconf.cohort_passes > 0
+      && (atomic_load_relaxed (&mutex->__data.__count) & bit) == 0)
+    atomic_fetch_or_relaxed (&mutex->__data.__count, bit);
+}
+
+/* Called after a thread of COHORT which has spun acquired MUTEX.  The
+   other spinning threads of COHORT announce themselves again.  */
+static inline void
+cohort_acquired (pthread_mutex_t *mutex, unsigned int cohort)
+{
+  unsigned int bit = cohort_spinner_bit (cohort);
+  if ((atomic_load_relaxed (&mutex->__data.__count) & bit) != 0)
+    atomic_fetch_and_relaxed (&mutex->__data.__count, ~bit);
+}
+
+/* Choose the cohort for which MUTEX is reserved once the calling
+   thread releases it.  Must be called before the lock word is
+   released.  */
+static inline void
+cohort_release (pthread_mutex_t *mutex)
+{
+  unsigned int old = atomic_load_relaxed (&mutex->__data.__count);
+  if (old == 0)
+    /* No thread has spun since the lock was last released.  */
+    return;
+
+  unsigned int max_passes = __mutex_aconf.cohort_passes;
+  unsigned int self = cohort_self ();
+  unsigned int new;
+  do
+    {
+      unsigned int spinners = old >> COHORT_SPINNERS_SHIFT;
+      unsigned int reserved = old & COHORT_NODE_MASK;
+      unsigned int passes = ((old & COHORT_PASSES_MASK)
+			     >> COHORT_PASSES_SHIFT);
+      unsigned int next_passes = reserved == self ? passes + 1 : 1;
+      new = old & ~(COHORT_NODE_MASK | COHORT_PASSES_MASK);
+      if ((spinners & (1u << (self - 1))) != 0 && next_passes <= max_passes)
+	/* Keep the lock within the cohort.  */
+	new = ((new & ~cohort_spinner_bit (self)) | self
+	       | (next_passes << COHORT_PASSES_SHIFT));
+      else if ((spinners & ~(1u << (self - 1))) != 0)
+	{
+	  /* Pass the lock to the next cohort with spinning threads.  */
+	  unsigned int next = self;
+	  do
+	    next = next % COHORT_MAX + 1;
+	  while ((spinners & (1u << (next - 1))) == 0);
+	  new = (new & ~cohort_spinner_bit (next)) | next;
+	}
+    }
+  while (!atomic_compare_exchange_weak_relaxed (&mutex->__data.__count,
+						&old, new));
+}
+
+#endif /* pthread_mutex_cohort.h */
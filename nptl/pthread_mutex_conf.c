@@ -29,6 +29,7 @@ struct mutex_config __mutex_aconf =
   /* The maximum number of times a thread should spin on the lock before
   calling into kernel to block.  */
   .spin_count = DEFAULT_ADAPTIVE_COUNT,
+  .cohort_passes = 64,
 };
 libc_hidden_data_def (__mutex_aconf)
 
@@ -38,12 +39,24 @@ TUNABLE_CALLBACK (set_mutex_spin_count) (tunable_val_t *valp)
   __mutex_aconf.spin_count = (int32_t) (valp)->numval;
 }
 
+static void
+TUNABLE_CALLBACK (set_mutex_cohort_passes) (tunable_val_t *valp)
+{
+  __mutex_aconf.cohort_passes = (int32_t) (valp)->numval;
+}
+
 static void
 TUNABLE_CALLBACK (set_stack_cache_size) (tunable_val_t *valp)
 {
   __nptl_stack_cache_maxsize = valp->numval;
 }
 
+static void
+TUNABLE_CALLBACK (set_stack_cache_resident_size) (tunable_val_t *valp)
+{
+  __nptl_stack_cache_resident_maxsize = valp->numval;
+}
+
 static void
 TUNABLE_CALLBACK (set_stack_hugetlb) (tunable_val_t *valp)
 {
@@ -55,8 +68,12 @@ __pthread_tunables_init (void)
 {
   TUNABLE_GET (mutex_spin_count, int32_t,
                TUNABLE_CALLBACK (set_mutex_spin_count));
+  TUNABLE_GET (mutex_cohort_passes, int32_t,
+               TUNABLE_CALLBACK (set_mutex_cohort_passes));
   TUNABLE_GET (stack_cache_size, size_t,
                TUNABLE_CALLBACK (set_stack_cache_size));
+  TUNABLE_GET (stack_cache_resident_size, size_t,
+               TUNABLE_CALLBACK (set_stack_cache_resident_size));
   TUNABLE_GET (stack_hugetlb, int32_t,
 	       TUNABLE_CALLBACK (set_stack_hugetlb));
 }
@@ -85,6 +85,13 @@ ___pthread_mutex_init (pthread_mutex_t *mutex,
       break;
     }
 
+  /* Cohort mutexes only implement the normal lock protocol.  */
+  if ((imutexattr->mutexkind & ~PTHREAD_MUTEXATTR_FLAG_BITS
+       & PTHREAD_MUTEX_KIND_MASK_NP) == PTHREAD_MUTEX_COHORT_NP
+      && (imutexattr->mutexkind & (PTHREAD_MUTEXATTR_FLAG_ROBUST
+				   | PTHREAD_MUTEXATTR_PROTOCOL_MASK)) != 0)
+    return ENOTSUP;
+
   /* Clear the whole variable.  */
   memset (mutex, '\0', __SIZEOF_PTHREAD_MUTEX_T);
 
@@ -24,6 +24,7 @@
 #include "pthreadP.h"
 #include <atomic.h>
 #include <futex-internal.h>
+#include <pthread_mutex_cohort.h>
 #include <stap-probe.h>
 #include <shlib-compat.h>
 
@@ -166,6 +167,35 @@ PTHREAD_MUTEX_LOCK (pthread_mutex_t *mutex)
 	}
       assert (mutex->__data.__owner == 0);
     }
+  else if (__builtin_expect (PTHREAD_MUTEX_TYPE (mutex)
+			     == PTHREAD_MUTEX_COHORT_NP, 1))
+    {
+      /* A free lock which is reserved for some cohort is not acquired
+	 before the cohort of the calling thread is known.  */
+      if (!cohort_may_acquire (mutex, 0) || LLL_MUTEX_TRYLOCK (mutex) != 0)
+	{
+	  unsigned int cohort = cohort_self ();
+	  int cnt = 0;
+	  int max_cnt = max_adaptive_count ();
+	  do
+	    {
+	      if (cnt++ >= max_cnt)
+		{
+		  /* Ignore the reservation and wait on the futex.  */
+		  LLL_MUTEX_LOCK (mutex);
+		  break;
+		}
+	      cohort_announce (mutex, cohort);
+	      atomic_spin_nop ();
+	    }
+	  while (LLL_MUTEX_READ_LOCK (mutex) != 0
+		 || !cohort_may_acquire (mutex, cohort)
+		 || LLL_MUTEX_TRYLOCK (mutex) != 0);
+
+	  cohort_acquired (mutex, cohort);
+	}
+      assert (mutex->__data.__owner == 0);
+    }
   else
     {
       pid_t id = THREAD_GETMEM (THREAD_SELF, tid);
@@ -25,6 +25,7 @@
 #include <lowlevellock.h>
 #include <not-cancel.h>
 #include <futex-internal.h>
+#include <pthread_mutex_cohort.h>
 
 #include <stap-probe.h>
 
@@ -121,6 +122,34 @@ __pthread_mutex_clocklock_common (pthread_mutex_t *mutex,
 	}
       break;
 
+    case PTHREAD_MUTEX_COHORT_NP:
+      if (!cohort_may_acquire (mutex, 0)
+	  || lll_trylock (mutex->__data.__lock) != 0)
+	{
+	  unsigned int cohort = cohort_self ();
+	  int cnt = 0;
+	  int max_cnt = max_adaptive_count ();
+	  do
+	    {
+	      if (cnt++ >= max_cnt)
+		{
+		  result = __futex_clocklock64 (&mutex->__data.__lock,
+						clockid, abstime,
+						PTHREAD_MUTEX_PSHARED (mutex));
+		  break;
+		}
+	      cohort_announce (mutex, cohort);
+	      atomic_spin_nop ();
+	    }
+	  while (atomic_load_relaxed (&mutex->__data.__lock) != 0
+		 || !cohort_may_acquire (mutex, cohort)
+		 || lll_trylock (mutex->__data.__lock) != 0);
+
+	  if (result == 0)
+	    cohort_acquired (mutex, cohort);
+	}
+      break;
+
     case PTHREAD_MUTEX_ROBUST_RECURSIVE_NP:
     case PTHREAD_MUTEX_ROBUST_ERRORCHECK_NP:
     case PTHREAD_MUTEX_ROBUST_NORMAL_NP:
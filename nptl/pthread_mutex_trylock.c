@@ -71,6 +71,8 @@ ___pthread_mutex_trylock (pthread_mutex_t *mutex)
       /*FALL THROUGH*/
     case PTHREAD_MUTEX_ADAPTIVE_NP:
     case PTHREAD_MUTEX_ERRORCHECK_NP:
+    /* Cohort reservations do not apply to trylock.  */
+    case PTHREAD_MUTEX_COHORT_NP:
       if (lll_trylock (mutex->__data.__lock) != 0)
 	break;
 
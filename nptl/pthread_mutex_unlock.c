@@ -22,6 +22,7 @@
 #include <lowlevellock.h>
 #include <stap-probe.h>
 #include <futex-internal.h>
+#include <pthread_mutex_cohort.h>
 #include <shlib-compat.h>
 
 static int
@@ -92,6 +93,12 @@ __pthread_mutex_unlock_usercnt (pthread_mutex_t *mutex, int decr)
   else if (__builtin_expect (PTHREAD_MUTEX_TYPE (mutex)
 			      == PTHREAD_MUTEX_ADAPTIVE_NP, 1))
     goto normal;
+  else if (__builtin_expect (PTHREAD_MUTEX_TYPE (mutex)
+			      == PTHREAD_MUTEX_COHORT_NP, 1))
+    {
+      cohort_release (mutex);
+      goto normal;
+    }
   else
     {
       /* Error checking mutex.  */
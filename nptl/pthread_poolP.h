@@ -0,0 +1,259 @@
+/* Internal definitions for pthread_pool_np thread pools.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _PTHREAD_POOLP_H
+#define _PTHREAD_POOLP_H 1
+
+#include <atomic.h>
+#include <futex-internal.h>
+#include <lowlevellock.h>
+#include <pthreadP.h>
+#include <stdbool.h>
+
+/* A pool consists of NWORKERS worker threads, each of which owns a
+   work-stealing deque as described by Chase and Lev ("Dynamic Circular
+   Work-Stealing Deque", SPAA 2005), in the C11 formulation of Lê et al.
+   ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP
+   2013).  A task submitted by a worker is pushed to the bottom of its
+   own deque, and the worker pops tasks from the bottom again, so
+   fork-join code runs depth-first and without contention.  Idle workers
+   steal from the top of the deques of other workers, starting at a
+   random victim.  The deques have a fixed size; if a deque is full, the
+   submitting worker runs the task itself.
+
+   Threads which are not workers of the pool submit tasks to the
+   injection queue of the pool, a ring buffer protected by a lock which
+   grows as needed.  Workers take tasks from it after their own deque
+   and before stealing.
+
+   A worker which finds no task spins for a while, then sleeps on the
+   SLEEP_SEQ futex.  It loads SLEEP_SEQ, increments NSLEEPING and looks
+   for tasks once more before it waits, and a submitter increments
+   SLEEP_SEQ and wakes a worker if NSLEEPING is nonzero after it has
+   made its task visible.  The loads of the queues and of NSLEEPING are
+   separated from the preceding stores by seq_cst fences, so either the
+   worker sees the task or the submitter sees the sleeping worker.
+
+   A pthread_pool_group_np_t counts the tasks in the group which have not
+   finished yet in __pending.  Threads waiting for the count to reach
+   zero set POOL_GROUP_WAITERS in it before they block on it.  The
+   worker finishing the last task clears the count and the flag in the
+   same atomic operation and does not access the group afterwards except
+   for the futex wake-up, so the group may be reused or deallocated as
+   soon as a waiter has returned.  A worker of the pool waiting for a
+   group runs other tasks in the meantime, so nested fork-join code does
+   not run out of workers.  */
+
+/* The number of tasks in a worker deque.  Must be a power of two.  */
+#define POOL_DEQUE_SIZE 256
+
+/* The number of times a worker looks for tasks before it sleeps.  */
+#define POOL_SPIN_COUNT 100
+
+/* The initial size of the injection queue.  Must be a power of two.  */
+#define POOL_INJECT_SIZE 64
+
+/* Set in the __pending field of a group while threads wait for it.  */
+#define POOL_GROUP_WAITERS 0x80000000U
+
+#define POOL_CACHE_LINE 64
+
+struct pthread_pool_task
+{
+  void (*func) (void *);
+  void *arg;
+  pthread_pool_group_np_t *group;
+};
+
+/* TOP and BOTTOM are indices into TASKS modulo POOL_DEQUE_SIZE which wrap
+   around, so they are only compared through their difference.  The
+   fields of the tasks are accessed atomically because a thief may read a
+   task which the owner overwrites concurrently; the thief then fails to
+   update TOP and discards what it has read.  */
+struct pthread_pool_deque
+{
+  unsigned int top __attribute__ ((aligned (POOL_CACHE_LINE)));
+  unsigned int bottom __attribute__ ((aligned (POOL_CACHE_LINE)));
+  struct pthread_pool_task tasks[POOL_DEQUE_SIZE];
+};
+
+struct pthread_pool_worker
+{
+  struct pthread_pool_deque deque;
+  struct pthread_pool_np *pool;
+  pthread_t thread;
+  /* State of the random number generator for the choice of victims.  */
+  unsigned int random;
+} __attribute__ ((aligned (POOL_CACHE_LINE)));
+
+struct pthread_pool_np
+{
+  unsigned int nworkers;
+  /* Nonzero once pthread_pool_destroy_np has been called.  */
+  unsigned int shutdown;
+  /* Nonzero for the pool returned by pthread_pool_default_np.  */
+  bool is_default;
+  /* The value of __fork_generation when the pool was created.  The
+     workers do not exist in a subprocess created by fork.  */
+  unsigned long int fork_generation;
+
+  /* Futex on which idle workers sleep, and the number of sleepers.  */
+  unsigned int sleep_seq __attribute__ ((aligned (POOL_CACHE_LINE)));
+  unsigned int nsleeping;
+
+  /* The injection queue.  INJECT_COUNT is also read without the lock to
+     check whether the queue is empty.  */
+  int inject_lock __attribute__ ((aligned (POOL_CACHE_LINE)));
+  unsigned int inject_count;
+  unsigned int inject_head;
+  unsigned int inject_size;
+  struct pthread_pool_task *inject;
+
+  /* Array of NWORKERS workers, and the allocation containing it.  */
+  struct pthread_pool_worker *workers;
+  void *workers_mem;
+};
+
+/* The worker running on the calling thread, or NULL.  */
+extern __thread struct pthread_pool_worker *__pthread_pool_self
+  attribute_hidden attribute_tls_model_ie;
+
+/* Push TASK to the bottom of DEQUE.  Must only be called by the owner of
+   DEQUE.  Return false if DEQUE is full.  */
+static inline bool
+__pthread_pool_deque_push (struct pthread_pool_deque *deque,
+			   const struct pthread_pool_task *task)
+{
+  unsigned int b = atomic_load_relaxed (&deque->bottom);
+  unsigned int t = atomic_load_acquire (&deque->top);
+  if (b - t >= POOL_DEQUE_SIZE)
+    return false;
+  struct pthread_pool_task *slot = &deque->tasks[b % POOL_DEQUE_SIZE];
+  atomic_store_relaxed (&slot->func, task->func);
+  atomic_store_relaxed (&slot->arg, task->arg);
+  atomic_store_relaxed (&slot->group, task->group);
+  /* Release MO so that thieves which see the new bottom see the task.  */
+  atomic_store_release (&deque->bottom, b + 1);
+  return true;
+}
+
+/* Pop a task from the bottom of DEQUE into *TASK.  Must only be called by
+   the owner of DEQUE.  Return false if DEQUE is empty.  */
+static inline bool
+__pthread_pool_deque_pop (struct pthread_pool_deque *deque,
+			  struct pthread_pool_task *task)
+{
+  unsigned int b = atomic_load_relaxed (&deque->bottom) - 1;
+  atomic_store_relaxed (&deque->bottom, b);
+  /* Thieves must see the decremented bottom before we load top, so that
+     a thief and the owner cannot both take the last task.  */
+  atomic_thread_fence_seq_cst ();
+  unsigned int t = atomic_load_relaxed (&deque->top);
+  if ((int) (b - t) < 0)
+    {
+      /* Empty.  */
+      atomic_store_relaxed (&deque->bottom, b + 1);
+      return false;
+    }
+  struct pthread_pool_task *slot = &deque->tasks[b % POOL_DEQUE_SIZE];
+  task->func = atomic_load_relaxed (&slot->func);
+  task->arg = atomic_load_relaxed (&slot->arg);
+  task->group = atomic_load_relaxed (&slot->group);
+  if (b != t)
+    /* More than one task was left, so no thief can take this one.  */
+    return true;
+  /* This is the last task.  Race against thieves for it.  As in the
+     formulation of Lê et al., the CAS is seq_cst; it pairs with the CAS
+     in __pthread_pool_deque_steal.  */
+  bool taken = atomic_compare_exchange_weak_seq_cst (&deque->top, &t, t + 1);
+  while (!taken && t == b)
+    /* A spurious failure.  */
+    taken = atomic_compare_exchange_weak_seq_cst (&deque->top, &t, t + 1);
+  atomic_store_relaxed (&deque->bottom, b + 1);
+  return taken;
+}
+
+enum pthread_pool_steal_result
+{
+  POOL_STEAL_EMPTY,
+  POOL_STEAL_SUCCESS,
+  /* Another thread took the task we tried to steal.  */
+  POOL_STEAL_ABORT
+};
+
+/* Take a task from the top of DEQUE into *TASK.  May be called by any
+   thread.  */
+static inline enum pthread_pool_steal_result
+__pthread_pool_deque_steal (struct pthread_pool_deque *deque,
+			    struct pthread_pool_task *task)
+{
+  unsigned int t = atomic_load_acquire (&deque->top);
+  atomic_thread_fence_seq_cst ();
+  unsigned int b = atomic_load_acquire (&deque->bottom);
+  if ((int) (b - t) <= 0)
+    return POOL_STEAL_EMPTY;
+  struct pthread_pool_task *slot = &deque->tasks[t % POOL_DEQUE_SIZE];
+  task->func = atomic_load_relaxed (&slot->func);
+  task->arg = atomic_load_relaxed (&slot->arg);
+  task->group = atomic_load_relaxed (&slot->group);
+  /* The acquire load of bottom synchronized with the push of the task,
+     so we see its fields.  The CAS needs release MO (and is seq_cst as
+     in the formulation of Lê et al.) so that our loads of the task
+     happen before the owner reuses the slot: the owner's acquire load
+     of top in __pthread_pool_deque_push synchronizes with it.
+     Otherwise, on weakly ordered targets, the loads could be satisfied
+     after the CAS and return a task the owner is overwriting.  */
+  if (!atomic_compare_exchange_weak_seq_cst (&deque->top, &t, t + 1))
+    return POOL_STEAL_ABORT;
+  return POOL_STEAL_SUCCESS;
+}
+
+/* Look for a task for SELF, a worker of POOL, and store it in *TASK.
+   Return false if there is none.  */
+extern bool __pthread_pool_find_task (struct pthread_pool_np *pool,
+				      struct pthread_pool_worker *self,
+				      struct pthread_pool_task *task)
+  attribute_hidden;
+
+/* Remove a finished task from GROUP, and wake up the waiters if it was
+   the last one.  */
+extern void __pthread_pool_group_finish (pthread_pool_group_np_t *group)
+  attribute_hidden;
+
+/* Run TASK and update its group.  */
+extern void __pthread_pool_run_task (const struct pthread_pool_task *task)
+  attribute_hidden;
+
+/* Wake up a sleeping worker of POOL, if there is one, after a task has
+   been made visible to the workers.  */
+extern void __pthread_pool_wake (struct pthread_pool_np *pool)
+  attribute_hidden;
+
+/* Return the number of workers for a pool sized to the CPUs the process
+   may use.  */
+extern unsigned int __pthread_pool_default_size (void) attribute_hidden;
+
+/* Terminate the workers of POOL and deallocate it.  */
+extern void __pthread_pool_free (struct pthread_pool_np *pool)
+  attribute_hidden;
+
+extern int __pthread_pool_create_np (pthread_pool_np_t **pool,
+				     unsigned int nworkers);
+libc_hidden_proto (__pthread_pool_create_np)
+
+#endif /* pthread_poolP.h */
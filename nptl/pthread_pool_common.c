@@ -0,0 +1,146 @@
+/* Task scheduling for pthread_pool_np thread pools.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <limits.h>
+#include "pthread_poolP.h"
+
+__thread struct pthread_pool_worker *__pthread_pool_self;
+
+/* Take the oldest task from the injection queue of POOL.  */
+static bool
+inject_take (struct pthread_pool_np *pool, struct pthread_pool_task *task)
+{
+  if (atomic_load_relaxed (&pool->inject_count) == 0)
+    return false;
+  bool found = false;
+  lll_lock (pool->inject_lock, LLL_PRIVATE);
+  if (pool->inject_count > 0)
+    {
+      *task = pool->inject[pool->inject_head];
+      pool->inject_head = (pool->inject_head + 1) & (pool->inject_size - 1);
+      atomic_store_relaxed (&pool->inject_count, pool->inject_count - 1);
+      found = true;
+    }
+  lll_unlock (pool->inject_lock, LLL_PRIVATE);
+  return found;
+}
+
+bool
+__pthread_pool_find_task (struct pthread_pool_np *pool,
+			  struct pthread_pool_worker *self,
+			  struct pthread_pool_task *task)
+{
+  if (__pthread_pool_deque_pop (&self->deque, task))
+    return true;
+  if (inject_take (pool, task))
+    return true;
+
+  unsigned int n = pool->nworkers;
+  if (n == 1)
+    return false;
+  /* Start at a random victim so that thieves do not all go for the
+     same deque.  */
+  self->random = self->random * 1103515245 + 12345;
+  unsigned int start = (self->random >> 16) % n;
+  bool retry;
+  do
+    {
+      retry = false;
+      for (unsigned int i = 0; i < n; ++i)
+	{
+	  struct pthread_pool_worker *victim = &pool->workers[(start + i) % n];
+	  if (victim == self)
+	    continue;
+	  switch (__pthread_pool_deque_steal (&victim->deque, task))
+	    {
+	    case POOL_STEAL_SUCCESS:
+	      return true;
+	    case POOL_STEAL_ABORT:
+	      /* The deque was not empty, so look again.  */
+	      retry = true;
+	      break;
+	    case POOL_STEAL_EMPTY:
+	      break;
+	    }
+	}
+    }
+  while (retry);
+  return false;
+}
+
+void
+__pthread_pool_group_finish (pthread_pool_group_np_t *group)
+{
+  /* Release MO so that a waiter which sees the count reach zero
+     synchronizes with the task.  The last task clears
+     POOL_GROUP_WAITERS too, and must not access the group afterwards
+     (see pthread_poolP.h).  */
+  unsigned int pending = atomic_load_relaxed (&group->__pending);
+  unsigned int new_pending;
+  do
+    {
+      new_pending = pending - 1;
+      if ((new_pending & ~POOL_GROUP_WAITERS) == 0)
+	new_pending = 0;
+    }
+  while (!atomic_compare_exchange_weak_release (&group->__pending,
+						&pending, new_pending));
+  if (new_pending == 0 && (pending & POOL_GROUP_WAITERS) != 0)
+    futex_wake (&group->__pending, INT_MAX, FUTEX_PRIVATE);
+}
+
+void
+__pthread_pool_run_task (const struct pthread_pool_task *task)
+{
+  pthread_pool_group_np_t *group = task->group;
+  task->func (task->arg);
+  if (group != NULL)
+    __pthread_pool_group_finish (group);
+}
+
+void
+__pthread_pool_wake (struct pthread_pool_np *pool)
+{
+  /* Pairs with the fence in worker_sleep in pthread_pool_create.c.  */
+  atomic_thread_fence_seq_cst ();
+  if (atomic_load_relaxed (&pool->nsleeping) > 0)
+    {
+      atomic_fetch_add_release (&pool->sleep_seq, 1);
+      futex_wake (&pool->sleep_seq, 1, FUTEX_PRIVATE);
+    }
+}
+
+void
+__pthread_pool_free (struct pthread_pool_np *pool)
+{
+  atomic_store_release (&pool->shutdown, 1);
+  /* Release MO so that workers which see the new SLEEP_SEQ see
+     SHUTDOWN.  */
+  atomic_fetch_add_release (&pool->sleep_seq, 1);
+  futex_wake (&pool->sleep_seq, INT_MAX, FUTEX_PRIVATE);
+
+  /* In a subprocess created by fork, the workers do not exist.  */
+  if (pool->fork_generation == __fork_generation)
+    for (unsigned int i = 0; i < pool->nworkers; ++i)
+      if (pool->workers[i].thread != 0)
+	__pthread_join (pool->workers[i].thread, NULL);
+
+  free (pool->inject);
+  free (pool->workers_mem);
+  free (pool);
+}
@@ -0,0 +1,141 @@
+/* Create a pthread_pool_np thread pool.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <libc-pointer-arith.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pthread_poolP.h"
+
+/* Wait until a task may be available for SELF, or the pool is shut
+   down.  Return true if a task was found and stored in *TASK.  */
+static bool
+worker_sleep (struct pthread_pool_np *pool, struct pthread_pool_worker *self,
+	      struct pthread_pool_task *task)
+{
+  /* Acquire MO so that the increment of NSLEEPING is not reordered
+     before the load, which would allow us to miss a wake-up.  */
+  unsigned int seq = atomic_load_acquire (&pool->sleep_seq);
+  atomic_fetch_add_relaxed (&pool->nsleeping, 1);
+  /* Pairs with the fence in __pthread_pool_wake.  */
+  atomic_thread_fence_seq_cst ();
+  bool found = __pthread_pool_find_task (pool, self, task);
+  if (!found && atomic_load_relaxed (&pool->shutdown) == 0)
+    futex_wait_simple (&pool->sleep_seq, seq, FUTEX_PRIVATE);
+  atomic_fetch_add_relaxed (&pool->nsleeping, -1);
+  return found;
+}
+
+static void *
+worker_start (void *closure)
+{
+  struct pthread_pool_worker *self = closure;
+  struct pthread_pool_np *pool = self->pool;
+  __pthread_pool_self = self;
+
+  struct pthread_pool_task task;
+  unsigned int spins = 0;
+  while (true)
+    {
+      /* Acquire MO so that we see the tasks submitted before the pool
+	 was destroyed.  */
+      bool shutdown = atomic_load_acquire (&pool->shutdown) != 0;
+      if (__pthread_pool_find_task (pool, self, &task)
+	  || (!shutdown && spins >= POOL_SPIN_COUNT
+	      && worker_sleep (pool, self, &task)))
+	{
+	  __pthread_pool_run_task (&task);
+	  spins = 0;
+	  continue;
+	}
+      if (shutdown)
+	break;
+      if (spins < POOL_SPIN_COUNT)
+	{
+	  ++spins;
+	  atomic_spin_nop ();
+	}
+    }
+  return NULL;
+}
+
+int
+__pthread_pool_create_np (pthread_pool_np_t **poolp, unsigned int nworkers)
+{
+  if (nworkers == 0)
+    nworkers = __pthread_pool_default_size ();
+  if (nworkers > INT_MAX / sizeof (struct pthread_pool_worker))
+    return EINVAL;
+
+  struct pthread_pool_np *pool = calloc (1, sizeof (*pool));
+  if (pool == NULL)
+    return ENOMEM;
+  pool->nworkers = nworkers;
+  pool->fork_generation = __fork_generation;
+  pool->inject_lock = LLL_LOCK_INITIALIZER;
+  pool->inject_size = POOL_INJECT_SIZE;
+  pool->inject = malloc (POOL_INJECT_SIZE * sizeof (*pool->inject));
+  /* The workers must not share cache lines with other data, but libc
+     cannot use aligned_alloc.  */
+  size_t workers_size = nworkers * sizeof (struct pthread_pool_worker);
+  pool->workers_mem = malloc (workers_size + POOL_CACHE_LINE - 1);
+  if (pool->inject == NULL || pool->workers_mem == NULL)
+    {
+      free (pool->inject);
+      free (pool->workers_mem);
+      free (pool);
+      return ENOMEM;
+    }
+  pool->workers = PTR_ALIGN_UP (pool->workers_mem, POOL_CACHE_LINE);
+  memset (pool->workers, 0, workers_size);
+
+  /* The workers only need a small stack if the tasks do, but that is
+     not known, so use the default size.  Block all signals in the
+     workers but SIGSETXID, as for other internal threads.  */
+  pthread_attr_t attr;
+  __pthread_attr_init (&attr);
+  sigset_t ss;
+  __sigfillset (&ss);
+  __sigdelset (&ss, SIGSETXID);
+  int result = __pthread_attr_setsigmask_internal (&attr, &ss);
+  for (unsigned int i = 0; result == 0 && i < nworkers; ++i)
+    {
+      struct pthread_pool_worker *worker = &pool->workers[i];
+      worker->pool = pool;
+      worker->random = i + 1;
+      result = __pthread_create (&worker->thread, &attr, worker_start,
+				 worker);
+      if (result != 0)
+	worker->thread = 0;
+    }
+  __pthread_attr_destroy (&attr);
+
+  if (result != 0)
+    {
+      /* Terminate the workers which have been created.  */
+      __pthread_pool_free (pool);
+      return result;
+    }
+
+  *poolp = pool;
+  return 0;
+}
+libc_hidden_def (__pthread_pool_create_np)
+weak_alias (__pthread_pool_create_np, pthread_pool_create_np)
@@ -0,0 +1,61 @@
+/* Return the default pthread_pool_np thread pool.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include "pthread_poolP.h"
+
+/* The default pool, or NULL if it has not been created yet.  It is
+   never destroyed, except when it is replaced in a subprocess created
+   by fork.  */
+static pthread_pool_np_t *default_pool;
+
+pthread_pool_np_t *
+pthread_pool_default_np (void)
+{
+  /* Acquire MO so that we see the initialization of the pool.  */
+  pthread_pool_np_t *pool = atomic_load_acquire (&default_pool);
+  if (__glibc_likely (pool != NULL
+		      && pool->fork_generation == __fork_generation))
+    return pool;
+
+  pthread_pool_np_t *new_pool;
+  int result = __pthread_pool_create_np (&new_pool, 0);
+  if (result != 0)
+    {
+      __set_errno (result);
+      return NULL;
+    }
+  new_pool->is_default = true;
+
+  /* Release MO so that other threads see the initialization of the
+     pool.  A pool of the parent process which is replaced here is not
+     deallocated because other threads may still use it (and get
+     EINVAL).  */
+  pthread_pool_np_t *old_pool = pool;
+  while (!atomic_compare_exchange_weak_release (&default_pool, &pool,
+						new_pool))
+    if (pool != old_pool)
+      {
+	/* Another thread has installed a new pool.  Synchronize with
+	   it.  */
+	atomic_thread_fence_acquire ();
+	__pthread_pool_free (new_pool);
+	return pool;
+      }
+  return new_pool;
+}
@@ -0,0 +1,35 @@
+/* Destroy a pthread_pool_np thread pool.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include "pthread_poolP.h"
+
+int
+pthread_pool_destroy_np (pthread_pool_np_t *pool)
+{
+  /* The default pool is shared by all users in the process.  */
+  if (pool->is_default)
+    return EINVAL;
+  /* A worker cannot wait for itself to terminate.  */
+  struct pthread_pool_worker *self = __pthread_pool_self;
+  if (self != NULL && self->pool == pool)
+    return EDEADLK;
+
+  __pthread_pool_free (pool);
+  return 0;
+}
@@ -0,0 +1,96 @@
+/* Submit a task to a pthread_pool_np thread pool.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <stdlib.h>
+#include "pthread_poolP.h"
+
+/* Append TASK to the injection queue of POOL, growing it if it is
+   full.  */
+static int
+inject_push (struct pthread_pool_np *pool, const struct pthread_pool_task *task)
+{
+  int result = 0;
+  lll_lock (pool->inject_lock, LLL_PRIVATE);
+  unsigned int count = pool->inject_count;
+  if (count == pool->inject_size)
+    {
+      /* Move the tasks to the start of a queue twice the size.  */
+      struct pthread_pool_task *new_inject
+	= __libc_reallocarray (NULL, 2 * pool->inject_size,
+			       sizeof (*new_inject));
+      if (new_inject == NULL)
+	{
+	  result = ENOMEM;
+	  goto out;
+	}
+      for (unsigned int i = 0; i < count; ++i)
+	new_inject[i] = pool->inject[(pool->inject_head + i)
+				     & (pool->inject_size - 1)];
+      free (pool->inject);
+      pool->inject = new_inject;
+      pool->inject_head = 0;
+      pool->inject_size *= 2;
+    }
+  pool->inject[(pool->inject_head + count) & (pool->inject_size - 1)] = *task;
+  atomic_store_relaxed (&pool->inject_count, count + 1);
+ out:
+  lll_unlock (pool->inject_lock, LLL_PRIVATE);
+  return result;
+}
+
+int
+pthread_pool_submit_np (pthread_pool_np_t *pool,
+			pthread_pool_group_np_t *group,
+			void (*func) (void *), void *arg)
+{
+  if (__glibc_unlikely (pool->fork_generation != __fork_generation))
+    /* The workers of a pool do not exist in a subprocess.  */
+    return EINVAL;
+
+  struct pthread_pool_task task = { func, arg, group };
+  /* The task must be counted before a worker can run it.  */
+  if (group != NULL)
+    atomic_fetch_add_relaxed (&group->__pending, 1);
+
+  struct pthread_pool_worker *self = __pthread_pool_self;
+  if (self != NULL && self->pool == pool)
+    {
+      if (!__pthread_pool_deque_push (&self->deque, &task))
+	{
+	  /* Running the task here has the same effect as queuing it,
+	     except that the other tasks of this worker are delayed, which
+	     is acceptable because there are enough of them.  */
+	  __pthread_pool_run_task (&task);
+	  return 0;
+	}
+    }
+  else
+    {
+      int result = inject_push (pool, &task);
+      if (result != 0)
+	{
+	  if (group != NULL)
+	    __pthread_pool_group_finish (group);
+	  return result;
+	}
+    }
+
+  __pthread_pool_wake (pool);
+  return 0;
+}
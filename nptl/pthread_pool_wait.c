@@ -0,0 +1,63 @@
+/* Wait for a group of tasks of a pthread_pool_np thread pool.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include "pthread_poolP.h"
+
+int
+pthread_pool_wait_np (pthread_pool_np_t *pool, pthread_pool_group_np_t *group)
+{
+  if (__glibc_unlikely (pool->fork_generation != __fork_generation))
+    return EINVAL;
+
+  /* A worker of POOL runs other tasks while it waits, because the tasks
+     of the group may be queued behind them.  */
+  struct pthread_pool_worker *self = __pthread_pool_self;
+  if (self != NULL && self->pool != pool)
+    self = NULL;
+
+  struct pthread_pool_task task;
+  unsigned int spins = 0;
+  while (true)
+    {
+      /* Acquire MO so that we synchronize with the tasks of the
+	 group.  */
+      unsigned int pending = atomic_load_acquire (&group->__pending);
+      if ((pending & ~POOL_GROUP_WAITERS) == 0)
+	return 0;
+      if (self != NULL && __pthread_pool_find_task (pool, self, &task))
+	{
+	  __pthread_pool_run_task (&task);
+	  spins = 0;
+	  continue;
+	}
+      if (spins < POOL_SPIN_COUNT)
+	{
+	  ++spins;
+	  atomic_spin_nop ();
+	  continue;
+	}
+      if ((pending & POOL_GROUP_WAITERS) == 0
+	  && !atomic_compare_exchange_weak_relaxed (&group->__pending,
+						    &pending,
+						    pending | POOL_GROUP_WAITERS))
+	continue;
+      futex_wait_simple (&group->__pending, pending | POOL_GROUP_WAITERS,
+			 FUTEX_PRIVATE);
+    }
+}
@@ -0,0 +1,135 @@
+/* Revocation of the reader bias of PTHREAD_RWLOCK_READER_BIASED_NP rwlocks.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <futex-internal.h>
+#include <ldsodefs.h>
+#include <list.h>
+#include <lowlevellock.h>
+#include <sched.h>
+#include "pthread_rwlock_bias.h"
+
+/* Result of looking for the threads which hold a read lock through a
+   slot.  */
+enum bias_readers
+{
+  /* No thread holds the rwlock through a slot.  */
+  BIAS_READERS_NONE,
+  /* A thread holds it and will wake us when it releases its slot.  */
+  BIAS_READERS_WAIT,
+  /* A thread is acquiring or releasing its slot, and will not wake
+     us.  */
+  BIAS_READERS_TRANSIENT
+};
+
+/* Look for a thread in LIST which holds a read lock on RWLOCK through a
+   slot.  Unless TRY, ask the threads to wake us when they release their
+   slot.  This includes the calling thread, for which the write lock
+   then fails or deadlocks as for other rwlocks.  */
+static enum bias_readers
+list_find_readers (list_t *list, pthread_rwlock_t *rwlock, bool try)
+{
+  enum bias_readers result = BIAS_READERS_NONE;
+  list_t *runp;
+  list_for_each (runp, list)
+    {
+      struct pthread *t = list_entry (runp, struct pthread, list);
+      for (int i = 0; i < PTHREAD_RWLOCK_BIAS_SLOTS; ++i)
+	{
+	  struct pthread_rwlock_bias_slot *slot = &t->rwlock_bias[i];
+	  if (atomic_load_relaxed (&slot->lock) != rwlock)
+	    continue;
+	  if (try)
+	    return BIAS_READERS_WAIT;
+	  atomic_store_relaxed (&slot->wake, 1);
+	  /* Pairs with the fence in __pthread_rwlock_bias_rdunlock.  */
+	  atomic_thread_fence_seq_cst ();
+	  /* Acquire MO so that we synchronize with the release of the
+	     slot.  */
+	  if (atomic_load_acquire (&slot->lock) != rwlock)
+	    continue;
+	  if (atomic_load_relaxed (&slot->count) == 0)
+	    result = BIAS_READERS_TRANSIENT;
+	  else if (result == BIAS_READERS_NONE)
+	    result = BIAS_READERS_WAIT;
+	}
+    }
+  return result;
+}
+
+static enum bias_readers
+find_readers (pthread_rwlock_t *rwlock, bool try)
+{
+  lll_lock (GL (dl_stack_cache_lock), LLL_PRIVATE);
+  enum bias_readers result = list_find_readers (&GL (dl_stack_used),
+						rwlock, try);
+  enum bias_readers user = list_find_readers (&GL (dl_stack_user),
+					      rwlock, try);
+  lll_unlock (GL (dl_stack_cache_lock), LLL_PRIVATE);
+  return result > user ? result : user;
+}
+
+int
+__pthread_rwlock_bias_revoke (pthread_rwlock_t *rwlock, clockid_t clockid,
+			      const struct __timespec64 *abstime, bool try)
+{
+  /* No reader can set the bias again while we hold the write lock.  */
+  atomic_store_relaxed (&rwlock->__data.__bias, 0);
+  atomic_thread_fence_seq_cst ();
+
+  uint32_t start = __pthread_rwlock_bias_clock ();
+  for (;;)
+    {
+      /* Readers add BIAS_WAKE before they release their slot, so if one
+	 of them releases it after we looked at it, the futex wait below
+	 does not block.  */
+      unsigned int bias = atomic_load_acquire (&rwlock->__data.__bias);
+      enum bias_readers readers = find_readers (rwlock, try);
+      if (readers == BIAS_READERS_NONE)
+	break;
+
+      int result = EBUSY;
+      if (!try)
+	{
+	  /* Readers with a slot do not block on anything we hold, so they
+	     will eventually release it.  */
+	  if (readers == BIAS_READERS_TRANSIENT)
+	    {
+	      __sched_yield ();
+	      continue;
+	    }
+	  result = __futex_abstimed_wait64 (&rwlock->__data.__bias, bias,
+					    clockid, abstime, FUTEX_PRIVATE);
+	  if (result != ETIMEDOUT && result != EOVERFLOW)
+	    continue;
+	}
+      /* The remaining readers still hold the rwlock through their
+	 slots, so the next writer has to revoke the bias again.  We
+	 still hold the write lock, so no reader has acquired the rwlock
+	 in the meantime.  */
+      atomic_store_release (&rwlock->__data.__bias, BIAS_ENABLED);
+      return result;
+    }
+
+  uint32_t now = __pthread_rwlock_bias_clock ();
+  uint32_t inhibit = (now - start) * BIAS_INHIBIT_FACTOR;
+  if (inhibit > BIAS_INHIBIT_MAX || now - start > BIAS_INHIBIT_MAX)
+    inhibit = BIAS_INHIBIT_MAX;
+  atomic_store_relaxed (&rwlock->__data.__bias_until, now + inhibit);
+  return 0;
+}
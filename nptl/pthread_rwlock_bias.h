@@ -0,0 +1,221 @@
+/* Reader bias for PTHREAD_RWLOCK_READER_BIASED_NP rwlocks.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _PTHREAD_RWLOCK_BIAS_H
+#define _PTHREAD_RWLOCK_BIAS_H 1
+
+#include <atomic.h>
+#include <futex-internal.h>
+#include <pthreadP.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/* A reader-biased rwlock is a normal rwlock (see pthread_rwlock_common.c)
+   with an additional way for readers to acquire it, following the BRAVO
+   design by Dice and Kogan.  While BIAS_ENABLED is set in the __bias
+   field of the rwlock, a reader does not register in __readers, whose cache line
+   would then be modified by all readers.  Instead, it records the rwlock
+   in one of the rwlock_bias slots of its own thread descriptor, then
+   checks that the bias is still set.  A writer first acquires the rwlock
+   as usual, which excludes readers that use __readers, then clears
+   __bias and waits until no thread has the rwlock in a slot anymore
+   (the bias is revoked).  The store to the slot and the load of __bias
+   in the reader, and the store to __bias and the loads of the slots in
+   the writer, are separated by seq_cst fences, so either the reader
+   notices the revocation and falls back to __readers, or the writer
+   sees the slot and waits for the reader.
+
+   The writer blocks on __bias, which also serves as a futex: the bits
+   above BIAS_ENABLED count wake-ups.  To wait for a slot, the writer
+   sets the wake field of the slot and then checks that the slot still
+   holds the rwlock with a nonzero count.  A reader releasing its slot
+   first sets the count to zero and then checks the wake field; if it is
+   set, the reader adds BIAS_WAKE to __bias before it releases the slot,
+   and calls futex_wake afterwards.  Seq_cst fences between these
+   accesses ensure that a reader whose count the writer saw nonzero
+   notices the wake field.  Because the reader only modifies __bias
+   while it still holds the read lock, the writer cannot acquire the
+   rwlock, and its owner cannot destroy it, before that modification;
+   the futex_wake may then hit a destroyed rwlock, which is harmless as
+   for the other futexes of the rwlock.  A count of zero in a slot that
+   holds the rwlock means that the reader is between the two stores of
+   an acquisition or release which it completes without blocking, so
+   the writer only yields in this case.
+
+   Revocation has to look at all threads, so it is expensive.  The writer
+   scans the threads once, then once each time it has been woken.  After a
+   revocation, the bias is only set again by a reader that acquired the
+   rwlock through __readers, after __bias_until, which the writer sets
+   to BIAS_INHIBIT_FACTOR times the duration of the revocation into the
+   future.  __bias_until is in microseconds of CLOCK_MONOTONIC, modulo
+   2^32.  Because setting the bias requires a read lock, writers never
+   see the bias being set while they hold the rwlock.
+
+   A thread which already has a slot for the rwlock acquires further read
+   locks by incrementing the count in its slot, even if the bias has been
+   revoked in the meantime, because a writer waiting for the slot to be
+   released must not block such recursive read locks.  The bias is never
+   set for process-shared rwlocks because the slots of the threads in
+   other processes are not visible.  */
+
+/* The time for which a reader-biased rwlock is not biased after a
+   revocation, relative to the time the revocation took.  */
+#define BIAS_INHIBIT_FACTOR 9
+
+/* Upper limit for the time the bias is inhibited, in microseconds.  */
+#define BIAS_INHIBIT_MAX 1000000
+
+/* Bits of __bias.  BIAS_ENABLED is set while readers may use a slot.
+   Readers add BIAS_WAKE to wake a writer revoking the bias.  */
+#define BIAS_ENABLED 1
+#define BIAS_WAKE 2
+
+/* Return CLOCK_MONOTONIC in microseconds, modulo 2^32.  */
+static inline uint32_t
+__pthread_rwlock_bias_clock (void)
+{
+  struct __timespec64 ts;
+  __clock_gettime64 (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline bool
+__pthread_rwlock_is_biased_kind (pthread_rwlock_t *rwlock)
+{
+  return rwlock->__data.__flags == PTHREAD_RWLOCK_READER_BIASED_NP;
+}
+
+/* Try to acquire a read lock on RWLOCK through a slot of the calling
+   thread.  Return true on success.  */
+static __always_inline bool
+__pthread_rwlock_bias_rdlock (pthread_rwlock_t *rwlock)
+{
+  struct pthread *self = THREAD_SELF;
+  struct pthread_rwlock_bias_slot *free_slot = NULL;
+  for (int i = 0; i < PTHREAD_RWLOCK_BIAS_SLOTS; ++i)
+    {
+      struct pthread_rwlock_bias_slot *slot = &self->rwlock_bias[i];
+      pthread_rwlock_t *lock = atomic_load_relaxed (&slot->lock);
+      if (lock == rwlock)
+	{
+	  /* A recursive read lock.  */
+	  atomic_store_relaxed (&slot->count, slot->count + 1);
+	  return true;
+	}
+      if (lock == NULL && free_slot == NULL)
+	free_slot = slot;
+    }
+  if (free_slot == NULL
+      || (atomic_load_relaxed (&rwlock->__data.__bias) & BIAS_ENABLED) == 0)
+    return false;
+
+  atomic_store_relaxed (&free_slot->lock, rwlock);
+  atomic_thread_fence_seq_cst ();
+  /* Acquire MO so that we synchronize with the reader that set the bias,
+     which synchronized with prior writers when it acquired the lock
+     through __readers.  */
+  if (__glibc_likely ((atomic_load_acquire (&rwlock->__data.__bias)
+			& BIAS_ENABLED) != 0))
+    {
+      atomic_store_relaxed (&free_slot->count, 1);
+      return true;
+    }
+  /* A writer is revoking the bias.  */
+  atomic_store_relaxed (&free_slot->lock, NULL);
+  return false;
+}
+
+/* Release a read lock on RWLOCK if the calling thread holds it through
+   a slot.  Return false if the read lock must be released through
+   __readers instead.  */
+static __always_inline bool
+__pthread_rwlock_bias_rdunlock (pthread_rwlock_t *rwlock)
+{
+  struct pthread *self = THREAD_SELF;
+  for (int i = 0; i < PTHREAD_RWLOCK_BIAS_SLOTS; ++i)
+    {
+      struct pthread_rwlock_bias_slot *slot = &self->rwlock_bias[i];
+      if (atomic_load_relaxed (&slot->lock) == rwlock)
+	{
+	  unsigned int count = slot->count - 1;
+	  atomic_store_relaxed (&slot->count, count);
+	  if (count != 0)
+	    return true;
+
+	  /* Pairs with the fence in list_find_reader.  */
+	  atomic_thread_fence_seq_cst ();
+	  bool wake = atomic_load_relaxed (&slot->wake) != 0;
+	  if (__glibc_unlikely (wake))
+	    {
+	      atomic_store_relaxed (&slot->wake, 0);
+	      atomic_fetch_add_relaxed (&rwlock->__data.__bias, BIAS_WAKE);
+	    }
+	  /* Release MO so that a revoking writer synchronizes with the
+	     end of our critical section.  */
+	  atomic_store_release (&slot->lock, NULL);
+	  if (__glibc_unlikely (wake))
+	    futex_wake (&rwlock->__data.__bias, 1, FUTEX_PRIVATE);
+	  return true;
+	}
+    }
+  return false;
+}
+
+/* Called by a reader that acquired RWLOCK through __readers.  Set the
+   bias again if it is not inhibited by a recent revocation.  */
+static __always_inline void
+__pthread_rwlock_bias_enable (pthread_rwlock_t *rwlock)
+{
+  if (__pthread_rwlock_is_biased_kind (rwlock)
+      && rwlock->__data.__shared == 0
+      && (atomic_load_relaxed (&rwlock->__data.__bias) & BIAS_ENABLED) == 0)
+    {
+      uint32_t until = atomic_load_relaxed (&rwlock->__data.__bias_until);
+      /* This is true if __bias_until is in the past, taking the
+	 wrap-around into account.  */
+      if (until - __pthread_rwlock_bias_clock () > BIAS_INHIBIT_MAX)
+	/* Release MO so that readers that see the bias synchronize with
+	   the writers we synchronized with.  */
+	atomic_store_release (&rwlock->__data.__bias, BIAS_ENABLED);
+    }
+}
+
+/* Revoke the bias of RWLOCK, which the calling thread has acquired as a
+   writer through __readers, and wait until no thread holds a read lock
+   through a slot.  If TRY, return EBUSY instead of waiting.  Otherwise,
+   return ETIMEDOUT if ABSTIME on CLOCKID passes first.  The caller has
+   to release the write lock if this fails.  */
+int __pthread_rwlock_bias_revoke (pthread_rwlock_t *rwlock, clockid_t clockid,
+				  const struct __timespec64 *abstime,
+				  bool try)
+  attribute_hidden;
+
+/* Called by a writer after acquiring RWLOCK through __readers.  Return 0
+   if there are no readers left, or an error code as for
+   __pthread_rwlock_bias_revoke.  */
+static __always_inline int
+__pthread_rwlock_bias_wrlock (pthread_rwlock_t *rwlock, clockid_t clockid,
+			      const struct __timespec64 *abstime, bool try)
+{
+  if ((atomic_load_relaxed (&rwlock->__data.__bias) & BIAS_ENABLED) == 0)
+    return 0;
+  return __pthread_rwlock_bias_revoke (rwlock, clockid, abstime, try);
+}
+
+#endif /* pthread_rwlock_bias.h */
@@ -25,6 +25,7 @@
 #include <atomic.h>
 #include <futex-internal.h>
 #include <time.h>
+#include "pthread_rwlock_bias.h"
 
 
 /* A reader--writer lock that fulfills the POSIX requirements (but operations
@@ -55,6 +56,10 @@
    preferred, then write lock acquisition attempts will block subsequent read
    lock acquisition attempts, so that new incoming readers do not prolong a
    phase in which readers have acquired the lock.
+   Rwlocks of kind PTHREAD_RWLOCK_READER_BIASED_NP behave like
+   PTHREAD_RWLOCK_PREFER_WRITER_NP ones, except that readers can also acquire
+   them without modifying the rwlock, at the expense of writers; see
+   pthread_rwlock_bias.h.
 
    The main components of the rwlock are a writer-only lock that allows only
    one of the concurrent writers to be the primary writer, and a
@@ -277,9 +282,11 @@ __pthread_rwlock_rdunlock (pthread_rwlock_t *rwlock)
 }
 
 
+/* Acquire a read lock by registering as a reader in __readers.  */
 static __always_inline int
-__pthread_rwlock_rdlock_full64 (pthread_rwlock_t *rwlock, clockid_t clockid,
-                                const struct __timespec64 *abstime)
+__pthread_rwlock_rdlock_readers64 (pthread_rwlock_t *rwlock,
+				   clockid_t clockid,
+				   const struct __timespec64 *abstime)
 {
   unsigned int r;
 
@@ -523,6 +530,23 @@ __pthread_rwlock_rdlock_full64 (pthread_rwlock_t *rwlock, clockid_t clockid,
 }
 
 
+static __always_inline int
+__pthread_rwlock_rdlock_full64 (pthread_rwlock_t *rwlock, clockid_t clockid,
+                                const struct __timespec64 *abstime)
+{
+  if (!__pthread_rwlock_is_biased_kind (rwlock))
+    return __pthread_rwlock_rdlock_readers64 (rwlock, clockid, abstime);
+
+  /* See pthread_rwlock_bias.h.  */
+  if (__pthread_rwlock_bias_rdlock (rwlock))
+    return 0;
+  int err = __pthread_rwlock_rdlock_readers64 (rwlock, clockid, abstime);
+  if (err == 0)
+    __pthread_rwlock_bias_enable (rwlock);
+  return err;
+}
+
+
 static __always_inline void
 __pthread_rwlock_wrunlock (pthread_rwlock_t *rwlock)
 {
@@ -946,5 +970,17 @@ __pthread_rwlock_wrlock_full64 (pthread_rwlock_t *rwlock, clockid_t clockid,
  done:
   atomic_store_relaxed (&rwlock->__data.__cur_writer,
 			THREAD_GETMEM (THREAD_SELF, tid));
+
+  /* Wait for the readers which do not use __readers.  */
+  if (__pthread_rwlock_is_biased_kind (rwlock))
+    {
+      int err = __pthread_rwlock_bias_wrlock (rwlock, clockid, abstime,
+					      false);
+      if (err != 0)
+	{
+	  __pthread_rwlock_wrunlock (rwlock);
+	  return err;
+	}
+    }
   return 0;
 }
@@ -36,6 +36,10 @@ ___pthread_rwlock_tryrdlock (pthread_rwlock_t *rwlock)
      Because POSIX does not require a failed trylock to "synchronize memory",
      relaxed MO is sufficient here and on the failure path of the CAS
      below.  */
+  if (__pthread_rwlock_is_biased_kind (rwlock)
+      && __pthread_rwlock_bias_rdlock (rwlock))
+    return 0;
+
   unsigned int r = atomic_load_relaxed (&rwlock->__data.__readers);
   unsigned int rnew;
   do
@@ -111,6 +115,7 @@ ___pthread_rwlock_tryrdlock (pthread_rwlock_t *rwlock)
 	}
     }
 
+  __pthread_rwlock_bias_enable (rwlock);
   return 0;
 
 
@@ -19,6 +19,7 @@
 #include "pthreadP.h"
 #include <atomic.h>
 #include <shlib-compat.h>
+#include "pthread_rwlock_common.c"
 
 /* See pthread_rwlock_common.c for an overview.  */
 int
@@ -57,6 +58,14 @@ ___pthread_rwlock_trywrlock (pthread_rwlock_t *rwlock)
 	    atomic_store_relaxed (&rwlock->__data.__wrphase_futex, 1);
 	  atomic_store_relaxed (&rwlock->__data.__cur_writer,
 	      THREAD_GETMEM (THREAD_SELF, tid));
+	  /* Readers that do not use __readers must not be waited for.  */
+	  if (__pthread_rwlock_is_biased_kind (rwlock)
+	      && __pthread_rwlock_bias_wrlock (rwlock, CLOCK_REALTIME, NULL,
+					       true) != 0)
+	    {
+	      __pthread_rwlock_wrunlock (rwlock);
+	      return EBUSY;
+	    }
 	  return 0;
 	}
       /* TODO Back-off.  */
@@ -38,7 +38,8 @@ ___pthread_rwlock_unlock (pthread_rwlock_t *rwlock)
   if (atomic_load_relaxed (&rwlock->__data.__cur_writer)
       == THREAD_GETMEM (THREAD_SELF, tid))
       __pthread_rwlock_wrunlock (rwlock);
-  else
+  else if (!(__pthread_rwlock_is_biased_kind (rwlock)
+	     && __pthread_rwlock_bias_rdunlock (rwlock)))
     __pthread_rwlock_rdunlock (rwlock);
   return 0;
 }
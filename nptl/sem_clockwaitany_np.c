@@ -0,0 +1,220 @@
+/* sem_clockwaitany_np -- wait on several semaphores at once.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <time.h>
+#include "semaphoreP.h"
+#include "sem_waitcommon.c"
+
+/* A thread waiting on several semaphores registers as a waiter on each
+   of them, exactly as __new_sem_wait_slow64 does for a single one, so
+   that sem_post issues a futex wake-up for every semaphore it waits on.
+   It then blocks on the futex words of all of them with futex_waitv
+   until one of the semaphores has a token, and grabs the token.
+
+   sem_post only wakes one waiter.  If that waiter is a thread waiting
+   on several semaphores which grabs a token from another semaphore,
+   the wake-up is not used for the semaphore it was meant for, and a
+   thread blocked on that semaphore alone might not wake up although a
+   token is available.  Therefore, after it stops being a registered
+   waiter, the thread wakes one waiter of every other semaphore which
+   still has tokens and waiters.  This can cause spurious wake-ups,
+   which all waiters tolerate.  */
+
+struct waitany_cleanup_args
+{
+  struct new_sem **sems;
+  unsigned int nsems;
+};
+
+/* Stop being a registered waiter on all semaphores.  */
+static void
+waitany_unregister (struct new_sem **sems, unsigned int nsems)
+{
+  for (unsigned int i = 0; i < nsems; ++i)
+    __sem_wait_cleanup (sems[i]);
+}
+
+/* Forward wake-ups the calling thread might have consumed for the
+   semaphores other than SEMS[GRABBED].  GRABBED is -1 if the thread
+   has not grabbed a token.  */
+static void
+waitany_pass_on (struct new_sem **sems, unsigned int nsems, int grabbed)
+{
+  for (unsigned int i = 0; i < nsems; ++i)
+    {
+      if ((int) i == grabbed)
+	continue;
+      struct new_sem *sem = sems[i];
+#if __HAVE_64B_ATOMICS
+      uint64_t d = atomic_load_relaxed (&sem->data);
+      if ((d & SEM_VALUE_MASK) != 0 && (d >> SEM_NWAITERS_SHIFT) != 0)
+	futex_wake (((unsigned int *) &sem->data) + SEM_VALUE_OFFSET, 1,
+		    sem->private);
+#else
+      unsigned int v = atomic_load_relaxed (&sem->value);
+      if ((v >> SEM_VALUE_SHIFT) != 0 && (v & SEM_NWAITERS_MASK) != 0)
+	futex_wake (&sem->value, 1, sem->private);
+#endif
+    }
+}
+
+static void
+waitany_cleanup (void *arg)
+{
+  struct waitany_cleanup_args *args = arg;
+  waitany_unregister (args->sems, args->nsems);
+  waitany_pass_on (args->sems, args->nsems, -1);
+}
+
+/* Prepare to block on SEM: set up ITEM for it, and return true if SEM
+   has no token.  */
+static bool
+waitany_prepare (struct new_sem *sem, struct futex_waitv_item *item)
+{
+#if __HAVE_64B_ATOMICS
+  futex_waitv_item_init (item, (unsigned int *) &sem->data + SEM_VALUE_OFFSET,
+			 0, sem->private);
+  /* Relaxed MO is sufficient; the futex_waitv or the CAS in
+     __new_sem_wait_fast perform the real work.  */
+  return (atomic_load_relaxed (&sem->data) & SEM_VALUE_MASK) == 0;
+#else
+  futex_waitv_item_init (item, &sem->value, SEM_NWAITERS_MASK,
+			 sem->private);
+  /* Make sure that the nwaiters bit is set, as in
+     __new_sem_wait_slow64.  */
+  unsigned int v = atomic_load_relaxed (&sem->value);
+  do
+    {
+      if ((v & SEM_NWAITERS_MASK) != 0)
+	break;
+    }
+  while (!atomic_compare_exchange_weak_release (&sem->value,
+      &v, v | SEM_NWAITERS_MASK));
+  return (v >> SEM_VALUE_SHIFT) == 0;
+#endif
+}
+
+/* Slow path that blocks.  Return the index of the semaphore from which
+   a token was grabbed, or -1 with errno set.  */
+static int
+__attribute__ ((noinline))
+waitany_slow (struct new_sem **sems, unsigned int nsems, clockid_t clockid,
+	      const struct __timespec64 *abstime)
+{
+  struct futex_waitv_item items[FUTEX_WAITV_MAX];
+  struct waitany_cleanup_args args = { sems, nsems };
+  int result = -1;
+
+  /* Add a waiter to every semaphore.  See __new_sem_wait_slow64 for the
+     MOs.  */
+  for (unsigned int i = 0; i < nsems; ++i)
+#if __HAVE_64B_ATOMICS
+    atomic_fetch_add_relaxed (&sems[i]->data,
+			      (uint64_t) 1 << SEM_NWAITERS_SHIFT);
+#else
+    atomic_fetch_add_acquire (&sems[i]->nwaiters, 1);
+#endif
+
+  pthread_cleanup_push (waitany_cleanup, &args);
+
+  for (;;)
+    {
+      /* Try to grab a token, without changing the number of waiters.  */
+      for (unsigned int i = 0; i < nsems; ++i)
+	if (__new_sem_wait_fast (sems[i], 1) == 0)
+	  {
+	    result = i;
+	    break;
+	  }
+      if (result >= 0)
+	break;
+
+      /* If there is still no token, sleep until there might be one.  */
+      bool block = true;
+      for (unsigned int i = 0; i < nsems; ++i)
+	if (!waitany_prepare (sems[i], &items[i]))
+	  block = false;
+      if (!block)
+	continue;
+
+      int err = __futex_waitv_cancelable64 (items, nsems, clockid, abstime);
+      /* As for a single semaphore, retry on a real or spurious wake-up
+	 and on EAGAIN, and forward the other errors to the caller.  */
+      if (err == ETIMEDOUT || err == EINTR || err == ENOSYS)
+	{
+	  __set_errno (err);
+	  break;
+	}
+    }
+
+  pthread_cleanup_pop (0);
+
+  waitany_unregister (sems, nsems);
+  waitany_pass_on (sems, nsems, result);
+  return result;
+}
+
+int
+__sem_clockwaitany_np64 (sem_t *const sems[], unsigned int nsems,
+			 clockid_t clockid,
+			 const struct __timespec64 *abstime)
+{
+  if (nsems == 0 || nsems > FUTEX_WAITV_MAX)
+    {
+      __set_errno (EINVAL);
+      return -1;
+    }
+
+  /* Check that supplied clockid is one we support, even if we don't end up
+     waiting.  */
+  if (!futex_abstimed_supported_clockid (clockid)
+      || (abstime != NULL && !valid_nanoseconds (abstime->tv_nsec)))
+    {
+      __set_errno (EINVAL);
+      return -1;
+    }
+
+  struct new_sem **isems = (struct new_sem **) sems;
+  for (unsigned int i = 0; i < nsems; ++i)
+    if (__new_sem_wait_fast (isems[i], 0) == 0)
+      return i;
+
+  if (nsems == 1)
+    /* This does not need futex_waitv, so it also works on older kernels.  */
+    return __new_sem_wait_slow64 (isems[0], clockid, abstime);
+
+  return waitany_slow (isems, nsems, clockid, abstime);
+}
+
+#if __TIMESIZE != 64
+libc_hidden_def (__sem_clockwaitany_np64)
+
+int
+sem_clockwaitany_np (sem_t *const sems[], unsigned int nsems,
+		     clockid_t clockid, const struct timespec *abstime)
+{
+  struct __timespec64 ts64, *pts64 = NULL;
+  if (abstime != NULL)
+    {
+      ts64 = valid_timespec_to_timespec64 (*abstime);
+      pts64 = &ts64;
+    }
+
+  return __sem_clockwaitany_np64 (sems, nsems, clockid, pts64);
+}
+#endif
@@ -0,0 +1,143 @@
+/* Test PTHREAD_MUTEX_COHORT_NP mutexes.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <support/check.h>
+#include <support/timespec.h>
+#include <support/xthread.h>
+#include <support/xtime.h>
+
+enum { nthreads = 8, iterations = 20000 };
+
+static pthread_mutex_t mutex;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static unsigned long int counter;
+static int cond_state;
+
+static void *
+thread_func (void *closure)
+{
+  int id = (uintptr_t) closure;
+  for (int i = 0; i < iterations; ++i)
+    {
+      switch ((i + id) % 4)
+	{
+	case 0:
+	  if (pthread_mutex_trylock (&mutex) == 0)
+	    break;
+	  /* Fall through.  */
+	case 1:
+	  {
+	    struct timespec ts = timespec_add (xclock_now (CLOCK_REALTIME),
+					       make_timespec (10, 0));
+	    TEST_COMPARE (pthread_mutex_timedlock (&mutex, &ts), 0);
+	  }
+	  break;
+	default:
+	  xpthread_mutex_lock (&mutex);
+	  break;
+	}
+      unsigned long int value = counter;
+      for (int j = 0; j < 10; ++j)
+	__asm__ volatile ("" ::: "memory");
+      counter = value + 1;
+      xpthread_mutex_unlock (&mutex);
+    }
+  return NULL;
+}
+
+static void *
+cond_thread (void *closure)
+{
+  xpthread_mutex_lock (&mutex);
+  cond_state = 1;
+  xpthread_cond_signal (&cond);
+  while (cond_state != 2)
+    xpthread_cond_wait (&cond, &mutex);
+  xpthread_mutex_unlock (&mutex);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  pthread_mutexattr_t attr;
+  xpthread_mutexattr_init (&attr);
+  xpthread_mutexattr_settype (&attr, PTHREAD_MUTEX_COHORT_NP);
+  int kind;
+  TEST_COMPARE (pthread_mutexattr_gettype (&attr, &kind), 0);
+  TEST_COMPARE (kind, PTHREAD_MUTEX_COHORT_NP);
+  TEST_COMPARE (pthread_mutexattr_settype (&attr,
+					   PTHREAD_MUTEX_COHORT_NP + 1),
+		EINVAL);
+
+  /* Robust and priority protocol mutexes are not supported.  */
+  pthread_mutex_t other;
+  xpthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+  TEST_COMPARE (pthread_mutex_init (&other, &attr), ENOTSUP);
+  xpthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_STALLED);
+  xpthread_mutexattr_setprotocol (&attr, PTHREAD_PRIO_INHERIT);
+  TEST_COMPARE (pthread_mutex_init (&other, &attr), ENOTSUP);
+  xpthread_mutexattr_setprotocol (&attr, PTHREAD_PRIO_NONE);
+
+  xpthread_mutex_init (&mutex, &attr);
+  xpthread_mutexattr_destroy (&attr);
+
+  /* Mutual exclusion with all locking functions.  */
+  pthread_t threads[nthreads];
+  for (int i = 0; i < nthreads; ++i)
+    threads[i] = xpthread_create (NULL, thread_func, (void *) (uintptr_t) i);
+  for (int i = 0; i < nthreads; ++i)
+    xpthread_join (threads[i]);
+  TEST_COMPARE (counter, (unsigned long int) nthreads * iterations);
+
+  /* A cohort mutex can be used with condition variables.  */
+  xpthread_mutex_lock (&mutex);
+  pthread_t thr = xpthread_create (NULL, cond_thread, NULL);
+  while (cond_state != 1)
+    xpthread_cond_wait (&cond, &mutex);
+  cond_state = 2;
+  xpthread_cond_signal (&cond);
+  xpthread_mutex_unlock (&mutex);
+  xpthread_join (thr);
+
+  /* A reservation for a cohort without spinning threads does not
+     prevent other threads from acquiring the lock.  The reservation
+     is in the low bits of the __count field, and cohort 16 is only
+     used by threads on node 15 (modulo 16).  */
+  mutex.__data.__count = 16;
+  xpthread_mutex_lock (&mutex);
+  xpthread_mutex_unlock (&mutex);
+  mutex.__data.__count = 16;
+  TEST_COMPARE (pthread_mutex_trylock (&mutex), 0);
+  xpthread_mutex_unlock (&mutex);
+  mutex.__data.__count = 16;
+  struct timespec ts = timespec_add (xclock_now (CLOCK_REALTIME),
+				     make_timespec (10, 0));
+  TEST_COMPARE (pthread_mutex_timedlock (&mutex, &ts), 0);
+  TEST_COMPARE (pthread_mutex_trylock (&mutex), EBUSY);
+  xpthread_mutex_unlock (&mutex);
+
+  xpthread_mutex_destroy (&mutex);
+  return 0;
+}
+
+#include <support/test-driver.c>
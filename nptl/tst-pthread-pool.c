@@ -0,0 +1,188 @@
+/* Test pthread_pool_np thread pools.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <support/check.h>
+#include <support/xthread.h>
+#include <support/xunistd.h>
+
+static pthread_pool_np_t *pool;
+static atomic_int counter;
+
+static void
+count_task (void *closure)
+{
+  atomic_fetch_add (&counter, 1);
+}
+
+/* Compute the Fibonacci number of N with nested fork-join tasks.  */
+struct fib
+{
+  unsigned int n;
+  unsigned long int result;
+};
+
+static void
+fib_task (void *closure)
+{
+  struct fib *f = closure;
+  if (f->n < 2)
+    {
+      f->result = f->n;
+      return;
+    }
+  struct fib a = { f->n - 1, 0 };
+  struct fib b = { f->n - 2, 0 };
+  pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+  TEST_COMPARE (pthread_pool_submit_np (pool, &group, fib_task, &a), 0);
+  fib_task (&b);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+  f->result = a.result + b.result;
+}
+
+/* Submit more tasks than fit into the deque of a worker.  */
+static void
+spawn_many_task (void *closure)
+{
+  pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+  for (int i = 0; i < 1000; ++i)
+    TEST_COMPARE (pthread_pool_submit_np (pool, &group, count_task, NULL), 0);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+}
+
+static void
+destroy_task (void *closure)
+{
+  int expected = (uintptr_t) closure;
+  TEST_COMPARE (pthread_pool_destroy_np (pool), expected);
+}
+
+static void
+slow_task (void *closure)
+{
+  usleep (1000);
+  atomic_fetch_add (&counter, 1);
+}
+
+/* Run tests on POOL.  If IS_DEFAULT, it is the default pool.  */
+static void
+test_pool (bool is_default)
+{
+  /* Tasks submitted from outside of the pool.  */
+  atomic_store (&counter, 0);
+  pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+  for (int i = 0; i < 1000; ++i)
+    TEST_COMPARE (pthread_pool_submit_np (pool, &group, count_task, NULL), 0);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+  TEST_COMPARE (atomic_load (&counter), 1000);
+  /* Waiting for an empty group returns immediately, and the group can
+     be reused.  */
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+  for (int i = 0; i < 10; ++i)
+    TEST_COMPARE (pthread_pool_submit_np (pool, &group, slow_task, NULL), 0);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+  TEST_COMPARE (atomic_load (&counter), 1010);
+
+  /* Tasks submitted by workers.  */
+  atomic_store (&counter, 0);
+  for (int i = 0; i < 4; ++i)
+    TEST_COMPARE (pthread_pool_submit_np (pool, &group, spawn_many_task,
+					  NULL), 0);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+  TEST_COMPARE (atomic_load (&counter), 4000);
+
+  /* Nested fork-join.  Waiting workers run other tasks, so this does not
+     deadlock even with more nesting levels than workers.  */
+  struct fib f = { 20, 0 };
+  TEST_COMPARE (pthread_pool_submit_np (pool, &group, fib_task, &f), 0);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+  TEST_COMPARE (f.result, 6765);
+
+  /* A task cannot destroy its pool.  */
+  TEST_COMPARE (pthread_pool_submit_np (pool, &group, destroy_task,
+					(void *) (uintptr_t) (is_default
+							      ? EINVAL
+							      : EDEADLK)),
+		0);
+  TEST_COMPARE (pthread_pool_wait_np (pool, &group), 0);
+}
+
+static int
+do_test (void)
+{
+  for (unsigned int nworkers = 1; nworkers <= 4; nworkers *= 2)
+    {
+      TEST_COMPARE (pthread_pool_create_np (&pool, nworkers), 0);
+      test_pool (false);
+
+      /* Tasks without a group are run before the pool is destroyed.  */
+      atomic_store (&counter, 0);
+      for (int i = 0; i < 10; ++i)
+	TEST_COMPARE (pthread_pool_submit_np (pool, NULL, slow_task, NULL),
+		      0);
+      TEST_COMPARE (pthread_pool_destroy_np (pool), 0);
+      TEST_COMPARE (atomic_load (&counter), 10);
+    }
+
+  /* A pool sized to the CPUs of the process.  */
+  TEST_COMPARE (pthread_pool_create_np (&pool, 0), 0);
+  test_pool (false);
+  TEST_COMPARE (pthread_pool_destroy_np (pool), 0);
+
+  /* The default pool.  */
+  pool = pthread_pool_default_np ();
+  TEST_VERIFY_EXIT (pool != NULL);
+  TEST_VERIFY (pthread_pool_default_np () == pool);
+  TEST_COMPARE (pthread_pool_destroy_np (pool), EINVAL);
+  test_pool (true);
+
+  /* The workers of the pools of the parent process do not exist in a
+     subprocess, but there is a new default pool.  */
+  pthread_pool_np_t *parent_pool;
+  TEST_COMPARE (pthread_pool_create_np (&parent_pool, 2), 0);
+  pid_t pid = xfork ();
+  if (pid == 0)
+    {
+      pthread_pool_group_np_t group = PTHREAD_POOL_GROUP_INITIALIZER_NP;
+      TEST_COMPARE (pthread_pool_submit_np (parent_pool, &group, count_task,
+					    NULL), EINVAL);
+      TEST_COMPARE (pthread_pool_destroy_np (parent_pool), 0);
+      pthread_pool_np_t *default_pool = pool;
+      pool = pthread_pool_default_np ();
+      TEST_VERIFY_EXIT (pool != NULL);
+      TEST_VERIFY (pool != default_pool);
+      TEST_COMPARE (pthread_pool_submit_np (default_pool, &group, count_task,
+					    NULL), EINVAL);
+      test_pool (true);
+      _exit (0);
+    }
+  int status;
+  xwaitpid (pid, &status, 0);
+  TEST_COMPARE (status, 0);
+  TEST_VERIFY (pthread_pool_default_np () == pool);
+  TEST_COMPARE (pthread_pool_destroy_np (parent_pool), 0);
+
+  return 0;
+}
+
+#include <support/test-driver.c>
@@ -0,0 +1,276 @@
+/* Test rwlocks with PTHREAD_RWLOCK_READER_BIASED_NP.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <support/check.h>
+#include <support/process_state.h>
+#include <support/timespec.h>
+#include <support/xthread.h>
+#include <support/xtime.h>
+
+static void
+init_biased (pthread_rwlock_t *rwlock, int pshared)
+{
+  pthread_rwlockattr_t attr;
+  xpthread_rwlockattr_init (&attr);
+  xpthread_rwlockattr_setkind_np (&attr, PTHREAD_RWLOCK_READER_BIASED_NP);
+  TEST_COMPARE (pthread_rwlockattr_setpshared (&attr, pshared), 0);
+  xpthread_rwlock_init (rwlock, &attr);
+  TEST_COMPARE (pthread_rwlockattr_destroy (&attr), 0);
+}
+
+/* Acquire and release a read lock, so that the rwlock becomes biased
+   unless a recent revocation inhibits that.  */
+static void
+read_once (pthread_rwlock_t *rwlock)
+{
+  xpthread_rwlock_rdlock (rwlock);
+  xpthread_rwlock_unlock (rwlock);
+}
+
+static pthread_rwlock_t lock;
+static pthread_barrier_t barrier;
+
+/* Hold a read lock on LOCK between two barrier waits.  */
+static void *
+reader_thread (void *closure)
+{
+  read_once (&lock);
+  xpthread_rwlock_rdlock (&lock);
+  xpthread_barrier_wait (&barrier);
+  xpthread_barrier_wait (&barrier);
+  xpthread_rwlock_unlock (&lock);
+  return NULL;
+}
+
+/* Hold a read lock on LOCK, and take another one after a writer has
+   started to wait.  */
+static void *
+recursive_reader_thread (void *closure)
+{
+  xpthread_rwlock_rdlock (&lock);
+  xpthread_barrier_wait (&barrier);
+  usleep (50 * 1000);
+  xpthread_rwlock_rdlock (&lock);
+  xpthread_rwlock_unlock (&lock);
+  xpthread_rwlock_unlock (&lock);
+  return NULL;
+}
+
+static void *
+writer_thread (void *closure)
+{
+  xpthread_rwlock_wrlock (&lock);
+  xpthread_rwlock_unlock (&lock);
+  return NULL;
+}
+
+static atomic_int writer_tid;
+
+static void *
+blocking_writer_thread (void *closure)
+{
+  atomic_store (&writer_tid, gettid ());
+  return writer_thread (closure);
+}
+
+/* Readers check that the two counters are equal, writers increment
+   both.  */
+
+enum { stress_threads = 4, stress_iterations = 20000 };
+
+static unsigned int counter1;
+static unsigned int counter2;
+static atomic_int mismatches;
+
+static void *
+stress_thread (void *closure)
+{
+  unsigned int seed = (unsigned long int) closure;
+  for (int i = 0; i < stress_iterations; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      if ((seed >> 16) % 64 == 0)
+	{
+	  xpthread_rwlock_wrlock (&lock);
+	  unsigned int c = counter1;
+	  counter1 = c + 1;
+	  counter2 = c + 1;
+	  xpthread_rwlock_unlock (&lock);
+	}
+      else
+	{
+	  xpthread_rwlock_rdlock (&lock);
+	  if (counter1 != counter2)
+	    atomic_fetch_add (&mismatches, 1);
+	  /* A recursive read lock now and then.  */
+	  if ((seed >> 16) % 8 == 0)
+	    {
+	      xpthread_rwlock_rdlock (&lock);
+	      if (counter1 != counter2)
+		atomic_fetch_add (&mismatches, 1);
+	      xpthread_rwlock_unlock (&lock);
+	    }
+	  xpthread_rwlock_unlock (&lock);
+	}
+    }
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  /* The kind is accepted and reported back.  */
+  {
+    pthread_rwlockattr_t attr;
+    int kind;
+    xpthread_rwlockattr_init (&attr);
+    TEST_COMPARE (pthread_rwlockattr_setkind_np
+		  (&attr, PTHREAD_RWLOCK_READER_BIASED_NP), 0);
+    TEST_COMPARE (pthread_rwlockattr_getkind_np (&attr, &kind), 0);
+    TEST_COMPARE (kind, PTHREAD_RWLOCK_READER_BIASED_NP);
+    TEST_COMPARE (pthread_rwlockattr_destroy (&attr), 0);
+  }
+
+  init_biased (&lock, PTHREAD_PROCESS_PRIVATE);
+  xpthread_barrier_init (&barrier, NULL, 2);
+
+  /* Recursive read locks, also on more rwlocks than a thread has slots
+     for.  */
+  {
+    enum { nlocks = 8, depth = 3 };
+    pthread_rwlock_t locks[nlocks];
+    for (int i = 0; i < nlocks; ++i)
+      {
+	init_biased (&locks[i], PTHREAD_PROCESS_PRIVATE);
+	read_once (&locks[i]);
+      }
+    for (int i = 0; i < nlocks; ++i)
+      for (int j = 0; j < depth; ++j)
+	xpthread_rwlock_rdlock (&locks[i]);
+    for (int i = 0; i < nlocks; ++i)
+      {
+	TEST_COMPARE (pthread_rwlock_trywrlock (&locks[i]), EBUSY);
+	for (int j = 0; j < depth; ++j)
+	  TEST_COMPARE (pthread_rwlock_tryrdlock (&locks[i]), 0);
+	for (int j = 0; j < 2 * depth; ++j)
+	  xpthread_rwlock_unlock (&locks[i]);
+      }
+    for (int i = 0; i < nlocks; ++i)
+      {
+	TEST_COMPARE (pthread_rwlock_trywrlock (&locks[i]), 0);
+	xpthread_rwlock_unlock (&locks[i]);
+	TEST_COMPARE (pthread_rwlock_destroy (&locks[i]), 0);
+      }
+  }
+
+  /* A writer has to wait for a reader in another thread, which may hold
+     the rwlock without registering in __readers.  Repeat to get the bias
+     back after the revocations.  */
+  for (int i = 0; i < 3; ++i)
+    {
+      pthread_t thr = xpthread_create (NULL, reader_thread, NULL);
+      xpthread_barrier_wait (&barrier);
+
+      TEST_COMPARE (pthread_rwlock_trywrlock (&lock), EBUSY);
+      struct timespec ts = timespec_add (xclock_now (CLOCK_MONOTONIC),
+					 make_timespec (0, 20 * 1000 * 1000));
+      TEST_COMPARE (pthread_rwlock_clockwrlock (&lock, CLOCK_MONOTONIC, &ts),
+		    ETIMEDOUT);
+      TEST_TIMESPEC_NOW_OR_AFTER (CLOCK_MONOTONIC, ts);
+      ts = timespec_add (xclock_now (CLOCK_REALTIME),
+			 make_timespec (0, 20 * 1000 * 1000));
+      TEST_COMPARE (pthread_rwlock_timedwrlock (&lock, &ts), ETIMEDOUT);
+      /* Other readers are not blocked by failed writers.  */
+      TEST_COMPARE (pthread_rwlock_tryrdlock (&lock), 0);
+      xpthread_rwlock_unlock (&lock);
+
+      xpthread_barrier_wait (&barrier);
+      xpthread_join (thr);
+      xpthread_rwlock_wrlock (&lock);
+      xpthread_rwlock_unlock (&lock);
+      /* Wait until the bias may be set again.  */
+      usleep (100 * 1000);
+    }
+
+  /* A writer waiting for a reader with a slot sleeps until the reader
+     releases it, instead of spinning.  */
+  {
+    pthread_t reader = xpthread_create (NULL, reader_thread, NULL);
+    xpthread_barrier_wait (&barrier);
+    pthread_t writer = xpthread_create (NULL, blocking_writer_thread, NULL);
+    while (atomic_load (&writer_tid) == 0)
+      usleep (1000);
+    support_process_state_wait (atomic_load (&writer_tid),
+				support_process_state_sleeping);
+    xpthread_barrier_wait (&barrier);
+    xpthread_join (reader);
+    xpthread_join (writer);
+    usleep (100 * 1000);
+  }
+
+  /* A writer revoking the bias must not block recursive read locks of a
+     thread that holds the rwlock.  */
+  {
+    read_once (&lock);
+    pthread_t reader = xpthread_create (NULL, recursive_reader_thread, NULL);
+    xpthread_barrier_wait (&barrier);
+    pthread_t writer = xpthread_create (NULL, writer_thread, NULL);
+    xpthread_join (reader);
+    xpthread_join (writer);
+  }
+
+  /* Mutual exclusion under contention.  */
+  {
+    pthread_t threads[stress_threads];
+    for (int i = 0; i < stress_threads; ++i)
+      threads[i] = xpthread_create (NULL, stress_thread,
+				    (void *) (unsigned long int) (i + 1));
+    for (int i = 0; i < stress_threads; ++i)
+      xpthread_join (threads[i]);
+    TEST_COMPARE (atomic_load (&mismatches), 0);
+    TEST_COMPARE (counter1, counter2);
+  }
+
+  xpthread_barrier_destroy (&barrier);
+  TEST_COMPARE (pthread_rwlock_destroy (&lock), 0);
+
+  /* Process-shared rwlocks of this kind work, but never become
+     biased.  */
+  {
+    pthread_rwlock_t shared;
+    init_biased (&shared, PTHREAD_PROCESS_SHARED);
+    read_once (&shared);
+    xpthread_rwlock_rdlock (&shared);
+    TEST_COMPARE (pthread_rwlock_trywrlock (&shared), EBUSY);
+    xpthread_rwlock_unlock (&shared);
+    xpthread_rwlock_wrlock (&shared);
+    TEST_COMPARE (pthread_rwlock_tryrdlock (&shared), EBUSY);
+    xpthread_rwlock_unlock (&shared);
+    TEST_COMPARE (pthread_rwlock_destroy (&shared), 0);
+  }
+
+  return 0;
+}
+
+#include <support/test-driver.c>
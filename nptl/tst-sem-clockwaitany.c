@@ -0,0 +1,210 @@
+/* Test sem_clockwaitany_np.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <errno.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <support/check.h>
+#include <support/timespec.h>
+#include <support/xthread.h>
+#include <support/xtime.h>
+
+enum { nsems = 4 };
+
+static sem_t sem_storage[nsems];
+static sem_t *sems[nsems];
+
+static int
+sem_value (sem_t *sem)
+{
+  int value;
+  TEST_COMPARE (sem_getvalue (sem, &value), 0);
+  return value;
+}
+
+static struct timespec
+timeout_in (int msec)
+{
+  return timespec_add (xclock_now (CLOCK_MONOTONIC),
+		       make_timespec (0, msec * 1000 * 1000));
+}
+
+static void *
+waitany_thread (void *closure)
+{
+  return (void *) (intptr_t) sem_clockwaitany_np (sems, nsems,
+						  CLOCK_MONOTONIC, NULL);
+}
+
+/* A mix of threads waiting on one semaphore and on all of them consume
+   the tokens of one poster.  A lost wake-up makes the test time out.  */
+
+enum { single_threads = nsems, any_threads = 3, tokens = 20000 };
+
+static atomic_int consumed;
+static atomic_bool stop;
+
+static void *
+single_consumer (void *closure)
+{
+  sem_t *sem = closure;
+  while (true)
+    {
+      while (sem_wait (sem) != 0)
+	TEST_COMPARE (errno, EINTR);
+      if (atomic_load (&stop))
+	break;
+      atomic_fetch_add (&consumed, 1);
+    }
+  return NULL;
+}
+
+static void *
+any_consumer (void *closure)
+{
+  while (true)
+    {
+      int r = sem_clockwaitany_np (sems, nsems, CLOCK_REALTIME, NULL);
+      if (r < 0)
+	{
+	  TEST_COMPARE (errno, EINTR);
+	  continue;
+	}
+      TEST_VERIFY (r < nsems);
+      if (atomic_load (&stop))
+	break;
+      atomic_fetch_add (&consumed, 1);
+    }
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  /* The last semaphore is process-shared, so that the array mixes both
+     kinds of futexes.  */
+  for (int i = 0; i < nsems; ++i)
+    {
+      TEST_COMPARE (sem_init (&sem_storage[i], i == nsems - 1, 0), 0);
+      sems[i] = &sem_storage[i];
+    }
+
+  /* Invalid arguments.  */
+  struct timespec ts = timeout_in (0);
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (sems, 0, CLOCK_MONOTONIC, &ts), -1);
+  TEST_COMPARE (errno, EINVAL);
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_PROCESS_CPUTIME_ID,
+				     &ts), -1);
+  TEST_COMPARE (errno, EINVAL);
+  ts.tv_nsec = -1;
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_MONOTONIC, &ts), -1);
+  TEST_COMPARE (errno, EINVAL);
+  sem_t *too_many[129];
+  for (int i = 0; i < 129; ++i)
+    too_many[i] = sems[0];
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (too_many, 129, CLOCK_MONOTONIC, NULL),
+		-1);
+  TEST_COMPARE (errno, EINVAL);
+
+  /* An available token is taken without blocking, even if the timeout
+     has already passed.  */
+  TEST_COMPARE (sem_post (sems[2]), 0);
+  ts = make_timespec (0, 0);
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_MONOTONIC, &ts), 2);
+  TEST_COMPARE (sem_value (sems[2]), 0);
+
+  /* The first semaphore with a token is used.  */
+  TEST_COMPARE (sem_post (sems[3]), 0);
+  TEST_COMPARE (sem_post (sems[1]), 0);
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_MONOTONIC, NULL), 1);
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_MONOTONIC, NULL), 3);
+
+  /* Timeouts.  This is the first call which needs futex_waitv.  */
+  ts = timeout_in (50);
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_MONOTONIC, &ts), -1);
+  if (errno == ENOSYS)
+    FAIL_UNSUPPORTED ("kernel does not support futex_waitv");
+  TEST_COMPARE (errno, ETIMEDOUT);
+  TEST_TIMESPEC_NOW_OR_AFTER (CLOCK_MONOTONIC, ts);
+  ts = timespec_add (xclock_now (CLOCK_REALTIME),
+		     make_timespec (0, 50 * 1000 * 1000));
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (sems, nsems, CLOCK_REALTIME, &ts), -1);
+  TEST_COMPARE (errno, ETIMEDOUT);
+  /* A single semaphore does not use futex_waitv.  */
+  ts = timeout_in (10);
+  errno = 0;
+  TEST_COMPARE (sem_clockwaitany_np (sems, 1, CLOCK_MONOTONIC, &ts), -1);
+  TEST_COMPARE (errno, ETIMEDOUT);
+
+  /* Wake-up by a post to each of the semaphores.  */
+  for (int i = 0; i < nsems; ++i)
+    {
+      pthread_t thr = xpthread_create (NULL, waitany_thread, NULL);
+      usleep (10 * 1000);
+      TEST_COMPARE (sem_post (sems[i]), 0);
+      TEST_COMPARE ((intptr_t) xpthread_join (thr), i);
+      for (int j = 0; j < nsems; ++j)
+	TEST_COMPARE (sem_value (sems[j]), 0);
+    }
+
+  /* Cancellation while blocked.  The thread is no longer a waiter
+     afterwards, so the tokens stay available.  */
+  {
+    pthread_t thr = xpthread_create (NULL, waitany_thread, NULL);
+    usleep (10 * 1000);
+    xpthread_cancel (thr);
+    TEST_VERIFY (xpthread_join (thr) == PTHREAD_CANCELED);
+    TEST_COMPARE (sem_post (sems[0]), 0);
+    TEST_COMPARE (sem_trywait (sems[0]), 0);
+  }
+
+  /* Concurrent waiters on single semaphores and on all of them.  */
+  pthread_t threads[single_threads + any_threads];
+  for (int i = 0; i < single_threads; ++i)
+    threads[i] = xpthread_create (NULL, single_consumer, sems[i]);
+  for (int i = 0; i < any_threads; ++i)
+    threads[single_threads + i] = xpthread_create (NULL, any_consumer, NULL);
+  for (int i = 0; i < tokens; ++i)
+    TEST_COMPARE (sem_post (sems[(i * 7) % nsems]), 0);
+  while (atomic_load (&consumed) < tokens)
+    usleep (1000);
+  TEST_COMPARE (atomic_load (&consumed), tokens);
+  /* Enough tokens to let every thread exit.  */
+  atomic_store (&stop, true);
+  for (int i = 0; i < nsems; ++i)
+    for (int j = 0; j < single_threads + any_threads; ++j)
+      TEST_COMPARE (sem_post (sems[i]), 0);
+  for (int i = 0; i < single_threads + any_threads; ++i)
+    xpthread_join (threads[i]);
+
+  for (int i = 0; i < nsems; ++i)
+    TEST_COMPARE (sem_destroy (sems[i]), 0);
+  return 0;
+}
+
+#include <support/test-driver.c>
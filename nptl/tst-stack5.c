@@ -0,0 +1,253 @@
+/* Test reuse of cached thread stacks of different sizes.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* Threads with stacks of several sizes are created and joined or
+   detached repeatedly, so that stacks go through the stack cache, and
+   the memory of some cached stacks is returned to the kernel.  Every
+   thread checks that its stack is large enough and uses most of it.
+   The same happens in a child process after fork, which moves the
+   stacks of the other threads into the cache.  One of these threads
+   has exited without being joined, so its stack memory has not been
+   returned to the kernel yet, and the accounting of that memory is
+   checked in the child: the memory of the most recently cached stack
+   must be kept while the other cached stacks are advised.  */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <support/check.h>
+#include <support/xthread.h>
+#include <support/xunistd.h>
+
+enum { nsizes = 5, rounds = 50, threads_per_round = 8 };
+
+static size_t sizes[nsizes];
+static pthread_attr_t attrs[nsizes];
+static atomic_int detached_running;
+
+/* Larger stacks, whose unused memory alone exceeds the limit for the
+   resident memory of cached stacks in the test environment.  */
+static size_t large_size;
+static pthread_attr_t large_attr;
+
+/* The TID of the thread which exits before fork.  */
+static atomic_int exited_tid;
+
+static void *
+thread_func (void *closure)
+{
+  size_t requested = (uintptr_t) closure;
+
+  pthread_attr_t attr;
+  TEST_COMPARE (pthread_getattr_np (pthread_self (), &attr), 0);
+  size_t size;
+  void *addr;
+  TEST_COMPARE (pthread_attr_getstack (&attr, &addr, &size), 0);
+  TEST_VERIFY (size >= requested);
+  xpthread_attr_destroy (&attr);
+
+  /* Use half of the stack.  */
+  size_t touch = requested / 2;
+  char buf[touch];
+  memset (buf, 0xa5, touch);
+  __asm__ volatile ("" : : "r" (buf) : "memory");
+  return NULL;
+}
+
+static void *
+detached_func (void *closure)
+{
+  thread_func (closure);
+  atomic_fetch_sub (&detached_running, 1);
+  return NULL;
+}
+
+static void
+run_rounds (void)
+{
+  for (int round = 0; round < rounds; ++round)
+    {
+      pthread_t threads[threads_per_round];
+      for (int i = 0; i < threads_per_round; ++i)
+	{
+	  int s = (round + i) % nsizes;
+	  threads[i] = xpthread_create (&attrs[s], thread_func,
+					(void *) (uintptr_t) sizes[s]);
+	}
+      /* A detached thread adds its stack to the cache itself.  */
+      int s = round % nsizes;
+      atomic_fetch_add (&detached_running, 1);
+      pthread_t thr = xpthread_create (&attrs[s], detached_func,
+				       (void *) (uintptr_t) sizes[s]);
+      xpthread_detach (thr);
+      for (int i = 0; i < threads_per_round; ++i)
+	xpthread_join (threads[i]);
+    }
+  while (atomic_load (&detached_running) > 0)
+    usleep (1000);
+}
+
+static void
+run_large (void)
+{
+  xpthread_join (xpthread_create (&large_attr, thread_func,
+				  (void *) (uintptr_t) large_size));
+}
+
+static void *
+exiting_func (void *closure)
+{
+  atomic_store (&exited_tid, gettid ());
+  return thread_func ((void *) (uintptr_t) large_size);
+}
+
+/* Return the lowest address of the stack of the calling thread.  */
+static unsigned char *
+stack_bottom (void)
+{
+  pthread_attr_t attr;
+  TEST_COMPARE (pthread_getattr_np (pthread_self (), &attr), 0);
+  size_t size;
+  void *addr;
+  TEST_COMPARE (pthread_attr_getstack (&attr, &addr, &size), 0);
+  xpthread_attr_destroy (&attr);
+  return addr;
+}
+
+static const unsigned char marker[] = "tst-stack5 marker";
+
+/* Write MARKER to the unused end of the stack of the thread, and
+   return its address.  */
+static void *
+marker_func (void *closure)
+{
+  unsigned char *bottom = stack_bottom ();
+  memcpy (bottom, marker, sizeof (marker));
+  return bottom;
+}
+
+/* Return true if the stack of the thread has the address CLOSURE and
+   still contains MARKER.  */
+static void *
+check_marker_func (void *closure)
+{
+  unsigned char *bottom = stack_bottom ();
+  if (bottom != closure)
+    {
+      puts ("warning: stack not reused, marker not checked");
+      return (void *) (uintptr_t) true;
+    }
+  return (void *) (uintptr_t) (memcmp (bottom, marker,
+				       sizeof (marker)) == 0);
+}
+
+/* Run in the child after fork.  The stack of the thread which exited
+   before fork is reused first, which subtracts its memory from the
+   accounted resident memory of the stack cache.  */
+static void
+check_unjoined_stack (void)
+{
+  run_large ();
+  void *bottom = xpthread_join (xpthread_create (&attrs[0], marker_func,
+						 NULL));
+  /* These threads exceed the limit for resident cached stacks, so
+     older stacks are advised, but the most recent one is kept.  */
+  for (int i = 0; i < 4; ++i)
+    run_large ();
+  TEST_VERIFY (xpthread_join (xpthread_create (&attrs[0], check_marker_func,
+					       bottom)));
+}
+
+static void *
+blocked_func (void *closure)
+{
+  pthread_barrier_t *barrier = closure;
+  xpthread_barrier_wait (barrier);
+  xpthread_barrier_wait (barrier);
+  return NULL;
+}
+
+static int
+do_test (void)
+{
+  long int pagesize = sysconf (_SC_PAGESIZE);
+  size_t minstack = sysconf (_SC_THREAD_STACK_MIN);
+  for (int i = 0; i < nsizes; ++i)
+    {
+      /* Sizes in different buckets, and sizes in the same bucket.  */
+      sizes[i] = minstack + (64 * 1024 << (i / 2)) + i * pagesize;
+      xpthread_attr_init (&attrs[i]);
+      xpthread_attr_setstacksize (&attrs[i], sizes[i]);
+    }
+  large_size = minstack + 1024 * 1024;
+  xpthread_attr_init (&large_attr);
+  xpthread_attr_setstacksize (&large_attr, large_size);
+
+  run_rounds ();
+
+  /* Threads still running at fork time.  */
+  pthread_barrier_t barrier;
+  xpthread_barrier_init (&barrier, NULL, 3);
+  pthread_t blocked[2];
+  for (int i = 0; i < 2; ++i)
+    blocked[i] = xpthread_create (&attrs[i * 3], blocked_func, &barrier);
+  xpthread_barrier_wait (&barrier);
+
+  /* A thread which has exited, but is not joined before fork.  Wait
+     until the kernel has removed it, after it has recorded its unused
+     stack memory.  */
+  pthread_t exited = xpthread_create (&large_attr, exiting_func, NULL);
+  while (atomic_load (&exited_tid) == 0)
+    usleep (1000);
+  char task[64];
+  snprintf (task, sizeof (task), "/proc/self/task/%d",
+	    atomic_load (&exited_tid));
+  struct stat64 st;
+  while (stat64 (task, &st) == 0)
+    usleep (1000);
+
+  pid_t pid = xfork ();
+  if (pid == 0)
+    {
+      check_unjoined_stack ();
+      run_rounds ();
+      _exit (0);
+    }
+
+  xpthread_barrier_wait (&barrier);
+  for (int i = 0; i < 2; ++i)
+    xpthread_join (blocked[i]);
+  xpthread_join (exited);
+  int status;
+  xwaitpid (pid, &status, 0);
+  TEST_COMPARE (status, 0);
+
+  run_rounds ();
+
+  xpthread_barrier_destroy (&barrier);
+  for (int i = 0; i < nsizes; ++i)
+    xpthread_attr_destroy (&attrs[i]);
+  xpthread_attr_destroy (&large_attr);
+  return 0;
+}
+
+#include <support/test-driver.c>
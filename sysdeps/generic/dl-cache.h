@@ -220,10 +220,33 @@ enum cache_extension_tag
       size must be a multiple of 4.  */
    cache_extension_tag_glibc_hwcaps,
 
+   /* Hash index for the library entries, so that the dynamic loader
+      does not have to binary-search the entry array.  An array of
+      struct cache_hash_index_slot elements, which is an
+      open-addressing hash table with linear probing, keyed by
+      _dl_cache_hash of the library name.  For every distinct name
+      (according to _dl_cache_libcmp), there is one slot holding the
+      index of the first entry with that name; the entries for the
+      glibc-hwcaps subdirectories and the regular entry follow it.
+
+      For this section, 4-byte alignment is required, and the number
+      of slots must be a power of two.  At least one slot must be
+      empty.  */
+   cache_extension_tag_hash_index,
+
    /* Total number of known cache extension tags.  */
    cache_extension_count
   };
 
+/* Element of the cache_extension_tag_hash_index section.  */
+struct cache_hash_index_slot
+{
+  uint32_t hash;		/* _dl_cache_hash of the key.  */
+  uint32_t entry;		/* Entry index, or cache_hash_index_empty.  */
+};
+
+enum { cache_hash_index_empty = (uint32_t) -1 };
+
 /* Element in the array following struct cache_extension.  Similar to
    an ELF section header.  */
 struct cache_extension_section
@@ -293,6 +316,22 @@ cache_extension_verify (struct cache_extension_all_loaded *loaded)
 	hwcaps->flags = 0;
       }
   }
+  {
+    /* Section must be aligned at 4 bytes, and the number of slots
+       must be a power of two.  */
+    struct cache_extension_loaded *index
+      = &loaded->sections[cache_extension_tag_hash_index];
+    size_t nslots = index->size / sizeof (struct cache_hash_index_slot);
+    if (nslots == 0
+	|| ((uintptr_t) index->base % 4) != 0
+	|| (index->size % sizeof (struct cache_hash_index_slot)) != 0
+	|| (nslots & (nslots - 1)) != 0)
+      {
+	index->base = NULL;
+	index->size = 0;
+	index->flags = 0;
+      }
+  }
 }
 
 static bool __attribute__ ((unused))
@@ -352,4 +391,55 @@ cache_extension_load (const struct cache_file_new *cache,
 
 extern int _dl_cache_libcmp (const char *p1, const char *p2) attribute_hidden;
 
+/* Hash function for the cache_extension_tag_hash_index section.
+   Names which are equal according to _dl_cache_libcmp have the same
+   hash value, so leading zeros of numbers are skipped.  */
+static inline uint32_t
+_dl_cache_hash (const char *name)
+{
+  uint32_t hash = 5381;
+  bool in_number = false;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0';
+       ++p)
+    {
+      bool digit = *p >= '0' && *p <= '9';
+      if (digit && *p == '0' && !in_number)
+	continue;
+      in_number = digit;
+      hash = hash * 33 + *p;
+    }
+  return hash;
+}
+
+/* Use the hash index SLOTS with NSLOTS slots to find NAME among the
+   NLIBS entries of size ENTRY_SIZE at LIBS.  Return the index of the
+   first entry for NAME, or -1 if there is none.  Keys are offsets
+   into STRING_TABLE, which is at least STRING_TABLE_SIZE bytes
+   long.  */
+static int __attribute__ ((unused))
+cache_hash_index_lookup (const struct cache_hash_index_slot *slots,
+			 uint32_t nslots, const char *string_table,
+			 uint32_t string_table_size,
+			 const struct file_entry *libs, uint32_t nlibs,
+			 uint32_t entry_size, const char *name)
+{
+  uint32_t hash = _dl_cache_hash (name);
+  uint32_t mask = nslots - 1;
+  for (uint32_t i = hash & mask, probes = 0; probes < nslots;
+       i = (i + 1) & mask, ++probes)
+    {
+      if (slots[i].entry == cache_hash_index_empty)
+	break;
+      if (slots[i].hash == hash && slots[i].entry < nlibs)
+	{
+	  const struct file_entry *lib
+	    = (const void *) libs + (size_t) slots[i].entry * entry_size;
+	  if (lib->key < string_table_size
+	      && _dl_cache_libcmp (name, string_table + lib->key) == 0)
+	    return slots[i].entry;
+	}
+    }
+  return -1;
+}
+
 #endif /* _DL_CACHE_H */
@@ -0,0 +1,47 @@
+/* Helper threads for the dynamic linker.  Generic stub version.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_HELPER_THREAD_H
+#define _DL_HELPER_THREAD_H
+
+#include <stdbool.h>
+
+/* Helper threads run before the thread library is initialized.  They
+   must not use TLS, allocate memory with malloc or take locks.  This
+   version does not support them.  */
+struct dl_helper_thread
+{
+  int unused;
+};
+
+/* Run FN (ARG) on a new helper thread described by *THREAD.  Return
+   false if the thread cannot be created.  */
+static inline bool
+_dl_helper_thread_start (struct dl_helper_thread *thread,
+			 int (*fn) (void *), void *arg)
+{
+  return false;
+}
+
+/* Wait for the helper thread started with *THREAD to exit.  */
+static inline void
+_dl_helper_thread_join (struct dl_helper_thread *thread)
+{
+}
+
+#endif /* _DL_HELPER_THREAD_H */
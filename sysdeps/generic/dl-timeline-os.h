@@ -0,0 +1,39 @@
+/* System interfaces for LD_DEBUG=timeline.  Generic version.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_TIMELINE_OS_H
+#define _DL_TIMELINE_OS_H
+
+#include <time.h>
+#include <unistd.h>
+
+/* Store the current CLOCK_MONOTONIC time in *TS.  */
+static inline void
+_dl_timeline_clock (struct __timespec64 *ts)
+{
+  __clock_gettime64 (CLOCK_MONOTONIC, ts);
+}
+
+/* Return the ID of the calling thread for the trace.  */
+static inline int
+_dl_timeline_tid (void)
+{
+  return __getpid ();
+}
+
+#endif /* _DL_TIMELINE_OS_H */
@@ -207,6 +207,11 @@ struct r_search_path_elem
     const char *dirname;
     size_t dirnamelen;
 
+    /* Names of the files in the directory and its hwcaps
+       subdirectories, read on first use if glibc.rtld.path_cache is
+       enabled, or NULL.  See elf/dl-path-cache.c.  */
+    struct dl_path_cache_dir **path_cache;
+
     enum r_dir_status status[0];
   };
 
@@ -432,6 +437,9 @@ struct rtld_global
   {
     size_t len;
     struct dtv_slotinfo_list *next;
+    /* Highest generation of the entries in SLOTINFO, so that
+       _dl_update_slotinfo can skip elements without changes.  */
+    size_t gen;
     struct dtv_slotinfo
     {
       size_t gen;
@@ -476,8 +484,10 @@ struct rtld_global
   /* List of thread stacks that were allocated by the application.  */
   EXTERN list_t _dl_stack_user;
 
-  /* List of queued thread stacks.  */
-  EXTERN list_t _dl_stack_cache;
+  /* Lists of queued thread stacks, by size class (see
+     __nptl_stack_cache_bucket).  */
+#define DL_STACK_CACHE_BUCKETS 16
+  EXTERN list_t _dl_stack_cache[DL_STACK_CACHE_BUCKETS];
 
   /* Total size of all stacks in the cache (sum over stackblock_size).  */
   EXTERN size_t _dl_stack_cache_actsize;
@@ -541,8 +551,10 @@ struct rtld_global_ro
 #define DL_DEBUG_STATISTICS (1 << 7)
 #define DL_DEBUG_UNUSED	    (1 << 8)
 #define DL_DEBUG_SCOPES	    (1 << 9)
+#define DL_DEBUG_TLS	    (1 << 10)
+#define DL_DEBUG_TIMELINE   (1 << 11)
 /* These two are used only internally.  */
-#define DL_DEBUG_HELP       (1 << 10)
+#define DL_DEBUG_HELP       (1 << 12)
 
   /* Platform name.  */
   EXTERN const char *_dl_platform;
@@ -665,6 +677,10 @@ struct rtld_global_ro
 				   struct link_map *);
   void *(*_dl_open) (const char *file, int mode, const void *caller_dlopen,
 		     Lmid_t nsid, int argc, char *argv[], char *env[]);
+  void (*_dl_open_many) (const char *const files[], size_t count, int mode,
+			 const void *caller_dlopen, Lmid_t nsid,
+			 void *handles[], int argc, char *argv[],
+			 char *env[]);
   void (*_dl_close) (void *map);
   /* libdl in a secondary namespace (after dlopen) must use
      _dl_catch_error from the main namespace, so it has to be
@@ -970,6 +986,11 @@ enum
     /* Set if dl_lookup is called for non-lazy relocation processing
        from _dl_relocate_object in elf/dl-reloc.c.  */
     DL_LOOKUP_FOR_RELOCATE = 8,
+    /* Set if dl_lookup is called ahead of relocation on a helper
+       thread.  Undefined symbols are not reported, and unique symbols
+       are returned without entering them into the unique symbol
+       table.  */
+    DL_LOOKUP_PREFETCH = 16,
   };
 
 /* Lookup versioned symbol.  */
@@ -1235,6 +1256,17 @@ extern void *_dl_open (const char *name, int mode, const void *caller,
 		       Lmid_t nsid, int argc, char *argv[], char *env[])
      attribute_hidden;
 
+/* Open the COUNT shared objects named in FILES like _dl_open, and
+   store their maps in HANDLES.  All the objects are mapped before any
+   of them is relocated, and the initializers of the new objects run
+   in a single pass once all are relocated.  On error, none of the
+   objects remains open.  */
+extern void _dl_open_many (const char *const files[], size_t count,
+			   int mode, const void *caller, Lmid_t nsid,
+			   void *handles[], int argc, char *argv[],
+			   char *env[])
+     attribute_hidden;
+
 /* Free or queue for freeing scope OLD.  If other threads might be
    in the middle of _dl_fixup, _dl_profile_fixup or dl*sym using the
    old scope, OLD can't be freed until no thread is using it.  */
@@ -30,6 +30,12 @@ __malloc_thp_mode (void)
   return malloc_thp_mode_not_supported;
 }
 
+size_t
+__malloc_thp_usage (const void *start, size_t len)
+{
+  return 0;
+}
+
 /* Return the default transparent huge page size.  */
 void
 __malloc_hugepage_config (size_t requested, size_t *pagesize, int *flags)
@@ -34,6 +34,12 @@ enum malloc_thp_mode_t
 
 enum malloc_thp_mode_t __malloc_thp_mode (void) attribute_hidden;
 
+/* Return the number of bytes of the LEN bytes starting at START which are
+   currently backed by transparent huge pages, or 0 if this cannot be
+   determined.  Only mappings which lie entirely within the range are
+   taken into account.  */
+size_t __malloc_thp_usage (const void *start, size_t len) attribute_hidden;
+
 /* Return the supported huge page size from the REQUESTED sizes on PAGESIZE
    along with the required extra mmap flags on FLAGS,  Requesting the value
    of 0 returns the default huge page size, otherwise the value will be
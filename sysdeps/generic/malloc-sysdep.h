@@ -26,3 +26,26 @@ check_may_shrink_heap (void)
 {
   return __libc_enable_secure;
 }
+
+/* Return the number of the CPU the calling thread is running on, or -1
+   if it cannot be determined cheaply.  */
+static inline int
+malloc_cpu_id (void)
+{
+  return -1;
+}
+
+/* Return the NUMA node of the CPU the calling thread is running on, or
+   -1 if it is not known.  */
+static inline int
+malloc_numa_node (void)
+{
+  return -1;
+}
+
+/* Ask for the pages in [ADDR, ADDR + LEN) to be placed on NUMA node
+   NODE.  This is only a hint.  */
+static inline void
+malloc_bind_node (void *addr, size_t len, int node)
+{
+}
@@ -24,6 +24,7 @@
 #include <ldsodefs.h>
 #include <list.h>
 #include <mqueue.h>
+#include <nptl/nptl-stack.h>
 #include <pthreadP.h>
 #include <sysdep.h>
 
@@ -75,8 +76,13 @@ reclaim_stacks (void)
 
 	  if (GL (dl_stack_used).next->prev != &GL (dl_stack_used))
 	    l = &GL (dl_stack_used);
-	  else if (GL (dl_stack_cache).next->prev != &GL (dl_stack_cache))
-	    l = &GL (dl_stack_cache);
+	  else
+	    for (size_t i = 0; i < DL_STACK_CACHE_BUCKETS; ++i)
+	      if (GL (dl_stack_cache)[i].next->prev != &GL (dl_stack_cache)[i])
+		{
+		  l = &GL (dl_stack_cache)[i];
+		  break;
+		}
 
 	  if (l != NULL)
 	    {
@@ -106,8 +112,11 @@ reclaim_stacks (void)
 	  /* This marks the stack as free.  */
 	  curp->tid = 0;
 
-	  /* Account for the size of the stack.  */
+	  /* Account for the size of the stack, and for the memory which
+	     a thread that has exited without being joined has not
+	     returned to the kernel yet.  */
 	  GL (dl_stack_cache_actsize) += curp->stackblock_size;
+	  __nptl_stack_cache_resident += curp->stackblock_unadvised_size;
 
 	  if (curp->specific_used)
 	    {
@@ -131,12 +140,23 @@ reclaim_stacks (void)
 	}
     }
 
-  /* Add the stack of all running threads to the cache.  */
-  list_splice (&GL (dl_stack_used), &GL (dl_stack_cache));
+  /* Add the stack of all running threads to the cache, in the bucket
+     for their size.  */
+  list_t *prevp;
+  list_for_each_prev_safe (runp, prevp, &GL (dl_stack_used))
+    {
+      struct pthread *curp = list_entry (runp, struct pthread, list);
+      if (curp != self)
+	{
+	  list_del (runp);
+	  list_add (runp, &GL (dl_stack_cache)[__nptl_stack_cache_bucket
+					       (curp->stackblock_size)]);
+	}
+    }
 
-  /* Remove the entry for the current thread to from the cache list
-     and add it to the list of running threads.  Which of the two
-     lists is decided by the user_stack flag.  */
+  /* Remove the entry for the current thread from its list and add it
+     to the list of running threads.  Which of the two lists is decided
+     by the user_stack flag.  */
   list_del (&self->list);
 
   /* Re-initialize the lists for all the threads.  */
@@ -23,6 +23,7 @@
 #include <sys/time.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <lowlevellock-futex.h>
 #include <libc-diag.h>
 
@@ -312,6 +313,51 @@ __futex_abstimed_wait64 (unsigned int* futex_word, unsigned int expected,
                          int private);
 libc_hidden_proto (__futex_abstimed_wait64);
 
+/* One futex word for __futex_waitv_cancelable64.  The layout matches
+   struct futex_waitv of the Linux futex_waitv system call.  */
+struct futex_waitv_item
+{
+  uint64_t val;
+  uint64_t uaddr;
+  uint32_t flags;
+  uint32_t __reserved;
+};
+
+/* The largest number of futex words __futex_waitv_cancelable64 accepts.  */
+#define FUTEX_WAITV_MAX 128
+
+/* Set up ITEM so that __futex_waitv_cancelable64 blocks on FUTEX_WORD while
+   it contains EXPECTED.  PRIVATE is as for futex_wait.  */
+static __always_inline void
+futex_waitv_item_init (struct futex_waitv_item *item,
+		       unsigned int *futex_word, unsigned int expected,
+		       int private)
+{
+  item->val = expected;
+  item->uaddr = (uintptr_t) futex_word;
+  item->flags = (FUTEX2_SIZE_U32
+		 | (private == FUTEX_PRIVATE ? FUTEX2_PRIVATE : 0));
+  item->__reserved = 0;
+}
+
+/* Block until one of the NITEMS futex words described by ITEMS is woken
+   by futex_wake, or until ABSTIME (if not NULL) has passed on the clock
+   CLOCKID.  NITEMS must be between 1 and FUTEX_WAITV_MAX.  The wait
+   does not block if any of the futex words does not contain its expected
+   value; which futex word caused the return is not reported because
+   the callers have to recheck all of them anyway.
+
+   Returns the same values as __futex_abstimed_wait_cancelable64, and
+   additionally ENOSYS if the kernel does not support the futex_waitv
+   system call (Linux 5.16 or later is required).
+
+   The call acts as a cancellation entrypoint.  */
+int
+__futex_waitv_cancelable64 (struct futex_waitv_item *items,
+			    unsigned int nitems, clockid_t clockid,
+			    const struct __timespec64 *abstime);
+libc_hidden_proto (__futex_waitv_cancelable64);
+
 
 static __always_inline int
 __futex_clocklock64 (int *futex, clockid_t clockid,
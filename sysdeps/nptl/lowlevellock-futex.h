@@ -42,6 +42,10 @@
 #define FUTEX_PRIVATE_FLAG	128
 #define FUTEX_CLOCK_REALTIME	256
 
+/* Flags of the futex words passed to futex_waitv.  */
+#define FUTEX2_SIZE_U32		0x02
+#define FUTEX2_PRIVATE		FUTEX_PRIVATE_FLAG
+
 #define FUTEX_BITSET_MATCH_ANY	0xffffffff
 
 /* Values for 'private' parameter of locking macros.  Yes, the
@@ -60,6 +60,8 @@ enum
 #ifdef __USE_GNU
   /* For compatibility.  */
   , PTHREAD_MUTEX_FAST_NP = PTHREAD_MUTEX_TIMED_NP
+  /* Prefers handing the lock to threads on the same NUMA node.  */
+  , PTHREAD_MUTEX_COHORT_NP = 4
 #endif
 };
 
@@ -106,6 +108,7 @@ enum
   PTHREAD_RWLOCK_PREFER_READER_NP,
   PTHREAD_RWLOCK_PREFER_WRITER_NP,
   PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP,
+  PTHREAD_RWLOCK_READER_BIASED_NP,
   PTHREAD_RWLOCK_DEFAULT_NP = PTHREAD_RWLOCK_PREFER_READER_NP
 };
 
@@ -1334,6 +1337,51 @@ extern int pthread_atfork (void (*__prepare) (void),
 			   void (*__child) (void)) __THROW;
 
 
+#ifdef __USE_GNU
+/* Thread pools.  */
+
+/* A pool of worker threads which run submitted tasks.  */
+typedef struct pthread_pool_np pthread_pool_np_t;
+
+/* A group of tasks for which pthread_pool_wait_np can wait.  */
+typedef struct
+{
+  unsigned int __pending;
+  unsigned int __reserved;
+} pthread_pool_group_np_t;
+
+# define PTHREAD_POOL_GROUP_INITIALIZER_NP { 0, 0 }
+
+/* Create a pool with NWORKERS worker threads and store it in *POOL.  If
+   NWORKERS is zero, use one worker per CPU the process may run on,
+   taking its affinity mask and CPU quota into account.  */
+extern int pthread_pool_create_np (pthread_pool_np_t **__pool,
+				   unsigned int __nworkers)
+     __THROW __nonnull ((1));
+
+/* Run the remaining tasks of POOL, terminate its workers and free it.  */
+extern int pthread_pool_destroy_np (pthread_pool_np_t *__pool)
+     __nonnull ((1));
+
+/* Return the pool shared by all users in the process, creating it if
+   necessary, or NULL if it cannot be created.  */
+extern pthread_pool_np_t *pthread_pool_default_np (void) __THROW;
+
+/* Run FUNC (ARG) on a worker of POOL.  If GROUP is not NULL, the task
+   belongs to it until FUNC returns.  */
+extern int pthread_pool_submit_np (pthread_pool_np_t *__pool,
+				   pthread_pool_group_np_t *__group,
+				   void (*__func) (void *), void *__arg)
+     __nonnull ((1, 3));
+
+/* Wait until all tasks in GROUP have finished.  Called from a worker
+   of POOL, run other tasks of POOL in the meantime.  */
+extern int pthread_pool_wait_np (pthread_pool_np_t *__pool,
+				 pthread_pool_group_np_t *__group)
+     __nonnull ((1, 2));
+#endif
+
+
 #ifdef __USE_EXTERN_INLINES
 /* Optimizations.  */
 __extern_inline int
@@ -22,6 +22,7 @@
 #include <nptl/nptl-stack.h>
 #include <pthreadP.h>
 #include <pthread_mutex_conf.h>
+#include <rseq-internal.h>
 #include <sys/resource.h>
 
 static inline void
@@ -54,6 +55,8 @@ __pthread_early_init (void)
   __default_pthread_attr.internal.guardsize = GLRO (dl_pagesize);
 
   __pthread_tunables_init ();
+
+  __mutex_aconf.cohort_rseq_node = rseq_node_id_supported ();
 }
 
 #endif  /* _PTHREAD_EARLY_INIT_H */
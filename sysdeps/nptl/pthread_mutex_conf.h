@@ -23,6 +23,12 @@
 struct mutex_config
 {
   int spin_count;
+  /* Maximum number of consecutive reservations of a cohort mutex for
+     the threads of one NUMA node.  */
+  int cohort_passes;
+  /* Nonzero if cohort mutexes can read the NUMA node from the rseq
+     area.  */
+  int cohort_rseq_node;
 };
 
 extern struct mutex_config __mutex_aconf;
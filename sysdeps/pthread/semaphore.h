@@ -96,6 +96,9 @@ extern int __REDIRECT (sem_clockwait,
 # endif
 #endif
 
+/* Get the system-specific extensions.  */
+#include <bits/semaphore_ext.h>
+
 /* Test whether SEM is posted.  */
 extern int sem_trywait (sem_t *__sem) __THROWNL __nonnull ((1));
 
@@ -0,0 +1,48 @@
+/* System-specific extensions of <semaphore.h>, Linux version.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _SEMAPHORE_H
+# error "Never include <bits/semaphore_ext.h> directly; use <semaphore.h> instead."
+#endif
+
+#ifdef __USE_GNU
+
+/* Wait until one of the NSEMS semaphores in SEMS is posted, or only until
+   ABSTIME on clock CLOCK if ABSTIME is not null, and decrement it.  Return
+   the index of the decremented semaphore in SEMS, or -1 on error.
+
+   This function is a cancellation point and therefore not marked with
+   __THROW.  */
+# ifndef __USE_TIME_BITS64
+extern int sem_clockwaitany_np (sem_t *const *__sems, unsigned int __nsems,
+				clockid_t __clock,
+				const struct timespec *__abstime)
+  __nonnull ((1));
+# else
+#  ifdef __REDIRECT
+extern int __REDIRECT (sem_clockwaitany_np,
+                       (sem_t *const *__sems, unsigned int __nsems,
+                        clockid_t __clock,
+                        const struct timespec *__abstime),
+                        __sem_clockwaitany_np64)
+  __nonnull ((1));
+#  else
+#   define sem_clockwaitany_np __sem_clockwaitany_np64
+#  endif
+# endif
+#endif /* __USE_GNU  */
@@ -79,8 +79,8 @@ _dl_make_stacks_executable (void **stack_endp)
   /* Also change the permission for the currently unused stacks.  This
      might be wasted time but better spend it here than adding a check
      in the fast path.  */
-  if (err == 0)
-    list_for_each (runp, &GL (dl_stack_cache))
+  for (size_t i = 0; err == 0 && i < DL_STACK_CACHE_BUCKETS; ++i)
+    list_for_each (runp, &GL (dl_stack_cache)[i])
       {
 	err = __nptl_change_stack_perm (list_entry (runp, struct pthread,
 						    list));
@@ -0,0 +1,119 @@
+/* Helper threads for the dynamic linker.  Linux version.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_HELPER_THREAD_H
+#define _DL_HELPER_THREAD_H
+
+#include <atomic.h>
+#include <libc-pointer-arith.h>
+#include <lowlevellock-futex.h>
+#include <sched.h>
+#include <stackinfo.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/rseq.h>
+#include <tls.h>
+#include <tls-setup.h>
+
+/* Helper threads run before the thread library is initialized.  Each
+   one gets a minimal thread control block at the start of its stack
+   mapping, installed with CLONE_SETTLS, so that THREAD_SELF, the
+   thread ID and the stack protector and pointer guard values are its
+   own.  The TCB has no DTV and no static TLS block: as on the main
+   thread, TLS variables must not be used before relocation is
+   complete, and a helper thread must not allocate memory with malloc
+   or take locks, whose startup versions are not thread-safe.  */
+struct dl_helper_thread
+{
+  /* The mapping holding the TCB and the stack.  */
+  void *stack;
+  struct pthread *pd;
+};
+
+/* Symbol lookups only need a small stack.  */
+#define DL_HELPER_THREAD_STACK_SIZE (64 * 1024)
+
+/* The space for the TCB, which precedes the thread pointer if the DTV
+   is at the thread pointer.  */
+#if TLS_TCB_AT_TP
+# define DL_HELPER_THREAD_TCB_SIZE ALIGN_UP (TLS_TCB_SIZE, TCB_ALIGNMENT)
+#else
+# define DL_HELPER_THREAD_TCB_SIZE \
+  ALIGN_UP (TLS_PRE_TCB_SIZE + TLS_TCB_SIZE, TCB_ALIGNMENT)
+#endif
+
+/* Run FN (ARG) on a new helper thread described by *THREAD.  Return
+   false if the thread cannot be created.  */
+static inline bool
+_dl_helper_thread_start (struct dl_helper_thread *thread,
+			 int (*fn) (void *), void *arg)
+{
+  thread->stack = __mmap (NULL, DL_HELPER_THREAD_STACK_SIZE,
+			  PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (thread->stack == MAP_FAILED)
+    return false;
+
+  /* The mapping is zero-filled, so the TCB has no DTV, and the
+     descriptor fields not set below are in their initial state.  */
+  struct pthread *pd = thread->stack;
+  thread->pd = pd;
+#if TLS_TCB_AT_TP
+  pd->header.self = pd;
+  pd->header.tcb = pd;
+#endif
+#ifdef THREAD_COPY_STACK_GUARD
+  THREAD_COPY_STACK_GUARD (pd);
+#endif
+#ifdef THREAD_COPY_POINTER_GUARD
+  THREAD_COPY_POINTER_GUARD (pd);
+#endif
+  tls_setup_tcbhead (pd);
+  /* Helper threads do not register with rseq.  */
+  pd->rseq_area.cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+
+  void *stack = thread->stack;
+#if _STACK_GROWS_DOWN
+  stack += DL_HELPER_THREAD_STACK_SIZE;
+#else
+  stack += DL_HELPER_THREAD_TCB_SIZE;
+#endif
+  int flags = (CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND
+	       | CLONE_THREAD | CLONE_SYSVSEM | CLONE_SETTLS
+	       | CLONE_PARENT_SETTID | CLONE_CHILD_CLEARTID);
+  TLS_DEFINE_INIT_TP (tp, pd);
+  if (__clone (fn, stack, flags, arg, &pd->tid, (void *) tp, &pd->tid) < 0)
+    {
+      __munmap (thread->stack, DL_HELPER_THREAD_STACK_SIZE);
+      return false;
+    }
+  return true;
+}
+
+/* Wait for the helper thread started with *THREAD to exit.  */
+static inline void
+_dl_helper_thread_join (struct dl_helper_thread *thread)
+{
+  pid_t tid;
+  while ((tid = atomic_load_acquire (&thread->pd->tid)) != 0)
+    lll_futex_wait (&thread->pd->tid, tid, LLL_SHARED);
+  __munmap (thread->stack, DL_HELPER_THREAD_STACK_SIZE);
+}
+
+#endif /* _DL_HELPER_THREAD_H */
@@ -0,0 +1,69 @@
+/* System interfaces for LD_DEBUG=timeline.  Linux version.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#ifndef _DL_TIMELINE_OS_H
+#define _DL_TIMELINE_OS_H
+
+#include <kernel-features.h>
+#include <ldsodefs.h>
+#include <sysdep.h>
+#include <sysdep-vdso.h>
+#include <time.h>
+
+/* Store the current CLOCK_MONOTONIC time in *TS.  The dynamic linker
+   cannot use clock_gettime, so call the vDSO or the system call
+   directly.  Errors result in a zero timestamp.  */
+static inline void
+_dl_timeline_clock (struct __timespec64 *ts)
+{
+#ifdef HAVE_CLOCK_GETTIME64_VSYSCALL
+  int (*vdso_time64) (clockid_t clock_id, struct __timespec64 *tp)
+    = GLRO(dl_vdso_clock_gettime64);
+  if (vdso_time64 != NULL
+      && INTERNAL_VSYSCALL_CALL (vdso_time64, 2, CLOCK_MONOTONIC, ts) == 0)
+    return;
+#endif
+
+#ifndef __NR_clock_gettime64
+# define __NR_clock_gettime64 __NR_clock_gettime
+#endif
+  if (INTERNAL_SYSCALL_CALL (clock_gettime64, CLOCK_MONOTONIC, ts) == 0)
+    return;
+
+#ifndef __ASSUME_TIME64_SYSCALLS
+  struct timespec ts32;
+  if (INTERNAL_SYSCALL_CALL (clock_gettime, CLOCK_MONOTONIC, &ts32) == 0)
+    {
+      *ts = valid_timespec_to_timespec64 (ts32);
+      return;
+    }
+#endif
+
+  ts->tv_sec = 0;
+  ts->tv_nsec = 0;
+}
+
+/* Return the ID of the calling thread for the trace.  The thread
+   control block may not be set up yet.  */
+static inline int
+_dl_timeline_tid (void)
+{
+  return INTERNAL_SYSCALL_CALL (gettid);
+}
+
+#endif /* _DL_TIMELINE_OS_H */
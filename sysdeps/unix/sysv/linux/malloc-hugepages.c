@@ -20,6 +20,7 @@
 #include <dirent.h>
 #include <malloc-hugepages.h>
 #include <not-cancel.h>
+#include <string.h>
 #include <sys/mman.h>
 
 unsigned long int
@@ -78,6 +79,116 @@ __malloc_thp_mode (void)
   return malloc_thp_mode_not_supported;
 }
 
+static uintptr_t
+parse_hex (const char **s)
+{
+  uintptr_t r = 0;
+  for (;; (*s)++)
+    {
+      char c = **s;
+      if (c >= '0' && c <= '9')
+	r = r * 16 + (c - '0');
+      else if (c >= 'a' && c <= 'f')
+	r = r * 16 + (c - 'a' + 10);
+      else
+	return r;
+    }
+}
+
+/* Process one LINE of /proc/self/smaps.  *INSIDE tracks whether the
+   current mapping lies within [LO, HI).  Return false once the mappings
+   are past the range, since the file is sorted by address.  */
+static bool
+thp_usage_line (const char *line, uintptr_t lo, uintptr_t hi, bool *inside,
+		size_t *total)
+{
+  /* Each mapping starts with a line in the form:
+       START-END PERMS OFFSET DEV INODE NAME
+     with lower-case hexadecimal addresses, while the fields which
+     follow start with an upper-case letter.  */
+  if ((line[0] >= '0' && line[0] <= '9') || (line[0] >= 'a' && line[0] <= 'f'))
+    {
+      uintptr_t vstart = parse_hex (&line);
+      if (*line++ != '-')
+	return true;
+      uintptr_t vend = parse_hex (&line);
+      if (vstart >= hi)
+	return false;
+      *inside = vstart >= lo && vend <= hi;
+    }
+  else if (*inside
+	   && strncmp (line, "AnonHugePages:", sizeof ("AnonHugePages:") - 1)
+	      == 0)
+    {
+      /* The value is in the form:
+	   AnonHugePages:      NUMBER kB  */
+      size_t kb = 0;
+      for (line += sizeof ("AnonHugePages:") - 1; *line == ' '; line++)
+	;
+      for (; *line >= '0' && *line <= '9'; line++)
+	kb = kb * 10 + (*line - '0');
+      *total += kb * 1024;
+    }
+  return true;
+}
+
+size_t
+__malloc_thp_usage (const void *start, size_t len)
+{
+  int fd = __open64_nocancel ("/proc/self/smaps", O_RDONLY);
+  if (fd == -1)
+    return 0;
+
+  uintptr_t lo = (uintptr_t) start;
+  uintptr_t hi = lo + len;
+  size_t total = 0;
+  bool inside = false;
+  /* Set while the rest of a line longer than the buffer is skipped.  */
+  bool skip = false;
+
+  char buf[1024];
+  size_t used = 0;
+  while (1)
+    {
+      ssize_t r = __read_nocancel (fd, buf + used, sizeof (buf) - used);
+      if (r <= 0)
+	break;
+      used += r;
+
+      char *line = buf;
+      char *end = buf + used;
+      char *nl;
+      bool more = true;
+      while (more && (nl = memchr (line, '\n', end - line)) != NULL)
+	{
+	  *nl = '\0';
+	  if (skip)
+	    skip = false;
+	  else
+	    more = thp_usage_line (line, lo, hi, &inside, &total);
+	  line = nl + 1;
+	}
+      if (!more)
+	break;
+
+      used = end - line;
+      if (used == sizeof (buf))
+	{
+	  /* Only the name of a mapping can be this long, so the mapping
+	     is ignored.  */
+	  skip = true;
+	  inside = false;
+	  used = 0;
+	}
+      else
+	memmove (buf, line, used);
+    }
+
+  __close_nocancel (fd);
+
+  return total;
+}
+
 static size_t
 malloc_default_hugepage_size (void)
 {
@@ -18,6 +18,8 @@
 
 #include <fcntl.h>
 #include <not-cancel.h>
+#include <sysdep.h>
+#include <tls.h>
 
 /* The Linux kernel overcommits address space by default and if there is not
    enough memory available, it uses various parameters to decide the process to
@@ -56,4 +58,50 @@ check_may_shrink_heap (void)
   return may_shrink_heap;
 }
 
+/* Return the number of the CPU the calling thread is running on, as
+   maintained by the kernel in the rseq area, or a negative value if
+   rseq is not registered.  Unlike sched_getcpu, do not fall back to a
+   system call.  */
+static inline int
+malloc_cpu_id (void)
+{
+  return (int) THREAD_GETMEM_VOLATILE (THREAD_SELF, rseq_area.cpu_id);
+}
+
+/* Return the NUMA node of the CPU the calling thread is running on, or
+   -1 if it is not known.  */
+static inline int
+malloc_numa_node (void)
+{
+  unsigned int cpu, node;
+  int r = INTERNAL_SYSCALL_CALL (getcpu, &cpu, &node, NULL);
+  if (INTERNAL_SYSCALL_ERROR_P (r))
+    return -1;
+  return node;
+}
+
+/* Ask for the pages in [ADDR, ADDR + LEN) to be placed on NUMA node
+   NODE.  MPOL_PREFERRED is used rather than MPOL_BIND so that the
+   kernel falls back to other nodes instead of failing page faults when
+   NODE runs out of memory.  Errors are ignored, the pages are then
+   placed according to the default policy.  */
+static inline void
+malloc_bind_node (void *addr, size_t len, int node)
+{
+#ifdef __NR_mbind
+  /* MPOL_PREFERRED from <linux/mempolicy.h>.  */
+  enum { mpol_preferred = 1 };
+  enum { max_nodes = 1024 };
+  unsigned long int mask[max_nodes / (8 * sizeof (unsigned long int))] = { 0 };
+  const size_t bits = 8 * sizeof (unsigned long int);
+
+  if (node < 0 || node >= max_nodes)
+    return;
+  mask[node / bits] = 1UL << (node % bits);
+  /* The kernel only looks at the first MAXNODE - 1 bits.  */
+  INTERNAL_SYSCALL_CALL (mbind, addr, len, mpol_preferred, mask,
+			 max_nodes + 1, 0);
+#endif
+}
+
 #define HAVE_MREMAP 1
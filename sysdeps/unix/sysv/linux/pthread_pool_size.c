@@ -0,0 +1,150 @@
+/* Default size of pthread_pool_np thread pools.  Linux version.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <not-cancel.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/sysinfo.h>
+#include <sysdep.h>
+#include <nptl/pthread_poolP.h>
+
+/* Read the file at PATH into BUF, of size SIZE, as a string.  */
+static bool
+read_file (const char *path, char *buf, size_t size)
+{
+  int fd = __open64_nocancel (path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  ssize_t n = __read_nocancel (fd, buf, size - 1);
+  __close_nocancel_nostatus (fd);
+  if (n < 0)
+    return false;
+  buf[n] = '\0';
+  return true;
+}
+
+static uint64_t
+parse_number (const char **p)
+{
+  uint64_t result = 0;
+  while (**p >= '0' && **p <= '9')
+    {
+      result = result * 10 + (**p - '0');
+      ++*p;
+    }
+  return result;
+}
+
+/* Return the number of CPUs which the cpu.max file at PATH allows, or 0
+   if there is no limit.  The file contains the quota and the period, or
+   "max" instead of the quota.  */
+static unsigned int
+read_cpu_max (const char *path)
+{
+  char buf[64];
+  if (!read_file (path, buf, sizeof (buf)))
+    return 0;
+  const char *p = buf;
+  if (*p < '0' || *p > '9')
+    return 0;
+  uint64_t quota = parse_number (&p);
+  if (*p++ != ' ')
+    return 0;
+  uint64_t period = parse_number (&p);
+  if (period == 0)
+    return 0;
+  uint64_t cpus = (quota + period - 1) / period;
+  if (cpus == 0)
+    return 1;
+  return cpus < UINT_MAX ? cpus : UINT_MAX;
+}
+
+/* Return the number of CPUs which the CPU bandwidth limit of the cgroup
+   of the process allows, or 0 if there is no limit.  Only the unified
+   cgroup v2 hierarchy is supported.  */
+static unsigned int
+cgroup_cpu_limit (void)
+{
+  static const char root[] = "/sys/fs/cgroup";
+  static const char cpu_max[] = "/cpu.max";
+  char buf[PATH_MAX];
+  if (!read_file ("/proc/self/cgroup", buf, sizeof (buf)))
+    return 0;
+
+  /* The cgroup in the v2 hierarchy is on the line starting with "0::".  */
+  char *path = buf;
+  while (strncmp (path, "0::", 3) != 0)
+    {
+      path = strchr (path, '\n');
+      if (path == NULL)
+	return 0;
+      ++path;
+    }
+  path += 3;
+  size_t path_len = __strchrnul (path, '\n') - path;
+
+  char dir[sizeof (root) + PATH_MAX + sizeof (cpu_max)];
+  if (path_len >= PATH_MAX)
+    return 0;
+  size_t len = sizeof (root) - 1;
+  memcpy (dir, root, len);
+  memcpy (dir + len, path, path_len);
+  len += path_len;
+
+  /* The effective limit is the lowest of the limits of the cgroup and
+     its ancestors.  The root cgroup has no cpu.max file.  */
+  unsigned int limit = 0;
+  while (len > sizeof (root) - 1)
+    {
+      memcpy (dir + len, cpu_max, sizeof (cpu_max));
+      unsigned int cpus = read_cpu_max (dir);
+      if (cpus != 0 && (limit == 0 || cpus < limit))
+	limit = cpus;
+      while (len > sizeof (root) - 1 && dir[len - 1] != '/')
+	--len;
+      --len;
+    }
+  return limit;
+}
+
+unsigned int
+__pthread_pool_default_size (void)
+{
+  /* The CPUs in the affinity mask, as for sysconf (_SC_NPROCESSORS_ONLN)
+     when /sys is not available.  */
+  enum { cpu_bits_size = CPU_ALLOC_SIZE (32768) };
+  __cpu_mask cpu_bits[cpu_bits_size / sizeof (__cpu_mask)];
+  int r = INTERNAL_SYSCALL_CALL (sched_getaffinity, 0, cpu_bits_size,
+				 cpu_bits);
+  unsigned int n;
+  if (r > 0)
+    n = CPU_COUNT_S (r, (cpu_set_t *) cpu_bits);
+  else
+    {
+      int nprocs = __get_nprocs ();
+      n = nprocs > 0 ? nprocs : 1;
+    }
+
+  unsigned int limit = cgroup_cpu_limit ();
+  if (limit != 0 && limit < n)
+    n = limit;
+  return n > 0 ? n : 1;
+}
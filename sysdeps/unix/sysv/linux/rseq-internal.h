@@ -23,8 +23,26 @@
 #include <kernel-features.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <sys/auxv.h>
 #include <sys/rseq.h>
 
+/* Read MEMBER of the rseq area of the calling thread, which the kernel
+   may update at any time.  */
+#define RSEQ_GETMEM_ONCE(member) \
+  THREAD_GETMEM_VOLATILE (THREAD_SELF, rseq_area.member)
+
+/* Return true if the kernel updates the node_id field of the rseq
+   areas it has registered.  */
+static inline bool
+rseq_node_id_supported (void)
+{
+  unsigned long int size;
+  return (__getauxval2 (AT_RSEQ_FEATURE_SIZE, &size)
+	  && size >= (offsetof (struct pthread, rseq_area.node_id)
+		      - offsetof (struct pthread, rseq_area)
+		      + sizeof (uint32_t)));
+}
+
 #ifdef RSEQ_SIG
 static inline bool
 rseq_register_current_thread (struct pthread *self, bool do_rseq)
@@ -28,6 +28,9 @@
 # include <error.h>
 # include <stdlib.h>
 # include <string.h>
+# include <sched.h>
+# include <stddef.h>
+# include <sys/auxv.h>
 # include <syscall.h>
 # include <thread_pointer.h>
 # include <tls.h>
@@ -43,6 +46,24 @@ do_rseq_main_test (void)
   TEST_VERIFY ((char *) __thread_pointer () + __rseq_offset
                == (char *) &pd->rseq_area);
   TEST_COMPARE (__rseq_size, sizeof (pd->rseq_area));
+
+  /* Cohort mutexes read the NUMA node from the rseq area if the kernel
+     updates it.  Retry if the thread migrates in the meantime.  */
+  if (getauxval (AT_RSEQ_FEATURE_SIZE)
+      >= offsetof (struct pthread, rseq_area.mm_cid)
+	 - offsetof (struct pthread, rseq_area))
+    for (int i = 0; i < 10; ++i)
+      {
+	unsigned int cpu, node;
+	unsigned int cpu_id = pd->rseq_area.cpu_id;
+	unsigned int node_id = pd->rseq_area.node_id;
+	TEST_COMPARE (getcpu (&cpu, &node), 0);
+	if (cpu == cpu_id && pd->rseq_area.cpu_id == cpu_id)
+	  {
+	    TEST_COMPARE (node_id, node);
+	    break;
+	  }
+      }
 }
 
 static void